@@ -4,8 +4,8 @@
 #   Program:    buildkabatdb
 #   File:       buildkabatdb.sh
 #   
-#   Version:    V1.2
-#   Date:       18.03.96
+#   Version:    V1.3
+#   Date:       19.10.26
 #   Function:   Rebuild the KabatMan data after the mirror s/w has pulled
 #               over new data
 #   
@@ -43,16 +43,17 @@
 #   mail program).
 #
 #   The script performs the following functions:
-#   1. Uncompresses the archives and builds into a single file
+#   1. Uncompresses the archives
 #   2. Moves any "update" files to required directories
-#   3. Calls the splitkabat program to split the files by species/chain
-#   4. Calls BuildFOF.perl to create a KabatMan file of files
-#   5. Runs KabatMan to convert to the KabatMan data format
-#   6. Runs KabatMan again to extract stats on the data
-#   7. Runs the updatestats Perl script to update the Kabat stats file
+#   3. Runs KabatMan to read the entry files directly and update the
+#      previous KabatMan data file (splitting by species/chain in
+#      memory rather than with splitkabat and BuildFOF.perl)
+#   4. Builds the entry files into a single file for distribution
+#   5. Runs KabatMan again to extract stats on the data
+#   6. Runs the updatestats Perl script to update the Kabat stats file
 #      and rebuild the stats Web page
-#   8. Tidies up and moves data to the "newkabat" directory
-#   9. Sends an EMail message to say the data have been updated.
+#   7. Tidies up and moves data to the "newkabat" directory
+#   8. Sends an EMail message to say the data have been updated.
 #
 #   Note that this script will need modifying once we get to 100000
 #   data files. We're still on < 30000, so we've got a way to go yet!
@@ -70,6 +71,11 @@
 #   V1.1  28.02.96 kabat.stat is now kept in $KABATDIR rather than in
 #                  $HTMLDIR
 #   V1.2  18.03.96 Added handling of the updates.tar.Z file
+#   V1.3  19.10.26 Updates the previous kabat.dat directly from the
+#                  entry files with kabatman -r -i rather than running
+#                  splitkabat and BuildFOF.perl and rebuilding it with
+#                  kabatman -f
+#                  Moves the kabat.dat.idx sequence index to $NEWKABAT
 #
 #*************************************************************************
 # The directory in which the mirrored database is kept
@@ -124,7 +130,21 @@ echo "done"
 # Remove all .bak backup files from revised entries
 \rm -f */*.bak
 
-# Combine all the data files into a single file
+# Run kabatman to update the previous data file directly from the entry
+# files. As with the single raw data file below, only $dir/$dir* is read
+# from each directory. Only entries which have changed since it was
+# built are re-read. If there is no previous file (or it has no raw file
+# index) the whole file is rebuilt.
+echo -n "Running KabatMan to build Kabat data file..."
+if [ -e $KABATDIR/kabat.dat ]; then
+  cp $KABATDIR/kabat.dat .
+fi
+$BINDIR/kabatman -r . -i >kabatman.log <<EOF
+quit
+EOF
+echo "done"
+
+# Combine all the data files into a single file for distribution
 # Note the use of $dir/$dir* rather than $dir/* to ensure that only the
 # proper files are used (other junk in the directories is skipped)
 echo -n "Creating single raw data file..."
@@ -141,24 +161,8 @@ echo -n "Removing separate entry data files..."
 \rm -rf 0*
 echo "done"
 
-# Run the splitkabat program to split these up by species
-echo -n "Splitting raw data by species and chain..."
-$BINDIR/splitkabat kabat.raw.dat
-echo "done"
-
-# Build the Kabat file of files
-$MIRRORBIN/BuildFOF.perl >kabat.fof
-
-# Run kabatman to build the new data file
-echo -n "Running KabatMan to build Kabat data file..."
-$BINDIR/kabatman -f >kabatman.log <<EOF
-quit
-EOF
-echo "done"
-
-# Remove the split files and the raw data file
+# Compress the raw data file
 echo -n "Tidying up..."
-\rm -f *.ig.*
 gzip kabat.raw.dat
 echo "done"
 
@@ -189,11 +193,11 @@ if [ ! -e $NEWKABAT ]; then
   mkdir $NEWKABAT
 fi
 mv kabat.dat        $NEWKABAT
+mv kabat.dat.idx    $NEWKABAT
 mv kabat.raw.dat.gz $NEWKABAT
 mv kabat_stats.html $NEWKABAT
 mv kabat.stat       $NEWKABAT
 mv kabatman.log     $NEWKABAT
-mv kabat.fof        $NEWKABAT
 
 # Remove the kabattemp directory
 cd ..
@@ -4,8 +4,8 @@
 #   Program:    installkabat
 #   File:       installkabat.sh
 #   
-#   Version:    V1.2
-#   Date:       22.04.96
+#   Version:    V1.3
+#   Date:       19.10.26
 #   Function:   Installs the updated Kabat data
 #   
 #   Copyright:  (c) Dr. Andrew C. R. Martin 1996
@@ -53,6 +53,10 @@
 #                  Small changes to the way the new version of the data
 #                  is copied to minimise time when data will be invalid
 #   V1.2  22.04.96 Files in KABATDIR protected against writing
+#   V1.3  19.10.26 No kabat.fof to install since buildkabat.sh builds
+#                  kabat.dat with kabatman -r
+#                  Installs the kabat.dat.idx sequence index with
+#                  kabat.dat, keeping the old version
 #
 #*************************************************************************
 NEWKABAT=/acrm/data/kabat/newkabat
@@ -62,9 +66,13 @@ HTMLDIR=/acrm/www/html/abs
 # Install the new kabat data; keep the old version 
 cd $NEWKABAT
 cp $KABATDIR/kabat.dat kabat.dat.old
+if [ -e $KABATDIR/kabat.dat.idx ]; then
+  cp $KABATDIR/kabat.dat.idx kabat.dat.idx.old
+fi
 cp kabat.dat $KABATDIR/kabat.dat.new
-cp kabat.fof $KABATDIR
+cp kabat.dat.idx $KABATDIR/kabat.dat.idx.new
 \mv -f $KABATDIR/kabat.dat.new $KABATDIR/kabat.dat
+\mv -f $KABATDIR/kabat.dat.idx.new $KABATDIR/kabat.dat.idx
 
 # Install the HTML
 cp kabat.stat $KABATDIR
@@ -77,6 +85,9 @@ chmod og-w $KABATDIR/*
 
 # Gzip the old version
 gzip -f kabat.dat.old
+if [ -e kabat.dat.idx.old ]; then
+  gzip -f kabat.dat.idx.old
+fi
 
 # Making a copy for distribution to others
 # /home/andrew/mirror/MakeFtpCopy.sh
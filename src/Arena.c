@@ -0,0 +1,250 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Arena.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Simple memory arenas. Memory is handed out from a list of large
+   blocks by moving a pointer along the current block; individual
+   allocations are never freed. Instead the whole arena is freed in one
+   go when the data stored in it are no longer needed.
+
+   Everything belonging to a data set (the DATA linked list, the special
+   numbering arrays and the cold text fields) is allocated from the
+   arena gDataArena, so reading the data is a small number of large
+   allocations and throwing them away is a single FreeArena().
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+                  Allocations counted by the hot-path counters
+                  Added ArenaUsage() and ArenaRound() for SHOW MEMORY
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define ARENAALIGN 16                /* Alignment of each allocation    */
+#define ROUNDUP(x) (((x) + ARENAALIGN - 1) & ~((size_t)ARENAALIGN - 1))
+
+/* Offset of the usable memory from the start of a block                */
+#define BLOCKHEAD  ROUNDUP(sizeof(ARENABLOCK))
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static ARENABLOCK *NewArenaBlock(size_t size);
+
+
+/************************************************************************/
+/*>ARENA *NewArena(size_t BlockSize)
+   ---------------------------------
+   Input:   size_t  BlockSize   Size of the blocks to be allocated
+   Returns: ARENA   *           New (empty) arena. NULL if no memory
+
+   Creates a new memory arena. No blocks are allocated until memory is
+   first requested.
+
+   19.10.26 Original    By: ACRM
+*/
+ARENA *NewArena(size_t BlockSize)
+{
+   ARENA *arena;
+
+   if((arena = (ARENA *)malloc(sizeof(ARENA)))==NULL)
+      return(NULL);
+
+   arena->blocks    = NULL;
+   arena->BlockSize = BlockSize;
+
+   return(arena);
+}
+
+
+/************************************************************************/
+/*>void *ArenaAlloc(ARENA *arena, size_t size)
+   -------------------------------------------
+   I/O:     ARENA  *arena     The arena
+   Input:   size_t size       Number of bytes required
+   Returns: void   *          Allocated memory. NULL if no memory
+
+   Allocates memory from an arena. The memory is not initialised and
+   remains valid until the arena is freed. A request larger than the
+   arena's block size is given a block of its own so the partly used
+   current block is not wasted.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Counted by STAT_ALLOC
+*/
+void *ArenaAlloc(ARENA *arena, size_t size)
+{
+   ARENABLOCK *block;
+   void       *mem;
+
+   size = ROUNDUP(size);
+   STATCOUNT(STAT_ALLOC);
+   STATAMOUNT(STAT_ALLOC, size);
+
+   if(size > arena->BlockSize - BLOCKHEAD)
+   {
+      /* Oversized; link it in behind the current block                 */
+      if((block = NewArenaBlock(BLOCKHEAD + size))==NULL)
+         return(NULL);
+      block->used = block->size;
+      if(arena->blocks == NULL)
+      {
+         arena->blocks = block;
+      }
+      else
+      {
+         block->next         = arena->blocks->next;
+         arena->blocks->next = block;
+      }
+      return((void *)((char *)block + BLOCKHEAD));
+   }
+
+   block = arena->blocks;
+   if((block == NULL) || (block->used + size > block->size))
+   {
+      /* Start a new current block                                      */
+      if((block = NewArenaBlock(arena->BlockSize))==NULL)
+         return(NULL);
+      block->next   = arena->blocks;
+      arena->blocks = block;
+   }
+
+   mem          = (void *)((char *)block + block->used);
+   block->used += size;
+
+   return(mem);
+}
+
+
+/************************************************************************/
+/*>void FreeArena(ARENA *arena)
+   ----------------------------
+   Input:   ARENA  *arena     The arena (may be NULL)
+
+   Frees an arena and all the memory allocated from it.
+
+   19.10.26 Original    By: ACRM
+*/
+void FreeArena(ARENA *arena)
+{
+   ARENABLOCK *block;
+
+   if(arena == NULL)
+      return;
+
+   while((block = arena->blocks) != NULL)
+   {
+      arena->blocks = block->next;
+      free(block);
+   }
+   free(arena);
+}
+
+
+/************************************************************************/
+/*>void ArenaUsage(ARENA *arena, size_t *allocated, size_t *used)
+   --------------------------------------------------------------
+   Input:   ARENA  *arena      The arena (may be NULL)
+   Output:  size_t *allocated  Total size of its blocks
+            size_t *used       Bytes handed out by ArenaAlloc()
+
+   The difference is the space left at the end of each block and the
+   block headers.
+
+   19.10.26 Original    By: ACRM
+*/
+void ArenaUsage(ARENA *arena, size_t *allocated, size_t *used)
+{
+   ARENABLOCK *block;
+
+   *allocated = *used = 0;
+   if(arena == NULL)
+      return;
+
+   for(block=arena->blocks; block!=NULL; NEXT(block))
+   {
+      *allocated += block->size;
+      *used      += block->used - BLOCKHEAD;
+   }
+}
+
+
+/************************************************************************/
+/*>size_t ArenaRound(size_t size)
+   ------------------------------
+   Input:   size_t  size      Number of bytes requested
+   Returns: size_t            Number of bytes ArenaAlloc() will use
+
+   19.10.26 Original    By: ACRM
+*/
+size_t ArenaRound(size_t size)
+{
+   return(ROUNDUP(size));
+}
+
+
+/************************************************************************/
+/*>static ARENABLOCK *NewArenaBlock(size_t size)
+   ---------------------------------------------
+   Input:   size_t     size   Total size of the block
+   Returns: ARENABLOCK *      The block. NULL if no memory
+
+   Allocates an empty block for an arena.
+
+   19.10.26 Original    By: ACRM
+*/
+static ARENABLOCK *NewArenaBlock(size_t size)
+{
+   ARENABLOCK *block;
+
+   if((block = (ARENABLOCK *)malloc(size))==NULL)
+      return(NULL);
+
+   block->next = NULL;
+   block->size = size;
+   block->used = BLOCKHEAD;
+
+   return(block);
+}
@@ -0,0 +1,85 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Arena.h
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Include file for using memory arenas
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+
+*************************************************************************/
+#ifndef _ARENA_H
+#define _ARENA_H
+
+/************************************************************************/
+/* Includes
+*/
+#include <stdlib.h>
+
+/************************************************************************/
+/* Defines and macros
+*/
+
+/* Versions of INIT() and ALLOCNEXT() which take the memory from an
+   arena. Lists built with these are freed with FreeArena() rather than
+   FREELIST()
+*/
+#define ARENAINIT(a,x,y) do { x=(y *)ArenaAlloc((a),sizeof(y));         \
+                              if((x)!=NULL) (x)->next=NULL; } while(0)
+#define ARENANEXT(a,x,y) do { (x)->next=(y *)ArenaAlloc((a),sizeof(y)); \
+                              if((x)->next!=NULL) (x)->next->next=NULL;  \
+                              (x)=(x)->next; } while(0)
+
+/************************************************************************/
+/* Structure definitions
+*/
+
+/* A memory arena is a list of blocks from which memory is allocated
+   by moving along the current (first) block. The memory in use in a
+   block follows the ARENABLOCK header
+*/
+typedef struct _arenablock
+{
+   struct _arenablock *next;
+   size_t             size,     /* Total size of the block              */
+                      used;     /* Bytes used including the header      */
+}  ARENABLOCK;
+
+typedef struct
+{
+   ARENABLOCK *blocks;
+   size_t     BlockSize;
+}  ARENA;
+
+#endif
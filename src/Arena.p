@@ -0,0 +1,10 @@
+ARENA *NewArena(size_t BlockSize)
+;
+void *ArenaAlloc(ARENA *arena, size_t size)
+;
+void FreeArena(ARENA *arena)
+;
+void ArenaUsage(ARENA *arena, size_t *allocated, size_t *used)
+;
+size_t ArenaRound(size_t size)
+;
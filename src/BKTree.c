@@ -0,0 +1,450 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       BKTree.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   BK-trees of the CDR sequences used to find the entries whose CDR is
+   within a given edit distance of a sequence (the WITHIN(n) test)
+   without comparing the sequence with every CDR in the data.
+
+   Each distinct sequence (in upper case without -'s) of a CDR under a
+   loop definition is a node of the tree and lists the entries which
+   have that sequence. Every child of a node is stored with its edit
+   distance from the node, and no two children of a node have the same
+   distance. Since edit distance is a metric, if a node is at distance
+   d from the query then anything within n of the query must be in a
+   child at distance d-n...d+n from the node; the other children need
+   not be visited.
+
+   A tree is built the first time it is needed and is kept with the
+   sequence index (allocated from gDataArena) until the data set is
+   freed. Patterns containing ? wildcards do not give a metric so they
+   are tested against every entry in the normal way.
+
+**************************************************************************
+
+   Usage:
+   ======
+   FindNeighbours() is called by FindCandidates() for a WITHIN(n) test.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+                  GetBKTree() counts whether the tree was ready in
+                  gCacheHits and gCacheMisses
+                  Added BKTreeMemory()
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define WORKBLOCK 65536                /* Arena block for the sequences */
+
+typedef struct
+{
+   char *seq;
+   int  length,
+        entry;
+}  LOOPSEQ;
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static BKTREE *GetBKTree(SEQINDEX *index, int field);
+static BOOL BuildBKTree(BKTREE *tree, int field);
+static void InsertBKNode(BKTREE *tree, int NewNode);
+static int CompareLoopSeqs(const void *ls1, const void *ls2);
+static int CompareEntries(const void *e1, const void *e2);
+
+
+/************************************************************************/
+/*>BOOL FindNeighbours(WHERE *wh, int **pCand, int *NCand)
+   -------------------------------------------------------
+   Input:   WHERE *wh        The WHERE item (a WITHIN(n) test)
+   Output:  int   **pCand    Malloc'd list of the matching entry numbers
+                             in ascending order
+            int   *NCand     Number of entries
+   Returns: BOOL             Was the tree used? If not, every entry
+                             must be tested
+   Globals: int   gLoopMode  Current loop definition
+
+   Finds the entries whose CDR is within wh->matcher.errors edits of
+   the pattern by searching the BK-tree for the CDR.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL FindNeighbours(WHERE *wh, int **pCand, int *NCand)
+{
+   SEQINDEX *index;
+   BKTREE   *tree;
+   BKNODE   *node;
+   int      *stack,
+            *found,
+            NStack = 0,
+            NFound = 0,
+            NHits  = 0,
+            field,
+            dist,
+            i,
+            child;
+
+   *pCand = NULL;
+   *NCand = 0;
+
+   if(((field = IndexField(wh->type, gLoopMode)) < 2) ||
+      (wh->matcher.length < 1) || (strchr(wh->pattern, '?') != NULL))
+      return(FALSE);
+
+   if(((index = GetSeqIndex())==NULL) ||
+      ((tree = GetBKTree(index, field))==NULL))
+      return(FALSE);
+   if(tree->NNodes == 0)
+      return(TRUE);
+
+   /* Each node is pushed once at most, so both lists fit in NNodes     */
+   if((stack = (int *)malloc(2 * tree->NNodes * sizeof(int)))==NULL)
+      return(FALSE);
+   found = stack + tree->NNodes;
+
+   stack[NStack++] = 0;
+   while(NStack)
+   {
+      node = &(tree->nodes[stack[--NStack]]);
+      dist = EditDistance(wh->pattern, wh->matcher.length,
+                          node->seq, node->length, FALSE);
+      if(dist <= wh->matcher.errors)
+      {
+         found[NFound++] = (int)(node - tree->nodes);
+         NHits += node->NEntries;
+      }
+
+      for(child=node->child; child != (-1);
+          child=tree->nodes[child].sibling)
+      {
+         if(abs(tree->nodes[child].dist - dist) <= wh->matcher.errors)
+            stack[NStack++] = child;
+      }
+   }
+
+   if((*pCand = (int *)malloc((NHits+1) * sizeof(int)))==NULL)
+   {
+      free(stack);
+      return(FALSE);
+   }
+   for(i=0; i<NFound; i++)
+   {
+      node = &(tree->nodes[found[i]]);
+      memcpy(*pCand + *NCand, node->entries, node->NEntries * sizeof(int));
+      *NCand += node->NEntries;
+   }
+   qsort(*pCand, *NCand, sizeof(int), CompareEntries);
+
+   free(stack);
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BKTREE *GetBKTree(SEQINDEX *index, int field)
+   ----------------------------------------------------
+   I/O:     SEQINDEX *index    The sequence index
+   Input:   int      field     Index field number (a CDR)
+   Returns: BKTREE   *         The tree. NULL if no memory
+
+   Gets the BK-tree for a field, building it if this is the first time
+   it has been needed.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Counts in gCacheHits or gCacheMisses
+*/
+static BKTREE *GetBKTree(SEQINDEX *index, int field)
+{
+   BKTREE *tree;
+
+   if(index->tree[field] != NULL)
+   {
+      gCacheHits++;
+      return(index->tree[field]);
+   }
+   gCacheMisses++;
+
+   if(((tree = (BKTREE *)ArenaAlloc(gDataArena, sizeof(BKTREE)))==NULL) ||
+      !BuildBKTree(tree, field))
+   {
+      fprintf(stderr,"Warning: No memory for CDR tree\n");
+      return(NULL);
+   }
+
+   index->tree[field] = tree;
+   return(tree);
+}
+
+
+/************************************************************************/
+/*>static BOOL BuildBKTree(BKTREE *tree, int field)
+   ------------------------------------------------
+   Output:  BKTREE *tree     The tree
+   Input:   int    field     Index field number (a CDR)
+   Returns: BOOL             Success (FALSE if no memory)
+   Globals: DATA   *gData    The data
+
+   Builds the BK-tree for a field. The sequences of all the entries are
+   sorted so that the entries sharing a sequence come together; each
+   distinct sequence then becomes a node and is inserted into the tree.
+   Entries with no sequence for the CDR are left out since they never
+   match. Only the nodes are kept in gDataArena; the sorted sequences
+   are built in a work arena which is freed at the end.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL BuildBKTree(BKTREE *tree, int field)
+{
+   DATA    *d;
+   ARENA   *work;
+   LOOPSEQ *seqs;
+   BKNODE  *node;
+   char    text[LARGEBUFF];
+   int     *entries,
+           NData = 0,
+           NSeqs = 0,
+           entry,
+           i;
+   BOOL    ok    = TRUE;
+
+   tree->nodes  = NULL;
+   tree->NNodes = 0;
+
+   for(d=gData; d!=NULL; NEXT(d))
+      NData++;
+   if(NData == 0)
+      return(TRUE);
+
+   if((seqs = (LOOPSEQ *)malloc(NData * sizeof(LOOPSEQ)))==NULL)
+      return(FALSE);
+   if((work = NewArena(WORKBLOCK))==NULL)
+   {
+      free(seqs);
+      return(FALSE);
+   }
+
+   for(d=gData, entry=0; ok && d!=NULL; NEXT(d), entry++)
+   {
+      if((seqs[NSeqs].length = FieldText(d, field, text)) == 0)
+         continue;
+      if((seqs[NSeqs].seq = (char *)ArenaAlloc(work,
+                                               seqs[NSeqs].length+1))
+         ==NULL)
+      {
+         ok = FALSE;
+         break;
+      }
+      strcpy(seqs[NSeqs].seq, text);
+      seqs[NSeqs].entry = entry;
+      NSeqs++;
+   }
+
+   if(ok && NSeqs)
+   {
+      qsort(seqs, NSeqs, sizeof(LOOPSEQ), CompareLoopSeqs);
+
+      tree->NNodes = 1;
+      for(i=1; i<NSeqs; i++)
+      {
+         if(strcmp(seqs[i].seq, seqs[i-1].seq))
+            tree->NNodes++;
+      }
+
+      if(((tree->nodes =
+           (BKNODE *)ArenaAlloc(gDataArena,
+                                tree->NNodes * sizeof(BKNODE)))==NULL) ||
+         ((entries = (int *)ArenaAlloc(gDataArena,
+                                       NSeqs * sizeof(int)))==NULL))
+      {
+         ok = FALSE;
+      }
+
+      for(i=0, node=NULL; ok && i<NSeqs; i++)
+      {
+         if((node == NULL) || strcmp(seqs[i].seq, node->seq))
+         {
+            node = (node == NULL) ? tree->nodes : node+1;
+            if((node->seq = (char *)ArenaAlloc(gDataArena,
+                                               seqs[i].length+1))==NULL)
+            {
+               ok = FALSE;
+               break;
+            }
+            strcpy(node->seq, seqs[i].seq);
+            node->length   = seqs[i].length;
+            node->entries  = entries + i;
+            node->NEntries = 0;
+            node->dist     = 0;
+            node->child    = (-1);
+            node->sibling  = (-1);
+         }
+         node->entries[node->NEntries++] = seqs[i].entry;
+      }
+
+      for(i=1; ok && i<tree->NNodes; i++)
+         InsertBKNode(tree, i);
+   }
+
+   if(!ok)
+      tree->NNodes = 0;
+
+   FreeArena(work);
+   free(seqs);
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static void InsertBKNode(BKTREE *tree, int NewNode)
+   ---------------------------------------------------
+   I/O:     BKTREE *tree     The tree
+   Input:   int    NewNode   Node to be inserted
+
+   Inserts a node into the tree. Starting at the root, moves to the
+   child at the same distance as the new node until there is none; the
+   new node then becomes a child at that distance. The sequences are
+   all different so the distance is never 0.
+
+   19.10.26 Original    By: ACRM
+*/
+static void InsertBKNode(BKTREE *tree, int NewNode)
+{
+   BKNODE *nodes = tree->nodes;
+   int    parent = 0,
+          child,
+          dist;
+
+   for(;;)
+   {
+      dist = EditDistance(nodes[NewNode].seq, nodes[NewNode].length,
+                          nodes[parent].seq, nodes[parent].length,
+                          FALSE);
+
+      for(child=nodes[parent].child; child != (-1);
+          child=nodes[child].sibling)
+      {
+         if(nodes[child].dist == dist)
+            break;
+      }
+
+      if(child == (-1))
+      {
+         nodes[NewNode].dist    = dist;
+         nodes[NewNode].sibling = nodes[parent].child;
+         nodes[parent].child    = NewNode;
+         return;
+      }
+      parent = child;
+   }
+}
+
+
+/************************************************************************/
+/*>static int CompareLoopSeqs(const void *ls1, const void *ls2)
+   ------------------------------------------------------------
+   qsort() comparison for LOOPSEQs; by sequence and then by entry.
+
+   19.10.26 Original    By: ACRM
+*/
+static int CompareLoopSeqs(const void *ls1, const void *ls2)
+{
+   LOOPSEQ *s1 = (LOOPSEQ *)ls1,
+           *s2 = (LOOPSEQ *)ls2;
+   int     cmp;
+
+   if((cmp = strcmp(s1->seq, s2->seq)) != 0)
+      return(cmp);
+   return(s1->entry - s2->entry);
+}
+
+
+/************************************************************************/
+/*>static int CompareEntries(const void *e1, const void *e2)
+   ---------------------------------------------------------
+   qsort() comparison for entry numbers.
+
+   19.10.26 Original    By: ACRM
+*/
+static int CompareEntries(const void *e1, const void *e2)
+{
+   return(*(int *)e1 - *(int *)e2);
+}
+
+
+/************************************************************************/
+/*>void BKTreeMemory(MEMUSE *use)
+   ------------------------------
+   Output:  MEMUSE    *use        Memory used by the CDR trees which have
+                                  been built
+   Globals: SEQINDEX  *gSeqIndex  The index holding the trees
+
+   For SHOW MEMORY.
+
+   19.10.26 Original    By: ACRM
+*/
+void BKTreeMemory(MEMUSE *use)
+{
+   BKTREE *tree;
+   int    field,
+          NEntries,
+          i;
+
+   if(gSeqIndex == NULL)
+      return;
+
+   for(field=0; field<NINDEXFIELD; field++)
+   {
+      if((tree = gSeqIndex->tree[field]) == NULL)
+         continue;
+
+      for(i=0, NEntries=0; i<tree->NNodes; i++)
+      {
+         NEntries       += tree->nodes[i].NEntries;
+         use->allocated += ArenaRound(tree->nodes[i].length+1);
+         use->used      += tree->nodes[i].length+1;
+      }
+      use->allocated += ArenaRound(sizeof(BKTREE)) +
+                        ArenaRound(tree->NNodes * sizeof(BKNODE)) +
+                        ArenaRound(NEntries * sizeof(int));
+      use->used      += sizeof(BKTREE) + tree->NNodes * sizeof(BKNODE) +
+                        NEntries * sizeof(int);
+   }
+}
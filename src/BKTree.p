@@ -0,0 +1,4 @@
+BOOL FindNeighbours(WHERE *wh, int **pCand, int *NCand)
+;
+void BKTreeMemory(MEMUSE *use)
+;
@@ -0,0 +1,887 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Batch.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Runs a WHERE test on batches of BATCHSIZE entries at a time rather
+   than one entry at a time.
+
+   The sets on the search stack are kept as arrays of flags, one byte
+   per entry, rather than in the active flags of each DATA, so a pass
+   through a set only reads the set. AND, OR and NOT are simple loops
+   over two of these arrays which the compiler can vectorise. The set
+   left at the end is copied to the active flags for the display.
+
+   For each batch, a selection vector is made of the numbers of the
+   entries which need to be tested: those in the batch which are
+   candidates from the sequence index or which are in zones not skipped
+   by the zone map. If the test is followed directly by AND, only the
+   entries which passed the test below it on the stack need be tested
+   since the others fail the AND anyway; similarly, if it is followed by
+   OR, only the entries which failed need be tested. The chains of tests
+   which make up most searches thus get quicker as they go.
+
+   The selected entries are then passed to a kernel which writes the
+   numbers of those which pass to a second vector. Tests on the date,
+   the length of a CDR, the source, class and COMPLETE use the columns
+   (below) and a separate tight loop for each comparison with no calls
+   and no branches, so the compiler can unroll them. Other tests call
+   TestEntry() for each selected entry.
+
+   The columns hold the values of these fields for each entry in the
+   order of gData. The sources and classes are coded: each distinct
+   value (up to MAXCODES-1 of them) has a code and the last code is
+   shared by any others. A test on a coded field is applied once to each
+   value to give a bit mask of the codes which pass so each entry is
+   just a shift and a mask. If there are other values, the mask can't
+   be used and TestEntry() is called. The CDR lengths for a loop and
+   loop definition are only found the first time they are needed. The
+   columns are allocated from gDataArena so they go when the data do.
+   They are also used to build the zone maps.
+
+**************************************************************************
+
+   Usage:
+   ======
+   When UseBatches() is TRUE, HandleMatch() calls BatchMatch(),
+   HandleLogical() calls BatchLogical() and ExecuteSearch() calls
+   BatchResult() at the end of the WHERE clause. SET BATCH OFF tests
+   one entry at a time as before, as does a search which may stop early
+   at the LIMIT.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define OTHERCODE    (MAXCODES-1)
+#define KERNEL_ROWS  0                 /* Kernels for BatchMatch()      */
+#define KERNEL_INT   1
+#define KERNEL_CODE  2
+
+/* Adds each entry in sel[] for which test is true to out[]. Written
+   without a branch so the loop may be unrolled
+*/
+#define SELECTLOOP(test)                                                 \
+   for(i=0; i<NSel; i++)                                                 \
+   {  row       = sel[i];                                                \
+      out[NOut] = row;                                                   \
+      NOut     += ((test) != 0);                                         \
+   }
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static int CodeValue(char **values, int *NValues, BOOL *other,
+                     char *value, int *last);
+static int SelectInt(int *column, int comparison, int value, int *sel,
+                     int NSel, int *out);
+static int SelectCode(unsigned char *column, uint64_t pass, int *sel,
+                      int NSel, int *out);
+static int SelectRows(DATA **rows, WHERE *wh, int *sel, int NSel,
+                      int *out, BOOL *ok);
+static unsigned char *GetSet(COLUMNS *cols, int level);
+
+
+/************************************************************************/
+/*>BOOL BatchMatch(WHERE *wh, int StackDepth, BOOL indexed, int *cand,
+                   int NCand, char *zones)
+   --------------------------------------------------------------------
+   Input:   WHERE *wh          An item from the WHERE clause linked list
+            int   StackDepth   Stack depth including the new set
+            BOOL  indexed      Only test the candidates?
+            int   *cand        Candidate entry numbers in ascending order
+            int   NCand        Number of candidates
+            char  *zones       Flag for each zone: may it match? (NULL
+                               if the zone map is not being used)
+   Returns: BOOL               Success?
+
+   Sets the new set on the stack by testing the entries a batch at a
+   time. The entries tested are counted in wh->stats.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL BatchMatch(WHERE *wh, int StackDepth, BOOL indexed, int *cand,
+                int NCand, char *zones)
+{
+   COLUMNS       *cols;
+   DATA          **rows;
+   unsigned char *codes   = NULL,
+                 *set,
+                 *below   = NULL;
+   uint64_t      pass     = 0;
+   int           *column  = NULL,
+                 sel[BATCHSIZE],
+                 out[BATCHSIZE],
+                 kernel   = KERNEL_ROWS,
+                 level    = StackDepth - 1,
+                 value    = 0,
+                 iCand    = 0,
+                 NTested  = 0,
+                 filter,
+                 loop,
+                 NSel,
+                 NOut     = 0,
+                 base,
+                 end,
+                 zone,
+                 stop,
+                 i,
+                 n;
+   BOOL          keep,
+                 ok       = TRUE;
+
+   filter = ChainFilter(wh, StackDepth - 1);
+   keep   = (filter == OPER_AND);
+   if(((cols = GetColumns())==NULL) ||
+      ((set = GetSet(cols, level))==NULL) ||
+      (filter && ((below = GetSet(cols, level - 1))==NULL)))
+   {
+      fprintf(stderr,"Error: No memory for search\n");
+      return(FALSE);
+   }
+   rows = cols->rows;
+
+   /* Choose the kernel                                                 */
+   switch(wh->type)
+   {
+   case FIELD_REFDATE:
+      column = cols->dates;
+      break;
+   case FIELD_LENGTH:
+      if((loop = LengthLoop(wh->param)) >= 0)
+         column = ColumnLengths(cols, loop, gLoopMode - 1);
+      break;
+   case FIELD_SOURCE:
+      if(!cols->OtherSources)
+      {
+         codes = cols->sources;
+         pass  = CodePass(cols->SourceValues, cols->NSources, FALSE, wh);
+      }
+      break;
+   case FIELD_CLASS:
+      if(!cols->OtherClasses)
+      {
+         codes = cols->classes;
+         pass  = CodePass(cols->ClassValues, cols->NClasses, FALSE, wh);
+      }
+      break;
+   case FIELD_COMPLETE:
+      codes = cols->complete;
+      pass  = (DoBoolTest(FALSE, wh->comparison, wh->data) ? 1 : 0) |
+              (DoBoolTest(TRUE,  wh->comparison, wh->data) ? 2 : 0);
+      break;
+   default:
+      break;
+   }
+   if(column != NULL)
+   {
+      if(!sscanf(wh->data,"%d",&value)) value=0;  /* As TestEntry()     */
+      kernel = KERNEL_INT;
+   }
+   else if(codes != NULL)
+   {
+      kernel = KERNEL_CODE;
+   }
+
+   for(base=0; base<cols->NRows; base+=BATCHSIZE)
+   {
+      end  = MIN(base + BATCHSIZE, cols->NRows);
+      NSel = 0;
+
+      /* Select the candidates or the entries in zones which may match */
+      if(indexed)
+      {
+         while((iCand < NCand) && (cand[iCand] < end))
+            sel[NSel++] = cand[iCand++];
+      }
+      else
+      {
+         for(zone=base; zone<end; zone+=ZONESIZE)
+         {
+            if((zones == NULL) || zones[zone / ZONESIZE])
+            {
+               stop = MIN(zone + ZONESIZE, end);
+               for(i=zone; i<stop; i++)
+                  sel[NSel++] = i;
+            }
+         }
+      }
+
+      /* Keep those which can change the result of the AND or OR        */
+      if(filter)
+      {
+         for(i=0, n=0; i<NSel; i++)
+         {
+            sel[n] = sel[i];
+            n     += (below[sel[i]] == keep);
+         }
+         NSel = n;
+      }
+      NTested += NSel;
+
+      switch(kernel)
+      {
+      case KERNEL_INT:
+         NOut = SelectInt(column, wh->comparison, value, sel, NSel, out);
+         STATTESTS(wh->type, NSel);
+         break;
+      case KERNEL_CODE:
+         NOut = SelectCode(codes, pass, sel, NSel, out);
+         STATTESTS(wh->type, NSel);
+         break;
+      default:
+         NOut = SelectRows(rows, wh, sel, NSel, out, &ok);
+         if(!ok)
+            return(FALSE);
+         break;
+      }
+
+      memset(set + base, 0, end - base);
+      for(i=0; i<NOut; i++)
+         set[out[i]] = 1;
+   }
+
+   wh->stats.tested  = NTested;
+   wh->stats.stopped = FALSE;
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>int ChainFilter(WHERE *wh, int StackDepth)
+   ------------------------------------------
+   Input:   WHERE  *wh          A WHERE test
+            int    StackDepth   Stack depth before the test
+   Returns: int                 OPER_AND if only entries in the set at
+                                the top of the stack need be tested,
+                                OPER_OR if only those not in it need be
+                                tested, 0 if all must be tested
+
+   A test followed directly by AND or OR is combined with the set below
+   it, so only the entries for which that set does not already decide
+   the result need be tested. This is only done when the tests are run
+   in batches.
+
+   19.10.26 Original    By: ACRM
+*/
+int ChainFilter(WHERE *wh, int StackDepth)
+{
+   if(!UseBatches() || wh->SetOper || (StackDepth < 1) ||
+      (wh->next == NULL) || !wh->next->SetOper)
+      return(0);
+
+   if((wh->next->type == OPER_AND) || (wh->next->type == OPER_OR))
+      return(wh->next->type);
+
+   return(0);
+}
+
+
+/************************************************************************/
+/*>BOOL UseBatches(void)
+   ---------------------
+   Returns: BOOL              Is the current search run in batches?
+   Globals: BOOL  gUseBatch   Set by SET BATCH
+
+   A search which may stop early at the LIMIT tests one entry at a time
+   so it can stop at the last hit needed.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL UseBatches(void)
+{
+   return(gUseBatch && !ScanLimit());
+}
+
+
+/************************************************************************/
+/*>int *BatchEntries(WHERE *wh, int StackDepth, unsigned char **pSet,
+                      int *NEntries)
+   -------------------------------------------------------------------
+   Input:   WHERE         *wh         An item from the WHERE clause
+            int           StackDepth  Stack depth including the new set
+   Output:  unsigned char **pSet      The new set, cleared
+            int           *NEntries   Number of entries to test
+   Returns: int *                     Malloc'd list of the entries to
+                                      test. NULL if no memory
+
+   For tests which are split between threads rather than run in batches
+   (see ParallelMatch()). Lists the entries whose result can change the
+   AND or OR which follows, or every entry.
+
+   19.10.26 Original    By: ACRM
+*/
+int *BatchEntries(WHERE *wh, int StackDepth, unsigned char **pSet,
+                  int *NEntries)
+{
+   COLUMNS       *cols;
+   unsigned char *below = NULL;
+   int           *entries,
+                 filter,
+                 i,
+                 n;
+   BOOL          keep;
+
+   filter = ChainFilter(wh, StackDepth - 1);
+   keep   = (filter == OPER_AND);
+   if(((cols = GetColumns())==NULL) ||
+      ((*pSet = GetSet(cols, StackDepth - 1))==NULL) ||
+      (filter && ((below = GetSet(cols, StackDepth - 2))==NULL)) ||
+      ((entries = (int *)malloc((cols->NRows+1) * sizeof(int)))==NULL))
+      return(NULL);
+
+   memset(*pSet, 0, cols->NRows);
+   for(i=0, n=0; i<cols->NRows; i++)
+   {
+      entries[n] = i;
+      n         += (!filter || (below[i] == keep));
+   }
+   *NEntries = n;
+
+   return(entries);
+}
+
+
+/************************************************************************/
+/*>BOOL BatchLogical(WHERE *wh, int *StackDepth)
+   ---------------------------------------------
+   Input:   WHERE *wh          A logical operator
+   I/O:     int   *StackDepth  The stack depth before and after the
+                               logical operation
+   Returns: BOOL               Success (fails if stack too shallow)
+
+   HandleLogical() for the sets kept by the batches.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL BatchLogical(WHERE *wh, int *StackDepth)
+{
+   COLUMNS       *cols;
+   unsigned char *a,
+                 *b;
+   int           i;
+
+   if((*StackDepth < ((wh->type == OPER_NOT) ? 1 : 2)) ||
+      ((cols = GetColumns())==NULL) ||
+      ((a = GetSet(cols, (*StackDepth)-1))==NULL))
+      return(FALSE);
+
+   switch(wh->type)
+   {
+   case OPER_NOT:
+      for(i=0; i<cols->NRows; i++)
+         a[i] ^= 1;
+      break;
+   case OPER_AND:
+      b = GetSet(cols, (*StackDepth)-2);
+      for(i=0; i<cols->NRows; i++)
+         b[i] &= a[i];
+      (*StackDepth)--;
+      break;
+   case OPER_OR:
+      b = GetSet(cols, (*StackDepth)-2);
+      for(i=0; i<cols->NRows; i++)
+         b[i] |= a[i];
+      (*StackDepth)--;
+      break;
+   default:
+      break;
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>int BatchCount(int StackDepth)
+   ------------------------------
+   Input:   int    StackDepth   Stack depth
+   Returns: int                 Entries in the set at that depth
+
+   ExplainCount() for the sets kept by the batches.
+
+   19.10.26 Original    By: ACRM
+*/
+int BatchCount(int StackDepth)
+{
+   COLUMNS       *cols;
+   unsigned char *set;
+   int           count = 0,
+                 i;
+
+   if(((cols = GetColumns())==NULL) ||
+      ((set = GetSet(cols, StackDepth-1))==NULL))
+      return(0);
+
+   for(i=0; i<cols->NRows; i++)
+      count += set[i];
+   return(count);
+}
+
+
+/************************************************************************/
+/*>BOOL BatchResult(void)
+   ----------------------
+   Returns: BOOL            Success (FALSE if no memory)
+   Globals: DATA   *gData   The active flags are set
+
+   Copies the set left on the stack to the active flags in the data
+   which are used to display the hits.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL BatchResult(void)
+{
+   COLUMNS       *cols;
+   unsigned char *set;
+   int           i;
+
+   if(((cols = GetColumns())==NULL) || ((set = GetSet(cols, 0))==NULL))
+   {
+      fprintf(stderr,"Error: No memory for search\n");
+      return(FALSE);
+   }
+
+   for(i=0; i<cols->NRows; i++)
+      cols->rows[i]->active[0] = set[i];
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>COLUMNS *GetColumns(void)
+   -------------------------
+   Returns: COLUMNS *          The columns. NULL if no memory
+   Globals: COLUMNS *gColumns  Set when first built
+            DATA    *gData     The data
+
+   Gets the columns, building them the first time. Whether they were
+   ready is counted in gCacheHits and gCacheMisses.
+
+   19.10.26 Original    By: ACRM
+*/
+COLUMNS *GetColumns(void)
+{
+   COLUMNS *cols;
+   DATA    *d;
+   int     LastSource = 0,
+           LastClass  = 0,
+           NData      = 0,
+           loop,
+           mode,
+           i;
+
+   if(gColumns != NULL)
+   {
+      gCacheHits++;
+      return(gColumns);
+   }
+   gCacheMisses++;
+
+   for(d=gData; d!=NULL; NEXT(d))
+      NData++;
+
+   if((gDataArena == NULL) ||
+      ((cols = (COLUMNS *)ArenaAlloc(gDataArena, sizeof(COLUMNS)))==NULL))
+      return(NULL);
+
+   cols->NRows        = NData;
+   cols->NSources     = cols->NClasses = 0;
+   cols->OtherSources = cols->OtherClasses = FALSE;
+   for(loop=0; loop<NLENGTHLOOPS; loop++)
+   {
+      for(mode=0; mode<NLOOPMODES; mode++)
+         cols->lengths[loop][mode] = NULL;
+   }
+   for(i=0; i<STACKDEPTH; i++)
+      cols->sets[i] = NULL;
+
+   /* One extra element each so nothing is asked for with size 0        */
+   if(((cols->rows = (DATA **)ArenaAlloc(gDataArena,
+                                         (NData+1) * sizeof(DATA *)))
+       ==NULL) ||
+      ((cols->dates = (int *)ArenaAlloc(gDataArena,
+                                        (NData+1) * sizeof(int)))==NULL) ||
+      ((cols->sources = (unsigned char *)ArenaAlloc(gDataArena, NData+1))
+       ==NULL) ||
+      ((cols->classes = (unsigned char *)ArenaAlloc(gDataArena, NData+1))
+       ==NULL) ||
+      ((cols->complete = (unsigned char *)ArenaAlloc(gDataArena, NData+1))
+       ==NULL))
+      return(NULL);
+
+   for(d=gData, i=0; d!=NULL; NEXT(d), i++)
+   {
+      cols->rows[i]     = d;
+      cols->dates[i]    = d->refdate;
+      cols->sources[i]  = (unsigned char)
+                          CodeValue(cols->SourceValues, &(cols->NSources),
+                                    &(cols->OtherSources), d->source,
+                                    &LastSource);
+      cols->classes[i]  = (unsigned char)
+                          CodeValue(cols->ClassValues, &(cols->NClasses),
+                                    &(cols->OtherClasses), d->UpperClass,
+                                    &LastClass);
+      cols->complete[i] = (unsigned char)(IsComplete(d) ? 1 : 0);
+   }
+
+   gColumns = cols;
+   return(cols);
+}
+
+
+/************************************************************************/
+/*>int *ColumnLengths(COLUMNS *cols, int loop, int mode)
+   -----------------------------------------------------
+   I/O:     COLUMNS *cols     The columns
+   Input:   int     loop      Index of the loop in gLoopDefs[]
+            int     mode      Loop definition (LOOP_xxxx - 1)
+   Returns: int *             Length of the loop in each entry. NULL if
+                              no memory
+
+   Gets the lengths of a loop, finding them in the same way as a LENGTH
+   test the first time.
+
+   19.10.26 Original    By: ACRM
+*/
+int *ColumnLengths(COLUMNS *cols, int loop, int mode)
+{
+   int  *lengths,
+        i;
+   char text[160];
+
+   if(cols->lengths[loop][mode] != NULL)
+      return(cols->lengths[loop][mode]);
+
+   if((lengths = (int *)ArenaAlloc(gDataArena,
+                                   (cols->NRows+1) * sizeof(int)))==NULL)
+      return(NULL);
+
+   for(i=0; i<cols->NRows; i++)
+   {
+      FillLoopMode(gLoopDefs[loop].name, cols->rows[i], text, mode+1);
+      lengths[i] = blTrueSeqLen(text);
+   }
+
+   cols->lengths[loop][mode] = lengths;
+   return(lengths);
+}
+
+
+/************************************************************************/
+/*>int LengthLoop(char *loopname)
+   ------------------------------
+   Input:   char   *loopname   Loop name (L1...H3)
+   Returns: int                Index of the loop in gLoopDefs[] (-1 if
+                               it isn't one of the first NLENGTHLOOPS)
+
+   Matches the name in the same way as FillLoopMode().
+
+   19.10.26 Original    By: ACRM
+*/
+int LengthLoop(char *loopname)
+{
+   int i;
+
+   for(i=0; (i<NLENGTHLOOPS) && (gLoopDefs[i].name != NULL); i++)
+   {
+      if(!blUpstrncmp(loopname,gLoopDefs[i].name,2))
+         return(i);
+   }
+   return(-1);
+}
+
+
+/************************************************************************/
+/*>uint64_t CodePass(char **values, int NValues, BOOL other, WHERE *wh)
+   --------------------------------------------------------------------
+   Input:   char   **values   The coded values
+            int    NValues    Number of them
+            BOOL   other      Set the bit for any other values?
+            WHERE  *wh        A test on the source or class
+   Returns: uint64_t          Bits of the codes of the values which pass
+                              the test
+
+   19.10.26 Original    By: ACRM
+*/
+uint64_t CodePass(char **values, int NValues, BOOL other, WHERE *wh)
+{
+   uint64_t pass = (other ? ((uint64_t)1 << OTHERCODE) : 0);
+   int      i;
+
+   for(i=0; i<NValues; i++)
+   {
+      if(DoStrTest(values[i], wh->comparison, wh->data))
+         pass |= (uint64_t)1 << i;
+   }
+   return(pass);
+}
+
+
+/************************************************************************/
+/*>void ColumnsMemory(MEMUSE *use)
+   -------------------------------
+   Output:  MEMUSE   *use        Memory used by the columns
+   Globals: COLUMNS  *gColumns   The columns (if built)
+
+   For SHOW MEMORY. The CDR lengths and the sets are counted with the
+   columns.
+
+   19.10.26 Original    By: ACRM
+*/
+void ColumnsMemory(MEMUSE *use)
+{
+   size_t size;
+   int    loop,
+          mode,
+          i;
+
+   if(gColumns == NULL)
+      return;
+
+   size = (gColumns->NRows+1) * sizeof(DATA *);
+   use->allocated += ArenaRound(size);
+   use->used      += size;
+   size = (gColumns->NRows+1) * sizeof(int);
+   use->allocated += ArenaRound(size);
+   use->used      += size;
+   size = gColumns->NRows+1;
+   use->allocated += 3 * ArenaRound(size);
+   use->used      += 3 * size;
+   use->allocated += ArenaRound(sizeof(COLUMNS));
+   use->used      += sizeof(COLUMNS);
+   use->fixed     += ArenaRound(sizeof(COLUMNS));
+
+   size = gColumns->NRows+1;
+   for(i=0; i<STACKDEPTH; i++)
+   {
+      if(gColumns->sets[i] != NULL)
+      {
+         use->allocated += ArenaRound(size);
+         use->used      += size;
+      }
+   }
+
+   size = (gColumns->NRows+1) * sizeof(int);
+   for(loop=0; loop<NLENGTHLOOPS; loop++)
+   {
+      for(mode=0; mode<NLOOPMODES; mode++)
+      {
+         if(gColumns->lengths[loop][mode] != NULL)
+         {
+            use->allocated += ArenaRound(size);
+            use->used      += size;
+         }
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>static int CodeValue(char **values, int *NValues, BOOL *other,
+                        char *value, int *last)
+   -------------------------------------------------------------
+   I/O:     char  **values    The coded values so far
+            int   *NValues    Number of them
+            BOOL  *other      Set if the value is not in the list and
+                              the list is full
+            int   *last       Code found last time (checked first since
+                              neighbouring entries usually match)
+   Input:   char  *value      The value of an entry
+   Returns: int               Code for the value
+
+   19.10.26 Original (ZoneValueBit() from ZoneMap.c)   By: ACRM
+*/
+static int CodeValue(char **values, int *NValues, BOOL *other,
+                     char *value, int *last)
+{
+   int i;
+
+   if((*last < *NValues) && !strcmp(values[*last], value))
+      return(*last);
+
+   for(i=0; i<*NValues; i++)
+   {
+      if(!strcmp(values[i], value))
+         return(*last = i);
+   }
+
+   if(*NValues < OTHERCODE)
+   {
+      values[*NValues] = value;
+      return(*last = (*NValues)++);
+   }
+
+   *other = TRUE;
+   return(OTHERCODE);
+}
+
+
+/************************************************************************/
+/*>static int SelectInt(int *column, int comparison, int value, int *sel,
+                        int NSel, int *out)
+   ---------------------------------------------------------------------
+   Input:   int   *column      Value for each entry
+            int   comparison   The comparison type
+            int   value        The number in the test
+            int   *sel         Entries to test
+            int   NSel         Number of them
+   Output:  int   *out         Entries which pass
+   Returns: int                Number which pass
+
+   Kernel for the tests on numbers. Gives the same results as
+   DoIntTest().
+
+   19.10.26 Original    By: ACRM
+*/
+static int SelectInt(int *column, int comparison, int value, int *sel,
+                     int NSel, int *out)
+{
+   int i,
+       row,
+       NOut = 0;
+
+   switch(comparison)
+   {
+   case COMP_EQ:
+      SELECTLOOP(column[row] == value);
+      break;
+   case COMP_NE:
+      SELECTLOOP(column[row] != value);
+      break;
+   case COMP_LT:
+      SELECTLOOP(column[row] <  value);
+      break;
+   case COMP_LE:
+      SELECTLOOP(column[row] <= value);
+      break;
+   case COMP_GT:
+      SELECTLOOP(column[row] >  value);
+      break;
+   case COMP_GE:
+      SELECTLOOP(column[row] >= value);
+      break;
+   default:
+      break;
+   }
+
+   return(NOut);
+}
+
+
+/************************************************************************/
+/*>static int SelectCode(unsigned char *column, uint64_t pass, int *sel,
+                         int NSel, int *out)
+   ---------------------------------------------------------------------
+   Input:   unsigned char *column   Code for each entry
+            uint64_t      pass      Bits of the codes which pass
+            int           *sel      Entries to test
+            int           NSel      Number of them
+   Output:  int           *out      Entries which pass
+   Returns: int                     Number which pass
+
+   Kernel for the tests on coded fields.
+
+   19.10.26 Original    By: ACRM
+*/
+static int SelectCode(unsigned char *column, uint64_t pass, int *sel,
+                      int NSel, int *out)
+{
+   int i,
+       row,
+       NOut = 0;
+
+   SELECTLOOP((pass >> column[row]) & 1);
+
+   return(NOut);
+}
+
+
+/************************************************************************/
+/*>static int SelectRows(DATA **rows, WHERE *wh, int *sel, int NSel,
+                         int *out, BOOL *ok)
+   -----------------------------------------------------------------
+   Input:   DATA  **rows      The entries
+            WHERE *wh         The test
+            int   *sel        Entries to test
+            int   NSel        Number of them
+   Output:  int   *out        Entries which pass
+            BOOL  *ok         FALSE if an error occurred (not changed
+                              otherwise)
+   Returns: int               Number which pass
+
+   Kernel for the other tests, which calls TestEntry() for each entry.
+
+   19.10.26 Original    By: ACRM
+*/
+static int SelectRows(DATA **rows, WHERE *wh, int *sel, int NSel,
+                      int *out, BOOL *ok)
+{
+   int i,
+       row,
+       NOut = 0;
+
+   SELECTLOOP(TestEntry(rows[row], wh, ok));
+
+   return(NOut);
+}
+
+
+/************************************************************************/
+/*>static unsigned char *GetSet(COLUMNS *cols, int level)
+   -------------------------------------------------------
+   I/O:     COLUMNS       *cols     The columns
+   Input:   int           level     Level in the stack (0...)
+   Returns: unsigned char *         The set at that level. NULL if no
+                                    memory
+
+   19.10.26 Original    By: ACRM
+*/
+static unsigned char *GetSet(COLUMNS *cols, int level)
+{
+   if((cols->sets[level] == NULL) &&
+      ((cols->sets[level] = (unsigned char *)ArenaAlloc(gDataArena,
+                                                         cols->NRows+1))
+       ==NULL))
+      return(NULL);
+   return(cols->sets[level]);
+}
@@ -0,0 +1,26 @@
+BOOL BatchMatch(WHERE *wh, int StackDepth, BOOL indexed, int *cand,
+                int NCand, char *zones)
+;
+int ChainFilter(WHERE *wh, int StackDepth)
+;
+BOOL UseBatches(void)
+;
+int *BatchEntries(WHERE *wh, int StackDepth, unsigned char **pSet,
+                  int *NEntries)
+;
+BOOL BatchLogical(WHERE *wh, int *StackDepth)
+;
+int BatchCount(int StackDepth)
+;
+BOOL BatchResult(void)
+;
+COLUMNS *GetColumns(void)
+;
+int *ColumnLengths(COLUMNS *cols, int loop, int mode)
+;
+int LengthLoop(char *loopname)
+;
+uint64_t CodePass(char **values, int NValues, BOOL other, WHERE *wh)
+;
+void ColumnsMemory(MEMUSE *use)
+;
@@ -0,0 +1,568 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Bench.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Runs a file of benchmark queries against the loaded data and writes
+   the timings to stdout as JSON so that runs can be compared.
+
+   Each query in the file starts with a line `## name' and runs to the
+   next one. Its lines are handled exactly as if they had been typed at
+   the prompt except that the output of the search is discarded. Other
+   lines starting with a # are comments.
+
+   Every query is run once untimed (which builds anything done lazily,
+   such as the sequence index) and then the requested number of times.
+   For each query the report gives the number of rows displayed, the
+   time of the first run, the mean, median, 90th and 99th percentile
+   and maximum times and the rows displayed per second at the median.
+   The report also gives the time taken to read the data, the peak
+   resident set size of the process and the distribution of the times
+   of all the runs of all the queries. Times are wall clock times since
+   some searches are run in several threads.
+
+   A log of searches written by SET LOG (see Capture.c) is a benchmark
+   file in which each query has a comment `# rows n time_ms t' giving
+   the rows displayed and time taken when it was logged. These are
+   given in the report alongside the new figures and any query which
+   now displays a different number of rows is reported as changed. A
+   log may thus be replayed to check both the speed and the results of
+   a new build or data set.
+
+**************************************************************************
+
+   Usage:
+   ======
+   RunBenchmark() is called by main() for kabatman -b file
+   A search log is replayed with kabatman -b logfile -n 1
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+                  Reads the rows and times of logged searches and
+                  reports changes. Added the distribution of all times
+                  PeakRSS() is no longer static
+
+*************************************************************************/
+/* Includes
+*/
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define BENCHOUTPUT "/dev/null"        /* Where search output is sent   */
+#define BENCHBLOCK  16384              /* Arena block for the queries   */
+
+typedef struct _benchline
+{
+   struct _benchline *next;
+   char              *text;
+}  BENCHLINE;
+
+typedef struct _benchquery
+{
+   struct _benchquery *next;
+   BENCHLINE          *lines;
+   char               *name;
+   double             *times,
+                      first,
+                      LoggedTime;
+   int                rows,
+                      LoggedRows;
+}  BENCHQUERY;
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static BENCHQUERY *ReadBenchQueries(ARENA *arena, char *filename,
+                                    int repeats);
+static BOOL RunBenchQuery(BENCHQUERY *q, double *seconds);
+static void WriteBenchReport(FILE *fp, BENCHQUERY *queries, int repeats,
+                             double LoadTime, double TotalTime);
+static double Percentile(double *sorted, int n, double percent);
+static int CompareTimes(const void *t1, const void *t2);
+static int CountChanged(BENCHQUERY *queries);
+static void WriteAllTimes(FILE *fp, BENCHQUERY *queries, int repeats);
+
+
+/************************************************************************/
+/*>BOOL RunBenchmark(char *filename, int repeats, double LoadTime)
+   ---------------------------------------------------------------
+   Input:   char   *filename   File of benchmark queries
+            int    repeats     Number of timed runs of each query
+            double LoadTime    Seconds taken to read the data
+   Returns: BOOL               Success (FALSE if the file can't be read
+                               or a query fails or displays a different
+                               number of rows from when it was logged)
+
+   Reads the queries, runs each of them once untimed and then repeats
+   times and writes the report.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Fails if logged searches have changed
+*/
+BOOL RunBenchmark(char *filename, int repeats, double LoadTime)
+{
+   ARENA      *arena;
+   BENCHQUERY *queries,
+              *q;
+   double     start;
+   int        i;
+   BOOL       ok = TRUE;
+
+   if((arena = NewArena(BENCHBLOCK))==NULL)
+   {
+      fprintf(stderr,"Error: No memory for benchmark queries\n");
+      return(FALSE);
+   }
+   if((queries = ReadBenchQueries(arena, filename, repeats))==NULL)
+   {
+      FreeArena(arena);
+      return(FALSE);
+   }
+
+   start = WallTime();
+   for(q=queries; ok && q!=NULL; NEXT(q))
+   {
+      ok = RunBenchQuery(q, &(q->first));
+      for(i=0; ok && i<repeats; i++)
+         ok = RunBenchQuery(q, &(q->times[i]));
+   }
+
+   if(ok)
+   {
+      WriteBenchReport(stdout, queries, repeats, LoadTime,
+                       WallTime() - start);
+
+      for(q=queries; q!=NULL; NEXT(q))
+      {
+         if((q->LoggedRows >= 0) && (q->rows != q->LoggedRows))
+         {
+            fprintf(stderr,"Error: Query %s displayed %d rows (%d when \
+logged)\n", q->name, q->rows, q->LoggedRows);
+            ok = FALSE;
+         }
+      }
+   }
+
+   FreeArena(arena);
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>double WallTime(void)
+   ---------------------
+   Returns: double     Wall clock time in seconds
+
+   19.10.26 Original    By: ACRM
+*/
+double WallTime(void)
+{
+   struct timeval tv;
+
+   gettimeofday(&tv, NULL);
+   return((double)tv.tv_sec + (double)tv.tv_usec / 1.0e6);
+}
+
+
+/************************************************************************/
+/*>static BENCHQUERY *ReadBenchQueries(ARENA *arena, char *filename,
+                                       int repeats)
+   -----------------------------------------------------------------
+   I/O:     ARENA      *arena     Arena for the queries
+   Input:   char       *filename  File of benchmark queries
+            int        repeats    Number of timed runs of each query
+   Returns: BENCHQUERY *          Linked list of queries. NULL if the
+                                  file can't be read, has no queries or
+                                  there is no memory
+
+   Reads the benchmark query file. Blank lines and comments are
+   dropped; anything before the first query is ignored. The comment
+   giving the rows and time of a logged search is kept with its query.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Reads the rows and time of logged searches
+*/
+static BENCHQUERY *ReadBenchQueries(ARENA *arena, char *filename,
+                                    int repeats)
+{
+   FILE       *fp;
+   BENCHQUERY *queries = NULL,
+              *q       = NULL,
+              *NewQuery;
+   BENCHLINE  *line    = NULL,
+              *NewLine;
+   char       buffer[2*MAXBUFF],
+              *p;
+   BOOL       ok       = TRUE;
+   double     LoggedTime;
+   int        LoggedRows;
+
+   if((fp=fopen(filename,"r"))==NULL)
+   {
+      fprintf(stderr,"Error: Unable to read benchmark file %s\n",
+              filename);
+      return(NULL);
+   }
+
+   while(ok && fgets(buffer,2*MAXBUFF,fp))
+   {
+      TERMINATE(buffer);
+      KILLLEADSPACES(p,buffer);
+
+      if(!strncmp(p,"##",2))                /* Start of a new query     */
+      {
+         KILLLEADSPACES(p,p+2);
+         if(((NewQuery = (BENCHQUERY *)ArenaAlloc(arena,
+                                                  sizeof(BENCHQUERY)))
+             ==NULL) ||
+            ((NewQuery->name = (char *)ArenaAlloc(arena, strlen(p)+1))
+             ==NULL) ||
+            ((NewQuery->times = (double *)ArenaAlloc(arena,
+                                           repeats * sizeof(double)))
+             ==NULL))
+         {
+            ok = FALSE;
+            break;
+         }
+         strcpy(NewQuery->name, p);
+         NewQuery->next  = NULL;
+         NewQuery->lines = NULL;
+         NewQuery->rows  = 0;
+         NewQuery->first = 0.0;
+         NewQuery->LoggedRows = (-1);
+         NewQuery->LoggedTime = 0.0;
+
+         if(q == NULL)
+            queries = NewQuery;
+         else
+            q->next = NewQuery;
+         q    = NewQuery;
+         line = NULL;
+      }
+      else if((q != NULL) &&
+              (sscanf(p,"# rows %d time_ms %lf",&LoggedRows,&LoggedTime)
+               ==2))                        /* Logged search            */
+      {
+         q->LoggedRows = LoggedRows;
+         q->LoggedTime = LoggedTime / 1000.0;
+      }
+      else if((p[0] != '#') && (p[0] != '\0') && (q != NULL))
+      {
+         if(((NewLine = (BENCHLINE *)ArenaAlloc(arena, sizeof(BENCHLINE)))
+             ==NULL) ||
+            ((NewLine->text = (char *)ArenaAlloc(arena, strlen(p)+1))
+             ==NULL))
+         {
+            ok = FALSE;
+            break;
+         }
+         strcpy(NewLine->text, p);
+         NewLine->next = NULL;
+
+         if(line == NULL)
+            q->lines = NewLine;
+         else
+            line->next = NewLine;
+         line = NewLine;
+      }
+   }
+   fclose(fp);
+
+   if(!ok)
+   {
+      fprintf(stderr,"Error: No memory for benchmark queries\n");
+      return(NULL);
+   }
+   if(queries == NULL)
+      fprintf(stderr,"Error: No queries in benchmark file %s\n",filename);
+
+   return(queries);
+}
+
+
+/************************************************************************/
+/*>static BOOL RunBenchQuery(BENCHQUERY *q, double *seconds)
+   ---------------------------------------------------------
+   I/O:     BENCHQUERY *q         The query. The number of rows is set
+   Output:  double     *seconds   Time taken
+   Returns: BOOL                  Success (FALSE if a search failed)
+   Globals: int        gNRows     Rows displayed by the last search
+
+   Gives each line of the query to HandleCommand() with the search
+   output sent to BENCHOUTPUT. gNRows is only set once a search has
+   displayed its results so a search which fails leaves it at -1.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL RunBenchQuery(BENCHQUERY *q, double *seconds)
+{
+   BENCHLINE *line;
+   char      buffer[2*MAXBUFF];
+   int       Mode = 0;
+   double    start;
+
+   start = WallTime();
+   for(line=q->lines; line!=NULL; NEXT(line))
+   {
+      /* HandleCommand() may modify the line                            */
+      strcpy(buffer, line->text);
+      gNRows = (-1);
+      HandleCommand(buffer, &Mode, BENCHOUTPUT);
+
+      if((line->text[0] == ';') || (line->text[0] == '.'))
+      {
+         if(gNRows < 0)
+         {
+            fprintf(stderr,"Error: Benchmark query %s failed\n",q->name);
+            return(FALSE);
+         }
+         q->rows = gNRows;
+      }
+   }
+   *seconds = WallTime() - start;
+
+   if(Mode != 0)
+   {
+      fprintf(stderr,"Error: Benchmark query %s is not ended with ;\n",
+              q->name);
+      return(FALSE);
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static void WriteBenchReport(FILE *fp, BENCHQUERY *queries,
+                                int repeats, double LoadTime,
+                                double TotalTime)
+   ------------------------------------------------------------
+   Input:   FILE       *fp         Output file
+            BENCHQUERY *queries    The queries, all run
+            int        repeats     Number of timed runs of each query
+            double     LoadTime    Seconds taken to read the data
+            double     TotalTime   Seconds taken to run the queries
+   Globals: DATA       *gData      The data
+
+   Writes the benchmark report as JSON. Times are in milliseconds
+   except for the load and total times which are in seconds. The
+   times of each query are sorted in place.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Added the distribution of all times and the rows and times
+            of logged searches
+*/
+static void WriteBenchReport(FILE *fp, BENCHQUERY *queries, int repeats,
+                             double LoadTime, double TotalTime)
+{
+   BENCHQUERY *q;
+   DATA       *d;
+   double     sum,
+              median;
+   int        NData = 0,
+              i;
+
+   for(d=gData; d!=NULL; NEXT(d))
+      NData++;
+
+   fprintf(fp,"{\n");
+   fprintf(fp,"  \"version\": \"V2.27\",\n");
+   fprintf(fp,"  \"dataset\": \"%s\",\n", gFileDate);
+   fprintf(fp,"  \"entries\": %d,\n", NData);
+   fprintf(fp,"  \"threads\": %d,\n", gNThreads);
+   fprintf(fp,"  \"repeats\": %d,\n", repeats);
+   fprintf(fp,"  \"load_s\": %.4f,\n", LoadTime);
+   fprintf(fp,"  \"total_s\": %.4f,\n", TotalTime);
+   fprintf(fp,"  \"peak_rss_kb\": %ld,\n", PeakRSS());
+   WriteAllTimes(fp, queries, repeats);
+   fprintf(fp,"  \"changed\": %d,\n", CountChanged(queries));
+   fprintf(fp,"  \"queries\": [\n");
+
+   for(q=queries; q!=NULL; NEXT(q))
+   {
+      qsort(q->times, repeats, sizeof(double), CompareTimes);
+      for(i=0, sum=0.0; i<repeats; i++)
+         sum += q->times[i];
+      median = Percentile(q->times, repeats, 50.0);
+
+      fprintf(fp,"    {\"name\": \"%s\", \"rows\": %d, ", q->name,
+              q->rows);
+      fprintf(fp,"\"first_ms\": %.3f, \"mean_ms\": %.3f, ",
+              1000.0 * q->first, 1000.0 * sum / repeats);
+      fprintf(fp,"\"p50_ms\": %.3f, \"p90_ms\": %.3f, ",
+              1000.0 * median, 1000.0 * Percentile(q->times, repeats, 90.0));
+      fprintf(fp,"\"p99_ms\": %.3f, \"max_ms\": %.3f, ",
+              1000.0 * Percentile(q->times, repeats, 99.0),
+              1000.0 * q->times[repeats-1]);
+      fprintf(fp,"\"rows_per_s\": %.1f",
+              ((median > 0.0) ? q->rows / median : 0.0));
+      if(q->LoggedRows >= 0)
+      {
+         fprintf(fp,", \"logged_rows\": %d, \"logged_ms\": %.3f, ",
+                 q->LoggedRows, 1000.0 * q->LoggedTime);
+         fprintf(fp,"\"changed\": %s",
+                 ((q->rows != q->LoggedRows) ? "true" : "false"));
+      }
+      fprintf(fp,"}%s\n", ((q->next != NULL) ? "," : ""));
+   }
+
+   fprintf(fp,"  ]\n");
+   fprintf(fp,"}\n");
+}
+
+
+/************************************************************************/
+/*>static double Percentile(double *sorted, int n, double percent)
+   ---------------------------------------------------------------
+   Input:   double *sorted    Values in ascending order
+            int    n          Number of values
+            double percent    Percentile required
+   Returns: double            The percentile (nearest rank)
+
+   19.10.26 Original    By: ACRM
+*/
+static double Percentile(double *sorted, int n, double percent)
+{
+   int rank;
+
+   rank = (int)(percent * n / 100.0 + 0.999999);
+   if(rank < 1) rank = 1;
+   if(rank > n) rank = n;
+   return(sorted[rank-1]);
+}
+
+
+/************************************************************************/
+/*>long PeakRSS(void)
+   ------------------
+   Returns: long        Peak resident set size in kilobytes
+
+   19.10.26 Original    By: ACRM
+   19.10.26 No longer static; also used by SHOW MEMORY
+*/
+long PeakRSS(void)
+{
+   struct rusage usage;
+
+   if(getrusage(RUSAGE_SELF, &usage))
+      return(0);
+   return((long)usage.ru_maxrss);
+}
+
+
+/************************************************************************/
+/*>static int CompareTimes(const void *t1, const void *t2)
+   -------------------------------------------------------
+   qsort() comparison for times.
+
+   19.10.26 Original    By: ACRM
+*/
+static int CompareTimes(const void *t1, const void *t2)
+{
+   double d1 = *(double *)t1,
+          d2 = *(double *)t2;
+
+   return((d1 < d2) ? (-1) : ((d1 > d2) ? 1 : 0));
+}
+
+
+/************************************************************************/
+/*>static int CountChanged(BENCHQUERY *queries)
+   --------------------------------------------
+   Input:   BENCHQUERY *queries    The queries, all run
+   Returns: int                    Number of logged searches which now
+                                   display a different number of rows
+
+   19.10.26 Original    By: ACRM
+*/
+static int CountChanged(BENCHQUERY *queries)
+{
+   BENCHQUERY *q;
+   int        NChanged = 0;
+
+   for(q=queries; q!=NULL; NEXT(q))
+   {
+      if((q->LoggedRows >= 0) && (q->rows != q->LoggedRows))
+         NChanged++;
+   }
+   return(NChanged);
+}
+
+
+/************************************************************************/
+/*>static void WriteAllTimes(FILE *fp, BENCHQUERY *queries, int repeats)
+   ---------------------------------------------------------------------
+   Input:   FILE       *fp         Output file
+            BENCHQUERY *queries    The queries, all run
+            int        repeats     Number of timed runs of each query
+
+   Writes the median, 90th and 99th percentile and maximum of the times
+   of all the timed runs of all the queries. For a replayed log this is
+   the distribution of the times of the searches in the workload.
+
+   19.10.26 Original    By: ACRM
+*/
+static void WriteAllTimes(FILE *fp, BENCHQUERY *queries, int repeats)
+{
+   BENCHQUERY *q;
+   double     *times;
+   int        NTimes = 0,
+              i;
+
+   for(q=queries; q!=NULL; NEXT(q))
+      NTimes += repeats;
+
+   if((times = (double *)malloc(NTimes * sizeof(double)))==NULL)
+      return;
+
+   for(q=queries, NTimes=0; q!=NULL; NEXT(q))
+   {
+      for(i=0; i<repeats; i++)
+         times[NTimes++] = q->times[i];
+   }
+   qsort(times, NTimes, sizeof(double), CompareTimes);
+
+   fprintf(fp,"  \"all_p50_ms\": %.3f, \"all_p90_ms\": %.3f, ",
+           1000.0 * Percentile(times, NTimes, 50.0),
+           1000.0 * Percentile(times, NTimes, 90.0));
+   fprintf(fp,"\"all_p99_ms\": %.3f, \"all_max_ms\": %.3f,\n",
+           1000.0 * Percentile(times, NTimes, 99.0),
+           1000.0 * times[NTimes-1]);
+
+   free(times);
+}
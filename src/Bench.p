@@ -0,0 +1,6 @@
+BOOL RunBenchmark(char *filename, int repeats, double LoadTime)
+;
+double WallTime(void)
+;
+long PeakRSS(void)
+;
@@ -3,11 +3,11 @@
    Program:    KabatMan
    File:       BuildSelect.c
    
-   Version:    V2.26
-   Date:       04.10.19
+   Version:    V2.27
+   Date:       19.10.26
    Function:   Database program for reading Kabat sequence files
    
-   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2019
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
    Author:     Dr. Andrew C. R. Martin
    Address:    Biomolecular Structure and Modelling Unit,
                Department of Biochemistry and Molecular Biology,
@@ -67,6 +67,9 @@
    V2.24 28.02.05 blGetWord() takes extra parameter
    V2.25 24.08.06 Skipped
    V2.26 04.10.19 Changed all bioplib calls to blXXX()
+   V2.27 19.10.26 Added COUNT, MIN, MAX and AVG aggregate functions
+                  Added DISTINCT
+                  Quotes are removed from parameters
 
 *************************************************************************/
 /* Includes
@@ -92,6 +95,7 @@
    Returns: BOOL                      Success (FALSE indicates syntax 
                                       error or memory allocation error)
    Globals: SELECTION *gSelectClause  The selection linked list
+            BOOL      gDistinct       Set by DISTINCT
 
    Parses a select clause and creates a linked list of selection actions.
    The word `SELECT' within the input buffer is ignored.
@@ -99,12 +103,16 @@
    20.04.94 Original   By: ACRM
    23.06.95 Added missing return value
    28.02.05 Added word length parameter for blGetWord()
+   19.10.26 Added aggregate functions. Allocation moved to AddSelection()
+            Added DISTINCT
 */
 BOOL BuildSelect(char *buffer)
 {
    char      *pch,
-             word[MAXBUFF];
-   int       i;
+             word[MAXBUFF],
+             field[MAXBUFF];
+   int       i,
+             aggregate;
 
    pch=buffer;
 
@@ -113,38 +121,42 @@ BOOL BuildSelect(char *buffer)
    {
       pch=blGetWord(pch,word,MAXBUFF);
 
-      if(blUpstrcmp(word,"SELECT")) /* If the word is not `SELECT'        */
+      if(!blUpstrcmp(word,"DISTINCT"))
       {
+         gDistinct = TRUE;
+      }
+      else if(blUpstrcmp(word,"SELECT")) /* If the word is not `SELECT'   */
+      {
+         /* See if it's an aggregate function; if so field contains the
+            field name from inside the brackets
+         */
+         aggregate = GetAggregate(word, field);
+
+         if(aggregate == AGG_COUNT)
+         {
+            if(!AddSelection(0, AGG_COUNT, field))
+               return(FALSE);
+            continue;
+         }
+         
          /* Run through the field list to see if we get a match         */
          for(i=0; gField[i].type; i++)
          {
-            if(!blUpstrncmp(word,gField[i].name,gField[i].length))
+            if(!blUpstrncmp(field,gField[i].name,gField[i].length))
             {
                /* We've got a match in our array of fields, so allocate 
                   the next entry in our linked list of selections.
                */
-               if(gSelectClause == NULL)
+               if((aggregate != AGG_NONE) && 
+                  !IsIntegerField(gField[i].type))
                {
-                  INIT(gSelectClause,SELECTION);
-                  gCurrentSelect = gSelectClause;
-               }
-               else
-               {
-                  ALLOCNEXT(gCurrentSelect,SELECTION);
-               }
-
-               /* Check allocation was OK                               */
-               if(gCurrentSelect==NULL)
-               {
-                  fprintf(stderr,"Error: No memory to build selection\n");
+                  fprintf(stderr,"Error: MIN, MAX and AVG may only be \
+used with LENGTH, DATE and COMPLETE\n");
                   return(FALSE);
                }
-
-               /* Fill in the field type for this selection sub-clause  */
-               gCurrentSelect->type = gField[i].type;
-
-               /* Now see if there is a parameter specified             */
-               FillParameter(gCurrentSelect->param, word);
+               
+               if(!AddSelection(gField[i].type, aggregate, field))
+                  return(FALSE);
 
                /* Break out of FIELD array                              */
                break;
@@ -162,6 +174,90 @@ BOOL BuildSelect(char *buffer)
    return(TRUE);
 }
 
+/************************************************************************/
+/*>BOOL AddSelection(int type, int aggregate, char *word)
+   ------------------------------------------------------
+   Input:   int       type            Field type
+            int       aggregate       Aggregate function (AGG_xxxx)
+            char      *word           The field (from which any parameter
+                                      is taken)
+   Returns: BOOL                      Success (FALSE if no memory)
+   Globals: SELECTION *gSelectClause  The selection linked list
+
+   Adds an item to the end of the selection linked list
+
+   19.10.26 Original   By: ACRM (taken from BuildSelect())
+*/
+BOOL AddSelection(int type, int aggregate, char *word)
+{
+   if(gSelectClause == NULL)
+   {
+      INIT(gSelectClause,SELECTION);
+      gCurrentSelect = gSelectClause;
+   }
+   else
+   {
+      ALLOCNEXT(gCurrentSelect,SELECTION);
+   }
+   
+   /* Check allocation was OK                                           */
+   if(gCurrentSelect==NULL)
+   {
+      fprintf(stderr,"Error: No memory to build selection\n");
+      return(FALSE);
+   }
+   
+   /* Fill in the field type for this selection sub-clause              */
+   gCurrentSelect->type      = type;
+   gCurrentSelect->aggregate = aggregate;
+   
+   /* Now see if there is a parameter specified                         */
+   FillParameter(gCurrentSelect->param, word);
+
+   return(TRUE);
+}
+
+/************************************************************************/
+/*>int GetAggregate(char *word, char *field)
+   -----------------------------------------
+   Input:   char *word    A word from a SELECT or ORDER BY clause
+   Output:  char *field   The field to which the aggregate applies or
+                          a copy of word if this is not an aggregate
+   Returns: int           Aggregate function (AGG_xxxx)
+
+   Checks whether a word is an aggregate function (COUNT, MIN(field),
+   MAX(field) or AVG(field)) and extracts the field from within the
+   brackets. Thus if word = AVG(LENGTH(H3)), field will be LENGTH(H3).
+
+   19.10.26 Original    By: ACRM
+*/
+int GetAggregate(char *word, char *field)
+{
+   char *open,
+        *close;
+   int  aggregate = AGG_NONE;
+
+   strcpy(field, word);
+
+   if(!blUpstrncmp(word,"COUNT",5))
+      aggregate = AGG_COUNT;
+   else if(!blUpstrncmp(word,"MIN(",4))
+      aggregate = AGG_MIN;
+   else if(!blUpstrncmp(word,"MAX(",4))
+      aggregate = AGG_MAX;
+   else if(!blUpstrncmp(word,"AVG(",4))
+      aggregate = AGG_AVG;
+
+   if((aggregate != AGG_NONE) && ((open = strchr(word,'('))!=NULL))
+   {
+      strcpy(field, open+1);
+      if((close = strrchr(field,')'))!=NULL)
+         *close = '\0';
+   }
+
+   return(aggregate);
+}
+
 /************************************************************************/
 /*>void FillParameter(char *param, char *word)
    -------------------------------------------
@@ -170,9 +266,12 @@ BOOL BuildSelect(char *buffer)
 
    Copies a parameter (if one exists) out of word into parameter. 
    Thus if word = TEST(PARAM), then param will be PARAM. If no parameter
-   is specified, param will contain a blank string.
+   is specified, param will contain a blank string. Any quotes around
+   the parameter are removed so that IDENTITY() may name entries such as
+   "MUC1-1'CL".
 
    20.04.94 Original    By: ACRM
+   19.10.26 Removes quotes with CopyUnquoted()
 */
 void FillParameter(char *param, char *word)
 {
@@ -188,7 +287,7 @@ void FillParameter(char *param, char *word)
          if((pw2 = strchr(pw1,')'))!=NULL)
             *pw2 = '\0';                          /* Terminate at )     */
          
-         strcpy(param,pw1);
+         CopyUnquoted(param,pw1);
       }
    }
 }
@@ -199,9 +298,12 @@ void FillParameter(char *param, char *word)
    Clears the current selection
 
    21.04.94 Original    By: ACRM
+   19.10.26 Also clears gDistinct
 */
 void ClearSelect(void)
 {
+   gDistinct = FALSE;
+   
    if(gSelectClause != NULL)
    {
       FREELIST(gSelectClause,SELECTION);
@@ -1,5 +1,9 @@
 BOOL BuildSelect(char *buffer)
 ;
+BOOL AddSelection(int type, int aggregate, char *word)
+;
+int GetAggregate(char *word, char *field)
+;
 void FillParameter(char *param, char *word)
 ;
 void ClearSelect(void)
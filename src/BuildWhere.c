@@ -3,11 +3,11 @@
    Program:    KabatMan
    File:       BuildWhere.c
    
-   Version:    V2.26
-   Date:       05.10.19
+   Version:    V2.27
+   Date:       19.10.26
    Function:   Database program for reading Kabat sequence files
    
-   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2019
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
    Author:     Dr. Andrew C. R. Martin
    Address:    Biomolecular Structure and Modelling Unit,
                Department of Biochemistry and Molecular Biology,
@@ -69,6 +69,14 @@
    V2.24 28.02.05 blGetWord() takes extra parameter
    V2.25 24.08.06 Skipped
    V2.26 04.10.19 Changed all bioplib calls to blXXX()
+   V2.27 19.10.26 Added LIMIT, OFFSET, ORDER BY and GROUP BY handling
+                  WHERE data converted to upper case and ungapped once
+                  when the clause is built
+                  The ungapped pattern is prepared for SeqMatch()
+                  Added MISMATCH(n) and SIMILAR(n) comparisons
+                  LIMIT must be positive
+                  Added WITHIN(n)
+                  Quote removal split out into CopyUnquoted()
 
 *************************************************************************/
 /* Includes
@@ -100,11 +108,14 @@
    The word `WHERE' within the input buffer is ignored.
 
    Currently the logic of the WHERE clause must be expressed in RPN.
+   The clause may end with ORDER BY field [ASC|DESC] and
+   LIMIT n [OFFSET m].
 
    20.04.94 Original   By: ACRM
    22.06.95 Doubled length of word buffer
    23.06.95 Added missing return value
    28.02.05 Added word length parameter to blGetWord()
+   19.10.26 Added LIMIT, OFFSET and ORDER BY
 */
 BOOL BuildWhere(char *buffer)
 {
@@ -119,7 +130,25 @@ BOOL BuildWhere(char *buffer)
 
       if(blUpstrcmp(word,"WHERE"))  /* If the word is not `WHERE'         */
       {
-         if(!CheckForSetOper(word, &error))
+         /* These must be checked before the set operators as ORDER
+            would otherwise be taken as OR
+         */
+         if(!blUpstrcmp(word,"LIMIT") || !blUpstrcmp(word,"OFFSET"))
+         {
+            pch = HandleLimitClause(pch,word,&error,2*MAXBUFF);
+            if(error) return(FALSE);
+         }
+         else if(!blUpstrcmp(word,"ORDER"))
+         {
+            pch = HandleOrderClause(pch,word,&error,2*MAXBUFF);
+            if(error) return(FALSE);
+         }
+         else if(!blUpstrcmp(word,"GROUP"))
+         {
+            pch = HandleGroupClause(pch,word,&error,2*MAXBUFF);
+            if(error) return(FALSE);
+         }
+         else if(!CheckForSetOper(word, &error))
          {
             if(error) return(FALSE);
             
@@ -207,6 +236,8 @@ BOOL CheckForSetOper(char *word, BOOL *error)
 
    20.04.94 Original    By: ACRM
    28.02.05 Added maxlength and added word length parameter to blGetWord()
+   19.10.26 Checks the pattern length for MISMATCH(), SIMILAR() and
+            WITHIN()
 */
 char *HandleWhereSubClause(char *buffer, char *word, BOOL *error,
                            int maxlength)
@@ -268,6 +299,24 @@ char *HandleWhereSubClause(char *buffer, char *word, BOOL *error,
 
          SetWhereData(gCurrentWhere,word);
 
+         if(((gCurrentWhere->comparison == COMP_MISMATCH) ||
+             (gCurrentWhere->comparison == COMP_SIMILAR)) &&
+            ((gCurrentWhere->matcher.length < 1) ||
+             (gCurrentWhere->matcher.length > MAXMATCHLEN)))
+         {
+            fprintf(stderr,"Error: MISMATCH() and SIMILAR() require a \
+sequence of 1 to %d residues\n", MAXMATCHLEN);
+            *error = TRUE;
+            return(NULL);
+         }
+         if((gCurrentWhere->comparison == COMP_WITHIN) &&
+            (gCurrentWhere->matcher.length < 1))
+         {
+            fprintf(stderr,"Error: WITHIN() requires a sequence\n");
+            *error = TRUE;
+            return(NULL);
+         }
+
          /* Return the new pointer to the next word                     */
          return(pch);
       }  /* Found field in FIELD array                                  */
@@ -279,6 +328,145 @@ char *HandleWhereSubClause(char *buffer, char *word, BOOL *error,
    return(NULL);
 }
    
+/************************************************************************/
+/*>char *HandleLimitClause(char *buffer, char *word, BOOL *error,
+                           int maxlength)
+   --------------------------------------------------------------
+   Input:   char  *buffer      Current start of next word in buffer
+            char  *word        The current word (LIMIT or OFFSET) - 
+                               modified on exit
+            int   maxlength    Maximum word length
+   Output:  BOOL  *error       TRUE if an error occurred
+   Returns: char  *            Pointer to start of next word in buffer 
+                               after processing this sub-clause
+   Globals: int   gLimit       Maximum number of hits to display
+            int   gOffset      Number of hits to skip before display
+            BOOL  gLimitError  Set if the value is missing or invalid
+
+   Reads the value following a LIMIT or OFFSET keyword. LIMIT must be
+   positive since a gLimit of 0 means no limit; OFFSET may be 0. If
+   the value is not valid, gLimitError is set so that the search is
+   not run without the limit.
+
+   19.10.26 Original    By: ACRM
+*/
+char *HandleLimitClause(char *buffer, char *word, BOOL *error,
+                        int maxlength)
+{
+   char  *pch = buffer;
+   int   *value,
+         n;
+
+   *error = FALSE;
+   value  = (blUpstrcmp(word,"LIMIT") ? &gOffset : &gLimit);
+   
+   pch = blGetWord(pch,word,maxlength);
+   if(!word[0] || (sscanf(word,"%d",&n) != 1) ||
+      (n < ((value == &gLimit) ? 1 : 0)))
+   {
+      if(value == &gLimit)
+         fprintf(stderr,"Error: LIMIT requires a positive integer\n");
+      else
+         fprintf(stderr,"Error: OFFSET requires a non-negative \
+integer\n");
+      gLimitError = TRUE;
+      *error      = TRUE;
+      return(NULL);
+   }
+
+   *value = n;
+   return(pch);
+}
+
+/************************************************************************/
+/*>char *HandleOrderClause(char *buffer, char *word, BOOL *error,
+                           int maxlength)
+   --------------------------------------------------------------
+   Input:   char  *buffer      Current start of next word in buffer
+            char  *word        The current word (ORDER) - modified on exit
+            int   maxlength    Maximum word length
+   Output:  BOOL  *error       TRUE if an error occurred
+   Returns: char  *            Pointer to start of next word in buffer 
+                               after processing this sub-clause
+   Globals: SELECTION *gOrderBy    The field on which to sort
+            BOOL      gOrderDesc   Sort in descending order?
+
+   Reads an ORDER BY field [ASC|DESC] sub-clause. The field may be an
+   aggregate function if the query is grouped.
+
+   19.10.26 Original    By: ACRM
+*/
+char *HandleOrderClause(char *buffer, char *word, BOOL *error,
+                        int maxlength)
+{
+   char  *pch = buffer,
+         *next,
+         field[MAXBUFF];
+   int   i,
+         aggregate;
+
+   *error = FALSE;
+
+   /* Get the word BY                                                   */
+   pch = blGetWord(pch,word,maxlength);
+   if(blUpstrcmp(word,"BY"))
+   {
+      fprintf(stderr,"Error: ORDER must be followed by BY\n");
+      *error = TRUE;
+      return(NULL);
+   }
+
+   /* Get the field and find it in the field list                       */
+   pch = blGetWord(pch,word,MAXBUFF);
+   aggregate = GetAggregate(word, field);
+   for(i=0; gField[i].type; i++)
+   {
+      if(!blUpstrncmp(field,gField[i].name,gField[i].length))
+         break;
+   }
+
+   if((aggregate != AGG_COUNT) &&
+      (!gField[i].type || !IsSortableField(gField[i].type) ||
+       ((aggregate != AGG_NONE) && !IsIntegerField(gField[i].type))))
+   {
+      fprintf(stderr,"Error: Cannot ORDER BY %s\n",word);
+      *error = TRUE;
+      return(NULL);
+   }
+
+   if(gOrderBy == NULL)
+   {
+      INIT(gOrderBy,SELECTION);
+      if(gOrderBy == NULL)
+      {
+         fprintf(stderr,"Error: No memory to build where clause\n");
+         *error = TRUE;
+         return(NULL);
+      }
+   }
+   gOrderBy->type      = (aggregate == AGG_COUNT) ? 0 : gField[i].type;
+   gOrderBy->aggregate = aggregate;
+   FillParameter(gOrderBy->param, field);
+   gOrderDesc          = FALSE;
+
+   /* See if the next word is ASC or DESC                               */
+   if(pch != NULL)
+   {
+      next = blGetWord(pch,word,maxlength);
+      if(!blUpstrncmp(word,"ASC",3))
+      {
+         pch = next;
+      }
+      else if(!blUpstrncmp(word,"DESC",4))
+      {
+         gOrderDesc = TRUE;
+         pch        = next;
+      }
+   }
+
+   return(pch);
+}
+
 /************************************************************************/
 /*>BOOL SetComparison(WHERE *p, char *word)
    ----------------------------------------
@@ -288,14 +476,21 @@ char *HandleWhereSubClause(char *buffer, char *word, BOOL *error,
 
    Sets the comparison field of the structure according to the given
    symbol. = or == are accepted for equal and != or <> are accepted for
-   not equal.
+   not equal. MISMATCH(n) and SIMILAR(n) (no space before the bracket)
+   allow n substitutions or n edits in a sequence substring match and
+   WITHIN(n) allows n edits between the whole sequence and the data.
+   These set p->matcher.errors; p->type must already be set.
 
    20.04.94 Original    By: ACRM
    21.04.94 Added INC to substring options
    16.03.95 Added FORTRAN style (EQ, NE, etc.) comparisons
+   19.10.26 Added MISMATCH(n) and SIMILAR(n)
+   19.10.26 Added WITHIN(n)
 */
 BOOL SetComparison(WHERE *p, char *word)
 {
+   int errors;
+   
    UPPER(word);
    
    if(!strcmp(word, "=")  || 
@@ -336,6 +531,28 @@ BOOL SetComparison(WHERE *p, char *word)
       p->comparison = COMP_GE;
       return(TRUE);
    }
+   else if(!strncmp(word, "MISMATCH(",9) ||
+           !strncmp(word, "SIMILAR(",8)  ||
+           !strncmp(word, "WITHIN(",7))
+   {
+      if(!IsSequenceField(p->type))
+      {
+         fprintf(stderr,"Error: MISMATCH(), SIMILAR() and WITHIN() may \
+only be used with sequence fields\n");
+         return(FALSE);
+      }
+      if((sscanf(strchr(word,'(')+1, "%d", &errors) != 1) ||
+         (errors < 0))
+      {
+         fprintf(stderr,"Error: Invalid number of errors (%s)\n",word);
+         return(FALSE);
+      }
+      p->comparison     = ((word[0] == 'M') ? COMP_MISMATCH :
+                           ((word[0] == 'S') ? COMP_SIMILAR :
+                            COMP_WITHIN));
+      p->matcher.errors = errors;
+      return(TRUE);
+   }
    else if(!strncmp(word, "CONT",4) || 
            !strncmp(word, "LIKE",4) || 
            !strncmp(word, "SIM",3)  || 
@@ -349,69 +566,242 @@ BOOL SetComparison(WHERE *p, char *word)
    return(FALSE);
 }
 
+/************************************************************************/
+/*>BOOL IsSequenceField(int type)
+   ------------------------------
+   Input:   int   type      Field type
+   Returns: BOOL            Is this a sequence field?
+
+   Tests whether a field is a chain, CDR or framework sequence.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL IsSequenceField(int type)
+{
+   switch(type)
+   {
+   case FIELD_LIGHT:
+   case FIELD_HEAVY:
+   case FIELD_L1:
+   case FIELD_L2:
+   case FIELD_L3:
+   case FIELD_H1:
+   case FIELD_H2:
+   case FIELD_H3:
+   case FIELD_LFR1:
+   case FIELD_LFR2:
+   case FIELD_LFR3:
+   case FIELD_LFR4:
+   case FIELD_HFR1:
+   case FIELD_HFR2:
+   case FIELD_HFR3:
+   case FIELD_HFR4:
+      return(TRUE);
+   default:
+      break;
+   }
+   return(FALSE);
+}
+
+/************************************************************************/
+/*>void CopyUnquoted(char *out, char *word)
+   ----------------------------------------
+   Input:   char  *word    The word to copy
+   Output:  char  *out     The word without its quotes
+
+   Copies a word. If the first character is a ' or " then it is skipped
+   and the copy ends at the last occurrence of the same quote, so a
+   quoted string may contain the other quote character (as in entry
+   names such as "MUC1-1'CL").
+
+   19.10.26 Original (from SetWhereData())   By: ACRM
+*/
+void CopyUnquoted(char *out, char *word)
+{
+   char *p;
+   int  len;
+
+   if((word[0] == '"') || (word[0] == '\''))
+   {
+      strcpy(out, word+1);
+      len = strlen(out);
+      for(p=out + len-1; p>=out; p--)
+      {
+         if(*p==word[0])
+         {
+            *p = '\0';
+            break;
+         }
+      }
+   }
+   else
+   {
+      strcpy(out, word);
+   }
+}
+
 /************************************************************************/
 /*>void SetWhereData(WHERE *wh, char *word)
    ----------------------------------------
    Input:   char  *word    The data to copy into the WHERE item
    Output:  WHERE *wh      wh->data will contain the word
+                           wh->pattern will contain the word without -'s
+                           wh->matcher is set up for wh->pattern
 
    Copies data into the where item data field, removing any leading or
-   trailing ' or "
+   trailing ' or ". The data are converted to upper case and a copy with
+   any -'s removed is made for searching sequences, so this need not be
+   done for each entry searched.
 
    20.04.94 Original    By: ACRM
    13.07.00 The check for trailing ' or " was actually stopping the string
             at the first occurrence rather than the last. Fixed this!
+   19.10.26 Converts to upper case and sets wh->pattern and wh->matcher
+            Quotes are removed by CopyUnquoted()
 */
 void SetWhereData(WHERE *wh, char *word)
 {  
-   char *p;
-   int  len;
+   char *p,
+        *q;
    
-   /* If the first character is a ' or " then skip it and end the string at
-      the last ' or "
-   */
-   if(word[0] == '"')
+   CopyUnquoted(wh->data, word);
+
+   UPPER(wh->data);
+   for(p=wh->data, q=wh->pattern; *p; p++)
+   {
+      if(*p != '-')
+         *(q++) = *p;
+   }
+   *q = '\0';
+
+   InitMatcher(wh->pattern, &(wh->matcher));
+}
+
+/************************************************************************/
+/*>char *HandleGroupClause(char *buffer, char *word, BOOL *error,
+                           int maxlength)
+   --------------------------------------------------------------
+   Input:   char  *buffer      Current start of next word in buffer
+            char  *word        The current word (GROUP) - modified on exit
+            int   maxlength    Maximum word length
+   Output:  BOOL  *error       TRUE if an error occurred
+   Returns: char  *            Pointer to start of next word in buffer 
+                               after processing this sub-clause
+   Globals: SELECTION *gGroupBy    The fields on which to group
+
+   Reads a GROUP BY field[, field...] sub-clause. The list of fields
+   ends at the first word which is not a field name.
+
+   19.10.26 Original    By: ACRM
+*/
+char *HandleGroupClause(char *buffer, char *word, BOOL *error,
+                        int maxlength)
+{
+   SELECTION *p = NULL;
+   char      *pch = buffer,
+             *next;
+   int       i;
+
+   *error = FALSE;
+
+   /* Get the word BY                                                   */
+   pch = blGetWord(pch,word,maxlength);
+   if(blUpstrcmp(word,"BY"))
    {
-      strcpy(wh->data, word+1);
-      len = strlen(wh->data);
-      for(p=wh->data + len-1; p>=wh->data; p--)
+      fprintf(stderr,"Error: GROUP must be followed by BY\n");
+      *error = TRUE;
+      return(NULL);
+   }
+
+   /* Find the end of any existing list                                 */
+   for(p=gGroupBy; p!=NULL && p->next!=NULL; NEXT(p)) ;
+
+   next = pch;
+   do
+   {
+      /* Get the field and find it in the field list                    */
+      next = blGetWord(next,word,MAXBUFF);
+      for(i=0; gField[i].type; i++)
       {
-         if(*p=='"')
-         {
-            *p = '\0';
+         if(!blUpstrncmp(word,gField[i].name,gField[i].length))
             break;
-         }
       }
-   }
-   else if(word[0] == '\'')
-   {
-      strcpy(wh->data, word+1);
-      len = strlen(wh->data);
-      for(p=wh->data + len-1; p>=wh->data; p--)
+
+      if(!gField[i].type)
       {
-         if(*p=='\'')
+         /* The first field must be valid; after that we have simply
+            reached the end of the list
+         */
+         if(p == NULL)
          {
-            *p = '\0';
-            break;
+            fprintf(stderr,"Error: Cannot GROUP BY %s\n",word);
+            *error = TRUE;
+            return(NULL);
          }
+         break;
       }
-   }
-   else
-   {
-      strcpy(wh->data, word);
-   }
+
+      if(!IsSortableField(gField[i].type))
+      {
+         fprintf(stderr,"Error: Cannot GROUP BY %s\n",word);
+         *error = TRUE;
+         return(NULL);
+      }
+
+      if(gGroupBy == NULL)
+      {
+         INIT(gGroupBy,SELECTION);
+         p = gGroupBy;
+      }
+      else
+      {
+         ALLOCNEXT(p,SELECTION);
+      }
+      if(p == NULL)
+      {
+         fprintf(stderr,"Error: No memory to build where clause\n");
+         *error = TRUE;
+         return(NULL);
+      }
+      p->type      = gField[i].type;
+      p->aggregate = AGG_NONE;
+      FillParameter(p->param, word);
+
+      pch = next;
+   }  while(pch != NULL);
+
+   return(pch);
 }
 
+
 /************************************************************************/
 /*>void ClearWhere(void)
    ---------------------
    Clears the current where statement
 
    21.04.94 Original    By: ACRM
+   19.10.26 Also clears LIMIT, OFFSET, ORDER BY and GROUP BY
+            Clears gLimitError
 */
 void ClearWhere(void)
 {
    DATA *d;
+
+   gLimitError = FALSE;
+
+   gLimit     = 0;
+   gOffset    = 0;
+   gOrderDesc = FALSE;
+   if(gOrderBy != NULL)
+   {
+      free(gOrderBy);
+      gOrderBy = NULL;
+   }
+   if(gGroupBy != NULL)
+   {
+      FREELIST(gGroupBy,SELECTION);
+      gGroupBy = NULL;
+   }
    
    if(gWhereClause != NULL)
    {
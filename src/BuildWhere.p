@@ -5,8 +5,21 @@ BOOL CheckForSetOper(char *word, BOOL *error)
 char *HandleWhereSubClause(char *buffer, char *word, BOOL *error,
                            int maxlength)
 ;
+char *HandleLimitClause(char *buffer, char *word, BOOL *error,
+                        int maxlength)
+;
+char *HandleOrderClause(char *buffer, char *word, BOOL *error,
+                        int maxlength)
+;
+char *HandleGroupClause(char *buffer, char *word, BOOL *error,
+                        int maxlength)
+;
 BOOL SetComparison(WHERE *p, char *word)
 ;
+BOOL IsSequenceField(int type)
+;
+void CopyUnquoted(char *out, char *word)
+;
 void SetWhereData(WHERE *wh, char *word)
 ;
 void ClearWhere(void)
@@ -0,0 +1,280 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Capture.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Writes a log of the searches which are run so that a real workload
+   can be replayed later against another build or data set.
+
+   The log is written in the format of a benchmark query file so
+   kabatman -b runs it. Each search which completes is written as a
+   query named by the date and time it was run and the number of
+   searches so far, followed by a comment giving the number of rows it
+   displayed and the time it took, a SET line giving the variables
+   which affect the search and the SELECT and WHERE lines which were
+   typed for it. When a log is replayed the rows displayed by each
+   query are compared with those in the comment.
+
+   The log is appended to so that several sessions may be collected in
+   one file.
+
+**************************************************************************
+
+   Usage:
+   ======
+   SET LOG file      starts logging searches to the file
+   SET LOG OFF       stops logging
+   kabatman -l file  starts logging at the start of the session
+
+   CaptureLine() is given each line of a SELECT or WHERE clause and
+   CaptureSearch() is called once a search has been run.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+
+*************************************************************************/
+/* Includes
+*/
+#include <time.h>
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define CAPTUREBUFF 8192               /* Space for the lines of a
+                                          SELECT or WHERE clause        */
+#define CAPTURE_SELECT 0
+#define CAPTURE_WHERE  1
+
+/************************************************************************/
+/* Globals
+*/
+static FILE *sCaptureFile = NULL;
+static BOOL sAtExitSet    = FALSE;
+static char sClause[2][CAPTUREBUFF],   /* Lines of the SELECT and WHERE */
+            sCanonical[MAXBUFF];       /* CANONICAL given in the log    */
+static BOOL sTooLong[2]   = {FALSE, FALSE};
+static int  sNSearches    = 0;
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static void WriteSetState(FILE *fp);
+
+
+/************************************************************************/
+/*>BOOL OpenCapture(char *filename)
+   --------------------------------
+   Input:   char   *filename    Log file to append to
+   Returns: BOOL                Success
+
+   Starts logging searches to a file. Any log already being written is
+   closed first.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL OpenCapture(char *filename)
+{
+   time_t now;
+
+   CloseCapture();
+
+   if((sCaptureFile = fopen(filename,"a"))==NULL)
+   {
+      fprintf(stderr,"Error: Unable to open log file %s\n",filename);
+      return(FALSE);
+   }
+
+   if(!sAtExitSet)
+   {
+      atexit(CloseCapture);
+      sAtExitSet = TRUE;
+   }
+
+   /* The log may be replayed in a session which has changed the
+      canonical definitions, so the first search always gives them
+   */
+   strcpy(sCanonical, "?");
+
+   now = time(NULL);
+   fprintf(sCaptureFile,"# KabatMan V2.27 search log started %s",
+           ctime(&now));
+   fprintf(sCaptureFile,"# Data set created %s\n\n",
+           (gFileDate[0] ? gFileDate : "(unknown)"));
+   fflush(sCaptureFile);
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void CloseCapture(void)
+   -----------------------
+   Stops logging searches (if they are being logged).
+
+   19.10.26 Original    By: ACRM
+*/
+void CloseCapture(void)
+{
+   if(sCaptureFile != NULL)
+   {
+      fclose(sCaptureFile);
+      sCaptureFile = NULL;
+   }
+}
+
+
+/************************************************************************/
+/*>void CaptureLine(char *line, int Mode, BOOL NewClause)
+   ------------------------------------------------------
+   Input:   char   *line       A line of a SELECT or WHERE clause
+            int    Mode        1 for SELECT, 2 for WHERE (as used by
+                               HandleCommand())
+            BOOL   NewClause   The line starts the clause
+
+   Remembers a line of the SELECT or WHERE clause for the log. The
+   lines are kept even when searches are not being logged since a
+   clause may be used by searches after the log is started.
+
+   19.10.26 Original    By: ACRM
+*/
+void CaptureLine(char *line, int Mode, BOOL NewClause)
+{
+   int clause,
+       length;
+
+   if((Mode != 1) && (Mode != 2))
+      return;
+   clause = ((Mode == 1) ? CAPTURE_SELECT : CAPTURE_WHERE);
+
+   if(NewClause)
+   {
+      sClause[clause][0] = '\0';
+      sTooLong[clause]   = FALSE;
+   }
+
+   length = strlen(sClause[clause]);
+   if(length + (int)strlen(line) + 2 > CAPTUREBUFF)
+   {
+      sTooLong[clause] = TRUE;
+      return;
+   }
+   sprintf(sClause[clause]+length, "%s\n", line);
+}
+
+
+/************************************************************************/
+/*>void CaptureSearch(double seconds)
+   ----------------------------------
+   Input:   double  seconds     Time taken by the search
+   Globals: int     gNRows      Rows displayed by the search (-1 if it
+                                failed)
+
+   Writes a search which has just been run to the log. Searches which
+   failed are not written.
+
+   19.10.26 Original    By: ACRM
+*/
+void CaptureSearch(double seconds)
+{
+   char      stamp[MAXBUFF];
+   time_t    now;
+   struct tm *tm;
+
+   if((sCaptureFile == NULL) || (gNRows < 0))
+      return;
+
+   if(sTooLong[CAPTURE_SELECT] || sTooLong[CAPTURE_WHERE])
+   {
+      fprintf(stderr,"Warning: Search too long to be logged\n");
+      return;
+   }
+
+   now = time(NULL);
+   tm  = localtime(&now);
+   strftime(stamp, MAXBUFF, "%Y%m%d-%H%M%S", tm);
+
+   fprintf(sCaptureFile,"## %s-%d\n", stamp, ++sNSearches);
+   fprintf(sCaptureFile,"# rows %d time_ms %.3f\n", gNRows,
+           1000.0 * seconds);
+   WriteSetState(sCaptureFile);
+   fputs(sClause[CAPTURE_SELECT], sCaptureFile);
+   fputs(sClause[CAPTURE_WHERE],  sCaptureFile);
+   fprintf(sCaptureFile,";\n\n");
+
+   /* Flushed so that the log is complete if the program is killed      */
+   fflush(sCaptureFile);
+}
+
+
+/************************************************************************/
+/*>static void WriteSetState(FILE *fp)
+   -----------------------------------
+   Input:   FILE    *fp           Log file
+   Globals: int     gLoopMode     CDR definitions
+            BOOL    gShowInserts  Show alignment dashes in CDRs?
+            REAL    gVariability  Variability threshold
+            BOOL    gHTML         HTML output?
+            char    gDelim        Field delimiter
+            int     gNThreads     Threads to use
+            BOOL    gUseIndex     Use the sequence index?
+            int     gLSHMinData   Entries from which the LSH is used
+            BOOL    gUseZoneMap   Use the zone maps?
+            BOOL    gUseBatch     Test batches of entries?
+            char    gCanonical[]  Canonical definitions in use
+
+   Writes SET commands to restore the variables which affect a search.
+   CANONICAL is only given when it has changed since the last search
+   logged since it re-reads the definitions. The default delimiter (a
+   comma) can't be given with SET so is not written.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Added ZONEMAP and BATCH
+*/
+static void WriteSetState(FILE *fp)
+{
+   static char *LoopNames[] = {"", "KABAT", "ABM", "CHOTHIA", "CONTACT"};
+
+   if(strcmp(sCanonical, gCanonical))
+   {
+      fprintf(fp,"SET CANONICAL %s\n",
+              (gCanonical[0] ? gCanonical : "DEFAULT"));
+      strcpy(sCanonical, gCanonical);
+   }
+
+   fprintf(fp,"SET LOOP %s INSERTS %s VARIABILITY %g HTML %s",
+           LoopNames[gLoopMode], (gShowInserts ? "ON" : "OFF"),
+           (double)gVariability, (gHTML ? "ON" : "OFF"));
+   if(gDelim != ',')
+      fprintf(fp," DELIMITER %c", gDelim);
+   fprintf(fp," THREADS %d INDEX %s LSH %d ZONEMAP %s BATCH %s\n",
+           gNThreads, (gUseIndex ? "ON" : "OFF"), gLSHMinData,
+           (gUseZoneMap ? "ON" : "OFF"), (gUseBatch ? "ON" : "OFF"));
+}
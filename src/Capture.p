@@ -0,0 +1,8 @@
+BOOL OpenCapture(char *filename)
+;
+void CloseCapture(void)
+;
+void CaptureLine(char *line, int Mode, BOOL NewClause)
+;
+void CaptureSearch(double seconds)
+;
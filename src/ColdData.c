@@ -0,0 +1,365 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       ColdData.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Handling of the `cold' text fields (antigen, full source and
+   reference). These are long strings which most queries never look
+   at, so they are kept out of the DATA structure in a separately
+   allocated COLDDATA block.
+
+   From version 5.0 of the stored data file, these fields are written
+   in a separate section at the end of the file (introduced by !COLD)
+   and each entry stores the offset of its record in that section. The
+   section is not read when the data are loaded; an entry's fields are
+   read the first time they are needed. If a scan needs the fields for
+   every entry, the whole section is read in one sequential pass
+   instead.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+                  Cold fields are allocated from the data set arena
+                  Upper case copies of antigen and reference are stored
+                  for searching
+                  Counts the records found in memory or read in
+                  gCacheHits and gCacheMisses
+                  Added ColdDataMemory()
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+
+/************************************************************************/
+/* Globals
+*/
+static FILE     *sColdFp      = NULL;   /* Stored file for lazy reads   */
+static long     sColdStart    = 0L;     /* Offset of the !COLD section  */
+static BOOL     sColdPending  = FALSE;  /* Are any entries not read?    */
+static int      sNCold        = 0;      /* Records once all were read   */
+static COLDDATA sEmptyCold    = {"", "", "", "", ""};
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static BOOL ReadColdRecord(FILE *fp, DATA *d);
+
+
+/************************************************************************/
+/*>COLDDATA *NewColdData(ARENA *arena, char *antigen, char *fsource,
+                          char *reference)
+   --------------------------------------------------------------------
+   I/O:     ARENA    *arena       Arena from which to allocate
+   Input:   char     *antigen     Antigen
+            char     *fsource     Source as given in the file
+            char     *reference   Reference
+   Returns: COLDDATA *            Newly allocated cold fields (NULL if
+                                  no memory)
+
+   Allocates a COLDDATA structure and its strings as a single block.
+   Upper case copies of the antigen and reference are made at the same
+   time so searches need not convert them.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Allocates from an arena
+            Added UpperAntigen and UpperReference
+*/
+COLDDATA *NewColdData(ARENA *arena, char *antigen, char *fsource,
+                      char *reference)
+{
+   COLDDATA *cold;
+   int      lena = strlen(antigen)   + 1,
+            lenf = strlen(fsource)   + 1,
+            lenr = strlen(reference) + 1;
+
+   if((cold = (COLDDATA *)ArenaAlloc(arena, sizeof(COLDDATA) +
+                                            2*lena + lenf + 2*lenr))
+      ==NULL)
+      return(NULL);
+
+   cold->antigen        = (char *)(cold + 1);
+   cold->fsource        = cold->antigen   + lena;
+   cold->reference      = cold->fsource   + lenf;
+   cold->UpperAntigen   = cold->reference + lenr;
+   cold->UpperReference = cold->UpperAntigen + lena;
+   strcpy(cold->antigen,        antigen);
+   strcpy(cold->fsource,        fsource);
+   strcpy(cold->reference,      reference);
+   strcpy(cold->UpperAntigen,   antigen);
+   strcpy(cold->UpperReference, reference);
+   UPPER(cold->UpperAntigen);
+   UPPER(cold->UpperReference);
+
+   return(cold);
+}
+
+
+/************************************************************************/
+/*>COLDDATA *GetColdData(DATA *d)
+   ------------------------------
+   Input:   DATA     *d     A data entry
+   Returns: COLDDATA *      The entry's cold fields
+
+   Returns the cold fields for an entry, reading them from the stored
+   data file if they have not yet been read. If they can't be read, a
+   set of blank fields is returned so the result may always be used.
+
+   Records which have to be read are counted in gCacheMisses. Those
+   already in memory are not counted since this may be called from
+   several threads once LoadAllColdData() has been called.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Counts the records read
+*/
+COLDDATA *GetColdData(DATA *d)
+{
+   if(d->cold == NULL)
+   {
+      gCacheMisses++;
+      if((sColdFp == NULL) || (d->ColdOffset < 0) ||
+         fseek(sColdFp, sColdStart + d->ColdOffset, SEEK_SET) ||
+         !ReadColdRecord(sColdFp, d))
+      {
+         return(&sEmptyCold);
+      }
+   }
+   return(d->cold);
+}
+
+
+/************************************************************************/
+/*>BOOL LoadAllColdData(void)
+   --------------------------
+   Returns: BOOL         Success
+   Globals: DATA *gData  The data linked list
+
+   Makes sure the cold fields have been read for every entry. Any which
+   are missing are filled in by reading the whole !COLD section of the
+   stored file in one pass. The file is then closed. This must be
+   called before a scan which uses the cold fields and before the cold
+   fields are accessed from more than one thread.
+
+   The records found in memory are counted in gCacheHits and those read
+   in gCacheMisses.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Counts the records found in memory and read
+*/
+BOOL LoadAllColdData(void)
+{
+   DATA *d;
+   BOOL ok = TRUE;
+
+   if(!sColdPending)
+   {
+      gCacheHits += sNCold;
+      return(TRUE);
+   }
+
+   if(sColdFp == NULL || fseek(sColdFp, sColdStart, SEEK_SET))
+   {
+      fprintf(stderr,"Error: Unable to read the !COLD section of the \
+stored data\n");
+      return(FALSE);
+   }
+
+   /* The records are in the same order as the entries                  */
+   for(d=gData; d!=NULL; NEXT(d))
+   {
+      if(d->ColdOffset < 0)
+         continue;
+      sNCold++;
+
+      if(d->cold != NULL)
+      {
+         gCacheHits++;
+
+         /* Already read; skip over this record                         */
+         if(fseek(sColdFp, sColdStart + d->ColdOffset, SEEK_SET))
+            ok = FALSE;
+         else
+            ok = ReadColdRecord(sColdFp, NULL);
+      }
+      else
+      {
+         gCacheMisses++;
+         ok = ReadColdRecord(sColdFp, d);
+      }
+
+      if(!ok)
+      {
+         fprintf(stderr,"Error: Unable to read the !COLD section of the \
+stored data\n");
+         return(FALSE);
+      }
+   }
+
+   CloseColdData();
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void OpenColdData(FILE *fp, long ColdStart)
+   -------------------------------------------
+   Input:   FILE  *fp          The stored data file (left open)
+            long  ColdStart    Offset of the first record of the !COLD
+                               section
+
+   Records the stored data file from which the cold fields are to be
+   read on demand. The file is closed by CloseColdData().
+
+   19.10.26 Original    By: ACRM
+*/
+void OpenColdData(FILE *fp, long ColdStart)
+{
+   CloseColdData();
+   sColdFp      = fp;
+   sColdStart   = ColdStart;
+   sColdPending = TRUE;
+   sNCold       = 0;
+}
+
+
+/************************************************************************/
+/*>void CloseColdData(void)
+   ------------------------
+   Closes the stored data file used for reading the cold fields.
+
+   19.10.26 Original    By: ACRM
+*/
+void CloseColdData(void)
+{
+   if(sColdFp != NULL)
+      fclose(sColdFp);
+   sColdFp      = NULL;
+   sColdPending = FALSE;
+}
+
+
+/************************************************************************/
+/*>long WriteColdData(FILE *fp, DATA *d)
+   -------------------------------------
+   Input:   FILE  *fp     Output file (may be NULL to just get the size)
+            DATA  *d      A data entry
+   Returns: long          Number of bytes in the record
+
+   Writes the !COLD section record for an entry (fsource, antigen and
+   reference on separate lines).
+
+   19.10.26 Original    By: ACRM
+*/
+long WriteColdData(FILE *fp, DATA *d)
+{
+   COLDDATA *cold = GetColdData(d);
+
+   if(fp != NULL)
+      fprintf(fp,"%s\n%s\n%s\n",
+              cold->fsource, cold->antigen, cold->reference);
+
+   return((long)(strlen(cold->fsource) + strlen(cold->antigen) +
+                 strlen(cold->reference) + 3));
+}
+
+
+/************************************************************************/
+/*>static BOOL ReadColdRecord(FILE *fp, DATA *d)
+   ---------------------------------------------
+   Input:   FILE  *fp     Stored data file positioned at a record
+   I/O:     DATA  *d      Entry for which the record is read (NULL to
+                          skip the record)
+   Returns: BOOL          Success
+
+   Reads a record from the !COLD section of the stored data file. The
+   fields are allocated from gDataArena.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL ReadColdRecord(FILE *fp, DATA *d)
+{
+   char fsource[SEQBUFF],
+        antigen[SEQBUFF],
+        reference[SEQBUFF];
+
+   if(!fgets(fsource,   SEQBUFF, fp) ||
+      !fgets(antigen,   SEQBUFF, fp) ||
+      !fgets(reference, SEQBUFF, fp))
+      return(FALSE);
+
+   if(d != NULL)
+   {
+      TERMINATE(fsource);
+      TERMINATE(antigen);
+      TERMINATE(reference);
+      if((d->cold = NewColdData(gDataArena, antigen, fsource,
+                                reference))==NULL)
+         return(FALSE);
+   }
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void ColdDataMemory(MEMUSE *use)
+   --------------------------------
+   Output:  MEMUSE  *use     Memory used by the cold fields which have
+                             been read
+   Globals: DATA    *gData   The data
+
+   For SHOW MEMORY.
+
+   19.10.26 Original    By: ACRM
+*/
+void ColdDataMemory(MEMUSE *use)
+{
+   DATA   *d;
+   size_t size;
+
+   for(d=gData; d!=NULL; NEXT(d))
+   {
+      if(d->cold != NULL)
+      {
+         size = sizeof(COLDDATA) + 2 * strlen(d->cold->antigen) +
+                strlen(d->cold->fsource) +
+                2 * strlen(d->cold->reference) + 5;
+         use->allocated += ArenaRound(size);
+         use->used      += size;
+      }
+   }
+}
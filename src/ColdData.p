@@ -0,0 +1,15 @@
+COLDDATA *NewColdData(ARENA *arena, char *antigen, char *fsource,
+                      char *reference)
+;
+COLDDATA *GetColdData(DATA *d)
+;
+BOOL LoadAllColdData(void)
+;
+void OpenColdData(FILE *fp, long ColdStart)
+;
+void CloseColdData(void)
+;
+long WriteColdData(FILE *fp, DATA *d)
+;
+void ColdDataMemory(MEMUSE *use)
+;
@@ -0,0 +1,283 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Distinct.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   SELECT DISTINCT. Some chains appear in several entries because they
+   are paired with more than one partner chain. DISTINCT removes hits
+   whose selected fields are identical to those of an earlier hit.
+
+   Each hit is hashed on the text of its selected fields and stored in
+   an open addressing hash table sized from the number of hits. Hits
+   with the same hash are compared properly so a hash collision can
+   never lose a hit. The light and heavy chains are hashed once when
+   the data are loaded so selecting LIGHT, HEAVY, PIRFILE or SEQUENCE
+   just uses the stored hash. Note that PIRFILE and SEQUENCE are taken
+   as duplicates if the chains are the same even though the PIR title
+   includes the entry name.
+
+   Duplicates are removed from the hit list before anything is
+   formatted.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static unsigned long HashTuple(DATA *d);
+static BOOL SameTuple(DATA *d1, DATA *d2);
+
+
+/************************************************************************/
+/*>unsigned long HashBytes(char *bytes, int length, unsigned long hash)
+   --------------------------------------------------------------------
+   Input:   char          *bytes   Bytes to hash
+            int           length   Number of bytes
+            unsigned long hash     Hash so far (HASH_INIT to start)
+   Returns: unsigned long          Updated hash
+
+   FNV-1a hash of a block of bytes. The hash of several blocks may be
+   built up by passing the result of one call to the next.
+
+   19.10.26 Original    By: ACRM
+*/
+unsigned long HashBytes(char *bytes, int length, unsigned long hash)
+{
+   int i;
+
+   for(i=0; i<length; i++)
+   {
+      hash ^= (unsigned char)bytes[i];
+      hash *= 16777619UL;
+   }
+   return(hash);
+}
+
+
+/************************************************************************/
+/*>void SetChainHashes(DATA *data)
+   -------------------------------
+   I/O:     DATA  *data    Linked list of data
+
+   Stores a hash of the light and heavy chain sequences in each entry.
+   Must be called once the data have been read.
+
+   19.10.26 Original    By: ACRM
+*/
+void SetChainHashes(DATA *data)
+{
+   DATA *d;
+
+   for(d=data; d!=NULL; NEXT(d))
+   {
+      d->LightHash = HashBytes(d->light, strlen(d->light), HASH_INIT);
+      d->HeavyHash = HashBytes(d->heavy, strlen(d->heavy), HASH_INIT);
+   }
+}
+
+
+/************************************************************************/
+/*>BOOL DistinctHits(DATA **hits, int *NHits, int MaxHits)
+   -------------------------------------------------------
+   I/O:     DATA  **hits      Array of hits
+            int   *NHits      Number of hits
+   Input:   int   MaxHits     Stop once this many distinct hits have
+                              been found (0 = all)
+   Returns: BOOL              Success (FALSE if no memory)
+   Globals: SELECTION *gSelectClause  The selected fields
+
+   Removes hits whose selected fields are the same as those of an
+   earlier hit. The hits which remain keep their order.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL DistinctHits(DATA **hits, int *NHits, int MaxHits)
+{
+   DATA          **table;
+   unsigned long *hashes,
+                 hash;
+   int           size = 16,
+                 mask,
+                 i, j,
+                 NKept = 0;
+
+   if(*NHits < 2)
+      return(TRUE);
+
+   /* Table is a power of 2 and at least twice the number of hits       */
+   while(size < 2 * (*NHits))
+      size *= 2;
+   mask = size - 1;
+
+   if((table = (DATA **)malloc(size * sizeof(DATA *)))==NULL)
+      return(FALSE);
+   if((hashes = (unsigned long *)malloc(size * sizeof(unsigned long)))
+      ==NULL)
+   {
+      free(table);
+      return(FALSE);
+   }
+   for(i=0; i<size; i++)
+      table[i] = NULL;
+
+   for(i=0; i<*NHits; i++)
+   {
+      hash = HashTuple(hits[i]);
+
+      /* Linear probe until we find the tuple or an empty slot          */
+      for(j=(int)(hash & mask); table[j]!=NULL; j=(j+1) & mask)
+      {
+         if((hashes[j] == hash) && SameTuple(table[j], hits[i]))
+            break;
+      }
+
+      if(table[j] == NULL)
+      {
+         table[j]       = hits[i];
+         hashes[j]      = hash;
+         hits[NKept++]  = hits[i];
+
+         if(MaxHits && (NKept >= MaxHits))
+            break;
+      }
+   }
+
+   *NHits = NKept;
+   free(table);
+   free(hashes);
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static unsigned long HashTuple(DATA *d)
+   ---------------------------------------
+   Input:   DATA          *d     A hit
+   Returns: unsigned long        Hash of the selected fields
+   Globals: SELECTION *gSelectClause  The selected fields
+
+   19.10.26 Original    By: ACRM
+*/
+static unsigned long HashTuple(DATA *d)
+{
+   SELECTION     *p;
+   char          text[LARGEBUFF];
+   unsigned long hash = HASH_INIT;
+
+   for(p=gSelectClause; p!=NULL; NEXT(p))
+   {
+      switch(p->type)
+      {
+      case FIELD_LIGHT:
+         hash = (hash * 31) ^ d->LightHash;
+         break;
+      case FIELD_HEAVY:
+         hash = (hash * 31) ^ d->HeavyHash;
+         break;
+      case FIELD_PIR:
+      case FIELD_SEQUENCE:
+         hash = (hash * 31) ^ d->LightHash;
+         hash = (hash * 31) ^ d->HeavyHash;
+         break;
+      default:
+         if(!GetFieldText(d, p->type, p->param, text))
+            text[0] = '\0';
+         /* Include the terminating '\0' to separate the fields         */
+         hash = HashBytes(text, strlen(text)+1, hash);
+         break;
+      }
+   }
+   return(hash);
+}
+
+
+/************************************************************************/
+/*>static BOOL SameTuple(DATA *d1, DATA *d2)
+   -----------------------------------------
+   Input:   DATA  *d1, *d2   Two hits
+   Returns: BOOL             Are the selected fields the same?
+   Globals: SELECTION *gSelectClause  The selected fields
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL SameTuple(DATA *d1, DATA *d2)
+{
+   SELECTION *p;
+   char      text1[LARGEBUFF],
+             text2[LARGEBUFF];
+
+   for(p=gSelectClause; p!=NULL; NEXT(p))
+   {
+      switch(p->type)
+      {
+      case FIELD_LIGHT:
+         if(strcmp(d1->light, d2->light))
+            return(FALSE);
+         break;
+      case FIELD_HEAVY:
+         if(strcmp(d1->heavy, d2->heavy))
+            return(FALSE);
+         break;
+      case FIELD_PIR:
+      case FIELD_SEQUENCE:
+         if(strcmp(d1->light, d2->light) || strcmp(d1->heavy, d2->heavy))
+            return(FALSE);
+         break;
+      default:
+         if(!GetFieldText(d1, p->type, p->param, text1))
+            text1[0] = '\0';
+         if(!GetFieldText(d2, p->type, p->param, text2))
+            text2[0] = '\0';
+         if(strcmp(text1, text2))
+            return(FALSE);
+         break;
+      }
+   }
+   return(TRUE);
+}
@@ -0,0 +1,6 @@
+unsigned long HashBytes(char *bytes, int length, unsigned long hash)
+;
+void SetChainHashes(DATA *data)
+;
+BOOL DistinctHits(DATA **hits, int *NHits, int MaxHits)
+;
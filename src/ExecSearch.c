@@ -3,11 +3,11 @@
    Program:    KabatMan
    File:       ExecSearch.c
    
-   Version:    V2.26
-   Date:       04.10.19
+   Version:    V2.27
+   Date:       19.10.26
    Function:   Database program for reading Kabat sequence files
    
-   Copyright:  (c) UCL / Andrew C. R. Martin 1994-2019
+   Copyright:  (c) UCL / Andrew C. R. Martin 1994-2026
    Author:     Dr. Andrew C. R. Martin
    Address:    Biomolecular Structure and Modelling Unit,
                Department of Biochemistry and Molecular Biology,
@@ -79,6 +79,34 @@
                   Changed all calls to GetKabatOffset() to add the new
                   count parameter
    V2.26 04.10.19 Changed all bioplib calls to blXXX()
+   V2.27 19.10.26 Added LIMIT and OFFSET with early termination of the
+                  scan where the WHERE clause allows
+                  Added ORDER BY. DisplaySearch() now works from an array
+                  of hits and gets field text from GetFieldText()
+                  Added GROUP BY. FindCanonical() no longer changes
+                  gLoopMode so that it is thread-safe
+                  Added SELECT DISTINCT
+                  Antigen, fsource and reference now obtained through
+                  GetColdData()
+                  String tests use the upper case and ungapped copies
+                  made when the data are read and no longer modify the
+                  data or allocate memory
+                  Ungapped sequences are searched with SeqMatch().
+                  fuzzystrstr() moved to Match.c
+                  HandleMatch() only tests the candidates from the
+                  sequence index for LIKE on indexed fields
+                  Added MISMATCH(n) and SIMILAR(n) for sequences, run in
+                  parallel
+                  Added WITHIN(n) which uses the CDR BK-trees
+                  WHERE tests, canonicals, subgroups and the output are
+                  counted by the hot-path counters
+                  Each WHERE item, the variability filter and the
+                  display are traced
+                  Added IDENTITY(name). RemoveDupes() uses the LSH for
+                  large data sets. TooSimilar() moved to Similar.c
+                  DisplaySearch() sets gNRows for the benchmark
+                  Added EXPLAIN and EXPLAIN ANALYZE. ScanLimit() split
+                  out of ExecuteSearch()
 
 *************************************************************************/
 /* Includes
@@ -88,6 +116,17 @@
 /************************************************************************/
 /* Defines and macros
 */
+#define MINTHREADDATA 256       /* Min entries worth giving to a thread */
+
+typedef struct
+{
+   DATA          **data;
+   WHERE         *wh;
+   unsigned char *set;          /* Set filled when run in batches       */
+   int           *entries,      /* Entries to test when run in batches  */
+                 depth;
+   BOOL          ok[MAXTHREADS];  /* Cleared by a thread on an error    */
+}  MATCHJOB;
 
 /************************************************************************/
 /* Globals
@@ -97,6 +136,8 @@
 /* Prototypes
 */
 #include "protos.h"
+static BOOL ParallelMatch(WHERE *wh, int StackDepth);
+static void MatchEntries(int start, int stop, int thread, void *data);
 
 /************************************************************************/
 /*>BOOL ExecuteSearch(char *filename)
@@ -108,29 +149,86 @@
    calling HandleMatch() or HandleLogical() as appropriate to add data to
    the stack or to perform a logical set operation on the current stack.
 
+   If a LIMIT has been given and the WHERE clause is a single test with
+   no variability filtering, sorting, grouping or DISTINCT, the scan
+   stops as soon as enough hits have been found.
+
+   The search is not run if there was an error in a LIMIT or OFFSET
+   clause.
+
+   After EXPLAIN the plan is printed instead of running the search.
+   After EXPLAIN ANALYZE the search is run and each step is timed; the
+   report is printed after the hits.
+
    20.04.94 Original    By: ACRM
    21.04.94 Added filename parameter
    26.04.94 Prints error message if stack depth wrong.
    23.06.95 Added missing return value
+   19.10.26 Added early termination when LIMIT is specified
+            Calls DisplayGroups() for grouped queries
+            Added EXPLAIN and EXPLAIN ANALYZE
+            Each WHERE item and the display are traced
+            The result of the tests in batches is copied to the active
+            flags with BatchResult()
+            Not run if gLimitError is set
 */
 BOOL ExecuteSearch(char *filename)
 {
-   int   StackDepth = 0;
-   WHERE *wh;
-   FILE  *fp = stdout;
+   int    StackDepth = 0,
+          MaxHits;
+   WHERE  *wh;
+   FILE   *fp = stdout;
+   BOOL   grouped,
+          ok = TRUE;
+   double start = 0.0;
+   char   text[MAXBUFF*4];
+
+   if(gLimitError)
+   {
+      fprintf(stderr,"Error: Search not run since the LIMIT or OFFSET \
+is not valid\n");
+      return(FALSE);
+   }
+
+   grouped = IsGroupedQuery();
+   if(!grouped && (gOrderBy != NULL) && (gOrderBy->aggregate != AGG_NONE))
+   {
+      fprintf(stderr,"Error: ORDER BY an aggregate requires GROUP BY\n");
+      return(FALSE);
+   }
+
+   if(gExplain == EXPLAIN_PLAN)
+   {
+      ExplainPlan(stdout);
+      return(TRUE);
+   }
+   if(gExplain == EXPLAIN_ANALYZE)
+   {
+      ResetExplain();
+      start = WallTime();
+   }
+
+   MaxHits = ScanLimit();
 
    for(wh=gWhereClause; wh!=NULL; NEXT(wh))
    {
+      BeginStep(&(wh->stats), ExplainInput(wh, StackDepth));
+      DescribeWhere(wh, text);
       if(wh->SetOper)        /* This is a logical operator              */
       {
-         if(!HandleLogical(wh,&StackDepth))
-            return(FALSE);
+         TraceBegin(0, "HandleLogical", text);
+         ok = HandleLogical(wh,&StackDepth);
       }
       else                   /* This is a standard comparison           */
       {
-         if(!HandleMatch(wh,&StackDepth))
-            return(FALSE);
+         TraceBegin(0, "HandleMatch", text);
+         ok = HandleMatch(wh,&StackDepth,MaxHits);
       }
+      TraceEnd(0);
+      if(!ok)
+         return(FALSE);
+      EndStep(&(wh->stats), (wh->stats.stopped ? MaxHits :
+                             ExplainCount(StackDepth)));
    }
 
    if(StackDepth != 1)
@@ -138,6 +236,8 @@ BOOL ExecuteSearch(char *filename)
       fprintf(stderr,"Error: Stack depth (%d) should be 1\n",StackDepth);
       return(FALSE);
    }
+   if(UseBatches() && !BatchResult())
+      return(FALSE);
 
    if(filename != NULL)
    {
@@ -148,12 +248,51 @@ BOOL ExecuteSearch(char *filename)
       }
    }
    
-   DisplaySearch(fp,StackDepth);
+   if(grouped)
+   {
+      BeginStep(ExplainStage(STAGE_GROUP), ExplainCount(StackDepth));
+      TraceBegin(0, "DisplayGroups", NULL);
+      ok = DisplayGroups(fp,StackDepth);
+      TraceEnd(0);
+      EndStep(ExplainStage(STAGE_GROUP), gNRows);
+   }
+   else
+   {
+      TraceBegin(0, "DisplaySearch", NULL);
+      DisplaySearch(fp,StackDepth);
+      TraceEnd(0);
+   }
    
    if(fp != stdout)
       fclose(fp);
 
-   return(TRUE);
+   if(gExplain == EXPLAIN_ANALYZE)
+      ExplainAnalyze(stdout, WallTime() - start);
+
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>int ScanLimit(void)
+   -------------------
+   Returns: int         Hits after which the scan may stop (0 = none)
+
+   See if we can stop the scan early. This requires a LIMIT and a single
+   test (no set operations), no variability filter, no sorting, no
+   grouping and no DISTINCT since those need the complete hit list.
+
+   19.10.26 Original (from ExecuteSearch())   By: ACRM
+*/
+int ScanLimit(void)
+{
+   if((gLimit > 0) && (gVariability <= 0.0) && (gOrderBy == NULL) &&
+      !IsGroupedQuery() && !gDistinct &&
+      (gWhereClause != NULL) && (gWhereClause->next == NULL))
+   {
+      return(gOffset + gLimit);
+   }
+   return(0);
 }
    
       
@@ -170,11 +309,15 @@ BOOL ExecuteSearch(char *filename)
    containing the result of the logical operation.
 
    20.04.94 Original    By: ACRM
+   19.10.26 Calls BatchLogical() when the tests are run in batches
 */
 BOOL HandleLogical(WHERE *wh, int *StackDepth)
 {
    DATA *d;
 
+   if(UseBatches())
+      return(BatchLogical(wh, StackDepth));
+
    switch(wh->type)
    {
    case OPER_NOT:
@@ -205,9 +348,10 @@ BOOL HandleLogical(WHERE *wh, int *StackDepth)
 
 
 /************************************************************************/
-/*>BOOL HandleMatch(WHERE *wh, int *StackDepth)
-   --------------------------------------------
+/*>BOOL HandleMatch(WHERE *wh, int *StackDepth, int MaxHits)
+   ---------------------------------------------------------
    Input:   WHERE *wh         An item from the WHERE clause linked list
+            int   MaxHits     Stop after this many hits (0 = no limit)
    I/O:     int   *StackDepth The stack depth before and after adding
                               this set.
    Returns: BOOL              Success?
@@ -215,6 +359,10 @@ BOOL HandleLogical(WHERE *wh, int *StackDepth)
    Adds a new set to the stack by comparing each item in the data list
    with the specification in this WHERE clause.
 
+   If MaxHits is non-zero, the scan stops once that many hits have been
+   found. Entries after the last hit are not examined so their flags are
+   undefined; the caller must not look beyond the MaxHits'th hit.
+
    20.04.94 Original    By: ACRM
    26.04.94 Added light and heavy.
             Modified for new DoStrTest()
@@ -224,15 +372,38 @@ BOOL HandleLogical(WHERE *wh, int *StackDepth)
    10.09.97 Added subgroup handling
    03.04.02 Added reference date
    28.02.05 Added LFR1...HFR4 handling
+   19.10.26 Added MaxHits
+            Reads all the cold fields before testing ANTIGEN or REF
+            Uses the upper case copies of text fields and DoSeqTest()
+            for sequences
+            Uses the sequence index where possible so that only the
+            candidate entries are tested
+            Tests moved to TestEntry(). MISMATCH() and SIMILAR() tests
+            are run in parallel by ParallelMatch()
+            Also WITHIN() tests
+            Finds the entry named for IDENTITY
+            Records the access used, the entries tested and whether the
+            scan stopped early in wh->stats
+            Scan timed by the hot-path counters
+            Scans skip zones which the zone map shows can't match
+            Tests batches of entries with BatchMatch() when
+            UseBatches() (never with a MaxHits)
 */
-BOOL HandleMatch(WHERE *wh, int *StackDepth)
+BOOL HandleMatch(WHERE *wh, int *StackDepth, int MaxHits)
 {
    DATA *d;
-   char loop[160],
-        res,
-        class[8];
-   int  len,
-        idata;
+   int  NHits = 0,
+        *cand = NULL,
+        NCand = 0,
+        iCand = 0,
+        NZones  = 0,
+        NTested = 0,
+        entry;
+   char *zones = NULL;
+   BOOL indexed,
+        zoned,
+        ok    = TRUE;
+   STATTIMER(start)
 
    if(++(*StackDepth) >= STACKDEPTH)
    {
@@ -241,215 +412,404 @@ BOOL HandleMatch(WHERE *wh, int *StackDepth)
       return(FALSE);
    }
 
-   for(d=gData; d!=NULL; NEXT(d))
+   /* IDENTITY needs the entry it names                                 */
+   if((wh->type == FIELD_IDENTITY) &&
+      ((wh->entry = FindEntry(wh->param)) == NULL))
+   {
+      fprintf(stderr,"Error: No entry called %s\n", wh->param);
+      return(FALSE);
+   }
+
+   /* Tests on the cold fields need them for every entry so read them
+      all in one go
+   */
+   if((wh->type == FIELD_ANTIGEN) || (wh->type == FIELD_REF))
+   {
+      if(!LoadAllColdData())
+         return(FALSE);
+   }
+
+   /* See if the sequence index limits the entries to be tested         */
+   indexed = FindCandidates(wh, &cand, &NCand);
+   wh->stats.access  = (indexed ? ACCESS_INDEX : ACCESS_SCAN);
+   wh->stats.stopped = FALSE;
+
+   /* Approximate sequence matches and identities are split between
+      threads
+   */
+   if(!indexed && !MaxHits &&
+      ((wh->comparison == COMP_MISMATCH) ||
+       (wh->comparison == COMP_SIMILAR)  ||
+       (wh->comparison == COMP_WITHIN)   ||
+       (wh->type == FIELD_IDENTITY)))
+      return(ParallelMatch(wh, *StackDepth));
+
+   /* Otherwise the zone map may show blocks of entries which can't
+      match
+   */
+   zoned = (!indexed && FindZones(wh, &zones, &NZones));
+   if(zoned)
+      wh->stats.access = ACCESS_ZONEMAP;
+
+   /* The scan can't stop early so test a batch at a time               */
+   if(UseBatches())
+   {
+      STATSTART(start);
+      ok = BatchMatch(wh, *StackDepth, indexed, cand, NCand, zones);
+      STATTESTTIME(wh->type, start);
+      if(cand != NULL)
+         free(cand);
+      if(zones != NULL)
+         free(zones);
+      return(ok);
+   }
+
+   STATSTART(start);
+   for(d=gData, entry=0; d!=NULL; NEXT(d), entry++)
    {
-      switch(wh->type)
+      if(indexed)
       {
-      case FIELD_NAME:
-         d->active[(*StackDepth)-1] = DoStrTest(d->name,
-                                                wh->comparison, 
-                                                wh->data, FALSE);
-         break;
-      case FIELD_ANTIGEN:
-         d->active[(*StackDepth)-1] = DoStrTest(d->antigen,
-                                                wh->comparison, 
-                                                wh->data, FALSE);
-         break;
-      case FIELD_CLASS:
-         d->active[(*StackDepth)-1] = DoStrTest(d->class,
-                                                wh->comparison, 
-                                                wh->data, FALSE);
-         break;
-      case FIELD_SOURCE:
-         d->active[(*StackDepth)-1] = DoStrTest(d->source,
-                                                wh->comparison, 
-                                                wh->data, FALSE);
-         break;
-      case FIELD_REF:
-         d->active[(*StackDepth)-1] = DoStrTest(d->reference,
-                                                wh->comparison, 
-                                                wh->data, FALSE);
-         break;
-      case FIELD_LENGTH:
-         FillLoop(wh->param,d,loop);                /* Get loop         */
-         len = blTrueSeqLen(loop);                    /* Get length       */
-         if(!sscanf(wh->data,"%d",&idata)) idata=0; /* Get required len */
-         d->active[(*StackDepth)-1] = DoIntTest(len,
-                                                wh->comparison, idata);
-         break;
-      case FIELD_RES:
-         res = GetResidue(d, wh->param);
-         d->active[(*StackDepth)-1] = DoCharTest(res,
-                                                 wh->comparison, 
-                                                 wh->data[0]);
-         break;
-      case FIELD_COMPLETE:
-         d->active[(*StackDepth)-1] = DoBoolTest(IsComplete(d),
-                                                 wh->comparison,
-                                                 wh->data);
-         break;
-      case FIELD_LIGHT:
-         d->active[(*StackDepth)-1] = DoStrTest(d->light,
-                                                wh->comparison,
-                                                wh->data, TRUE);
-         break;
-      case FIELD_HEAVY:
-         d->active[(*StackDepth)-1] = DoStrTest(d->heavy,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_L1:
-         FillLoop("L1",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_L2:
-         FillLoop("L2",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_L3:
-         FillLoop("L3",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_H1:
-         FillLoop("H1",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_H2:
-         FillLoop("H2",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_H3:
-         FillLoop("H3",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_VAR:
-         break;
-      case FIELD_CANONICAL:
-         if(FindCanonical(d,wh->param,class))
-         {
-            d->active[(*StackDepth)-1] = DoStrTest(class,
-                                                   wh->comparison, 
-                                                   wh->data, FALSE);
-         }
-         else
+         if((iCand >= NCand) || (cand[iCand] != entry))
          {
-            fprintf(stderr,"Error: Unable to get canonical \
-information\n");
-            return(FALSE);
+            d->active[(*StackDepth)-1] = FALSE;
+            continue;
          }
-         break;
-      case FIELD_IDLIGHT:
-         d->active[(*StackDepth)-1] = DoStrTest(d->idlight,
-                                                wh->comparison, 
-                                                wh->data, FALSE);
-         break;
-      case FIELD_IDHEAVY:
-         d->active[(*StackDepth)-1] = DoStrTest(d->idheavy,
-                                                wh->comparison, 
-                                                wh->data, FALSE);
-         break;
-      case FIELD_SUBGROUP:
-         GetSubgroup(d,wh->param,class);
-         d->active[(*StackDepth)-1] = DoStrTest(class,
-                                                wh->comparison, 
-                                                wh->data, FALSE);
-         break;
-      case FIELD_REFDATE:
-         if(!sscanf(wh->data,"%d",&idata)) idata=0; /* Get WHERE date   */
-         d->active[(*StackDepth)-1] = DoIntTest(d->refdate,
-                                                wh->comparison, idata);
-         break;
-      case FIELD_LFR1:
-         FillFW("LFR1",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_LFR2:
-         FillFW("LFR2",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_LFR3:
-         FillFW("LFR3",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_LFR4:
-         FillFW("LFR4",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_HFR1:
-         FillFW("HFR1",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_HFR2:
-         FillFW("HFR2",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_HFR3:
-         FillFW("HFR3",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      case FIELD_HFR4:
-         FillFW("HFR4",d,loop);
-         d->active[(*StackDepth)-1] = DoStrTest(loop,
-                                                wh->comparison, 
-                                                wh->data, TRUE);
-         break;
-      default:
+         iCand++;
+      }
+      else if(zoned && !zones[entry / ZONESIZE])
+      {
+         d->active[(*StackDepth)-1] = FALSE;
+         continue;
+      }
+
+      NTested++;
+      d->active[(*StackDepth)-1] = TestEntry(d, wh, &ok);
+      if(!ok)
+      {
+         if(cand != NULL)
+            free(cand);
+         if(zones != NULL)
+            free(zones);
          return(FALSE);
-         break;
       }
+
+      /* Stop the scan if we have enough hits                           */
+      if(MaxHits && d->active[(*StackDepth)-1] && (++NHits >= MaxHits))
+         break;
    }
+   STATTESTTIME(wh->type, start);
+
+   /* d is only set if the scan stopped early                           */
+   wh->stats.stopped = (d != NULL);
+   wh->stats.tested  = NTested;
+
+   if(cand != NULL)
+      free(cand);
+   if(zones != NULL)
+      free(zones);
 
    return(TRUE);
 }
 
 
 /************************************************************************/
-/*>BOOL DoStrTest(char *text, int comparison, char *subtext, BOOL fuzzy)
+/*>BOOL TestEntry(DATA *d, WHERE *wh, BOOL *ok)
+   --------------------------------------------
+   Input:   DATA  *d          An entry from the data
+            WHERE *wh         An item from the WHERE clause linked list
+   Output:  BOOL  *ok         FALSE if an error occurred (not changed
+                              otherwise)
+   Returns: BOOL              Does the entry match?
+
+   Compares an entry with the specification in a WHERE item. Tests on
+   the sequence fields do not change any shared data so may be run in
+   several threads at once.
+
+   19.10.26 Original - split out of HandleMatch()    By: ACRM
+   19.10.26 Counted by the hot-path counters for the field type
+*/
+BOOL TestEntry(DATA *d, WHERE *wh, BOOL *ok)
+{
+   char loop[160],
+        res,
+        class[8];
+   int  len,
+        idata;
+   BOOL match = FALSE;
+
+   STATTEST(wh->type);
+   switch(wh->type)
+   {
+   case FIELD_NAME:
+      match = DoStrTest(d->UpperName, wh->comparison, wh->data);
+      break;
+   case FIELD_ANTIGEN:
+      match = DoStrTest(GetColdData(d)->UpperAntigen, wh->comparison,
+                        wh->data);
+      break;
+   case FIELD_CLASS:
+      match = DoStrTest(d->UpperClass, wh->comparison, wh->data);
+      break;
+   case FIELD_SOURCE:
+      match = DoStrTest(d->source, wh->comparison, wh->data);
+      break;
+   case FIELD_REF:
+      match = DoStrTest(GetColdData(d)->UpperReference, wh->comparison,
+                        wh->data);
+      break;
+   case FIELD_LENGTH:
+      FillLoop(wh->param,d,loop);                /* Get loop         */
+      len = blTrueSeqLen(loop);                    /* Get length       */
+      if(!sscanf(wh->data,"%d",&idata)) idata=0; /* Get required len */
+      match = DoIntTest(len, wh->comparison, idata);
+      break;
+   case FIELD_RES:
+      res = GetResidue(d, wh->param);
+      match = DoCharTest(res, wh->comparison, wh->data[0]);
+      break;
+   case FIELD_COMPLETE:
+      match = DoBoolTest(IsComplete(d), wh->comparison, wh->data);
+      break;
+   case FIELD_LIGHT:
+      match = DoSeqTest(d->light, d->UngappedLight, wh);
+      break;
+   case FIELD_HEAVY:
+      match = DoSeqTest(d->heavy, d->UngappedHeavy, wh);
+      break;
+   case FIELD_L1:
+      FillLoop("L1",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_L2:
+      FillLoop("L2",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_L3:
+      FillLoop("L3",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_H1:
+      FillLoop("H1",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_H2:
+      FillLoop("H2",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_H3:
+      FillLoop("H3",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_VAR:
+      break;
+   case FIELD_CANONICAL:
+      if(FindCanonical(d,wh->param,class))
+      {
+         UPPER(class);
+         match = DoStrTest(class, wh->comparison, wh->data);
+      }
+      else
+      {
+         fprintf(stderr,"Error: Unable to get canonical \
+information\n");
+         *ok = FALSE;
+      }
+      break;
+   case FIELD_IDLIGHT:
+      match = DoStrTest(d->idlight, wh->comparison, wh->data);
+      break;
+   case FIELD_IDHEAVY:
+      match = DoStrTest(d->idheavy, wh->comparison, wh->data);
+      break;
+   case FIELD_SUBGROUP:
+      GetSubgroup(d,wh->param,class);
+      UPPER(class);
+      match = DoStrTest(class, wh->comparison, wh->data);
+      break;
+   case FIELD_REFDATE:
+      if(!sscanf(wh->data,"%d",&idata)) idata=0; /* Get WHERE date   */
+      match = DoIntTest(d->refdate, wh->comparison, idata);
+      break;
+   case FIELD_LFR1:
+      FillFW("LFR1",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_LFR2:
+      FillFW("LFR2",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_LFR3:
+      FillFW("LFR3",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_LFR4:
+      FillFW("LFR4",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_HFR1:
+      FillFW("HFR1",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_HFR2:
+      FillFW("HFR2",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_HFR3:
+      FillFW("HFR3",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_HFR4:
+      FillFW("HFR4",d,loop);
+      match = DoSeqTest(loop, NULL, wh);
+      break;
+   case FIELD_IDENTITY:
+      if(!sscanf(wh->data,"%d",&idata)) idata=0; /* Get WHERE value  */
+      match = DoIntTest(PercentIdentity(wh->entry, d), wh->comparison,
+                        idata);
+      break;
+   default:
+      *ok = FALSE;
+      break;
+   }
+
+   return(match);
+}
+
+
+/************************************************************************/
+/*>static BOOL ParallelMatch(WHERE *wh, int StackDepth)
+   ----------------------------------------------------
+   Input:   WHERE *wh         An item from the WHERE clause linked list
+            int   StackDepth  Stack depth including the new set
+   Returns: BOOL              Success?
+
+   Sets the new set on the stack by testing every entry with the WHERE
+   item, splitting the entries between threads. Used for the slower
+   approximate sequence matches.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Records the access and entries tested in wh->stats
+            When run in batches, fills the set kept by the batches and
+            only tests the entries listed by BatchEntries()
+            Fails if a test failed in any thread
+*/
+static BOOL ParallelMatch(WHERE *wh, int StackDepth)
+{
+   MATCHJOB job;
+   DATA     *d;
+   int      NData = 0,
+            i;
+   BOOL     ok    = TRUE;
+
+   wh->stats.access = ACCESS_PARALLEL;
+   job.wh      = wh;
+   job.depth   = StackDepth;
+   job.set     = NULL;
+   job.entries = NULL;
+   for(i=0; i<MAXTHREADS; i++)
+      job.ok[i] = TRUE;
+
+   if(UseBatches())
+   {
+      if((job.entries = BatchEntries(wh, StackDepth, &(job.set), &NData))
+         ==NULL)
+      {
+         fprintf(stderr,"Error: No memory for search\n");
+         return(FALSE);
+      }
+      job.data = gColumns->rows;
+   }
+   else
+   {
+      for(d=gData; d!=NULL; NEXT(d))
+         NData++;
+      if((job.data = (DATA **)malloc((NData+1) * sizeof(DATA *)))==NULL)
+      {
+         fprintf(stderr,"Error: No memory for search\n");
+         return(FALSE);
+      }
+      for(d=gData, i=0; d!=NULL; NEXT(d), i++)
+         job.data[i] = d;
+   }
+   wh->stats.tested = NData;
+
+   if(NData > 0)
+      ParallelFor(NData, GetNThreads(NData, MINTHREADDATA), MatchEntries,
+                  (void *)&job);
+   for(i=0; i<MAXTHREADS; i++)
+      ok = ok && job.ok[i];
+
+   if(job.entries != NULL)
+      free(job.entries);
+   else
+      free(job.data);
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static void MatchEntries(int start, int stop, int thread, void *data)
    ---------------------------------------------------------------------
-   Input:   char *text         The data text
+   Input:   int   start     First entry to test
+            int   stop      One beyond the last entry to test
+            int   thread    Thread number
+            void  *data     The MATCHJOB
+
+   Tests entries start to stop-1 for ParallelMatch().
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Timed by the thread's hot-path counters
+            Fills the set of the batches with the listed entries
+            Stops and clears the thread's ok flag if a test fails
+*/
+static void MatchEntries(int start, int stop, int thread, void *data)
+{
+   MATCHJOB *job = (MATCHJOB *)data;
+   BOOL     ok   = TRUE;
+   int      i,
+            e;
+   STATTIMER(ticks)
+
+   STATSTART(ticks);
+   for(i=start; ok && i<stop; i++)
+   {
+      if(job->set != NULL)
+      {
+         e = job->entries[i];
+         job->set[e] = (unsigned char)
+                       (TestEntry(job->data[e], job->wh, &ok) != FALSE);
+      }
+      else
+      {
+         job->data[i]->active[job->depth-1] = TestEntry(job->data[i],
+                                                        job->wh, &ok);
+      }
+   }
+   if(!ok)
+      job->ok[thread] = FALSE;
+   STATTESTTIME(job->wh->type, ticks);
+}
+
+
+/************************************************************************/
+/*>BOOL DoStrTest(char *text, int comparison, char *subtext)
+   ----------------------------------------------------------
+   Input:   char *text         The data text (upper case)
             int  comparison    The comparison type
-            char *subtext      The text we are searching for
-            BOOL fuzzy         Ignore -'s in either string
+            char *subtext      The text to search for (upper case)
    Returns: BOOL               Match?
 
    Compares 2 strings using the mode specified by comparison. Not case
-   sensitive.
+   sensitive since both strings are already in upper case.
 
    20.04.94 Original    By: ACRM
    26.04.94 Added fuzzy parameter
    15.12.95 Changed call to strstr() to use QueryStrStr()
+   19.10.26 No longer converts the strings to upper case (which changed
+            the data). Fuzzy matching moved to DoSeqTest()
 */
-BOOL DoStrTest(char *text, int comparison, char *subtext, BOOL fuzzy)
+BOOL DoStrTest(char *text, int comparison, char *subtext)
 {
-   UPPER(text);
-   UPPER(subtext);
-   
    switch(comparison)
    {
    case COMP_EQ:
@@ -459,14 +819,7 @@ BOOL DoStrTest(char *text, int comparison, char *subtext, BOOL fuzzy)
       if(strcmp(text,subtext))           return(TRUE);
       break;
    case COMP_SIM:
-      if(fuzzy)
-      {
-         if(fuzzystrstr(text,subtext))   return(TRUE);
-      }
-      else
-      {
-         if(blQueryStrStr(text,subtext)!=NULL)  return(TRUE);
-      }
+      if(blQueryStrStr(text,subtext)!=NULL)  return(TRUE);
       break;
    default:
       break;
@@ -476,63 +829,85 @@ BOOL DoStrTest(char *text, int comparison, char *subtext, BOOL fuzzy)
 
 
 /************************************************************************/
-/*>BOOL fuzzystrstr(char *text, char *subtext)
-   -------------------------------------------
-   Input:   char  *text       String in which to search
-            char  *subtext    Substring for which to look
-   Returns: BOOL              Found?
-
-   Like strstr(), but ignores -'s in either string. Also returns BOOL
-   (found?) rather than a pointer into the string.
-
-   26.04.94 Original    By: ACRM
-   22.06.95 Added checks on blank strings and string lengths
-   23.06.95 Initialise SubText to NULL
-   27.06.95 malloc() for SubText was being done wrong!
-   15.12.95 Changed call to strstr() to use QueryStrStr()
+/*>BOOL DoSeqTest(char *seq, char *ungapped, WHERE *wh)
+   ----------------------------------------------------
+   Input:   char  *seq         The sequence as stored (with -'s)
+            char  *ungapped    The sequence with the -'s removed or
+                               NULL if there is no ungapped copy
+            WHERE *wh          The WHERE item
+   Returns: BOOL               Match?
+
+   Compares a sequence with the data from a WHERE item. Equality tests
+   use the sequence as stored; substring tests ignore -'s in either
+   string. The ungapped copies made when the data were read are
+   searched with SeqMatch(); other sequences (loops and frameworks
+   extracted during the search) are searched with fuzzystrstr() which
+   skips the -'s as it goes. MISMATCH() and SIMILAR() tests use
+   HammingMatch() and EditMatch() on the sequence without -'s. WITHIN()
+   tests use EditDistance() on the whole sequence without -'s; a
+   sequence which is only -'s does not match.
+
+   19.10.26 Original - split out of DoStrTest()    By: ACRM
+   19.10.26 Added MISMATCH() and SIMILAR()
+   19.10.26 Added WITHIN()
 */
-BOOL fuzzystrstr(char *text, char *subtext)
+BOOL DoSeqTest(char *seq, char *ungapped, WHERE *wh)
 {
-   char *Text,
-        *SubText = NULL,
-        *ptr = NULL;
+   char buffer[LARGEBUFF];
    int  i,
         j;
+   
+   if((wh->comparison != COMP_SIM) &&
+      (wh->comparison != COMP_MISMATCH) &&
+      (wh->comparison != COMP_SIMILAR) &&
+      (wh->comparison != COMP_WITHIN))
+      return(DoStrTest(seq, wh->comparison, wh->data));
 
    /* Both are blank strings                                            */
-   if(!text[0] && !subtext[0])
+   if(!seq[0] && !wh->data[0])
       return(TRUE);
    
    /* One is a blank string                                             */
-   if(!text[0] || !subtext[0])
+   if(!seq[0] || !wh->data[0])
       return(FALSE);
 
-   /* Test if substring is longer than main string                      */
-   if(strlen(text) < strlen(subtext))
-      return(FALSE);
-   
-   if((Text = malloc((strlen(text)+1)*sizeof(char)))!=NULL)
+   if(wh->comparison == COMP_SIM)
    {
-      if((SubText = malloc((strlen(subtext)+1)*sizeof(char)))!=NULL)
-      {
-         for(i=0, j=0; text[i]; i++)
-            if(text[i] != '-')    Text[j++]    = text[i];
-         Text[j]    = '\0';
-         
-         for(i=0, j=0; subtext[i]; i++)
-            if(subtext[i] != '-') SubText[j++] = subtext[i];
-         SubText[j] = '\0';
+      /* Test if substring is longer than main string                   */
+      if(strlen(seq) < strlen(wh->data))
+         return(FALSE);
+
+      if(ungapped == NULL)
+         return(fuzzystrstr(seq, wh->pattern));
 
-         ptr = blQueryStrStr(Text,SubText);
-      }         
+      return(SeqMatch(ungapped, strlen(ungapped), wh->pattern, 
+                      &(wh->matcher)));
+   }
+
+   /* Approximate matches need the sequence without -'s                 */
+   if(ungapped == NULL)
+   {
+      for(i=0, j=0; seq[i] && (j < LARGEBUFF-1); i++)
+      {
+         if(seq[i] != '-')
+            buffer[j++] = seq[i];
+      }
+      buffer[j] = '\0';
+      ungapped  = buffer;
    }
 
-   if(Text    != NULL) free(Text);
-   if(SubText != NULL) free(SubText);
+   if(wh->comparison == COMP_WITHIN)
+   {
+      return(ungapped[0] &&
+             (EditDistance(ungapped, strlen(ungapped), wh->pattern,
+                           wh->matcher.length, TRUE)
+              <= wh->matcher.errors));
+   }
 
-   if(ptr     != NULL) return(TRUE);
+   if(wh->comparison == COMP_MISMATCH)
+      return(HammingMatch(ungapped, strlen(ungapped), &(wh->matcher)));
 
-   return(FALSE);
+   return(EditMatch(ungapped, strlen(ungapped), &(wh->matcher)));
 }
 
 
@@ -677,6 +1052,9 @@ BOOL IsComplete(DATA *d)
             int  StackDepth    Current stack depth
 
    Displays the selection specified by the top item on the stack.
+   The hits are sorted if ORDER BY has been given, the first gOffset 
+   hits are skipped and, if gLimit is set, output stops after gLimit 
+   hits have been displayed.
    
    20.04.94 Original    By: ACRM
    21.04.94 Added commas between fields. Added output file pointer.
@@ -701,18 +1079,29 @@ BOOL IsComplete(DATA *d)
             Fixed a bug in PIR writing. When writing to a file with
             multiple hits, the output would be corrupted as the file
             was opened for writing multiple times.
+   19.10.26 Added gOffset and gLimit handling. Now works from an array
+            of hits which is sorted if gOrderBy is set. Field values
+            now come from GetFieldText(). Duplicates are removed from the
+            array if gDistinct is set
+            Sets gNRows
+            Times the steps for EXPLAIN ANALYZE
+            Rows and bytes written counted by STAT_OUTPUT
+            RemoveDupes() traced
 */
 void DisplaySearch(FILE *fp, int StackDepth)
 {
-   DATA      *d;
+   DATA      *d,
+             **hits     = NULL;
    SELECTION *p;
    FILE      *fpPIR     = fp;
    FILE      *fpSEQ     = fp;
-   char      loop[160],
-             class[8],
-             res;
-   int       len,
-             NHits      = 0;
+   char      text[LARGEBUFF];
+   int       i,
+             NHits      = 0,
+             NFound     = 0,
+             MaxHits    = 0,
+             First,
+             Last;
    BOOL      first,
              GotPrint   = FALSE,
              openedPIR  = FALSE,
@@ -722,203 +1111,119 @@ void DisplaySearch(FILE *fp, int StackDepth)
       return;
    
    if(gVariability > 0.0)
+   {
+      BeginStep(ExplainStage(STAGE_VARIABILITY), ExplainCount(StackDepth));
+      TraceBegin(0, "RemoveDupes", NULL);
       RemoveDupes(StackDepth);
-   
-   for(d=gData; d!=NULL; NEXT(d))
+      TraceEnd(0);
+      EndStep(ExplainStage(STAGE_VARIABILITY), ExplainCount(StackDepth));
+   }
+
+   /* If the hits don't need sorting, we only need to collect as far as
+      the last one to be displayed
+   */
+   if(gLimit && (gOrderBy == NULL))
+      MaxHits = gOffset + gLimit;
+
+   if(!CollectHits(StackDepth, (gDistinct ? 0 : MaxHits), &hits, &NFound))
    {
-      if(d->active[StackDepth-1])
+      fprintf(stderr,"Error: No memory for hit list\n");
+      return;
+   }
+
+   /* Remove duplicates before anything is sorted or formatted          */
+   if(gDistinct)
+   {
+      BeginStep(ExplainStage(STAGE_DISTINCT), NFound);
+      if(!DistinctHits(hits, &NFound, MaxHits))
       {
-         first = TRUE;
-         NHits++;
+         fprintf(stderr,"Error: No memory for DISTINCT\n");
+         free(hits);
+         return;
+      }
+      EndStep(ExplainStage(STAGE_DISTINCT), NFound);
+   }
+
+   if(gOrderBy != NULL)
+   {
+      BeginStep(ExplainStage(STAGE_ORDER), NFound);
+      if(!SortHits(hits, NFound, (gLimit ? gOffset+gLimit : 0)))
+      {
+         fprintf(stderr,"Error: No memory to sort hits\n");
+         free(hits);
+         return;
+      }
+      EndStep(ExplainStage(STAGE_ORDER), NFound);
+   }
+
+   /* Work out the range of hits to be displayed                        */
+   First = MIN(gOffset, NFound);
+   Last  = (gLimit ? MIN(NFound, gOffset+gLimit) : NFound);
+   
+   BeginStep(ExplainStage(STAGE_DISPLAY), NFound);
+   for(i=First; i<Last; i++)
+   {
+      d     = hits[i];
+      first = TRUE;
+      NHits++;
          
-         for(p=gSelectClause; p!=NULL; NEXT(p))
+      for(p=gSelectClause; p!=NULL; NEXT(p))
+      {
+         if(first)
+            first = FALSE;
+         else
+         {
+            fputc(gDelim,fp);   /* 14.10.98 Instead of hardcoded        */
+            fputc(' ',fp);
+            STATAMOUNT(STAT_OUTPUT, 2);
+         }
+               
+         switch(p->type)
          {
-            if(first)
-               first = FALSE;
-            else
+         case FIELD_PIR:
+            if(p->param[0] && !openedPIR)
             {
-               fputc(gDelim,fp);   /* 14.10.98 Instead of hardcoded     */
-               fputc(' ',fp);
+               if((fpPIR=fopen(p->param,"w"))==NULL)
+                  fpPIR = fp;
+               openedPIR = TRUE;
             }
-               
-            switch(p->type)
+            WriteAsPIR(fpPIR,d);
+            break;
+         case FIELD_SEQUENCE:
+            if(p->param[0] && !openedSEQ)
             {
-            case FIELD_NAME:
-               fprintf(fp,"%s",d->name);
-               GotPrint = TRUE;
-               break;
-            case FIELD_ANTIGEN:
-               fprintf(fp,"%s",d->antigen);
-               GotPrint = TRUE;
-               break;
-            case FIELD_L1:
-               FillLoop("L1", d, loop);
-               fprintf(fp,"%s",loop);
-               GotPrint = TRUE;
-               break;
-            case FIELD_L2:
-               FillLoop("L2", d, loop);
-               fprintf(fp,"%s",loop);
-               GotPrint = TRUE;
-               break;
-            case FIELD_L3:
-               FillLoop("L3", d, loop);
-               fprintf(fp,"%s",loop);
-               GotPrint = TRUE;
-               break;
-            case FIELD_H1:
-               FillLoop("H1", d, loop);
-               fprintf(fp,"%s",loop);
-               GotPrint = TRUE;
-               break;
-            case FIELD_H2:
-               FillLoop("H2", d, loop);
-               fprintf(fp,"%s",loop);
-               GotPrint = TRUE;
-               break;
-            case FIELD_H3:
-               FillLoop("H3", d, loop);
-               fprintf(fp,"%s",loop);
-               GotPrint = TRUE;
-               break;
-            case FIELD_CLASS:
-               fprintf(fp,"%s",d->class);
-               GotPrint = TRUE;
-               break;
-            case FIELD_SOURCE:
-               fprintf(fp,"%s",d->source);
-               GotPrint = TRUE;
-               break;
-            case FIELD_REF:
-               fprintf(fp,"%s",d->reference);
-               GotPrint = TRUE;
-               break;
-            case FIELD_LENGTH:
-               FillLoop(p->param, d, loop);
-               len = blTrueSeqLen(loop);
-               fprintf(fp,"%d",len);
-               GotPrint = TRUE;
-               break;
-            case FIELD_RES:
-               res = GetResidue(d, p->param);
-               fprintf(fp,"%c",res);
-               GotPrint = TRUE;
-               break;
-            case FIELD_PIR:
-               if(p->param[0] && !openedPIR)
-               {
-                  if((fpPIR=fopen(p->param,"w"))==NULL)
-                     fpPIR = fp;
-                  openedPIR = TRUE;
-               }
-               WriteAsPIR(fpPIR,d);
-               break;
-            case FIELD_LIGHT:
-               fprintf(fp,"%s",d->light);
-               GotPrint = TRUE;
-               break;
-            case FIELD_HEAVY:
-               fprintf(fp,"%s",d->heavy);
-               GotPrint = TRUE;
-               break;
-            case FIELD_CANONICAL:
-               if(FindCanonical(d,p->param,class))
-               {
-                  fprintf(fp,"%s",class);
-                  GotPrint = TRUE;
-               }
-               break;
-            case FIELD_IDLIGHT:
-               fprintf(fp,"%s",d->idlight);
-               GotPrint = TRUE;
-               break;
-            case FIELD_IDHEAVY:
-               fprintf(fp,"%s",d->idheavy);
-               GotPrint = TRUE;
-               break;
-            case FIELD_URLLIGHT:
-               if(d->idlight[0])
-                  fprintf(fp,gURLFormat,d->idlight,d->idlight);
-               else
-                  fprintf(fp,"??????");
-               GotPrint = TRUE;
-               break;
-            case FIELD_URLHEAVY:
-               if(d->idheavy[0])
-                  fprintf(fp,gURLFormat,d->idheavy,d->idheavy);
-               else
-                  fprintf(fp,"??????");
-               GotPrint = TRUE;
-               break;
-            case FIELD_SUBGROUP:
-               GetSubgroup(d,p->param,class);
-               fprintf(fp,"%s",class);
-               GotPrint = TRUE;
-               break;
-            case FIELD_REFDATE:
-               fprintf(fp,"%d",d->refdate);
-               GotPrint = TRUE;
-               break;
-            case FIELD_LFR1:
-               FillFW("LFR1", d, loop);
-               fprintf(fp,"%s",loop);
-               GotPrint = TRUE;
-               break;
-            case FIELD_LFR2:
-               FillFW("LFR2", d, loop);
-               fprintf(fp,"%s",loop);
-               GotPrint = TRUE;
-               break;
-            case FIELD_LFR3:
-               FillFW("LFR3", d, loop);
-               fprintf(fp,"%s",loop);
-               GotPrint = TRUE;
-               break;
-            case FIELD_LFR4:
-               FillFW("LFR4", d, loop);
-               fprintf(fp,"%s",loop);
-               GotPrint = TRUE;
-               break;
-            case FIELD_HFR1:
-               FillFW("HFR1", d, loop);
-               fprintf(fp,"%s",loop);
-               GotPrint = TRUE;
-               break;
-            case FIELD_HFR2:
-               FillFW("HFR2", d, loop);
-               fprintf(fp,"%s",loop);
-               GotPrint = TRUE;
-               break;
-            case FIELD_HFR3:
-               FillFW("HFR3", d, loop);
-               fprintf(fp,"%s",loop);
-               GotPrint = TRUE;
-               break;
-            case FIELD_HFR4:
-               FillFW("HFR4", d, loop);
-               fprintf(fp,"%s",loop);
+               if((fpSEQ=fopen(p->param,"w"))==NULL)
+                  fpSEQ = fp;
+               openedSEQ = TRUE;
+            }
+            WriteNumberedSequence(fpSEQ,d);
+            break;
+         default:
+            if(GetFieldText(d, p->type, p->param, text))
+            {
+               fputs(text,fp);
+               STATAMOUNT(STAT_OUTPUT, strlen(text));
                GotPrint = TRUE;
-               break;
-            case FIELD_SEQUENCE:
-               if(p->param[0] && !openedSEQ)
-               {
-                  if((fpSEQ=fopen(p->param,"w"))==NULL)
-                     fpSEQ = fp;
-                  openedSEQ = TRUE;
-               }
-               WriteNumberedSequence(fpSEQ,d);
-               break;
-            default:
-               break;
             }
+            break;
          }
-         if(GotPrint) fprintf(fp,"\n");
       }
+      if(GotPrint)
+      {
+         fprintf(fp,"\n");
+         STATAMOUNT(STAT_OUTPUT, 1);
+      }
+      STATCOUNT(STAT_OUTPUT);
    }
+   EndStep(ExplainStage(STAGE_DISPLAY), NHits);
+
+   if(hits != NULL)
+      free(hits);
 
    if(gHTML) fprintf(fp,"<p><i>");
    fprintf(fp,"\n# Number of hits = %d (Dataset created %s)\n",
            NHits,gFileDate);
+   gNRows = NHits;
    if(gHTML) fprintf(fp,"</i><p>\n");
 
    if(fpPIR!=NULL && fpPIR!=stdout && fpPIR!=fp)
@@ -927,6 +1232,227 @@ void DisplaySearch(FILE *fp, int StackDepth)
 }
 
 
+/************************************************************************/
+/*>BOOL GetFieldText(DATA *d, int type, char *param, char *text)
+   -------------------------------------------------------------
+   Input:   DATA  *d        A data entry
+            int   type      Field type
+            char  *param    Field parameter
+   Output:  char  *text     The field value as text (must be at least
+                            LARGEBUFF long)
+   Returns: BOOL            Does this field have a textual value?
+
+   Gets the text which is displayed for a field. Returns FALSE for
+   fields which produce no text (PIR, SEQUENCE, COMPLETE, VARIABILITY)
+   or if the canonical class cannot be obtained.
+
+   19.10.26 Original    By: ACRM (taken from DisplaySearch())
+   19.10.26 Added IDENTITY
+*/
+BOOL GetFieldText(DATA *d, int type, char *param, char *text)
+{
+   DATA *e;
+
+   text[0] = '\0';
+   
+   switch(type)
+   {
+   case FIELD_NAME:
+      strcpy(text,d->name);
+      break;
+   case FIELD_ANTIGEN:
+      strcpy(text,GetColdData(d)->antigen);
+      break;
+   case FIELD_L1:
+      FillLoop("L1", d, text);
+      break;
+   case FIELD_L2:
+      FillLoop("L2", d, text);
+      break;
+   case FIELD_L3:
+      FillLoop("L3", d, text);
+      break;
+   case FIELD_H1:
+      FillLoop("H1", d, text);
+      break;
+   case FIELD_H2:
+      FillLoop("H2", d, text);
+      break;
+   case FIELD_H3:
+      FillLoop("H3", d, text);
+      break;
+   case FIELD_CLASS:
+      strcpy(text,d->class);
+      break;
+   case FIELD_SOURCE:
+      strcpy(text,d->source);
+      break;
+   case FIELD_REF:
+      strcpy(text,GetColdData(d)->reference);
+      break;
+   case FIELD_LENGTH:
+      FillLoop(param, d, text);
+      sprintf(text,"%d",blTrueSeqLen(text));
+      break;
+   case FIELD_RES:
+      text[0] = GetResidue(d, param);
+      text[1] = '\0';
+      break;
+   case FIELD_LIGHT:
+      strcpy(text,d->light);
+      break;
+   case FIELD_HEAVY:
+      strcpy(text,d->heavy);
+      break;
+   case FIELD_CANONICAL:
+      if(!FindCanonical(d,param,text))
+         return(FALSE);
+      break;
+   case FIELD_IDLIGHT:
+      strcpy(text,d->idlight);
+      break;
+   case FIELD_IDHEAVY:
+      strcpy(text,d->idheavy);
+      break;
+   case FIELD_URLLIGHT:
+      if(d->idlight[0])
+         sprintf(text,gURLFormat,d->idlight,d->idlight);
+      else
+         strcpy(text,"??????");
+      break;
+   case FIELD_URLHEAVY:
+      if(d->idheavy[0])
+         sprintf(text,gURLFormat,d->idheavy,d->idheavy);
+      else
+         strcpy(text,"??????");
+      break;
+   case FIELD_SUBGROUP:
+      GetSubgroup(d,param,text);
+      break;
+   case FIELD_REFDATE:
+      sprintf(text,"%d",d->refdate);
+      break;
+   case FIELD_LFR1:
+      FillFW("LFR1", d, text);
+      break;
+   case FIELD_LFR2:
+      FillFW("LFR2", d, text);
+      break;
+   case FIELD_LFR3:
+      FillFW("LFR3", d, text);
+      break;
+   case FIELD_LFR4:
+      FillFW("LFR4", d, text);
+      break;
+   case FIELD_HFR1:
+      FillFW("HFR1", d, text);
+      break;
+   case FIELD_HFR2:
+      FillFW("HFR2", d, text);
+      break;
+   case FIELD_HFR3:
+      FillFW("HFR3", d, text);
+      break;
+   case FIELD_HFR4:
+      FillFW("HFR4", d, text);
+      break;
+   case FIELD_IDENTITY:
+      if((e = FindEntry(param)) == NULL)
+         return(FALSE);
+      sprintf(text,"%d",PercentIdentity(e, d));
+      break;
+   default:
+      return(FALSE);
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>DATA *FindEntry(char *name)
+   ---------------------------
+   Input:   char  *name     Entry name (any case)
+   Returns: DATA  *         The first entry with this name (NULL if
+                            there is none)
+   Globals: DATA  *gData    The data
+
+   Finds an entry by name.
+
+   19.10.26 Original    By: ACRM
+*/
+DATA *FindEntry(char *name)
+{
+   DATA *d;
+   char upper[MAXBUFF];
+
+   strncpy(upper, name, MAXBUFF-1);
+   upper[MAXBUFF-1] = '\0';
+   UPPER(upper);
+
+   for(d=gData; d!=NULL; NEXT(d))
+   {
+      if(!strcmp(d->UpperName, upper))
+         return(d);
+   }
+
+   return(NULL);
+}
+
+
+/************************************************************************/
+/*>BOOL CollectHits(int StackDepth, int MaxHits, DATA ***pHits, 
+                    int *NHits)
+   -------------------------------------------------------------
+   Input:   int   StackDepth  Current stack depth
+            int   MaxHits     Stop after this many hits (0 = all)
+   Output:  DATA  ***pHits    Allocated array of hits
+            int   *NHits      Number of hits in the array
+   Returns: BOOL              Success (FALSE if no memory)
+
+   Builds an array of pointers to the entries flagged at the top of the
+   stack in load order. The array must be freed by the caller.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL CollectHits(int StackDepth, int MaxHits, DATA ***pHits, int *NHits)
+{
+   DATA *d,
+        **hits,
+        **newhits;
+   int  size = 256;
+
+   *NHits = 0;
+   if((hits = (DATA **)malloc(size * sizeof(DATA *)))==NULL)
+      return(FALSE);
+
+   for(d=gData; d!=NULL; NEXT(d))
+   {
+      if(d->active[StackDepth-1])
+      {
+         if(*NHits == size)
+         {
+            size *= 2;
+            if((newhits = (DATA **)realloc(hits, size * sizeof(DATA *)))
+               ==NULL)
+            {
+               free(hits);
+               return(FALSE);
+            }
+            hits = newhits;
+         }
+         hits[(*NHits)++] = d;
+
+         if(MaxHits && (*NHits >= MaxHits))
+            break;
+      }
+   }
+
+   *pHits = hits;
+   return(TRUE);
+}
+
+
 /************************************************************************/
 /*>void FillLoop(char *loopname, DATA *d, char *loop)
    --------------------------------------------------
@@ -934,13 +1460,39 @@ void DisplaySearch(FILE *fp, int StackDepth)
             DATA  *d            A data structure
    Output:  char  *loop         The sequence of the specified loop
 
+   Globals: int   gLoopMode     The loop definition to use
+
    Extracts the sequence for a specified loop from a data structure
 
    25.04.94 Original    By: ACRM
    31.07.00 Added CONTACT loop definitions
    24.08.06 Added additional (-1) parameter to GetKabatOffset()
+   19.10.26 Now just calls FillLoopMode()
 */
 void FillLoop(char *loopname, DATA *d, char *loop)
+{
+   FillLoopMode(loopname, d, loop, gLoopMode);
+}
+
+
+/************************************************************************/
+/*>void FillLoopMode(char *loopname, DATA *d, char *loop, int LoopMode)
+   -------------------------------------------------------------------
+   Input:   char  *loopname     The loop name (L1...H3)
+            DATA  *d            A data structure
+            int   LoopMode      The loop definition to use (LOOP_KABAT,
+                                LOOP_ABM, LOOP_CHOTHIA or LOOP_CONTACT)
+   Output:  char  *loop         The sequence of the specified loop
+
+   Extracts the sequence for a specified loop from a data structure
+   using the specified loop definition rather than the global one so
+   that it may be called from several threads at once.
+
+   19.10.26 Original    By: ACRM (taken from FillLoop())
+   19.10.26 Returns the blank string if the chain is missing rather than
+            copying from beyond its end
+*/
+void FillLoopMode(char *loopname, DATA *d, char *loop, int LoopMode)
 {
    int  i,
         j,
@@ -961,7 +1513,7 @@ void FillLoop(char *loopname, DATA *d, char *loop)
       if(!blUpstrncmp(loopname,gLoopDefs[i].name,2))
       {
          /* Found the required loop, get the start and end              */
-         switch(gLoopMode)
+         switch(LoopMode)
          {
          case LOOP_KABAT:
             strcpy(start, gLoopDefs[i].KabatS);
@@ -995,6 +1547,9 @@ void FillLoop(char *loopname, DATA *d, char *loop)
             KabatIndex = d->HNumbers;
          }
          
+         /* No loop if there is no chain                                */
+         if(chain[0] == '\0')
+            return;
 
          /* Build residues into the output loop array                   */
          StartOff = GetKabatOffset(KabatIndex, start, -1);
@@ -1064,6 +1619,9 @@ char GetResidue(DATA *d, char *resid)
             data file. If this is so, the flag gCanonChothiaNum is
             set and the ChoKab() routine is called to convert each
             residue number before testing
+   19.10.26 Uses FillLoopMode() rather than changing gLoopMode so that
+            it may be called from several threads at once
+            Timed by STAT_CANONICAL
 */
 BOOL FindCanonical(DATA *d, char *LoopID, char *class)
 {
@@ -1074,8 +1632,8 @@ BOOL FindCanonical(DATA *d, char *LoopID, char *class)
            LoopSeq[40];
    BOOL    Matched;
    int     i,
-           LoopLen,
-           LoopMode;
+           LoopLen;
+   STATTIMER(start)
 
    /* Initialise class to unknown                                       */
    strcpy(class,"?");
@@ -1083,17 +1641,15 @@ BOOL FindCanonical(DATA *d, char *LoopID, char *class)
    if(gChothia == NULL)
       return(FALSE);
 
+   STATSTART(start);
+
    /* Get the chain id from the loop id                                 */
    chain = LoopID[0];
    if(islower(chain))
       chain = toupper(chain);
    
-   /* Store the current loop mode and switch to AbM                     */
-   LoopMode  = gLoopMode;
-   gLoopMode = LOOP_ABM;    
-   
-   /* Get the loop length                                               */
-   FillLoop(LoopID,d,LoopSeq);
+   /* Get the loop length using the AbM definition                      */
+   FillLoopMode(LoopID,d,LoopSeq,LOOP_ABM);
    LoopLen = blTrueSeqLen(LoopSeq);
    
    for(p=gChothia; p!=NULL; NEXT(p))      /* Go through Chothia data    */
@@ -1123,14 +1679,14 @@ BOOL FindCanonical(DATA *d, char *LoopID, char *class)
                   */
                   if(ResID[0] == 'L' || ResID[0] == 'l')
                   {
-                     FillLoop("L1",d,LoopSeq);
+                     FillLoopMode("L1",d,LoopSeq,LOOP_ABM);
                      res = GetResidue(d, ChoKab("L1", 
                                                 blTrueSeqLen(LoopSeq),
                                                 ResID));
                   }
                   else
                   {
-                     FillLoop("H1",d,LoopSeq);
+                     FillLoopMode("H1",d,LoopSeq,LOOP_ABM);
                      res = GetResidue(d, ChoKab("H1", 
                                                 blTrueSeqLen(LoopSeq),
                                                 ResID));
@@ -1149,23 +1705,21 @@ BOOL FindCanonical(DATA *d, char *LoopID, char *class)
                }
             }
             
-            /* If we still have a match, then copy in the class data, 
-               restore the loop mode and return
-               */
+            /* If we still have a match, then copy in the class data 
+               and return
+            */
             if(Matched)
             {
                strcpy(class,p->class);
-               gLoopMode  = LoopMode;
+               STATSTOP(STAT_CANONICAL, start);
                return(TRUE);
             }
          }  /* Correct loop id                                          */
       }  /* Correct loop length                                         */
    }  /* Step through Chothia data                                      */
 
-   /* We didn't find it, but we still return TRUE (after restoring the
-      loop mode
-   */
-   gLoopMode  = LoopMode;
+   /* We didn't find it, but we still return TRUE                       */
+   STATSTOP(STAT_CANONICAL, start);
    return(TRUE);
 }
 
@@ -1176,19 +1730,60 @@ BOOL FindCanonical(DATA *d, char *LoopID, char *class)
    Input:    int   StackDepth        Depth of stack. Must be 1
 
    Runs through the top of the stack and compares the sequences to
-   remove near-duplicates.
+   remove near-duplicates. If there are at least gLSHMinData entries
+   and the cutoff is at least LSHMINIDENTITY, each is only compared
+   with the candidates from the LSH (which may miss a few).
 
    25.01.95 Original   By: ACRM
    23.06.95 Removed redundant variables
+   19.10.26 Uses the LSH for large data sets
 */
 void RemoveDupes(int StackDepth)
 {
-   DATA *d, *e;
+   DATA     *d, *e;
+   LSHINDEX *lsh;
+   int      *cand,
+            NActive = 0,
+            NCand,
+            entry,
+            i;
 
    /* Check that there is only one item in the stack                    */
    if(StackDepth != 1)
       return;
 
+   /* With many entries, only compare those the LSH finds may be similar
+      (an entry is only compared with entries after it as below)
+   */
+   for(d=gData; d!=NULL; NEXT(d))
+   {
+      if(d->active[0])
+         NActive++;
+   }
+   if(gLSHMinData && (NActive >= gLSHMinData) &&
+      (gVariability >= LSHMINIDENTITY) &&
+      ((lsh = GetLSHIndex()) != NULL) &&
+      ((cand = (int *)malloc(lsh->NData * sizeof(int))) != NULL))
+   {
+      for(entry=0; entry<lsh->NData; entry++)
+      {
+         d = lsh->data[entry];
+         if(!d->active[0])
+            continue;
+
+         NCand = LSHCandidates(lsh, entry, cand);
+         for(i=0; i<NCand; i++)
+         {
+            e = lsh->data[cand[i]];
+            if((cand[i] > entry) && e->active[0] &&
+               TooSimilar(d,e,gVariability))
+               e->active[0] = FALSE;
+         }
+      }
+      free(cand);
+      return;
+   }
+
    for(d=gData; d!=NULL; NEXT(d))
    {
       if(d->active[0])
@@ -1208,135 +1803,6 @@ void RemoveDupes(int StackDepth)
 }
 
 
-/************************************************************************/
-/*>BOOL TooSimilar(DATA *d, DATA *e, REAL Cutoff)
-   ----------------------------------------------
-   Input:    DATA     *d       Pointer to a data entry
-             DATA     *e       Pointer to a data entry
-             REAL     Cutoff   Percentage identity cutoff
-   Returns:  BOOL              True of identity > Cutoff 
-
-   Calculates a percentage identity between two antibodies. A missing
-   chain in one of the sequences is not penalised. Each mismatch
-   scores a penalty of 100/MeanLength % and deletions in one sequence 
-   wrt the other score a double penalty.
-
-   Returns immediately the identity falls below the specified Cutoff
-
-   25.01.95 Original    By: ACRM
-   26.01.95 Modified from SimilarityScore()
-*/
-BOOL TooSimilar(DATA *d, DATA *e, REAL Cutoff)
-{
-   int  i,
-        Length1,
-        Length2;
-   REAL MeanLength,
-        LScore = (REAL)100.0,
-        HScore = (REAL)100.0,
-        Score,
-        Penalty,
-        TwoPenalty,
-        TwoCutoff,
-        TwoCutMinus100;
-   BOOL LDone = FALSE,
-        HDone = FALSE;
-
-   TwoCutoff      = (REAL)2.0*Cutoff;
-   TwoCutMinus100 = TwoCutoff - (REAL)100.0;
-
-   LDone = (d->light[0] && e->light[0]);
-   HDone = (d->heavy[0] && e->heavy[0]);
-
-   /* Compare the light chains                                          */
-   if(LDone)
-   {
-      /* Calculate the mean sequence length and mismatch penalty        */
-      Length1    = blTrueSeqLen(d->light);
-      Length2    = blTrueSeqLen(e->light);
-      MeanLength = (REAL)(Length1+Length2)/(REAL)2.0;
-      Penalty    = (REAL)100.0/MeanLength;
-      TwoPenalty = (REAL)2.0 * Penalty;
-
-      /* For each residue in the light chain, decrement the score if there
-         is a mismatch
-      */
-      for(i=0; i<strlen(d->light); i++)
-      {
-         if(d->light[i] != e->light[i])   /* A mismatch                 */
-         {
-            /* If one was a deletion wrt to the other, double penalty   */
-            if((d->light[i] == '-') || (e->light[i] == '-'))
-               LScore -= TwoPenalty;
-            else
-               LScore -= Penalty;
-
-            /* This is an optimisation of 
-               ((LScore+100.0)/2.0 < Cutoff)
-            */
-            if(LScore < TwoCutMinus100)
-               return(FALSE);
-         }
-      }
-   }
-   
-   /* Compare the heavy chains                                          */
-   if(HDone)
-   {
-      /* Calculate the mean sequence length and mismatch penalty        */
-      Length1    = blTrueSeqLen(d->heavy);
-      Length2    = blTrueSeqLen(e->heavy);
-      MeanLength = (REAL)(Length1+Length2)/(REAL)2.0;
-      Penalty    = (REAL)100.0/MeanLength;
-      TwoPenalty = (REAL)2.0 * Penalty;
-
-      /* For each residue in the heavy chain, decrement the score if there
-         is a mismatch
-      */
-      for(i=0; i<strlen(d->heavy); i++)
-      {
-         if(d->heavy[i] != e->heavy[i])   /* A mismatch                 */
-         {
-            /* If one was a deletion wrt to the other, double penalty   */
-            if((d->heavy[i] == '-') || (e->heavy[i] == '-'))
-               HScore -= TwoPenalty;
-            else
-               HScore -= Penalty;
-
-            /* This is an optimisation of 
-               ((HScore+LScore)/2.0 < Cutoff)
-            */
-            if((HScore+LScore) < TwoCutoff)
-               return(FALSE);
-         }
-      }
-   }
-
-   /* Calculate the score based on which comparisons were performed     */
-   if(LDone && HDone)
-   {
-      Score = (LScore + HScore) / (REAL)2.0;
-   }
-   else if(LDone)
-   {
-      Score = LScore;
-   }
-   else if(HDone)
-   {
-      Score = HScore;
-   }
-   else
-   {
-      Score = (REAL)100.0;
-   }
-
-   if(Score < Cutoff)
-      return(FALSE);
-
-   return(TRUE);
-}
-
-
 /************************************************************************/
 /*>void GetSubgroup(DATA *d, char *chain, char *subgroup)
    ------------------------------------------------------
@@ -1348,22 +1814,28 @@ BOOL TooSimilar(DATA *d, DATA *e, REAL Cutoff)
    subgroup of a human sequence.
 
    09.09.97 Original   By: ACRM
+   19.10.26 Timed by STAT_SUBGROUP
+   19.10.26 No longer upper-cases the chain in place since the parameter
+            is shared by the threads of a GROUP BY
 */
 void GetSubgroup(DATA *d, char *chain, char *subgroup)
 {
-   char class[16];
+   char class[16],
+        ch;
+   STATTIMER(start)
 
-   *chain = (islower(*chain) ? toupper(*chain) : *chain);
+   STATSTART(start);
+   ch = (islower(*chain) ? toupper(*chain) : *chain);
    
    if(!strncmp(d->source,"HUMAN",5))
    {
-      if(*chain == 'L')
+      if(ch == 'L')
       {
          DoGetSubgroup(d->light, class, subgroup);
          if(!strstr(d->class, class))
             strcpy(subgroup,"?");
       }
-      else if(*chain == 'H')
+      else if(ch == 'H')
       {
          DoGetSubgroup(d->heavy, class, subgroup);
       }
@@ -1372,6 +1844,7 @@ void GetSubgroup(DATA *d, char *chain, char *subgroup)
    {
       strcpy(subgroup,"?");
    }
+   STATSTOP(STAT_SUBGROUP, start);
 }
 
 
@@ -1491,7 +1964,8 @@ void WriteAsPIR(FILE *fp, DATA *d)
    }
    fprintf(fp,"\n");
 
-   fprintf(fp,"%s - (%s) %s", buffer, d->source, d->fsource);
+   fprintf(fp,"%s - (%s) %s", buffer, d->source,
+           GetColdData(d)->fsource);
    if(strlen(d->light)==0)
       fprintf(fp," (HEAVY CHAIN)");
    else if(strlen(d->heavy)==0)
@@ -1540,6 +2014,7 @@ void WriteAsPIR(FILE *fp, DATA *d)
 
    28.02.05 Original    By: ACRM
    24.08.06 Added additional (-1) parameter to GetKabatOffset()
+   19.10.26 Returns the blank string if the chain is missing
 */
 void FillFW(char *fwname, DATA *d, char *framework)
 {
@@ -1612,6 +2087,9 @@ void FillFW(char *fwname, DATA *d, char *framework)
       KabatIndex = d->HNumbers;
    }
 
+   /* No framework if there is no chain                                 */
+   if(chain[0] == '\0')
+      return;
 
    /* Search the loop definition table for this loop                    */
    if(strlen(pre) == 0)
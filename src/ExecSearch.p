@@ -1,12 +1,16 @@
 BOOL ExecuteSearch(char *filename)
 ;
+int ScanLimit(void)
+;
 BOOL HandleLogical(WHERE *wh, int *StackDepth)
 ;
-BOOL HandleMatch(WHERE *wh, int *StackDepth)
+BOOL HandleMatch(WHERE *wh, int *StackDepth, int MaxHits)
+;
+BOOL TestEntry(DATA *d, WHERE *wh, BOOL *ok)
 ;
-BOOL DoStrTest(char *text, int comparison, char *subtext, BOOL fuzzy)
+BOOL DoStrTest(char *text, int comparison, char *subtext)
 ;
-BOOL fuzzystrstr(char *text, char *subtext)
+BOOL DoSeqTest(char *seq, char *ungapped, WHERE *wh)
 ;
 BOOL DoIntTest(int number, int comparison, int testnum)
 ;
@@ -18,15 +22,21 @@ BOOL IsComplete(DATA *d)
 ;
 void DisplaySearch(FILE *fp, int StackDepth)
 ;
+BOOL GetFieldText(DATA *d, int type, char *param, char *text)
+;
+BOOL CollectHits(int StackDepth, int MaxHits, DATA ***pHits, int *NHits)
+;
 void FillLoop(char *loopname, DATA *d, char *loop)
 ;
+void FillLoopMode(char *loopname, DATA *d, char *loop, int LoopMode)
+;
 char GetResidue(DATA *d, char *resid)
 ;
 BOOL FindCanonical(DATA *d, char *LoopID, char *class)
 ;
 void RemoveDupes(int StackDepth)
 ;
-BOOL TooSimilar(DATA *d, DATA *e, REAL Cutoff)
+DATA *FindEntry(char *name)
 ;
 void GetSubgroup(DATA *d, char *chain, char *subgroup)
 ;
@@ -0,0 +1,558 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Explain.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   EXPLAIN and EXPLAIN ANALYZE. A query preceded by EXPLAIN is not run;
+   instead the plan is printed: each item of the WHERE clause in the
+   order (RPN) in which it is evaluated, with the way the entries are
+   expected to be found for each test (a scan of every entry, the
+   sequence index, BK-tree or LSH, or a scan split between threads),
+   followed by the steps applied to the hits.
+
+   A query preceded by EXPLAIN ANALYZE is run as normal and each step
+   is timed. The report printed after the hits gives for each step the
+   entries given to it (rows in), the entries tested (for a test using
+   an index or stopping at the LIMIT this is fewer than the rows in),
+   the entries it passed on (rows out), the selectivity (rows out / rows
+   in), the elapsed time and the number of times data built on demand
+   (the sequence index, BK-trees, LSH and cold fields) were found ready
+   (hits) or had to be read or built (misses).
+
+   The steps call BeginStep() and EndStep() which do nothing unless
+   EXPLAIN ANALYZE has been given; ExplainCount() and ExplainInput()
+   similarly return 0 so the entries are only counted when needed.
+
+**************************************************************************
+
+   Usage:
+   ======
+   EXPLAIN [ANALYZE] may be given at the start of any line of a query
+   (normally the SELECT) and applies to the next search which is run.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define OPERWIDTH 30                   /* Width of an operation         */
+
+/************************************************************************/
+/* Globals
+*/
+static STEPSTATS sStages[NSTAGES];
+static char      *sStageNames[NSTAGES] =
+{
+   "VARIABILITY", "DISTINCT", "ORDER BY", "GROUP BY", "DISPLAY"
+};
+static char      *sAccessNames[] = {"scan", "index", "parallel",
+                                    "zone map"};
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static void DescribeStage(int stage, char *text);
+static int PlanAccess(WHERE *wh, int MaxHits);
+static void PrintStep(FILE *fp, char *step, char *text, char *access,
+                      STEPSTATS *stats);
+
+
+/************************************************************************/
+/*>void ResetExplain(void)
+   -----------------------
+   Globals: WHERE  *gWhereClause   The WHERE clause
+
+   Clears the statistics of the WHERE items and the other steps before
+   a search is analyzed.
+
+   19.10.26 Original    By: ACRM
+*/
+void ResetExplain(void)
+{
+   WHERE *wh;
+
+   memset(sStages, 0, NSTAGES * sizeof(STEPSTATS));
+   for(wh=gWhereClause; wh!=NULL; NEXT(wh))
+      memset(&(wh->stats), 0, sizeof(STEPSTATS));
+}
+
+
+/************************************************************************/
+/*>STEPSTATS *ExplainStage(int stage)
+   ----------------------------------
+   Input:   int       stage    STAGE_xxxx
+   Returns: STEPSTATS *        Statistics for that step
+
+   19.10.26 Original    By: ACRM
+*/
+STEPSTATS *ExplainStage(int stage)
+{
+   return(&(sStages[stage]));
+}
+
+
+/************************************************************************/
+/*>int ExplainCount(int StackDepth)
+   --------------------------------
+   Input:   int    StackDepth   Stack depth
+   Returns: int                 Entries in the set at that depth (0 if
+                                the search is not being analyzed)
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Counts the sets kept by the batches with BatchCount()
+*/
+int ExplainCount(int StackDepth)
+{
+   DATA *d;
+   int  count = 0;
+
+   if((gExplain != EXPLAIN_ANALYZE) || (StackDepth < 1))
+      return(0);
+   if(UseBatches())
+      return(BatchCount(StackDepth));
+
+   for(d=gData; d!=NULL; NEXT(d))
+   {
+      if(d->active[StackDepth-1])
+         count++;
+   }
+   return(count);
+}
+
+
+/************************************************************************/
+/*>int ExplainInput(WHERE *wh, int StackDepth)
+   -------------------------------------------
+   Input:   WHERE  *wh          A WHERE item about to be evaluated
+            int    StackDepth   Stack depth before it is evaluated
+   Returns: int                 Entries given to it (0 if the search is
+                                not being analyzed)
+
+   A test and NOT are given every entry; AND and OR are given the two
+   sets at the top of the stack. A test followed by AND or OR is only
+   given the entries which can change its result (see ChainFilter()).
+
+   19.10.26 Original    By: ACRM
+*/
+int ExplainInput(WHERE *wh, int StackDepth)
+{
+   DATA *d;
+   int  count = 0,
+        filter;
+
+   if(gExplain != EXPLAIN_ANALYZE)
+      return(0);
+
+   if(!wh->SetOper || (wh->type == OPER_NOT))
+   {
+      for(d=gData; d!=NULL; NEXT(d))
+         count++;
+      if((filter = ChainFilter(wh, StackDepth)) == OPER_AND)
+         return(ExplainCount(StackDepth));
+      if(filter == OPER_OR)
+         return(count - ExplainCount(StackDepth));
+      return(count);
+   }
+
+   return(ExplainCount(StackDepth) + ExplainCount(StackDepth - 1));
+}
+
+
+/************************************************************************/
+/*>void BeginStep(STEPSTATS *step, int RowsIn)
+   -------------------------------------------
+   Output:  STEPSTATS *step     Statistics for the step
+   Input:   int       RowsIn    Entries given to the step
+   Globals: long      gCacheHits, gCacheMisses
+
+   Starts timing a step if the search is being analyzed.
+
+   19.10.26 Original    By: ACRM
+*/
+void BeginStep(STEPSTATS *step, int RowsIn)
+{
+   if(gExplain != EXPLAIN_ANALYZE)
+      return;
+
+   step->done   = TRUE;
+   step->RowsIn = RowsIn;
+   step->hits   = gCacheHits;
+   step->misses = gCacheMisses;
+   step->time   = WallTime();
+}
+
+
+/************************************************************************/
+/*>void EndStep(STEPSTATS *step, int RowsOut)
+   ------------------------------------------
+   I/O:     STEPSTATS *step     Statistics for the step
+   Input:   int       RowsOut   Entries passed on by the step
+   Globals: long      gCacheHits, gCacheMisses
+
+   Finishes timing a step if the search is being analyzed.
+
+   19.10.26 Original    By: ACRM
+*/
+void EndStep(STEPSTATS *step, int RowsOut)
+{
+   if(gExplain != EXPLAIN_ANALYZE)
+      return;
+
+   step->time    = WallTime() - step->time;
+   step->hits    = gCacheHits   - step->hits;
+   step->misses  = gCacheMisses - step->misses;
+   step->RowsOut = RowsOut;
+}
+
+
+/************************************************************************/
+/*>void ExplainPlan(FILE *fp)
+   --------------------------
+   Input:   FILE   *fp      Output file
+   Globals: WHERE  *gWhereClause, SELECTION *gSelectClause etc.
+
+   Prints the plan for the current query without running it.
+
+   19.10.26 Original    By: ACRM
+*/
+void ExplainPlan(FILE *fp)
+{
+   WHERE *wh;
+   char  text[MAXBUFF*4],
+         step[16];
+   int   MaxHits = ScanLimit(),
+         stage,
+         n       = 0;
+
+   fprintf(fp,"# Query plan\n");
+   fprintf(fp,"# %4s  %-*s  %s\n", "Step", OPERWIDTH, "Operation",
+           "Access");
+
+   for(wh=gWhereClause; wh!=NULL; NEXT(wh))
+   {
+      DescribeWhere(wh, text);
+      sprintf(step, "%d", ++n);
+      if(wh->SetOper)
+         fprintf(fp,"# %4s  %s\n", step, text);
+      else
+         fprintf(fp,"# %4s  %-*s  %s\n", step, OPERWIDTH, text,
+                 sAccessNames[PlanAccess(wh, MaxHits)]);
+   }
+
+   for(stage=0; stage<NSTAGES; stage++)
+   {
+      DescribeStage(stage, text);
+      if(text[0])
+         fprintf(fp,"# %4s  %s\n", "", text);
+   }
+
+   if(gLimit)
+   {
+      fprintf(fp,"# %4s  LIMIT %d OFFSET %d", "", gLimit, gOffset);
+      if(MaxHits)
+         fprintf(fp," (scan stops after %d hits)", MaxHits);
+      fprintf(fp,"\n");
+   }
+}
+
+
+/************************************************************************/
+/*>void ExplainAnalyze(FILE *fp, double total)
+   -------------------------------------------
+   Input:   FILE   *fp      Output file
+            double total    Elapsed time for the whole search (s)
+   Globals: WHERE  *gWhereClause   The WHERE clause
+
+   Prints the statistics of each step of the search which has just been
+   run with EXPLAIN ANALYZE.
+
+   19.10.26 Original    By: ACRM
+*/
+void ExplainAnalyze(FILE *fp, double total)
+{
+   WHERE *wh;
+   char  text[MAXBUFF*4],
+         step[16];
+   int   stage,
+         n = 0;
+
+   fprintf(fp,"# Query analysis\n");
+   fprintf(fp,"# %4s  %-*s %-8s %8s %8s %8s %7s %10s %6s %6s\n", "Step",
+           OPERWIDTH, "Operation", "Access", "Rows in", "Tested",
+           "Rows out", "Select", "Time (ms)", "Hits", "Misses");
+
+   for(wh=gWhereClause; wh!=NULL; NEXT(wh))
+   {
+      DescribeWhere(wh, text);
+      sprintf(step, "%d", ++n);
+      PrintStep(fp, step, text,
+                (wh->SetOper ? "-" : sAccessNames[wh->stats.access]),
+                &(wh->stats));
+   }
+
+   for(stage=0; stage<NSTAGES; stage++)
+   {
+      if(sStages[stage].done)
+      {
+         DescribeStage(stage, text);
+         PrintStep(fp, "", text, "-", &(sStages[stage]));
+      }
+   }
+
+   fprintf(fp,"# %4s  %-*s %-8s %8s %8s %8s %7s %10.3f\n", "", OPERWIDTH,
+           "Total", "", "", "", "", "", 1000.0 * total);
+}
+
+
+/************************************************************************/
+/*>static void PrintStep(FILE *fp, char *step, char *text, char *access,
+                         STEPSTATS *stats)
+   ---------------------------------------------------------------------
+   Input:   FILE      *fp      Output file
+            char      *step    Step number (or blank)
+            char      *text    Description of the step
+            char      *access  Access used (or -)
+            STEPSTATS *stats   Statistics for the step
+
+   Prints one line of the EXPLAIN ANALYZE report. The entries tested
+   are only given for the WHERE tests.
+
+   19.10.26 Original    By: ACRM
+*/
+static void PrintStep(FILE *fp, char *step, char *text, char *access,
+                      STEPSTATS *stats)
+{
+   char tested[16],
+        select[16];
+
+   if(strcmp(access, "-"))
+      sprintf(tested, "%d", stats->tested);
+   else
+      strcpy(tested, "-");
+
+   if(stats->RowsIn > 0)
+      sprintf(select, "%.2f%%", 100.0 * stats->RowsOut / stats->RowsIn);
+   else
+      strcpy(select, "-");
+
+   fprintf(fp,"# %4s  %-*.*s %-8s %8d %8s %8d %7s %10.3f %6ld %6ld\n",
+           step, OPERWIDTH, OPERWIDTH, text, access, stats->RowsIn,
+           tested, stats->RowsOut, select, 1000.0 * stats->time,
+           stats->hits, stats->misses);
+}
+
+
+/************************************************************************/
+/*>void DescribeWhere(WHERE *wh, char *text)
+   -----------------------------------------
+   Input:   WHERE  *wh      A WHERE item
+   Output:  char   *text    Description (e.g. RESIDUE(L91) = W). Must
+                            be at least 4*MAXBUFF long
+
+   19.10.26 Original    By: ACRM
+   19.10.26 No longer static so it can be used for the trace
+*/
+void DescribeWhere(WHERE *wh, char *text)
+{
+   char comp[32];
+
+   if(wh->SetOper)
+   {
+      strcpy(text, FieldName(wh->type, gSetOper));
+      return;
+   }
+
+   switch(wh->comparison)
+   {
+   case COMP_EQ:       strcpy(comp, "=");    break;
+   case COMP_NE:       strcpy(comp, "!=");   break;
+   case COMP_LT:       strcpy(comp, "<");    break;
+   case COMP_GT:       strcpy(comp, ">");    break;
+   case COMP_LE:       strcpy(comp, "<=");   break;
+   case COMP_GE:       strcpy(comp, ">=");   break;
+   case COMP_SIM:      strcpy(comp, "LIKE"); break;
+   case COMP_MISMATCH:
+      sprintf(comp, "MISMATCH(%d)", wh->matcher.errors);
+      break;
+   case COMP_SIMILAR:
+      sprintf(comp, "SIMILAR(%d)", wh->matcher.errors);
+      break;
+   case COMP_WITHIN:
+      sprintf(comp, "WITHIN(%d)", wh->matcher.errors);
+      break;
+   default:
+      strcpy(comp, "?");
+      break;
+   }
+
+   if(wh->param[0])
+      sprintf(text, "%s(%s) %s %s", FieldName(wh->type, gField),
+              wh->param, comp, wh->data);
+   else
+      sprintf(text, "%s %s %s", FieldName(wh->type, gField), comp,
+              wh->data);
+}
+
+
+/************************************************************************/
+/*>static void DescribeStage(int stage, char *text)
+   ------------------------------------------------
+   Input:   int    stage    STAGE_xxxx
+   Output:  char   *text    Description of the step; blank if the
+                            current query does not use it
+
+   19.10.26 Original    By: ACRM
+*/
+static void DescribeStage(int stage, char *text)
+{
+   SELECTION *p;
+   int       n = 0;
+
+   text[0] = '\0';
+
+   switch(stage)
+   {
+   case STAGE_VARIABILITY:
+      if(gVariability > 0.0)
+         sprintf(text, "%s %g", sStageNames[stage], (double)gVariability);
+      break;
+   case STAGE_DISTINCT:
+      if(gDistinct)
+         strcpy(text, sStageNames[stage]);
+      break;
+   case STAGE_ORDER:
+      if(gOrderBy != NULL)
+         sprintf(text, "%s %s%s", sStageNames[stage],
+                 (gOrderBy->type ? FieldName(gOrderBy->type, gField) :
+                  "COUNT"),
+                 (gOrderDesc ? " DESC" : ""));
+      break;
+   case STAGE_GROUP:
+      if(IsGroupedQuery())
+      {
+         for(p=gGroupBy; p!=NULL; NEXT(p))
+            n++;
+         sprintf(text, "%s (%d field%s)", sStageNames[stage], n,
+                 ((n == 1) ? "" : "s"));
+      }
+      break;
+   case STAGE_DISPLAY:
+      if(!IsGroupedQuery())
+      {
+         for(p=gSelectClause; p!=NULL; NEXT(p))
+            n++;
+         sprintf(text, "%s (%d field%s)", sStageNames[stage], n,
+                 ((n == 1) ? "" : "s"));
+      }
+      break;
+   }
+}
+
+
+/************************************************************************/
+/*>char *FieldName(int type, FIELD *fields)
+   ----------------------------------------
+   Input:   int    type      FIELD_xxxx or OPER_xxxx type
+            FIELD  *fields   gField or gSetOper
+   Returns: char   *         The name of the field or operator
+
+   19.10.26 Original    By: ACRM
+   19.10.26 No longer static so it can be used by ShowStats()
+*/
+char *FieldName(int type, FIELD *fields)
+{
+   int i;
+
+   for(i=0; fields[i].type; i++)
+   {
+      if(fields[i].type == type)
+         return(fields[i].name);
+   }
+   return("?");
+}
+
+
+/************************************************************************/
+/*>static int PlanAccess(WHERE *wh, int MaxHits)
+   ---------------------------------------------
+   Input:   WHERE  *wh       A WHERE test
+            int    MaxHits   Hits after which the scan stops (0 = none)
+   Returns: int              ACCESS_xxxx expected for the test
+
+   Gives the way the entries are expected to be found for a test
+   following the choices made by HandleMatch() and FindCandidates().
+   A LIKE on an indexed field may still need a scan if the pattern has
+   no 3-mer without a wildcard.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Zone maps
+*/
+static int PlanAccess(WHERE *wh, int MaxHits)
+{
+   DATA *d;
+   int  NData = 0;
+
+   if(gUseIndex && (wh->comparison == COMP_WITHIN) &&
+      (IndexField(wh->type, gLoopMode) >= 2) &&
+      (strchr(wh->pattern, '?') == NULL))
+      return(ACCESS_INDEX);
+
+   if(wh->type == FIELD_IDENTITY)
+   {
+      for(d=gData; d!=NULL; NEXT(d))
+         NData++;
+      if(IsLSHTest(wh) && (NData >= gLSHMinData))
+         return(ACCESS_INDEX);
+   }
+   else if(gUseIndex && (wh->comparison == COMP_SIM) &&
+           (IndexField(wh->type, gLoopMode) >= 0) &&
+           (wh->matcher.length >= 3))
+   {
+      return(ACCESS_INDEX);
+   }
+
+   if(!MaxHits &&
+      ((wh->comparison == COMP_MISMATCH) ||
+       (wh->comparison == COMP_SIMILAR)  ||
+       (wh->comparison == COMP_WITHIN)   ||
+       (wh->type == FIELD_IDENTITY)))
+      return(ACCESS_PARALLEL);
+
+   if(IsZoneTest(wh))
+      return(ACCESS_ZONEMAP);
+
+   return(ACCESS_SCAN);
+}
@@ -0,0 +1,20 @@
+void ResetExplain(void)
+;
+STEPSTATS *ExplainStage(int stage)
+;
+int ExplainCount(int StackDepth)
+;
+int ExplainInput(WHERE *wh, int StackDepth)
+;
+void BeginStep(STEPSTATS *step, int RowsIn)
+;
+void EndStep(STEPSTATS *step, int RowsOut)
+;
+void ExplainPlan(FILE *fp)
+;
+void ExplainAnalyze(FILE *fp, double total)
+;
+char *FieldName(int type, FIELD *fields)
+;
+void DescribeWhere(WHERE *wh, char *text)
+;
@@ -0,0 +1,375 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Generate.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Generates a synthetic stored data file of any size from the data
+   which have been read so that loading, searching and memory use can
+   be tested on much larger data sets than the Kabat data.
+
+   Each synthetic entry is made from a template entry picked at random
+   from the data. The template gives the chains which are present, the
+   positions of the gaps (and hence the CDR lengths and insertions),
+   any special numbering, the source, class, date, antigen and
+   reference. About GENMUTATE% of the residues are then replaced by
+   residues drawn from the frequencies at that position of the
+   alignment in all the entries from the same source. The entries thus
+   follow the distributions of the real data while being different
+   from them. The name is the template's name followed by -G and the
+   entry number and new accession codes are given.
+
+   A fixed seed is used so the same file is made every time. The file
+   is written in the current stored data format, with the cold fields
+   in a temporary file until the end, so the entries need not all be
+   kept in memory. It is then read back so that the sequence index is
+   written alongside it as for any other stored data file.
+
+**************************************************************************
+
+   Usage:
+   ======
+   GenerateData() is called by main() for kabatman -g n file
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define GENSEED    20261019UL          /* Random number seed            */
+#define GENMUTATE  10                  /* % of residues replaced        */
+#define GENBLOCK   1048576             /* Arena block for the profiles  */
+#define NRESTYPES  26                  /* Residue letters A-Z           */
+
+typedef struct _profile
+{
+   struct _profile *next;
+   char            *source;
+   int             counts[2][LARGEBUFF][NRESTYPES],
+                   total[2][LARGEBUFF];
+}  PROFILE;
+
+/************************************************************************/
+/* Globals
+*/
+static unsigned long sGenSeed = GENSEED;
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static PROFILE *BuildProfiles(ARENA *arena);
+static PROFILE *FindProfile(PROFILE *profiles, char *source);
+static void MakeEntry(DATA *e, DATA *t, PROFILE *prof, long n);
+static void MutateChain(char *seq, PROFILE *prof, int chain);
+static int GenRandom(int n);
+
+
+/************************************************************************/
+/*>BOOL GenerateData(char *filename, long NEntries)
+   ------------------------------------------------
+   Input:   char   *filename    Stored data file to write
+            long   NEntries     Number of entries to generate
+   Returns: BOOL                Success
+   Globals: DATA   *gData       The data used as templates. Replaced by
+                                the generated data
+            char   gFileDate[]  Set to the current date
+
+   Writes a synthetic stored data file of NEntries entries based on the
+   current data and then reads it in and writes its sequence index.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL GenerateData(char *filename, long NEntries)
+{
+   static DATA entry;
+   DATA        *d,
+               **templates;
+   PROFILE     *profiles;
+   ARENA       *work;
+   FILE        *fp,
+               *fpCold;
+   long        n,
+               ColdOffset = 0L;
+   int         NData      = 0,
+               c;
+
+   for(d=gData; d!=NULL; NEXT(d))
+      NData++;
+   if(NData == 0)
+   {
+      fprintf(stderr,"Error: No data from which to generate entries\n");
+      return(FALSE);
+   }
+
+   /* The templates' cold fields are copied to the new entries          */
+   if(!LoadAllColdData() ||
+      ((templates = (DATA **)malloc(NData * sizeof(DATA *)))==NULL))
+   {
+      fprintf(stderr,"Error: No memory to generate data\n");
+      return(FALSE);
+   }
+   for(d=gData, NData=0; d!=NULL; NEXT(d))
+      templates[NData++] = d;
+
+   if(((work = NewArena(GENBLOCK))==NULL) ||
+      ((profiles = BuildProfiles(work))==NULL))
+   {
+      fprintf(stderr,"Error: No memory to generate data\n");
+      free(templates);
+      return(FALSE);
+   }
+
+   if((fp=fopen(filename,"w"))==NULL)
+   {
+      fprintf(stderr,"Error: Unable to open file %s\n",filename);
+      free(templates);
+      FreeArena(work);
+      return(FALSE);
+   }
+   if((fpCold=tmpfile())==NULL)
+   {
+      fprintf(stderr,"Error: Unable to open temporary file\n");
+      fclose(fp);
+      free(templates);
+      FreeArena(work);
+      return(FALSE);
+   }
+
+   /* The generated data are dated now                                  */
+   gFileDate[0] = '\0';
+   WriteStoredHeader(fp);
+
+   for(n=0; n<NEntries; n++)
+   {
+      d = templates[GenRandom(NData)];
+      MakeEntry(&entry, d, FindProfile(profiles, d->source), n);
+      ColdOffset += WriteStoredEntry(fp, &entry, ColdOffset);
+      WriteColdData(fpCold, &entry);
+   }
+
+   /* Copy the cold fields to the end of the file                       */
+   fprintf(fp,"!COLD\n");
+   rewind(fpCold);
+   while((c = getc(fpCold)) != EOF)
+      putc(c, fp);
+   fclose(fpCold);
+
+   free(templates);
+   FreeArena(work);
+
+   if(fclose(fp))
+   {
+      fprintf(stderr,"Error: Unable to write file %s\n",filename);
+      return(FALSE);
+   }
+
+   /* Read the file back to write the sequence index                    */
+   if(!ReadStoredData(filename) || !NormaliseData(gData))
+   {
+      fprintf(stderr,"Error: Unable to read back generated data\n");
+      return(FALSE);
+   }
+   SetChainHashes(gData);
+   WriteSeqIndex(filename);
+
+   if(gInfoLevel)
+      fprintf(stderr,"Generated %ld entries in %s\n", NEntries, filename);
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static PROFILE *BuildProfiles(ARENA *arena)
+   -------------------------------------------
+   I/O:     ARENA   *arena     Arena for the profiles
+   Returns: PROFILE *          Linked list of profiles, one per source.
+                               NULL if no memory
+   Globals: DATA    *gData     The data
+
+   Counts the residues at each position of the light and heavy chain
+   alignments for each source.
+
+   19.10.26 Original    By: ACRM
+*/
+static PROFILE *BuildProfiles(ARENA *arena)
+{
+   PROFILE *profiles = NULL,
+           *prof;
+   DATA    *d;
+   char    *seq;
+   int     chain,
+           i;
+
+   for(d=gData; d!=NULL; NEXT(d))
+   {
+      if((prof = FindProfile(profiles, d->source)) == NULL)
+      {
+         if((prof = (PROFILE *)ArenaAlloc(arena, sizeof(PROFILE)))==NULL)
+            return(NULL);
+         memset(prof, 0, sizeof(PROFILE));
+         prof->source = d->source;
+         prof->next   = profiles;
+         profiles     = prof;
+      }
+
+      for(chain=0; chain<2; chain++)
+      {
+         seq = (chain ? d->heavy : d->light);
+         for(i=0; seq[i] && i<LARGEBUFF; i++)
+         {
+            if(isupper(seq[i]))
+            {
+               prof->counts[chain][i][seq[i] - 'A']++;
+               prof->total[chain][i]++;
+            }
+         }
+      }
+   }
+
+   return(profiles);
+}
+
+
+/************************************************************************/
+/*>static PROFILE *FindProfile(PROFILE *profiles, char *source)
+   ------------------------------------------------------------
+   Input:   PROFILE *profiles   Linked list of profiles
+            char    *source     Source
+   Returns: PROFILE *           Profile for the source. NULL if none
+
+   19.10.26 Original    By: ACRM
+*/
+static PROFILE *FindProfile(PROFILE *profiles, char *source)
+{
+   PROFILE *prof;
+
+   for(prof=profiles; prof!=NULL; NEXT(prof))
+   {
+      if(!strcmp(prof->source, source))
+         return(prof);
+   }
+   return(NULL);
+}
+
+
+/************************************************************************/
+/*>static void MakeEntry(DATA *e, DATA *t, PROFILE *prof, long n)
+   --------------------------------------------------------------
+   Output:  DATA    *e      The new entry
+   Input:   DATA    *t      Template entry
+            PROFILE *prof   Profile for the template's source
+            long    n       Entry number
+
+   Makes a synthetic entry from a template. The special numbering and
+   cold fields are shared with the template.
+
+   19.10.26 Original    By: ACRM
+*/
+static void MakeEntry(DATA *e, DATA *t, PROFILE *prof, long n)
+{
+   char suffix[SMALLBUFF];
+   int  length;
+
+   *e      = *t;
+   e->next = NULL;
+
+   MutateChain(e->light, prof, 0);
+   MutateChain(e->heavy, prof, 1);
+
+   /* Name is the template's with -Gn added, shortened if need be       */
+   sprintf(suffix, "-G%ld", n+1);
+   length = MIN((int)strlen(t->name), SMALLBUFF - 1 - (int)strlen(suffix));
+   strncpy(e->name, t->name, length);
+   strcpy(e->name + length, suffix);
+
+   if(e->idlight[0])
+      sprintf(e->idlight, "%06ld", 2*n+1);
+   if(e->idheavy[0])
+      sprintf(e->idheavy, "%06ld", 2*n+2);
+}
+
+
+/************************************************************************/
+/*>static void MutateChain(char *seq, PROFILE *prof, int chain)
+   ------------------------------------------------------------
+   I/O:     char    *seq     Aligned chain sequence
+   Input:   PROFILE *prof    Profile for the source
+            int     chain    0 for light, 1 for heavy
+
+   Replaces about GENMUTATE% of the residues with residues drawn from
+   the profile at that position. Gaps and unknown residues are left
+   alone.
+
+   19.10.26 Original    By: ACRM
+*/
+static void MutateChain(char *seq, PROFILE *prof, int chain)
+{
+   int i,
+       r,
+       res;
+
+   for(i=0; seq[i] && i<LARGEBUFF; i++)
+   {
+      if(isupper(seq[i]) && (GenRandom(100) < GENMUTATE) &&
+         (prof->total[chain][i] > 0))
+      {
+         r = GenRandom(prof->total[chain][i]);
+         for(res=0; r >= prof->counts[chain][i][res]; res++)
+            r -= prof->counts[chain][i][res];
+         seq[i] = (char)('A' + res);
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>static int GenRandom(int n)
+   ---------------------------
+   Input:   int    n        Range
+   Returns: int             Random number 0...n-1
+
+   32-bit xorshift generator so that the data are the same on every
+   machine.
+
+   19.10.26 Original    By: ACRM
+*/
+static int GenRandom(int n)
+{
+   sGenSeed ^= (sGenSeed << 13) & 0xffffffffUL;
+   sGenSeed ^= sGenSeed >> 17;
+   sGenSeed ^= (sGenSeed << 5) & 0xffffffffUL;
+   return((int)(sGenSeed % (unsigned long)n));
+}
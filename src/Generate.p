@@ -0,0 +1,2 @@
+BOOL GenerateData(char *filename, long NEntries)
+;
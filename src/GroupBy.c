@@ -0,0 +1,886 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       GroupBy.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   GROUP BY and the aggregate functions COUNT, MIN, MAX and AVG.
+
+   The hits are aggregated in a single pass using a hash table keyed on
+   the text of the GROUP BY fields. Each field needed by the query (the
+   group keys and the fields used in aggregates) is calculated just once
+   for each hit, so expensive derived fields such as CANONICAL and
+   SUBGROUP are not recalculated for each use.
+
+   The hit list is split between several threads, each of which builds
+   its own table of partial aggregates. These are merged once all the
+   threads have finished. Groups are displayed in the order in which
+   they are first seen in the dataset unless ORDER BY is given.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+                  The variability filter is timed for EXPLAIN ANALYZE
+                  Output counted by the hot-path counters
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define MAXCOLS          32      /* Max distinct fields in a query      */
+#define MINTHREADHITS  1024      /* Min hits worth giving to a thread   */
+#define INITBUCKETS     256      /* Initial hash table size             */
+
+typedef struct
+{
+   int  type;                    /* Field type                          */
+   BOOL IsInt;                   /* Integer field                       */
+   char param[MAXBUFF];          /* Field parameter                     */
+}  COLUMN;
+
+typedef struct _group
+{
+   struct _group *next,          /* Next group in the same hash bucket  */
+                 *nextall;       /* Next group in the table             */
+   unsigned long hash;
+   char          *key;           /* Key texts separated by '\0'         */
+   int           keylen,
+                 first,          /* Index of the first hit in the group */
+                 count,
+                 *min,           /* Per column values for int columns   */
+                 *max;
+   double        *sum;
+}  GROUP;
+
+typedef struct
+{
+   GROUP **bucket,
+         *groups;
+   int   NBuckets,
+         NGroups;
+   BOOL  error;
+}  GROUPTAB;
+
+typedef struct
+{
+   DATA     **hits;
+   COLUMN   *cols;
+   GROUPTAB *tabs;
+   int      NCols,
+            NKeys,
+            *keycols;
+}  AGGJOB;
+
+/************************************************************************/
+/* Globals
+*/
+static int  sOrderCol   = -1,    /* Column used for ORDER BY            */
+            sOrderKey   = -1,    /* Key index used for ORDER BY         */
+            sOrderAgg   = AGG_NONE;
+static BOOL sOrderInt   = FALSE,
+            sDescending = FALSE;
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static int    AddColumn(COLUMN *cols, int *NCols, int type, char *param);
+static void   AggregateHits(int start, int stop, int thread, void *data);
+static BOOL   InitGroupTab(GROUPTAB *tab);
+static void   FreeGroupTab(GROUPTAB *tab);
+static GROUP  *FindGroup(GROUPTAB *tab, unsigned long hash, char *key,
+                         int keylen);
+static GROUP  *NewGroup(unsigned long hash, char *key, int keylen,
+                        int first, int NCols);
+static void   InsertGroup(GROUPTAB *tab, GROUP *g);
+static void   MergeGroup(GROUP *g1, GROUP *g2, COLUMN *cols, int NCols);
+static char   *GetKeyText(GROUP *g, int KeyIndex);
+static double GetAggregateValue(GROUP *g, int aggregate, int col);
+static int    CompareGroups(const void *g1, const void *g2);
+
+
+/************************************************************************/
+/*>BOOL IsGroupedQuery(void)
+   -------------------------
+   Returns: BOOL              Does the query need grouping?
+   Globals: SELECTION *gGroupBy       The GROUP BY list
+            SELECTION *gSelectClause  The SELECT list
+
+   A query is grouped if GROUP BY has been given or if the SELECT
+   statement contains an aggregate function (in which case all the hits
+   form a single group).
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL IsGroupedQuery(void)
+{
+   SELECTION *p;
+
+   if(gGroupBy != NULL)
+      return(TRUE);
+
+   for(p=gSelectClause; p!=NULL; NEXT(p))
+   {
+      if(p->aggregate != AGG_NONE)
+         return(TRUE);
+   }
+   return(FALSE);
+}
+
+
+/************************************************************************/
+/*>BOOL DisplayGroups(FILE *fp, int StackDepth)
+   --------------------------------------------
+   Input:   FILE *fp           Output file pointer
+            int  StackDepth    Current stack depth
+   Returns: BOOL               Success
+   Globals: SELECTION *gGroupBy       The GROUP BY list
+            SELECTION *gSelectClause  The SELECT list
+            SELECTION *gOrderBy       ORDER BY field
+            int       gNRows          Set to the groups displayed
+
+   Aggregates the hits at the top of the stack on the GROUP BY fields
+   and displays one line per group. Non-aggregate fields in the SELECT
+   statement must appear in the GROUP BY list. gOffset and gLimit apply
+   to the groups rather than to the hits.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Times the variability filter for EXPLAIN ANALYZE
+            Each value is formatted before it is written so the output
+            can be counted by STAT_OUTPUT
+   19.10.26 The variability filter is traced
+*/
+BOOL DisplayGroups(FILE *fp, int StackDepth)
+{
+   COLUMN    cols[MAXCOLS];
+   int       keycols[MAXCOLS],
+             selcols[MAXCOLS],
+             selkeys[MAXCOLS],
+             NCols    = 0,
+             NKeys    = 0,
+             NHits    = 0,
+             NThreads,
+             NGroups,
+             First,
+             Last,
+             i, j;
+   SELECTION *p;
+   DATA      **hits   = NULL;
+   GROUPTAB  tabs[MAXTHREADS];
+   GROUP     *g,
+             *gnext,
+             *gfound,
+             **groups = NULL;
+   AGGJOB    job;
+   BOOL      first,
+             ok       = TRUE;
+   char      number[SMALLBUFF],
+             *text;
+
+   if(StackDepth < 1 || StackDepth >= STACKDEPTH)
+      return(FALSE);
+
+   /* Build the list of columns; first the group keys                   */
+   for(p=gGroupBy; p!=NULL; NEXT(p))
+   {
+      if((keycols[NKeys] = AddColumn(cols,&NCols,p->type,p->param)) < 0)
+         return(FALSE);
+      /* Ignore repeated keys                                           */
+      for(j=0; j<NKeys; j++)
+      {
+         if(keycols[j] == keycols[NKeys])
+            break;
+      }
+      if(j == NKeys)
+         NKeys++;
+   }
+
+   /* Now the SELECT fields                                             */
+   for(p=gSelectClause, i=0; p!=NULL; NEXT(p), i++)
+   {
+      if(i >= MAXCOLS)
+      {
+         fprintf(stderr,"Error: Too many fields in SELECT\n");
+         return(FALSE);
+      }
+
+      selcols[i] = selkeys[i] = (-1);
+      if(p->aggregate == AGG_COUNT)
+         continue;
+
+      if((selcols[i] = AddColumn(cols,&NCols,p->type,p->param)) < 0)
+         return(FALSE);
+
+      if(p->aggregate == AGG_NONE)
+      {
+         for(j=0; j<NKeys; j++)
+         {
+            if(keycols[j] == selcols[i])
+            {
+               selkeys[i] = j;
+               break;
+            }
+         }
+         if(selkeys[i] < 0)
+         {
+            fprintf(stderr,"Error: Fields in SELECT must be in GROUP BY \
+or used in COUNT, MIN, MAX or AVG\n");
+            return(FALSE);
+         }
+      }
+   }
+
+   /* And the ORDER BY field                                            */
+   sOrderCol = sOrderKey = (-1);
+   sOrderAgg = AGG_NONE;
+   sOrderInt = FALSE;
+   if(gOrderBy != NULL)
+   {
+      sOrderAgg   = gOrderBy->aggregate;
+      sDescending = gOrderDesc;
+
+      if(sOrderAgg != AGG_COUNT)
+      {
+         if((sOrderCol = AddColumn(cols,&NCols,gOrderBy->type,
+                                   gOrderBy->param)) < 0)
+            return(FALSE);
+         sOrderInt = cols[sOrderCol].IsInt;
+      }
+
+      if(sOrderAgg == AGG_NONE)
+      {
+         for(j=0; j<NKeys; j++)
+         {
+            if(keycols[j] == sOrderCol)
+               sOrderKey = j;
+         }
+         if(sOrderKey < 0)
+         {
+            fprintf(stderr,"Error: ORDER BY field must be in GROUP \
+BY\n");
+            return(FALSE);
+         }
+      }
+   }
+
+   /* Get the list of hits                                              */
+   if(gVariability > 0.0)
+   {
+      BeginStep(ExplainStage(STAGE_VARIABILITY), ExplainCount(StackDepth));
+      TraceBegin(0, "RemoveDupes", NULL);
+      RemoveDupes(StackDepth);
+      TraceEnd(0);
+      EndStep(ExplainStage(STAGE_VARIABILITY), ExplainCount(StackDepth));
+   }
+
+   if(!CollectHits(StackDepth, 0, &hits, &NHits))
+   {
+      fprintf(stderr,"Error: No memory for hit list\n");
+      return(FALSE);
+   }
+
+   /* The cold fields must all be read before the threads start         */
+   for(i=0; i<NCols; i++)
+   {
+      if((cols[i].type == FIELD_ANTIGEN) || (cols[i].type == FIELD_REF))
+      {
+         if(!LoadAllColdData())
+         {
+            free(hits);
+            return(FALSE);
+         }
+         break;
+      }
+   }
+
+   /* Aggregate the hits with a hash table for each thread              */
+   NThreads = GetNThreads(NHits, MINTHREADHITS);
+   for(i=0; i<NThreads; i++)
+   {
+      if(!InitGroupTab(&(tabs[i])))
+      {
+         for(j=0; j<i; j++)
+            FreeGroupTab(&(tabs[j]));
+         free(hits);
+         fprintf(stderr,"Error: No memory for GROUP BY\n");
+         return(FALSE);
+      }
+   }
+
+   job.hits    = hits;
+   job.cols    = cols;
+   job.tabs    = tabs;
+   job.NCols   = NCols;
+   job.NKeys   = NKeys;
+   job.keycols = keycols;
+   ParallelFor(NHits, NThreads, AggregateHits, (void *)&job);
+
+   /* Merge the partial aggregates into the first table                 */
+   for(i=0; i<NThreads; i++)
+   {
+      if(tabs[i].error)
+         ok = FALSE;
+   }
+
+   for(i=1; ok && i<NThreads; i++)
+   {
+      for(g=tabs[i].groups; g!=NULL; g=gnext)
+      {
+         gnext = g->nextall;
+         if((gfound = FindGroup(&(tabs[0]), g->hash, g->key, g->keylen))
+            != NULL)
+         {
+            MergeGroup(gfound, g, cols, NCols);
+            free(g);
+         }
+         else
+         {
+            InsertGroup(&(tabs[0]), g);
+         }
+      }
+      tabs[i].groups = NULL;
+      FreeGroupTab(&(tabs[i]));
+   }
+
+   /* Build an array of the groups and sort it                          */
+   NGroups = tabs[0].NGroups;
+   if(ok && NGroups)
+   {
+      if((groups = (GROUP **)malloc(NGroups * sizeof(GROUP *)))==NULL)
+      {
+         ok = FALSE;
+      }
+      else
+      {
+         for(g=tabs[0].groups, i=0; g!=NULL; g=g->nextall)
+            groups[i++] = g;
+         qsort(groups, NGroups, sizeof(GROUP *), CompareGroups);
+      }
+   }
+
+   if(!ok)
+   {
+      fprintf(stderr,"Error: No memory for GROUP BY\n");
+   }
+   else
+   {
+      /* Display the groups                                             */
+      First = MIN(gOffset, NGroups);
+      Last  = (gLimit ? MIN(NGroups, gOffset+gLimit) : NGroups);
+
+      for(i=First; i<Last; i++)
+      {
+         g     = groups[i];
+         first = TRUE;
+
+         for(p=gSelectClause, j=0; p!=NULL; NEXT(p), j++)
+         {
+            if(first)
+               first = FALSE;
+            else
+            {
+               fputc(gDelim,fp);
+               fputc(' ',fp);
+               STATAMOUNT(STAT_OUTPUT, 2);
+            }
+
+            text = number;
+            switch(p->aggregate)
+            {
+            case AGG_COUNT:
+               sprintf(number,"%d",g->count);
+               break;
+            case AGG_MIN:
+               sprintf(number,"%d",g->min[selcols[j]]);
+               break;
+            case AGG_MAX:
+               sprintf(number,"%d",g->max[selcols[j]]);
+               break;
+            case AGG_AVG:
+               sprintf(number,"%.2f",GetAggregateValue(g,AGG_AVG,
+                                                       selcols[j]));
+               break;
+            default:
+               text = GetKeyText(g,selkeys[j]);
+               break;
+            }
+            fputs(text,fp);
+            STATAMOUNT(STAT_OUTPUT, strlen(text));
+         }
+         fprintf(fp,"\n");
+         STATAMOUNT(STAT_OUTPUT, 1);
+         STATCOUNT(STAT_OUTPUT);
+      }
+
+      if(gHTML) fprintf(fp,"<p><i>");
+      fprintf(fp,"\n# Number of groups = %d from %d hits (Dataset \
+created %s)\n", Last-First, NHits, gFileDate);
+      if(gHTML) fprintf(fp,"</i><p>\n");
+      gNRows = Last-First;
+   }
+
+   if(groups != NULL)
+      free(groups);
+   FreeGroupTab(&(tabs[0]));
+   free(hits);
+
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static int AddColumn(COLUMN *cols, int *NCols, int type, char *param)
+   ---------------------------------------------------------------------
+   I/O:     COLUMN  *cols    Array of columns
+            int     *NCols   Number of columns
+   Input:   int     type     Field type
+            char    *param   Field parameter
+   Returns: int              Index of the column (-1 if too many)
+
+   Finds a field in the column list, adding it if it isn't already
+   there, so that each field is calculated only once per hit. The
+   parameter is stored in upper case. It is shared by the threads of
+   AggregateHits() so the field routines must only read it.
+
+   19.10.26 Original    By: ACRM
+*/
+static int AddColumn(COLUMN *cols, int *NCols, int type, char *param)
+{
+   int i;
+
+   for(i=0; i<*NCols; i++)
+   {
+      if((cols[i].type == type) && !blUpstrcmp(cols[i].param, param))
+         return(i);
+   }
+
+   if(*NCols >= MAXCOLS)
+   {
+      fprintf(stderr,"Error: Too many fields in query\n");
+      return(-1);
+   }
+
+   cols[i].type  = type;
+   cols[i].IsInt = IsIntegerField(type);
+   strncpy(cols[i].param, param, MAXBUFF);
+   cols[i].param[MAXBUFF-1] = '\0';
+   UPPER(cols[i].param);
+   (*NCols)++;
+
+   return(i);
+}
+
+
+/************************************************************************/
+/*>static void AggregateHits(int start, int stop, int thread, void *data)
+   ----------------------------------------------------------------------
+   Input:   int   start     First hit to process
+            int   stop      One beyond the last hit to process
+            int   thread    Thread number
+            void  *data     The AGGJOB
+
+   Adds hits start to stop-1 into the hash table for this thread. Each
+   column is calculated once for each hit. Sets the table's error flag
+   if memory runs out.
+
+   19.10.26 Original    By: ACRM
+*/
+static void AggregateHits(int start, int stop, int thread, void *data)
+{
+   AGGJOB        *job = (AGGJOB *)data;
+   GROUPTAB      *tab = &(job->tabs[thread]);
+   COLUMN        *col;
+   GROUP         *g;
+   DATA          *d;
+   char          *key;
+   int           ivals[MAXCOLS],
+                 i, j, c,
+                 keylen;
+   unsigned long hash;
+
+   if((key = (char *)malloc((job->NKeys * LARGEBUFF + 1) *
+                            sizeof(char)))==NULL)
+   {
+      tab->error = TRUE;
+      return;
+   }
+
+   for(i=start; i<stop; i++)
+   {
+      d = job->hits[i];
+
+      /* Calculate the integer columns                                  */
+      for(c=0; c<job->NCols; c++)
+      {
+         if(job->cols[c].IsInt)
+            ivals[c] = GetIntegerField(d, job->cols[c].type,
+                                       job->cols[c].param);
+      }
+
+      /* Build the key from the text of the group key columns           */
+      for(j=0, keylen=0; j<job->NKeys; j++)
+      {
+         c   = job->keycols[j];
+         col = &(job->cols[c]);
+         if(col->IsInt)
+            sprintf(key+keylen, "%d", ivals[c]);
+         else if(!GetFieldText(d, col->type, col->param, key+keylen))
+            key[keylen] = '\0';
+         keylen += strlen(key+keylen) + 1;
+      }
+
+      hash = HashBytes(key, keylen, HASH_INIT);
+      if((g = FindGroup(tab, hash, key, keylen))==NULL)
+      {
+         if((g = NewGroup(hash, key, keylen, i, job->NCols))==NULL)
+         {
+            tab->error = TRUE;
+            break;
+         }
+         InsertGroup(tab, g);
+         for(c=0; c<job->NCols; c++)
+         {
+            if(job->cols[c].IsInt)
+               g->min[c] = g->max[c] = ivals[c];
+         }
+      }
+
+      /* Update the aggregates                                          */
+      g->count++;
+      for(c=0; c<job->NCols; c++)
+      {
+         if(job->cols[c].IsInt)
+         {
+            if(ivals[c] < g->min[c]) g->min[c] = ivals[c];
+            if(ivals[c] > g->max[c]) g->max[c] = ivals[c];
+            g->sum[c] += (double)ivals[c];
+         }
+      }
+   }
+
+   free(key);
+}
+
+
+/************************************************************************/
+/*>static BOOL InitGroupTab(GROUPTAB *tab)
+   ---------------------------------------
+   Output:  GROUPTAB *tab    Initialised empty hash table
+   Returns: BOOL             Success
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL InitGroupTab(GROUPTAB *tab)
+{
+   int i;
+
+   tab->groups   = NULL;
+   tab->NGroups  = 0;
+   tab->error    = FALSE;
+   tab->NBuckets = INITBUCKETS;
+   if((tab->bucket = (GROUP **)malloc(INITBUCKETS * sizeof(GROUP *)))
+      ==NULL)
+      return(FALSE);
+
+   for(i=0; i<INITBUCKETS; i++)
+      tab->bucket[i] = NULL;
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static void FreeGroupTab(GROUPTAB *tab)
+   ---------------------------------------
+   I/O:     GROUPTAB *tab    Hash table to free
+
+   Frees the groups and buckets of a hash table
+
+   19.10.26 Original    By: ACRM
+*/
+static void FreeGroupTab(GROUPTAB *tab)
+{
+   GROUP *g,
+         *gnext;
+
+   for(g=tab->groups; g!=NULL; g=gnext)
+   {
+      gnext = g->nextall;
+      free(g);
+   }
+   tab->groups = NULL;
+
+   if(tab->bucket != NULL)
+      free(tab->bucket);
+   tab->bucket = NULL;
+}
+
+
+/************************************************************************/
+/*>static GROUP *FindGroup(GROUPTAB *tab, unsigned long hash, char *key,
+                           int keylen)
+   ---------------------------------------------------------------------
+   Input:   GROUPTAB      *tab     Hash table
+            unsigned long hash     Hash of the key
+            char          *key     Key
+            int           keylen   Length of key
+   Returns: GROUP         *        The group (NULL if not found)
+
+   19.10.26 Original    By: ACRM
+*/
+static GROUP *FindGroup(GROUPTAB *tab, unsigned long hash, char *key,
+                        int keylen)
+{
+   GROUP *g;
+
+   for(g=tab->bucket[hash % tab->NBuckets]; g!=NULL; NEXT(g))
+   {
+      if((g->hash == hash) && (g->keylen == keylen) &&
+         !memcmp(g->key, key, keylen))
+         return(g);
+   }
+   return(NULL);
+}
+
+
+/************************************************************************/
+/*>static GROUP *NewGroup(unsigned long hash, char *key, int keylen,
+                          int first, int NCols)
+   -------------------------------------------------------------------
+   Input:   unsigned long hash     Hash of the key
+            char          *key     Key
+            int           keylen   Length of key
+            int           first    Index of the first hit in the group
+            int           NCols    Number of columns
+   Returns: GROUP         *        New empty group (NULL if no memory)
+
+   The group, its aggregate arrays and its key are allocated as one
+   block.
+
+   19.10.26 Original    By: ACRM
+*/
+static GROUP *NewGroup(unsigned long hash, char *key, int keylen,
+                       int first, int NCols)
+{
+   GROUP *g;
+   int   i;
+
+   if((g = (GROUP *)malloc(sizeof(GROUP) +
+                           NCols * (sizeof(double) + 2 * sizeof(int)) +
+                           keylen + 1))==NULL)
+      return(NULL);
+
+   g->sum    = (double *)(g+1);
+   g->min    = (int *)(g->sum + NCols);
+   g->max    = g->min + NCols;
+   g->key    = (char *)(g->max + NCols);
+   memcpy(g->key, key, keylen);
+   g->key[keylen] = '\0';
+
+   g->next    = g->nextall = NULL;
+   g->hash    = hash;
+   g->keylen  = keylen;
+   g->first   = first;
+   g->count   = 0;
+   for(i=0; i<NCols; i++)
+   {
+      g->sum[i] = 0.0;
+      g->min[i] = g->max[i] = 0;
+   }
+
+   return(g);
+}
+
+
+/************************************************************************/
+/*>static void InsertGroup(GROUPTAB *tab, GROUP *g)
+   ------------------------------------------------
+   I/O:     GROUPTAB *tab    Hash table
+   Input:   GROUP    *g      Group to add
+
+   Adds a group to a hash table, growing the table when it gets full.
+   If memory can't be found to grow it, the old table is simply kept.
+
+   19.10.26 Original    By: ACRM
+*/
+static void InsertGroup(GROUPTAB *tab, GROUP *g)
+{
+   GROUP **bucket,
+         *p;
+   int   i,
+         NBuckets;
+
+   if(tab->NGroups >= 2 * tab->NBuckets)
+   {
+      NBuckets = tab->NBuckets * 4;
+      if((bucket = (GROUP **)malloc(NBuckets * sizeof(GROUP *)))!=NULL)
+      {
+         for(i=0; i<NBuckets; i++)
+            bucket[i] = NULL;
+         for(p=tab->groups; p!=NULL; p=p->nextall)
+         {
+            i              = p->hash % NBuckets;
+            p->next        = bucket[i];
+            bucket[i]      = p;
+         }
+         free(tab->bucket);
+         tab->bucket   = bucket;
+         tab->NBuckets = NBuckets;
+      }
+   }
+
+   i              = g->hash % tab->NBuckets;
+   g->next        = tab->bucket[i];
+   tab->bucket[i] = g;
+   g->nextall     = tab->groups;
+   tab->groups    = g;
+   tab->NGroups++;
+}
+
+
+/************************************************************************/
+/*>static void MergeGroup(GROUP *g1, GROUP *g2, COLUMN *cols, int NCols)
+   ---------------------------------------------------------------------
+   I/O:     GROUP   *g1     Group to merge into
+   Input:   GROUP   *g2     Group to merge from
+            COLUMN  *cols   Columns
+            int     NCols   Number of columns
+
+   Merges the partial aggregates from another thread into a group
+
+   19.10.26 Original    By: ACRM
+*/
+static void MergeGroup(GROUP *g1, GROUP *g2, COLUMN *cols, int NCols)
+{
+   int c;
+
+   for(c=0; c<NCols; c++)
+   {
+      if(cols[c].IsInt)
+      {
+         g1->min[c] = MIN(g1->min[c], g2->min[c]);
+         g1->max[c] = MAX(g1->max[c], g2->max[c]);
+         g1->sum[c] += g2->sum[c];
+      }
+   }
+   g1->count += g2->count;
+   g1->first  = MIN(g1->first, g2->first);
+}
+
+
+/************************************************************************/
+/*>static char *GetKeyText(GROUP *g, int KeyIndex)
+   -----------------------------------------------
+   Input:   GROUP   *g          A group
+            int     KeyIndex    Which of the GROUP BY fields
+   Returns: char    *           The text of this field for the group
+
+   19.10.26 Original    By: ACRM
+*/
+static char *GetKeyText(GROUP *g, int KeyIndex)
+{
+   char *p = g->key;
+
+   while(KeyIndex-- > 0)
+      p += strlen(p) + 1;
+
+   return(p);
+}
+
+
+/************************************************************************/
+/*>static double GetAggregateValue(GROUP *g, int aggregate, int col)
+   -----------------------------------------------------------------
+   Input:   GROUP   *g          A group
+            int     aggregate   AGG_xxxx type
+            int     col         Column for MIN, MAX and AVG
+   Returns: double              The value of the aggregate
+
+   19.10.26 Original    By: ACRM
+*/
+static double GetAggregateValue(GROUP *g, int aggregate, int col)
+{
+   switch(aggregate)
+   {
+   case AGG_COUNT:
+      return((double)g->count);
+   case AGG_MIN:
+      return((double)g->min[col]);
+   case AGG_MAX:
+      return((double)g->max[col]);
+   case AGG_AVG:
+      return(g->count ? g->sum[col] / (double)g->count : 0.0);
+   default:
+      break;
+   }
+   return(0.0);
+}
+
+
+/************************************************************************/
+/*>static int CompareGroups(const void *g1, const void *g2)
+   --------------------------------------------------------
+   Input:   const void *g1, *g2   Pointers to GROUP pointers
+   Returns: int                   Comparison for qsort()
+
+   Compares groups on the ORDER BY field (if any) and then on the order
+   in which they were first seen.
+
+   19.10.26 Original    By: ACRM
+*/
+static int CompareGroups(const void *g1, const void *g2)
+{
+   GROUP  *a = *(GROUP **)g1,
+          *b = *(GROUP **)g2;
+   double va, vb;
+   int    cmp = 0;
+
+   if(sOrderAgg != AGG_NONE || (sOrderKey >= 0 && sOrderInt))
+   {
+      va  = GetAggregateValue(a, (sOrderAgg?sOrderAgg:AGG_MIN), sOrderCol);
+      vb  = GetAggregateValue(b, (sOrderAgg?sOrderAgg:AGG_MIN), sOrderCol);
+      cmp = (va < vb) ? -1 : ((va > vb) ? 1 : 0);
+   }
+   else if(sOrderKey >= 0)
+   {
+      cmp = strcmp(GetKeyText(a, sOrderKey), GetKeyText(b, sOrderKey));
+   }
+
+   if(cmp)
+      return(sDescending ? -cmp : cmp);
+
+   return(a->first - b->first);
+}
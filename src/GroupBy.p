@@ -0,0 +1,4 @@
+BOOL IsGroupedQuery(void)
+;
+BOOL DisplayGroups(FILE *fp, int StackDepth)
+;
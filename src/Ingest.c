@@ -0,0 +1,746 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Ingest.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Reads a raw Kabat archive (kabat.raw.dat) or the directory of entry
+   files from which it is built, without going through splitkabat and
+   a file of files.
+
+   The whole archive is read into memory in one pass. Each entry is
+   classified with the same rules as splitkabat (ClassifyKabatEntry())
+   and appended to an in-memory copy of the species and chain file
+   which splitkabat would have written. These are then grouped by
+   species in the same way as BuildFOF.perl and each group is opened
+   with fmemopen() and passed to ReadKabatGroup(), so the data are
+   exactly the same as from running splitkabat, BuildFOF.perl and
+   kabatman -f.
+
+   For a directory, each sub-directory `dir' contributes the files
+   `dir/dir*' as in buildkabat.sh. Anything else is ignored. Everything
+   is taken in name order.
+
+   The raw file index is kept as for the split files, using the names
+   splitkabat would have given them, so kabatman -r with -i updates the
+   stored data from the archive in the same way as -i alone does from
+   the split files.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+                  Keeps the raw file index. Added UpdateKabatArchive()
+
+*************************************************************************/
+/* Includes
+*/
+#include <sys/stat.h>
+#include <dirent.h>
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define MAXVIRTFILE  64         /* Max number of species/chain files    */
+#define BLOCKSIZE    65536      /* Size of reads and buffer increments  */
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static BOOL GrowBuffer(char **buffer, long *size, long needed);
+static BOOL AppendFile(char *filename, char **buffer, long *length,
+                       long *size);
+static BOOL AppendDirectory(char *dirname, char *prefix, char **buffer,
+                            long *length, long *size);
+static char **ListDirectory(char *dirname, char *prefix, int *NNames);
+static int  CompareNames(const void *name1, const void *name2);
+static int  CompareVirtFiles(const void *vf1, const void *vf2);
+static BOOL SplitArchive(char *buffer, long length, VIRTFILE *files,
+                         int *NFiles);
+static BOOL ReadVirtGroup(VIRTFILE *files, int NFiles);
+static BOOL LoadArchive(char *path, VIRTFILE *files, int *NFiles);
+static int  GroupSpec(VIRTFILE *files, int first, int NFiles,
+                      char *spec);
+
+
+/************************************************************************/
+/*>BOOL ReadKabatArchive(char *path)
+   ---------------------------------
+   Input:   char  *path        Raw Kabat archive or directory of entry
+                               files
+   Returns: BOOL               Success?
+   Globals: DATA  *gData       Data linked list
+
+   Reads a raw Kabat archive (or directory of entry files) into the
+   global gData linked list. The result is the same as splitting the
+   archive with splitkabat, building a file of files with BuildFOF.perl
+   and reading that with ReadKabatData().
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Each group is added to the raw file index. Reading the
+            archive split out into LoadArchive()
+*/
+BOOL ReadKabatArchive(char *path)
+{
+   VIRTFILE files[MAXVIRTFILE];
+   char     spec[MAXBUFF];
+   int      NFiles = 0,
+            first,
+            last,
+            i;
+   BOOL     ok;
+
+   /* Start a new raw file index                                        */
+   FreeRawIndex();
+
+   ok = LoadArchive(path, files, &NFiles);
+   SetVirtualFiles(files, NFiles);
+
+   /* Read each group of files as a line of the file of files           */
+   for(first=0; ok && first<NFiles; first=last)
+   {
+      last = GroupSpec(files, first, NFiles, spec);
+      if((ok = ReadVirtGroup(files+first, last-first)))
+         RecordRawGroup(spec, gData);
+   }
+
+   SetVirtualFiles(NULL, 0);
+   for(i=0; i<NFiles; i++)
+      free(files[i].buffer);
+
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>BOOL UpdateKabatArchive(char *path, int *NChanges)
+   --------------------------------------------------
+   Input:   char  *path        Raw Kabat archive or directory of entry
+                               files
+   Output:  int   *NChanges    Number of raw entries added, changed or
+                               deleted
+   Returns: BOOL               Success. FALSE if a full rebuild is
+                               needed
+   Globals: DATA  *gData       Data linked list read from the stored
+                               file (updated)
+
+   Brings the data read from the stored data file up to date with a raw
+   Kabat archive using the raw file index. The groups of in-memory
+   files are given to UpdateKabatGroups() as a file of files would be.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL UpdateKabatArchive(char *path, int *NChanges)
+{
+   VIRTFILE files[MAXVIRTFILE];
+   FILE     *fp;
+   char     spec[MAXBUFF],
+            *FoF    = NULL;
+   long     length  = 0,
+            size    = 0;
+   int      NFiles  = 0,
+            first,
+            last,
+            i;
+   BOOL     ok;
+
+   *NChanges = 0;
+
+   ok = LoadArchive(path, files, &NFiles);
+
+   /* Build the file of files                                           */
+   for(first=0; ok && first<NFiles; first=last)
+   {
+      last = GroupSpec(files, first, NFiles, spec);
+      if((ok = GrowBuffer(&FoF, &size, length+strlen(spec)+1)))
+      {
+         sprintf(FoF+length, "%s\n", spec);
+         length += strlen(spec)+1;
+      }
+   }
+
+   if(ok && (NFiles == 0))
+   {
+      fprintf(stderr,"Error: No entries in Kabat archive: %s\n", path);
+      ok = FALSE;
+   }
+
+   if(ok)
+   {
+      if((fp = fmemopen(FoF, length, "r"))==NULL)
+      {
+         ok = FALSE;
+      }
+      else
+      {
+         SetVirtualFiles(files, NFiles);
+         ok = UpdateKabatGroups(fp, NChanges);
+         SetVirtualFiles(NULL, 0);
+         fclose(fp);
+      }
+   }
+
+   if(FoF != NULL)
+      free(FoF);
+   for(i=0; i<NFiles; i++)
+      free(files[i].buffer);
+
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static BOOL LoadArchive(char *path, VIRTFILE *files, int *NFiles)
+   -----------------------------------------------------------------
+   Input:   char      *path     Raw Kabat archive or directory of entry
+                                files
+   Output:  VIRTFILE  *files    The species and chain files in name
+                                order
+            int       *NFiles   Number of files
+   Returns: BOOL                Success?
+
+   Reads the whole archive into memory and splits it into species and
+   chain files. The files are allocated even if FALSE is returned.
+
+   19.10.26 Original (from ReadKabatArchive())   By: ACRM
+*/
+static BOOL LoadArchive(char *path, VIRTFILE *files, int *NFiles)
+{
+   struct stat StatBuf;
+   char        *buffer = NULL;
+   long        length  = 0,
+               size    = 0;
+   BOOL        ok      = TRUE;
+
+   *NFiles = 0;
+
+   if(stat(path, &StatBuf))
+   {
+      fprintf(stderr,"Error: Unable to read Kabat archive: %s\n", path);
+      return(FALSE);
+   }
+
+   /* Read the whole archive into memory                                */
+   if(gInfoLevel >= 1)
+      printf("Reading Kabat archive: %s\n", path);
+   if(S_ISDIR(StatBuf.st_mode))
+      ok = AppendDirectory(path, NULL, &buffer, &length, &size);
+   else
+      ok = AppendFile(path, &buffer, &length, &size);
+
+   /* Split it into species and chain files                             */
+   if(ok)
+      ok = SplitArchive(buffer, length, files, NFiles);
+   if(buffer != NULL)
+      free(buffer);
+
+   qsort(files, *NFiles, sizeof(VIRTFILE), CompareVirtFiles);
+
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static int GroupSpec(VIRTFILE *files, int first, int NFiles,
+                        char *spec)
+   ------------------------------------------------------------
+   Input:   VIRTFILE  *files    The species and chain files in name
+                                order
+            int       first     The first file of a group
+            int       NFiles    Number of files
+   Output:  char      *spec     The group as a line of the file of files
+   Returns: int                 The first file of the next group
+
+   Finds the files for the same species (as BuildFOF.perl) and writes
+   them as BuildFOF.perl would, so the raw file index is the same as
+   for the split files.
+
+   19.10.26 Original    By: ACRM
+*/
+static int GroupSpec(VIRTFILE *files, int first, int NFiles, char *spec)
+{
+   char *species,
+        *p;
+   int  i;
+
+   species = files[first].name;
+   p       = strchr(species, '.');
+   for(i=first+1; i<NFiles; i++)
+   {
+      if(strncmp(files[i].name, species,
+                 (p==NULL)?strlen(species):(size_t)(p-species+1)))
+         break;
+   }
+
+   /* If there's no heavy chain file the line starts with a -           */
+   p = strrchr(species, '.');
+   spec[0] = '\0';
+   if((p == NULL) || strcmp(p, ".hc"))
+      strcat(spec, "- ");
+   for(; first<i; first++)
+   {
+      strcat(spec, files[first].name);
+      strcat(spec, " ");
+   }
+
+   return(i);
+}
+
+
+/************************************************************************/
+/*>static BOOL GrowBuffer(char **buffer, long *size, long needed)
+   --------------------------------------------------------------
+   I/O:     char  **buffer     Buffer (may be NULL)
+            long  *size        Allocated size of the buffer
+   Input:   long  needed       Size required
+   Returns: BOOL               Success?
+
+   Makes sure a buffer has at least the required size, doubling it as
+   needed.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL GrowBuffer(char **buffer, long *size, long needed)
+{
+   char *newbuff;
+   long newsize = *size;
+
+   if(needed <= *size)
+      return(TRUE);
+
+   if(newsize < BLOCKSIZE)
+      newsize = BLOCKSIZE;
+   while(newsize < needed)
+      newsize *= 2;
+
+   if((newbuff = (char *)realloc(*buffer, newsize))==NULL)
+   {
+      fprintf(stderr,"Error: No memory for Kabat archive\n");
+      return(FALSE);
+   }
+   *buffer = newbuff;
+   *size   = newsize;
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL AppendFile(char *filename, char **buffer, long *length,
+                          long *size)
+   -------------------------------------------------------------------
+   Input:   char  *filename    File to read
+   I/O:     char  **buffer     Buffer to which the file is appended
+            long  *length      Length of data in the buffer
+            long  *size        Allocated size of the buffer
+   Returns: BOOL               Success?
+
+   Appends the contents of a file to a buffer.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL AppendFile(char *filename, char **buffer, long *length,
+                       long *size)
+{
+   FILE   *fp;
+   size_t nread;
+
+   if((fp=fopen(filename,"r"))==NULL)
+   {
+      fprintf(stderr,"Error: Unable to read Kabat archive file: %s\n",
+              filename);
+      return(FALSE);
+   }
+
+   do
+   {
+      if(!GrowBuffer(buffer, size, *length + BLOCKSIZE))
+      {
+         fclose(fp);
+         return(FALSE);
+      }
+      nread    = fread(*buffer + *length, 1, BLOCKSIZE, fp);
+      *length += (long)nread;
+   }  while(nread == BLOCKSIZE);
+
+   fclose(fp);
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL AppendDirectory(char *dirname, char *prefix, char **buffer,
+                               long *length, long *size)
+   -----------------------------------------------------------------------
+   Input:   char  *dirname     Directory to read
+            char  *prefix      Only read files starting with this (NULL
+                               for the top level directory)
+   I/O:     char  **buffer     Buffer to which the files are appended
+            long  *length      Length of data in the buffer
+            long  *size        Allocated size of the buffer
+   Returns: BOOL               Success?
+
+   Appends the files in a directory to a buffer in name order. In the
+   top level directory, each sub-directory `dir' contributes the files
+   `dir/dir*'. Plain files in the top level directory and
+   sub-directories of sub-directories are ignored.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL AppendDirectory(char *dirname, char *prefix, char **buffer,
+                            long *length, long *size)
+{
+   struct stat StatBuf;
+   char        **names,
+               *filename;
+   int         NNames,
+               i;
+   BOOL        ok = TRUE;
+
+   if((names = ListDirectory(dirname, prefix, &NNames))==NULL)
+      return(FALSE);
+
+   for(i=0; i<NNames; i++)
+   {
+      if(ok)
+      {
+         if((filename = (char *)malloc(strlen(dirname) +
+                                       strlen(names[i]) + 2))==NULL)
+         {
+            fprintf(stderr,"Error: No memory for Kabat archive\n");
+            ok = FALSE;
+         }
+         else
+         {
+            sprintf(filename,"%s/%s",dirname,names[i]);
+            if(!stat(filename, &StatBuf))
+            {
+               if(S_ISDIR(StatBuf.st_mode))
+               {
+                  if(prefix == NULL)
+                     ok = AppendDirectory(filename, names[i], buffer,
+                                          length, size);
+               }
+               else if(S_ISREG(StatBuf.st_mode) && (prefix != NULL))
+               {
+                  ok = AppendFile(filename, buffer, length, size);
+               }
+            }
+            free(filename);
+         }
+      }
+      free(names[i]);
+   }
+   free(names);
+
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static char **ListDirectory(char *dirname, char *prefix, int *NNames)
+   ---------------------------------------------------------------------
+   Input:   char  *dirname     Directory to list
+            char  *prefix      Only list names starting with this (or
+                               NULL)
+   Output:  int   *NNames      Number of names
+   Returns: char  **           Sorted array of names (NULL on error)
+
+   Lists a directory, skipping names starting with a `.'. The names and
+   the array must be freed by the caller.
+
+   19.10.26 Original    By: ACRM
+*/
+static char **ListDirectory(char *dirname, char *prefix, int *NNames)
+{
+   DIR           *dir;
+   struct dirent *entry;
+   char          **names  = NULL,
+                 **newnames;
+   int           MaxNames = 0;
+
+   *NNames = 0;
+   if((dir = opendir(dirname))==NULL)
+   {
+      fprintf(stderr,"Error: Unable to read Kabat archive directory: \
+%s\n", dirname);
+      return(NULL);
+   }
+
+   while((entry = readdir(dir))!=NULL)
+   {
+      if(entry->d_name[0] == '.')
+         continue;
+      if((prefix != NULL) && strncmp(entry->d_name, prefix,
+                                     strlen(prefix)))
+         continue;
+
+      if(*NNames >= MaxNames)
+      {
+         MaxNames = (MaxNames ? 2*MaxNames : 256);
+         if((newnames = (char **)realloc(names, MaxNames*sizeof(char *)))
+            ==NULL)
+            break;
+         names = newnames;
+      }
+      if((names[*NNames] = (char *)malloc(strlen(entry->d_name)+1))
+         ==NULL)
+         break;
+      strcpy(names[(*NNames)++], entry->d_name);
+   }
+   closedir(dir);
+
+   if(entry != NULL)
+   {
+      fprintf(stderr,"Error: No memory for Kabat archive directory\n");
+      while(*NNames)
+         free(names[--(*NNames)]);
+      if(names != NULL)
+         free(names);
+      return(NULL);
+   }
+
+   /* Make sure we return a valid array for an empty directory          */
+   if(names == NULL && (names = (char **)malloc(sizeof(char *)))==NULL)
+   {
+      fprintf(stderr,"Error: No memory for Kabat archive directory\n");
+      return(NULL);
+   }
+
+   qsort(names, *NNames, sizeof(char *), CompareNames);
+   return(names);
+}
+
+
+/************************************************************************/
+/*>static int CompareNames(const void *name1, const void *name2)
+   -------------------------------------------------------------
+   qsort() comparison for an array of strings.
+
+   19.10.26 Original    By: ACRM
+*/
+static int CompareNames(const void *name1, const void *name2)
+{
+   return(strcmp(*(char **)name1, *(char **)name2));
+}
+
+
+/************************************************************************/
+/*>static int CompareVirtFiles(const void *vf1, const void *vf2)
+   -------------------------------------------------------------
+   qsort() comparison for an array of VIRTFILEs by name.
+
+   19.10.26 Original    By: ACRM
+*/
+static int CompareVirtFiles(const void *vf1, const void *vf2)
+{
+   return(strcmp(((VIRTFILE *)vf1)->name, ((VIRTFILE *)vf2)->name));
+}
+
+
+/************************************************************************/
+/*>static BOOL SplitArchive(char *buffer, long length, VIRTFILE *files,
+                            int *NFiles)
+   --------------------------------------------------------------------
+   Input:   char      *buffer   The archive
+            long      length    Length of the archive
+   Output:  VIRTFILE  *files    The species and chain files
+            int       *NFiles   Number of files
+   Returns: BOOL                Success?
+
+   Splits the archive into in-memory species and chain files as
+   splitkabat would have written them.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL SplitArchive(char *buffer, long length, VIRTFILE *files,
+                         int *NFiles)
+{
+   VIRTFILE *vf = NULL;
+   char     *name;
+   long     pos = 0,
+            start,
+            HeaderEnd;
+   int      i,
+            status;
+
+   *NFiles = 0;
+
+   for(;;)
+   {
+      start = pos;
+      if((status = ScanKabatEntry(buffer, length, &pos, &HeaderEnd,
+                                  &name))==0)
+         break;
+
+      if(status < 0)
+      {
+         fprintf(stderr,"Warning: Kabat archive entry missing DEFINI or \
+AANAME line:\n");
+         fwrite(buffer+start, 1, HeaderEnd-start, stderr);
+      }
+      if(name == NULL)
+         continue;
+
+      /* Find the file, usually the same as for the last entry          */
+      if((vf == NULL) || strcmp(vf->name, name))
+      {
+         for(i=0; i<*NFiles; i++)
+         {
+            if(!strcmp(files[i].name, name))
+               break;
+         }
+         if(i == *NFiles)
+         {
+            if(*NFiles >= MAXVIRTFILE)
+            {
+               fprintf(stderr,"Error: Too many species and chain \
+types in Kabat archive\n");
+               return(FALSE);
+            }
+            files[i].name   = name;
+            files[i].buffer = NULL;
+            files[i].length = 0;
+            files[i].size   = 0;
+            (*NFiles)++;
+         }
+         vf = files+i;
+      }
+
+      /* Copy the entry                                                 */
+      if(!GrowBuffer(&(vf->buffer), &(vf->size), vf->length+pos-start))
+         return(FALSE);
+      memcpy(vf->buffer+vf->length, buffer+start, pos-start);
+      vf->length += pos-start;
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL ReadVirtGroup(VIRTFILE *files, int NFiles)
+   ------------------------------------------------------
+   Input:   VIRTFILE  *files    The species and chain files for one
+                                species in name order
+            int       NFiles    Number of files
+   Returns: BOOL                Success?
+   Globals: DATA      *gData    Data linked list
+
+   Reads a group of in-memory files in the same way as ReadKabatData()
+   reads a line from the file of files. The first file is the heavy
+   chain file if it is a .hc file; the others are light chain files.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL ReadVirtGroup(VIRTFILE *files, int NFiles)
+{
+   FILE *fpH = NULL,
+        *fpL[MAXLFILES];
+   char source[MAXBUFF],
+        LFile[MAXLFILES][MAXBUFF],
+        *p;
+   int  LCClass[MAXLFILES],
+        NLFile = 0,
+        i;
+   BOOL ok = TRUE;
+
+   if(gInfoLevel >= 1)
+   {
+      printf("Processing files:");
+      if(((p = strrchr(files[0].name,'.'))==NULL) || strcmp(p,".hc"))
+         printf(" -");
+      for(i=0; i<NFiles; i++)
+         printf(" %s", files[i].name);
+      printf("\n");
+   }
+
+   for(i=0; i<NFiles; i++)
+   {
+      p = strrchr(files[i].name, '.');
+      if((i == 0) && (p != NULL) && !strcmp(p, ".hc"))
+      {
+         if((fpH = fmemopen(files[i].buffer, files[i].length, "r"))
+            ==NULL)
+         {
+            ok = FALSE;
+            break;
+         }
+      }
+      else if(NLFile < MAXLFILES)
+      {
+         if((fpL[NLFile] = fmemopen(files[i].buffer, files[i].length,
+                                    "r"))==NULL)
+         {
+            ok = FALSE;
+            break;
+         }
+
+         /* Set the class flag based on the filename                    */
+         strcpy(LFile[NLFile], files[i].name);
+         UPPER(LFile[NLFile]);
+         LCClass[NLFile] = 0;
+         if(strstr(LFile[NLFile],"KAPPA")!=NULL)
+            LCClass[NLFile] = CLASS_KAPPA;
+         else if(strstr(LFile[NLFile],"LAMBDA")!=NULL)
+            LCClass[NLFile] = CLASS_LAMBDA;
+         NLFile++;
+      }
+   }
+
+   if(!ok)
+   {
+      fprintf(stderr,"Error: Unable to open in-memory Kabat file: %s\n",
+              files[i].name);
+   }
+   else
+   {
+      /* Find out the source from the filename                          */
+      if(fpH != NULL)
+         GetSource(files[0].name, source);
+      else
+         GetSource(LFile[0], source);
+
+      ok = ReadKabatGroup(fpH, fpL, NLFile, source, LCClass);
+   }
+
+   if(fpH != NULL)
+      fclose(fpH);
+   for(i=0; i<NLFile; i++)
+      fclose(fpL[i]);
+
+   return(ok);
+}
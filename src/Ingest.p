@@ -0,0 +1,4 @@
+BOOL ReadKabatArchive(char *path)
+;
+BOOL UpdateKabatArchive(char *path, int *NChanges)
+;
@@ -0,0 +1,446 @@
+/*************************************************************************
+
+   Program:    KabatMan / splitkabat
+   File:       KabClass.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Classify new format Kabat entries by species and chain
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   The rules used to decide which species and chain type file a new
+   format Kabat entry belongs in, based on its DEFINI and SPECIE
+   records. Moved out of splitkabat.c so that KabatMan can classify
+   entries as it reads a raw Kabat archive directly.
+
+   The keywords are compiled once into a table indexed by their first
+   letter, so an entry's DEFINI and SPECIE records are scanned once
+   rather than searched for each species and chain in turn.
+
+   ScanKabatEntry() does the same job as FindFileType() and SkipEntry()
+   in splitkabat but works on an entry in memory.
+
+   This file does not depend on kabatman.h since it is also linked into
+   splitkabat.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original - gFileInfo[] and gSkipKeys[] and the end of
+                  FindFileType() from splitkabat.c V1.2
+                  Keyword matcher compiled by InitKabatClassifier().
+                  Added ScanKabatEntry()
+
+*************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/macros.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define MAXBUFF      160        /* Line length as in splitkabat         */
+#define NHEADER      16         /* Max header lines before AANAME       */
+#define MAXDEFLINE   8          /* Max DEFINI/SPECIE lines used         */
+#define MAXKEYWORD   64         /* Max distinct species/chain/skip keys */
+
+typedef struct
+{
+   char *source,
+        *chain,
+        *file;
+}  FILEINFO;
+
+/************************************************************************/
+/* Globals
+*/
+FILEINFO gFileInfo[] =              /* Map keywords to filename         */
+{  { "CAT ", "HEAVY", "cat.ig.hc"},
+   { "CAT ", "LAMBDA", "cat.ig.lambda"},
+   { "CAT ", "KAPPA", "cat.ig.kappa"},
+   { "CAT\n", "HEAVY", "cat.ig.hc"},
+   { "CAT\n", "LAMBDA", "cat.ig.lambda"},
+   { "CAT\n", "KAPPA", "cat.ig.kappa"},
+   { "CHICKEN", "HEAVY", "chicken.ig.hc"},
+   { "CHICKEN", "LAMBDA", "chicken.ig.lambda"},
+   { "CHICKEN", "KAPPA", "chicken.ig.kappa"},
+   { "DOG ", "HEAVY", "dog.ig.hc"},
+   { "DOG ", "LAMBDA", "dog.ig.lambda"},
+   { "DOG ", "KAPPA", "dog.ig.kappa"},
+   { "DOG\n", "HEAVY", "dog.ig.hc"},
+   { "DOG\n", "LAMBDA", "dog.ig.lambda"},
+   { "DOG\n", "KAPPA", "dog.ig.kappa"},
+   { "FROG", "HEAVY", "frog.ig.hc"},
+   { "FROG", "LAMBDA", "frog.ig.lambda"},
+   { "FROG", "KAPPA", "frog.ig.kappa"},
+   { "GOPHER", "HEAVY", "gopher.ig.hc"},
+   { "GOPHER", "LAMBDA", "gopher.ig.lambda"},
+   { "GOPHER", "KAPPA", "gopher.ig.kappa"},
+   { "HORSE", "HEAVY", "horse.ig.hc"},
+   { "HORSE", "LAMBDA", "horse.ig.lambda"},
+   { "HORSE", "KAPPA", "horse.ig.kappa"},
+   { "HUMAN", "HEAVY", "human.ig.hc"},
+   { "HUMAN", "LAMBDA", "human.ig.lambda"},
+   { "HUMAN", "KAPPA", "human.ig.kappa"},
+   { "MOUSE", "HEAVY", "mouse.ig.hc"},
+   { "MOUSE", "LAMBDA", "mouse.ig.lambda"},
+   { "MOUSE", "KAPPA", "mouse.ig.kappa"},
+   { "RABBIT", "HEAVY", "rabbit.ig.hc"},
+   { "RABBIT", "LAMBDA", "rabbit.ig.lambda"},
+   { "RABBIT", "KAPPA", "rabbit.ig.kappa"},
+   { "RAT", "HEAVY", "rat.ig.hc"},
+   { "RAT", "LAMBDA", "rat.ig.lambda"},
+   { "RAT", "KAPPA", "rat.ig.kappa"},
+   { "SHARK", "HEAVY", "shark.ig.hc"},
+   { "SHARK", "LAMBDA", "shark.ig.lambda"},
+   { "SHARK", "KAPPA", "shark.ig.kappa"},
+   { "SHEEP", "HEAVY", "sheep.ig.hc"},
+   { "SHEEP", "LAMBDA", "sheep.ig.lambda"},
+   { "SHEEP", "KAPPA", "sheep.ig.kappa"},
+   { "VARIOUS", "HEAVY", "various.ig.hc"},
+   { "VARIOUS", "LAMBDA", "various.ig.lambda"},
+   { "VARIOUS", "KAPPA", "various.ig.kappa"},
+   { NULL, NULL, NULL}
+}  ;
+
+char *gSkipKeys[] =               /* Any DEFINI having these is skipped */
+{  "MINIGENE",
+   "RECEPTOR",
+   "PSEUDOGENE",
+   "HISTOCOMPATIBILITY",
+   "CONSTANT",
+   "ADHESION",
+   "MICROGLOBULIN",
+   "COMPLEMENT",
+   "T-CELL",
+   "SIGNAL",
+   NULL
+}  ;
+
+static char *sKeyword[MAXKEYWORD];       /* Distinct keywords           */
+static int  sNKeyword     = 0,
+            sKeyStart[256],              /* First keyword for a letter  */
+            sKeyNext[MAXKEYWORD],        /* Next keyword, same letter   */
+            *sSourceKey   = NULL,        /* Keyword for each gFileInfo  */
+            *sChainKey    = NULL,        /*    source and chain         */
+            *sSkipKey     = NULL;        /* Keyword for each gSkipKeys  */
+static BOOL sInitialised  = FALSE;
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "KabClass.p"
+static int  AddKeyword(char *keyword);
+static long MemGets(char *line, int size, char *buffer, long pos,
+                    long end);
+
+
+/************************************************************************/
+/*>BOOL InitKabatClassifier(void)
+   ------------------------------
+   Returns: BOOL         Success (FALSE if no memory or too many keywords)
+
+   Compiles the species, chain and skip keywords from gFileInfo[] and
+   gSkipKeys[] into a table indexed by first letter. Called by
+   ClassifyKabatEntry() if needed, but must be called before
+   ClassifyKabatEntry() is used from more than one thread.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL InitKabatClassifier(void)
+{
+   int i,
+       NInfo,
+       NSkip;
+
+   if(sInitialised)
+      return(TRUE);
+
+   for(i=0; i<256; i++)
+      sKeyStart[i] = (-1);
+   sNKeyword = 0;
+
+   for(NInfo=0; gFileInfo[NInfo].file != NULL; NInfo++);
+   for(NSkip=0; gSkipKeys[NSkip] != NULL; NSkip++);
+
+   if(((sSourceKey = (int *)malloc(NInfo * sizeof(int)))==NULL) ||
+      ((sChainKey  = (int *)malloc(NInfo * sizeof(int)))==NULL) ||
+      ((sSkipKey   = (int *)malloc(NSkip * sizeof(int)))==NULL))
+      return(FALSE);
+
+   for(i=0; i<NInfo; i++)
+   {
+      if(((sSourceKey[i] = AddKeyword(gFileInfo[i].source)) < 0) ||
+         ((sChainKey[i]  = AddKeyword(gFileInfo[i].chain))  < 0))
+         return(FALSE);
+   }
+   for(i=0; i<NSkip; i++)
+   {
+      if((sSkipKey[i] = AddKeyword(gSkipKeys[i])) < 0)
+         return(FALSE);
+   }
+
+   sInitialised = TRUE;
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static int AddKeyword(char *keyword)
+   ------------------------------------
+   Input:   char  *keyword   An upper case keyword
+   Returns: int              Its index in sKeyword[] (-1 if the table is
+                             full)
+
+   Adds a keyword to the table unless it is already there.
+
+   19.10.26 Original    By: ACRM
+*/
+static int AddKeyword(char *keyword)
+{
+   int           i;
+   unsigned char first = (unsigned char)keyword[0];
+
+   for(i=sKeyStart[first]; i>=0; i=sKeyNext[i])
+   {
+      if(!strcmp(sKeyword[i], keyword))
+         return(i);
+   }
+
+   if(sNKeyword >= MAXKEYWORD)
+      return(-1);
+
+   i = sNKeyword++;
+   sKeyword[i]      = keyword;
+   sKeyNext[i]      = sKeyStart[first];
+   sKeyStart[first] = i;
+   return(i);
+}
+
+
+/************************************************************************/
+/*>char *ClassifyKabatEntry(char *deflines)
+   -----------------------------------------
+   Input:   char  *deflines  The DEFINI and SPECIE records of an entry
+                             concatenated with their newlines
+   Returns: char  *          The species and chain type file for the
+                             entry (e.g. human.ig.hc) or NULL if the
+                             entry is not wanted
+
+   Entries having any of the gSkipKeys[] are rejected. Otherwise the
+   first entry in gFileInfo[] whose species and chain both appear is
+   used. Failing that, the `various' file for the chain is used. Case
+   is ignored.
+
+   29.06.94 Original (as part of FindFileType())    By: ACRM
+   30.06.94 Handles gSkipKeys[]
+   08.02.95 Upcases the buffer before testing for keywords.
+   19.10.26 Split out of FindFileType() in splitkabat.c
+            Finds all the keywords in one pass using the table compiled
+            by InitKabatClassifier() rather than upcasing the buffer and
+            searching for each keyword in turn
+*/
+char *ClassifyKabatEntry(char *deflines)
+{
+   BOOL found[MAXKEYWORD];
+   char *p;
+   int  i, j;
+
+   if(!sInitialised && !InitKabatClassifier())
+      return(NULL);
+
+   for(i=0; i<sNKeyword; i++)
+      found[i] = FALSE;
+
+   /* Note every keyword which starts at each position                  */
+   for(p=deflines; *p; p++)
+   {
+      for(i=sKeyStart[(unsigned char)toupper(*p)]; i>=0; i=sKeyNext[i])
+      {
+         if(found[i])
+            continue;
+         for(j=1; sKeyword[i][j]; j++)
+         {
+            if(toupper(p[j]) != sKeyword[i][j])
+               break;
+         }
+         if(!sKeyword[i][j])
+            found[i] = TRUE;
+      }
+   }
+
+   /* See if any of the skip keys are present, if so return NULL        */
+   for(i=0; gSkipKeys[i] != NULL; i++)
+   {
+      if(found[sSkipKey[i]])
+         return(NULL);
+   }
+
+   /* Search for specific types                                         */
+   for(i=0; gFileInfo[i].file != NULL; i++)
+   {
+      if(found[sSourceKey[i]] && found[sChainKey[i]])
+         return(gFileInfo[i].file);
+   }
+
+   /* Now do `various' types                                            */
+   for(i=0; gFileInfo[i].file != NULL; i++)
+   {
+      if(!strncmp(gFileInfo[i].source,"VARIOUS",7) &&
+         found[sChainKey[i]])
+         return(gFileInfo[i].file);
+   }
+
+   return(NULL);
+}
+
+
+/************************************************************************/
+/*>int ScanKabatEntry(char *buffer, long end, long *pos, long *HeaderEnd,
+                      char **file)
+   ----------------------------------------------------------------------
+   Input:   char  *buffer     Kabat entries in memory
+            long  end         Length of buffer
+   I/O:     long  *pos        Start of the entry; output at the start of
+                              the next entry
+   Output:  long  *HeaderEnd  End of the header lines which were read to
+                              classify the entry
+            char  **file      The species and chain type file for the
+                              entry or NULL if it is not wanted
+   Returns: int               0 at end of buffer, 1 if the entry was
+                              classified, -1 if it had no DEFINI or
+                              SPECIE line before the AANAME line
+
+   Reads the header lines of an entry up to the AANAME line, classifies
+   the entry from its DEFINI and SPECIE lines and moves past the RECEND
+   line. Lines are split into MAXBUFF chunks exactly as splitkabat reads
+   them with fgets() so the entries are the same.
+
+   29.06.94 Original (as FindFileType() and SkipEntry())    By: ACRM
+   30.06.94 Handles multiple DEFINI lines
+   18.07.94 Checks specifes lines as well as DEFINI lines
+   08.02.95 Just looks for SEQ to end a header rather than SEQRES
+   19.10.26 Works on a buffer in memory
+*/
+int ScanKabatEntry(char *buffer, long end, long *pos, long *HeaderEnd,
+                   char **file)
+{
+   char line[MAXBUFF],
+        deflines[MAXDEFLINE * MAXBUFF];
+   int  NDefLine   = 0,
+        HeaderLine = 0;
+   long newpos;
+
+   deflines[0] = '\0';
+   *file       = NULL;
+
+   while((newpos = MemGets(line, MAXBUFF, buffer, *pos, end)) != *pos)
+   {
+      *pos = newpos;
+
+      if((!strncmp(line,"DEFINI",6) || !strncmp(line,"SPECIE",6)) &&
+         (NDefLine < MAXDEFLINE))
+      {
+         strcat(deflines, line);
+         NDefLine++;
+      }
+      if(!strncmp(line,"AANAME",6))
+      {
+         HeaderLine++;
+         break;
+      }
+      if(!strncmp(line,"SEQ",3))
+      {
+         NDefLine = 0;
+         break;
+      }
+
+      if(++HeaderLine >= NHEADER)
+      {
+         NDefLine = 0;
+         break;
+      }
+   }
+
+   /* As in splitkabat, a SEQ line at the start of an entry is taken as
+      the end of the data
+   */
+   if(!HeaderLine)
+      return(0);
+
+   *HeaderEnd = *pos;
+
+   if(NDefLine)
+      *file = ClassifyKabatEntry(deflines);
+
+   /* Move past the RECEND line                                         */
+   while((newpos = MemGets(line, MAXBUFF, buffer, *pos, end)) != *pos)
+   {
+      *pos = newpos;
+      if(!strncmp(line,"RECEND",6))
+         break;
+   }
+
+   return(NDefLine ? 1 : (-1));
+}
+
+
+/************************************************************************/
+/*>static long MemGets(char *line, int size, char *buffer, long pos,
+                       long end)
+   ------------------------------------------------------------------
+   Output:  char  *line        Line read
+   Input:   int   size         Size of line
+            char  *buffer      Buffer to read from
+            long  pos          Position in buffer
+            long  end          Length of buffer
+   Returns: long               Updated position (== pos at end of
+                               buffer)
+
+   Equivalent of fgets() reading from a buffer.
+
+   19.10.26 Original    By: ACRM
+*/
+static long MemGets(char *line, int size, char *buffer, long pos,
+                    long end)
+{
+   int i = 0;
+
+   while((i < size-1) && (pos < end))
+   {
+      line[i++] = buffer[pos++];
+      if(line[i-1] == '\n')
+         break;
+   }
+   line[i] = '\0';
+   return(pos);
+}
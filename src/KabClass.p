@@ -0,0 +1,7 @@
+BOOL InitKabatClassifier(void)
+;
+char *ClassifyKabatEntry(char *deflines)
+;
+int ScanKabatEntry(char *buffer, long end, long *pos, long *HeaderEnd,
+                   char **file)
+;
@@ -0,0 +1,475 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Match.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Substring matching of sequences for the LIKE comparison. The pattern
+   may contain ? as a single character wildcard.
+
+   SeqMatch() is used for the ungapped copies of the light and heavy
+   chains. Candidate start positions are found by comparing the first
+   and last characters of the pattern which are not wildcards against
+   16 positions at a time using SSE2 (which every x86-64 compiler
+   provides) and only those candidates are checked in full. Elsewhere
+   the same test is done a byte at a time.
+
+   fuzzystrstr() is used for sequences which may contain -'s (loops and
+   frameworks extracted during a search).
+
+   HammingMatch() and EditMatch() allow a number of errors for the
+   MISMATCH(n) and SIMILAR(n) comparisons. Both are bit-parallel with
+   one bit per pattern position in a 64-bit word, so they take a fixed
+   small number of operations per residue of the sequence whatever the
+   number of errors (HammingMatch() is the shift-and algorithm with one
+   word per error allowed; EditMatch() is Myers' algorithm).
+
+   EditDistance() gives the edit distance between two whole sequences
+   for the WITHIN(n) comparison and the BK-tree in BKTree.c.
+
+**************************************************************************
+
+   Usage:
+   ======
+   InitMatcher() is called once for the pattern when the WHERE clause
+   is built; SeqMatch(), HammingMatch() or EditMatch() is then called for
+   each sequence searched.
+
+   The microbenchmark program matchbench (make matchbench) compares
+   SeqMatch() with fuzzystrstr() and blQueryStrStr() and times
+   HammingMatch() and EditMatch().
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+                  Added EditDistance()
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/************************************************************************/
+/* Defines and macros
+*/
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static BOOL MatchAt(char *text, char *pattern, int length);
+
+
+/************************************************************************/
+/*>void InitMatcher(char *pattern, MATCHER *matcher)
+   -------------------------------------------------
+   Input:   char    *pattern   The pattern (without -'s)
+   Output:  MATCHER *matcher   The prepared matcher
+
+   Finds the length of the pattern and the first and last characters
+   which are not ? wildcards. Also sets up the bit masks used by
+   HammingMatch() and EditMatch() for the first MAXMATCHLEN characters
+   of the pattern. matcher->errors is not changed.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Added the bit masks
+*/
+void InitMatcher(char *pattern, MATCHER *matcher)
+{
+   int      i,
+            c;
+   uint64_t bit;
+
+   matcher->length = strlen(pattern);
+   matcher->first  = -1;
+   matcher->last   = -1;
+
+   for(c=0; c<256; c++)
+      matcher->masks[c] = 0;
+
+   for(i=0; i<matcher->length; i++)
+   {
+      bit = (i < MAXMATCHLEN) ? ((uint64_t)1 << i) : 0;
+      
+      if(pattern[i] != '?')
+      {
+         if(matcher->first == (-1))
+            matcher->first = i;
+         matcher->last = i;
+         matcher->masks[(unsigned char)pattern[i]] |= bit;
+      }
+      else
+      {
+         for(c=0; c<256; c++)
+            matcher->masks[c] |= bit;
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>BOOL SeqMatch(char *text, int length, char *pattern, MATCHER *matcher)
+   ----------------------------------------------------------------------
+   Input:   char    *text      Sequence to search (without -'s)
+            int     length     Length of text
+            char    *pattern   Pattern for which to look (without -'s)
+            MATCHER *matcher   Matcher from InitMatcher() for pattern
+   Returns: BOOL               Found?
+
+   Tests whether pattern (in which ? matches any character) occurs in
+   text. Gives the same result as fuzzystrstr() on a string without
+   -'s, but only compares the whole pattern at positions where the
+   first and last non-wildcard characters match. Under SSE2, these are
+   tested at 16 positions at once; the loads never go beyond the end of
+   the text.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL SeqMatch(char *text, int length, char *pattern, MATCHER *matcher)
+{
+   int  i       = 0,
+        plen    = matcher->length,
+        first   = matcher->first,
+        last    = matcher->last,
+        nstarts = length - plen + 1;     /* Possible start positions    */
+   char cFirst,
+        cLast;
+
+   if(nstarts <= 0)
+      return(plen == 0);
+
+   /* Pattern is all wildcards and the text is long enough              */
+   if(first == (-1))
+      return(TRUE);
+
+   cFirst = pattern[first];
+   cLast  = pattern[last];
+
+#ifdef __SSE2__
+   {
+      __m128i vFirst = _mm_set1_epi8(cFirst),
+              vLast  = _mm_set1_epi8(cLast),
+              block1,
+              block2;
+      int     mask,
+              bit;
+
+      for(i=0; i+16 <= nstarts; i+=16)
+      {
+         block1 = _mm_loadu_si128((__m128i *)(text + i + first));
+         block2 = _mm_loadu_si128((__m128i *)(text + i + last));
+         mask   = _mm_movemask_epi8(
+                     _mm_and_si128(_mm_cmpeq_epi8(block1, vFirst),
+                                   _mm_cmpeq_epi8(block2, vLast)));
+
+         /* Check each candidate start position in full                 */
+         while(mask)
+         {
+#ifdef __GNUC__
+            bit = __builtin_ctz(mask);
+#else
+            for(bit=0; !(mask & (1 << bit)); bit++);
+#endif
+            if(MatchAt(text+i+bit, pattern, plen))
+               return(TRUE);
+            mask &= mask - 1;
+         }
+      }
+   }
+#endif
+
+   /* Remaining start positions (or all of them without SSE2)           */
+   for(; i<nstarts; i++)
+   {
+      if((text[i+first] == cFirst) &&
+         (text[i+last]  == cLast)  &&
+         MatchAt(text+i, pattern, plen))
+         return(TRUE);
+   }
+
+   return(FALSE);
+}
+
+
+/************************************************************************/
+/*>BOOL HammingMatch(char *text, int length, MATCHER *matcher)
+   -----------------------------------------------------------
+   Input:   char    *text      Sequence to search (without -'s)
+            int     length     Length of text
+            MATCHER *matcher   Matcher from InitMatcher() with errors
+                               set. The pattern must be no longer than
+                               MAXMATCHLEN
+   Returns: BOOL               Found?
+
+   Tests whether the pattern occurs in text with no more than
+   matcher->errors substitutions. state[e] has bit i set if the first
+   i+1 characters of the pattern match the text ending at the current
+   position with e or fewer substitutions.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL HammingMatch(char *text, int length, MATCHER *matcher)
+{
+   uint64_t state[MAXMATCHLEN+1],
+            last,
+            prev,
+            old;
+   int      errors = matcher->errors,
+            i,
+            e;
+
+   if(length < matcher->length)
+      return(FALSE);
+   if(errors >= matcher->length)
+      return(TRUE);
+
+   last = (uint64_t)1 << (matcher->length - 1);
+   for(e=0; e<=errors; e++)
+      state[e] = 0;
+
+   for(i=0; i<length; i++)
+   {
+      uint64_t mask = matcher->masks[(unsigned char)text[i]];
+
+      prev     = state[0];
+      state[0] = ((state[0] << 1) | 1) & mask;
+      for(e=1; e<=errors; e++)
+      {
+         /* Either a match from e errors or a substitution from e-1     */
+         old      = state[e];
+         state[e] = (((state[e] << 1) | 1) & mask) | ((prev << 1) | 1);
+         prev     = old;
+      }
+
+      if(state[errors] & last)
+         return(TRUE);
+   }
+
+   return(FALSE);
+}
+
+
+/************************************************************************/
+/*>BOOL EditMatch(char *text, int length, MATCHER *matcher)
+   --------------------------------------------------------
+   Input:   char    *text      Sequence to search (without -'s)
+            int     length     Length of text
+            MATCHER *matcher   Matcher from InitMatcher() with errors
+                               set. The pattern must be no longer than
+                               MAXMATCHLEN
+   Returns: BOOL               Found?
+
+   Tests whether the pattern occurs in text with an edit distance
+   (substitutions, insertions and deletions) of no more than
+   matcher->errors. Uses Myers' bit-vector algorithm (J. ACM 46:395,
+   1999) which keeps the vertical differences (+1 or -1) of one column
+   of the dynamic programming matrix as the bit vectors VP and VN; HP
+   and HN are the horizontal differences. score is the edit distance of
+   the whole pattern ending at this position.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL EditMatch(char *text, int length, MATCHER *matcher)
+{
+   uint64_t VP    = ~(uint64_t)0,
+            VN    = 0,
+            HP,
+            HN,
+            XV,
+            XH,
+            mask,
+            last;
+   int      score = matcher->length,
+            i;
+
+   if(score <= matcher->errors)
+      return(TRUE);
+
+   last = (uint64_t)1 << (matcher->length - 1);
+
+   for(i=0; i<length; i++)
+   {
+      mask = matcher->masks[(unsigned char)text[i]];
+      XV   = mask | VN;
+      XH   = (((mask & VP) + VP) ^ VP) | mask;
+      HP   = VN | ~(XH | VP);
+      HN   = VP & XH;
+
+      if(HP & last)
+         score++;
+      else if(HN & last)
+         score--;
+      if(score <= matcher->errors)
+         return(TRUE);
+
+      /* The match may start anywhere in the text, so nothing is
+         shifted into the bottom bit
+      */
+      HP <<= 1;
+      HN <<= 1;
+      VP   = HN | ~(XV | HP);
+      VN   = HP & XV;
+   }
+
+   return(FALSE);
+}
+
+
+/************************************************************************/
+/*>int EditDistance(char *seq1, int len1, char *seq2, int len2,
+                    BOOL wildcard)
+   ------------------------------------------------------------
+   Input:   char    *seq1      First sequence (without -'s)
+            int     len1       Length of seq1
+            char    *seq2      Second sequence (without -'s)
+            int     len2       Length of seq2 (less than LARGEBUFF)
+            BOOL    wildcard   Does ? in seq2 match any character?
+   Returns: int                Edit distance
+
+   Gives the Levenshtein distance (the number of substitutions,
+   insertions and deletions needed to turn one sequence into the other)
+   between two whole sequences. The dynamic programming matrix is kept
+   one row (of seq2) at a time. Without wildcards this is a metric so it
+   may be used in the BK-tree.
+
+   19.10.26 Original    By: ACRM
+*/
+int EditDistance(char *seq1, int len1, char *seq2, int len2,
+                 BOOL wildcard)
+{
+   int row[LARGEBUFF+1],
+       diag,
+       above,
+       best,
+       i,
+       j;
+
+   for(j=0; j<=len2; j++)
+      row[j] = j;
+
+   for(i=0; i<len1; i++)
+   {
+      diag   = row[0];
+      row[0] = i+1;
+      for(j=0; j<len2; j++)
+      {
+         above = row[j+1];
+         best  = diag + (((seq1[i] == seq2[j]) ||
+                          (wildcard && (seq2[j] == '?'))) ? 0 : 1);
+         if(above + 1 < best)
+            best = above + 1;
+         if(row[j] + 1 < best)
+            best = row[j] + 1;
+         row[j+1] = best;
+         diag     = above;
+      }
+   }
+
+   return(row[len2]);
+}
+
+
+/************************************************************************/
+/*>static BOOL MatchAt(char *text, char *pattern, int length)
+   ----------------------------------------------------------
+   Input:   char    *text      Position in the sequence
+            char    *pattern   The pattern
+            int     length     Length of the pattern
+   Returns: BOOL               Match?
+
+   Compares the pattern with the text at this position, ? in the
+   pattern matching any character.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL MatchAt(char *text, char *pattern, int length)
+{
+   int i;
+
+   for(i=0; i<length; i++)
+   {
+      if((pattern[i] != '?') && (pattern[i] != text[i]))
+         return(FALSE);
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>BOOL fuzzystrstr(char *text, char *subtext)
+   -------------------------------------------
+   Input:   char  *text       String in which to search
+            char  *subtext    Substring for which to look (without -'s)
+   Returns: BOOL              Found?
+
+   Like blQueryStrStr(), but ignores -'s in the string being searched.
+   Also returns BOOL (found?) rather than a pointer into the string.
+
+   26.04.94 Original    By: ACRM
+   22.06.95 Added checks on blank strings and string lengths
+   23.06.95 Initialise SubText to NULL
+   27.06.95 malloc() for SubText was being done wrong!
+   15.12.95 Changed call to strstr() to use QueryStrStr()
+   19.10.26 The substring must already have had its -'s removed. Skips
+            -'s in the string as it goes rather than making copies
+            Blank string checks moved to DoSeqTest()
+            Moved from ExecSearch.c
+*/
+BOOL fuzzystrstr(char *text, char *subtext)
+{
+   char *t,
+        *s;
+
+   for(; *text; text++)
+   {
+      if(*text == '-')
+         continue;
+
+      for(t=text, s=subtext; *s; s++, t++)
+      {
+         while(*t == '-')
+            t++;
+         if(!*t)                    /* Hit the end of the string        */
+            return(FALSE);
+         if(*s != '?' && *s != *t)
+            break;
+      }
+      if(!*s)
+         return(TRUE);
+   }
+
+   return(!subtext[0]);
+}
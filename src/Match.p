@@ -0,0 +1,13 @@
+void InitMatcher(char *pattern, MATCHER *matcher)
+;
+BOOL SeqMatch(char *text, int length, char *pattern, MATCHER *matcher)
+;
+BOOL fuzzystrstr(char *text, char *subtext)
+;
+BOOL HammingMatch(char *text, int length, MATCHER *matcher)
+;
+BOOL EditMatch(char *text, int length, MATCHER *matcher)
+;
+int EditDistance(char *seq1, int len1, char *seq2, int len2,
+                 BOOL wildcard)
+;
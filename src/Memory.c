@@ -0,0 +1,395 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Memory.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Memory accounting. Each part of the program which holds memory (the
+   entry records, sequences, numbering, cold fields, indexes, Chothia
+   definitions and the current query) has a routine which fills in a
+   MEMUSE giving the memory set aside for it (allocated) and the part of
+   that which holds data (used). The difference is the space lost to
+   fixed size arrays, unused pointers and the rounding of allocations
+   from the arenas. These routines are registered with RegisterMemory()
+   and SHOW MEMORY calls them all to print the report.
+
+   The memory which grows with the number of entries is also projected
+   to a data set of a million entries, assuming the same mix of
+   entries, to help size machines for larger data sets. Indexes and caches are only
+   counted once they have been built or read so the figures depend on
+   the searches which have been run.
+
+   Most of the memory is in gDataArena. The space at the end of its
+   blocks which has not been handed out is shown as the arena's free
+   space.
+
+**************************************************************************
+
+   Usage:
+   ======
+   InitMemory() is called by main() to register the standard parts. A
+   new index or cache should add a routine for its footprint and
+   register it there.
+
+   SHOW MEMORY at the KabatMan prompt calls ShowMemory(). kabatman
+   -memstats calls it before the data are freed at the end of the run.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define MAXMEMPARTS 32                 /* Max registered parts          */
+#define MEMWIDTH    20                 /* Width of part names           */
+#define PROJECTION  1000000.0          /* Entries in the projection     */
+
+typedef struct
+{
+   char *name;
+   void (*func)(MEMUSE *use);
+}  MEMPART;
+
+/************************************************************************/
+/* Globals
+*/
+static MEMPART sMemParts[MAXMEMPARTS];
+static int     sNMemParts = 0;
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static void RecordMemory(MEMUSE *use);
+static void SequenceMemory(MEMUSE *use);
+static void NumberingMemory(MEMUSE *use);
+static void ChothiaMemory(MEMUSE *use);
+static void QueryMemory(MEMUSE *use);
+static void ArenaFreeMemory(MEMUSE *use);
+static size_t SmallSlack(char *string);
+
+
+/************************************************************************/
+/*>void InitMemory(void)
+   ---------------------
+   Registers the parts of the program reported by SHOW MEMORY.
+
+   19.10.26 Original    By: ACRM
+*/
+void InitMemory(void)
+{
+   RegisterMemory("Entry records",    RecordMemory);
+   RegisterMemory("Sequences",        SequenceMemory);
+   RegisterMemory("Numbering tables", NumberingMemory);
+   RegisterMemory("Cold fields",      ColdDataMemory);
+   RegisterMemory("Sequence index",   SeqIndexMemory);
+   RegisterMemory("CDR trees",        BKTreeMemory);
+   RegisterMemory("Similarity hash",  LSHMemory);
+   RegisterMemory("Columns",          ColumnsMemory);
+   RegisterMemory("Zone maps",        ZoneMapMemory);
+   RegisterMemory("Chothia rules",    ChothiaMemory);
+   RegisterMemory("Query",            QueryMemory);
+   RegisterMemory("Arena free space", ArenaFreeMemory);
+}
+
+
+/************************************************************************/
+/*>BOOL RegisterMemory(char *name, void (*func)(MEMUSE *use))
+   ----------------------------------------------------------
+   Input:   char   *name      Name shown in the report
+            void   (*func)()  Routine which fills in a MEMUSE
+   Returns: BOOL              Success (FALSE if there are too many)
+
+   Adds a part to the memory report. Registering a name a second time
+   replaces its routine.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL RegisterMemory(char *name, void (*func)(MEMUSE *use))
+{
+   int i;
+
+   for(i=0; i<sNMemParts; i++)
+   {
+      if(!strcmp(sMemParts[i].name, name))
+      {
+         sMemParts[i].func = func;
+         return(TRUE);
+      }
+   }
+
+   if(sNMemParts >= MAXMEMPARTS)
+   {
+      fprintf(stderr,"Error: Too many parts in the memory report\n");
+      return(FALSE);
+   }
+
+   sMemParts[sNMemParts].name = name;
+   sMemParts[sNMemParts].func = func;
+   sNMemParts++;
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void ShowMemory(FILE *fp)
+   -------------------------
+   Input:   FILE   *fp      Output file
+   Globals: DATA   *gData   The data
+
+   Prints the memory report: the memory allocated and used by each part
+   and, for those which grow with the data, the memory a million entries
+   would need.
+
+   19.10.26 Original    By: ACRM
+*/
+void ShowMemory(FILE *fp)
+{
+   MEMUSE use;
+   DATA   *d;
+   double scale,
+          projected,
+          TotalProjected = 0.0;
+   size_t TotalAllocated = 0,
+          TotalUsed      = 0;
+   int    NData          = 0,
+          i;
+
+   for(d=gData; d!=NULL; NEXT(d))
+      NData++;
+   scale = ((NData > 0) ? PROJECTION / NData : 0.0);
+
+   fprintf(fp,"# Memory use for %d entries\n", NData);
+   fprintf(fp,"# %-*s %12s %12s %6s %14s\n", MEMWIDTH, "Part",
+           "Alloc (kB)", "Used (kB)", "Used%", "Per 1M (MB)");
+   for(i=0; i<sNMemParts; i++)
+   {
+      use.allocated = use.used = use.fixed = 0;
+      (*(sMemParts[i].func))(&use);
+
+      projected = (double)use.fixed +
+                  (double)(use.allocated - use.fixed) * scale;
+      TotalAllocated += use.allocated;
+      TotalUsed      += use.used;
+      TotalProjected += projected;
+
+      fprintf(fp,"# %-*s %12.1f %12.1f %6.1f %14.1f\n", MEMWIDTH,
+              sMemParts[i].name, use.allocated / 1024.0,
+              use.used / 1024.0,
+              (use.allocated ? 100.0 * use.used / use.allocated : 0.0),
+              projected / (1024.0 * 1024.0));
+   }
+   fprintf(fp,"# %-*s %12.1f %12.1f %6.1f %14.1f\n", MEMWIDTH, "Total",
+           TotalAllocated / 1024.0, TotalUsed / 1024.0,
+           (TotalAllocated ? 100.0 * TotalUsed / TotalAllocated : 0.0),
+           TotalProjected / (1024.0 * 1024.0));
+   fprintf(fp,"# Peak resident set size %ld kB\n", PeakRSS());
+}
+
+
+/************************************************************************/
+/*>static void RecordMemory(MEMUSE *use)
+   -------------------------------------
+   Output:  MEMUSE  *use     Memory used by the DATA structures other
+                             than the sequences, and the upper case
+                             copies of the name and class
+
+   The space not used in the fixed size name, class, source and
+   accession code arrays is allocated but not used.
+
+   19.10.26 Original    By: ACRM
+*/
+static void RecordMemory(MEMUSE *use)
+{
+   DATA   *d;
+   size_t size;
+
+   size = ArenaRound(sizeof(DATA)) - 2 * LARGEBUFF * sizeof(char);
+   for(d=gData; d!=NULL; NEXT(d))
+   {
+      use->allocated += size;
+      use->used      += size - SmallSlack(d->class) -
+                        SmallSlack(d->name) - SmallSlack(d->idlight) -
+                        SmallSlack(d->idheavy) -
+                        (MAXBUFF - strlen(d->source) - 1);
+      if(d->UpperName != NULL)
+      {
+         use->allocated += ArenaRound(strlen(d->UpperName)+1) +
+                           ArenaRound(strlen(d->UpperClass)+1);
+         use->used      += strlen(d->UpperName)+1 +
+                           strlen(d->UpperClass)+1;
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>static void SequenceMemory(MEMUSE *use)
+   ---------------------------------------
+   Output:  MEMUSE  *use     Memory used by the aligned chains in the
+                             DATA structures and their ungapped copies
+
+   19.10.26 Original    By: ACRM
+*/
+static void SequenceMemory(MEMUSE *use)
+{
+   DATA *d;
+
+   for(d=gData; d!=NULL; NEXT(d))
+   {
+      use->allocated += 2 * LARGEBUFF * sizeof(char);
+      use->used      += strlen(d->light)+1 + strlen(d->heavy)+1;
+      if(d->UngappedLight != NULL)
+      {
+         use->allocated += ArenaRound(strlen(d->UngappedLight)+1) +
+                           ArenaRound(strlen(d->UngappedHeavy)+1);
+         use->used      += strlen(d->UngappedLight)+1 +
+                           strlen(d->UngappedHeavy)+1;
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>static void NumberingMemory(MEMUSE *use)
+   ----------------------------------------
+   Output:  MEMUSE  *use     Memory used by the special numbering of the
+                             chains which have it
+
+   Each table is an array of MAXKABATSEQ pointers of which only those
+   up to the terminating NULL are used and each number is given five
+   characters.
+
+   19.10.26 Original    By: ACRM
+*/
+static void NumberingMemory(MEMUSE *use)
+{
+   DATA *d;
+   char **numbers;
+   int  chain,
+        i;
+
+   for(d=gData; d!=NULL; NEXT(d))
+   {
+      for(chain=0; chain<2; chain++)
+      {
+         if((numbers = (chain ? d->HNumbers : d->LNumbers)) == NULL)
+            continue;
+
+         use->allocated += ArenaRound(MAXKABATSEQ * sizeof(char *));
+         for(i=0; numbers[i]!=NULL; i++)
+         {
+            use->allocated += ArenaRound(5 * sizeof(char));
+            use->used      += sizeof(char *) + strlen(numbers[i]) + 1;
+         }
+         use->used += sizeof(char *);
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>static void ChothiaMemory(MEMUSE *use)
+   --------------------------------------
+   Output:  MEMUSE  *use     Memory used by the canonical definitions
+
+   19.10.26 Original    By: ACRM
+*/
+static void ChothiaMemory(MEMUSE *use)
+{
+   ArenaUsage(gChothiaArena, &(use->allocated), &(use->used));
+   use->fixed = use->allocated;
+}
+
+
+/************************************************************************/
+/*>static void QueryMemory(MEMUSE *use)
+   ------------------------------------
+   Output:  MEMUSE  *use     Memory used by the current query
+
+   The clauses of the current query. The hit lists and other temporary
+   arrays used while a search is run are freed when it finishes.
+
+   19.10.26 Original    By: ACRM
+*/
+static void QueryMemory(MEMUSE *use)
+{
+   SELECTION *s;
+   WHERE     *w;
+
+   for(s=gSelectClause; s!=NULL; NEXT(s))
+      use->allocated += sizeof(SELECTION);
+   for(s=gGroupBy; s!=NULL; NEXT(s))
+      use->allocated += sizeof(SELECTION);
+   if(gOrderBy != NULL)
+      use->allocated += sizeof(SELECTION);
+   for(w=gWhereClause; w!=NULL; NEXT(w))
+      use->allocated += sizeof(WHERE);
+
+   use->used  = use->allocated;
+   use->fixed = use->allocated;
+}
+
+
+/************************************************************************/
+/*>static void ArenaFreeMemory(MEMUSE *use)
+   ----------------------------------------
+   Output:  MEMUSE  *use     Space in gDataArena which has not been
+                             handed out
+
+   19.10.26 Original    By: ACRM
+*/
+static void ArenaFreeMemory(MEMUSE *use)
+{
+   size_t allocated,
+          used;
+
+   ArenaUsage(gDataArena, &allocated, &used);
+   use->allocated = allocated - used;
+   use->fixed     = use->allocated;
+}
+
+
+/************************************************************************/
+/*>static size_t SmallSlack(char *string)
+   --------------------------------------
+   Input:   char   *string    A string in a SMALLBUFF array
+   Returns: size_t            Bytes of the array which are not used
+
+   19.10.26 Original    By: ACRM
+*/
+static size_t SmallSlack(char *string)
+{
+   return(SMALLBUFF - strlen(string) - 1);
+}
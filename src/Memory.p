@@ -0,0 +1,6 @@
+void InitMemory(void)
+;
+BOOL RegisterMemory(char *name, void (*func)(MEMUSE *use))
+;
+void ShowMemory(FILE *fp)
+;
@@ -0,0 +1,547 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       OrderBy.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Sorting of the hit list for ORDER BY. The sort key is calculated
+   once for each hit and the hits are then sorted on the stored keys.
+   Integer keys (lengths, dates) are sorted with an LSD radix sort;
+   string keys with qsort(). If only the first few hits are needed
+   (LIMIT), a bounded heap is used to keep just those so that the whole
+   hit list never needs to be sorted.
+
+   Ties are always broken on the original (load) order so the output is
+   the same as a stable sort.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+                  Added IDENTITY
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+typedef struct
+{
+   DATA *data;       /* The hit                                         */
+   int  index;       /* Position in the hit list - used to break ties   */
+   int  ikey;        /* Integer sort key                                */
+   char *skey;       /* String sort key                                 */
+}  SORTKEY;
+
+/************************************************************************/
+/* Globals
+*/
+static BOOL sDescending = FALSE;
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static int  CompareIntKeys(const void *k1, const void *k2);
+static int  CompareStrKeys(const void *k1, const void *k2);
+static BOOL RadixSortKeys(SORTKEY *keys, int NKeys);
+static void SiftDown(SORTKEY *heap, int NHeap, int i,
+                     int (*compare)(const void *, const void *));
+static int  TopKKeys(SORTKEY *keys, DATA **hits, int NHits, int TopK,
+                     BOOL IsInt);
+
+
+/************************************************************************/
+/*>BOOL IsIntegerField(int type)
+   -----------------------------
+   Input:   int   type      Field type
+   Returns: BOOL            Is this an integer field?
+
+   Tests whether a field has an integer value and should therefore be
+   sorted numerically.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL IsIntegerField(int type)
+{
+   switch(type)
+   {
+   case FIELD_LENGTH:
+   case FIELD_REFDATE:
+   case FIELD_COMPLETE:
+   case FIELD_IDENTITY:
+      return(TRUE);
+   default:
+      break;
+   }
+   return(FALSE);
+}
+
+
+/************************************************************************/
+/*>BOOL IsSortableField(int type)
+   ------------------------------
+   Input:   int   type      Field type
+   Returns: BOOL            Can we sort on this field?
+
+   Tests whether a field may be used in an ORDER BY clause. Fields which
+   write files or have no value cannot be used.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL IsSortableField(int type)
+{
+   switch(type)
+   {
+   case FIELD_PIR:
+   case FIELD_SEQUENCE:
+   case FIELD_VAR:
+   case FIELD_URLLIGHT:
+   case FIELD_URLHEAVY:
+      return(FALSE);
+   default:
+      break;
+   }
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>int GetIntegerField(DATA *d, int type, char *param)
+   ---------------------------------------------------
+   Input:   DATA  *d        A data entry
+            int   type      Field type (must be an integer field)
+            char  *param    Field parameter
+   Returns: int             The value of the field
+
+   Gets the value of an integer field for an entry.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Added IDENTITY
+*/
+int GetIntegerField(DATA *d, int type, char *param)
+{
+   char loop[160];
+   DATA *e;
+
+   switch(type)
+   {
+   case FIELD_LENGTH:
+      FillLoop(param,d,loop);
+      return(blTrueSeqLen(loop));
+   case FIELD_REFDATE:
+      return(d->refdate);
+   case FIELD_COMPLETE:
+      return(IsComplete(d) ? 1 : 0);
+   case FIELD_IDENTITY:
+      return(((e = FindEntry(param)) != NULL) ? PercentIdentity(e, d) : 0);
+   default:
+      break;
+   }
+   return(0);
+}
+
+
+/************************************************************************/
+/*>BOOL SortHits(DATA **hits, int NHits, int TopK)
+   -----------------------------------------------
+   I/O:     DATA  **hits       Array of hits
+   Input:   int   NHits        Number of hits
+            int   TopK         Number of hits actually needed (0 = all)
+   Globals: SELECTION *gOrderBy    The field on which to sort
+            BOOL      gOrderDesc   Sort in descending order
+   Returns: BOOL               Success (FALSE if no memory)
+
+   Sorts the hit list on the ORDER BY field. If TopK is specified (and
+   smaller than NHits), only the first TopK items in the array are
+   guaranteed to be correct on return.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL SortHits(DATA **hits, int NHits, int TopK)
+{
+   SORTKEY *keys;
+   char    text[LARGEBUFF];
+   int     i,
+           NKeys;
+   BOOL    IsInt,
+           ok = TRUE;
+
+   if(gOrderBy == NULL || NHits < 2)
+      return(TRUE);
+
+   sDescending = gOrderDesc;
+   IsInt       = IsIntegerField(gOrderBy->type);
+   if(TopK >= NHits)
+      TopK = 0;
+   NKeys = (TopK ? TopK : NHits);
+
+   if((keys = (SORTKEY *)malloc(NKeys * sizeof(SORTKEY)))==NULL)
+      return(FALSE);
+
+   if(TopK)
+   {
+      /* Only the first TopK are required so keep them in a heap       */
+      NKeys = TopKKeys(keys, hits, NHits, TopK, IsInt);
+      if(NKeys < 0)
+      {
+         free(keys);
+         return(FALSE);
+      }
+      qsort(keys, NKeys, sizeof(SORTKEY),
+            (IsInt ? CompareIntKeys : CompareStrKeys));
+   }
+   else
+   {
+      /* Calculate all the keys once                                    */
+      for(i=0; i<NHits; i++)
+      {
+         keys[i].data  = hits[i];
+         keys[i].index = i;
+         keys[i].skey  = NULL;
+         keys[i].ikey  = 0;
+
+         if(IsInt)
+         {
+            keys[i].ikey = GetIntegerField(hits[i], gOrderBy->type,
+                                           gOrderBy->param);
+         }
+         else
+         {
+            if(!GetFieldText(hits[i], gOrderBy->type, gOrderBy->param,
+                             text))
+               text[0] = '\0';
+            if((keys[i].skey = (char *)malloc((strlen(text)+1) *
+                                              sizeof(char)))==NULL)
+            {
+               NKeys = i;
+               ok    = FALSE;
+               break;
+            }
+            strcpy(keys[i].skey, text);
+         }
+      }
+
+      if(ok)
+      {
+         if(IsInt)
+            ok = RadixSortKeys(keys, NKeys);
+         else
+            qsort(keys, NKeys, sizeof(SORTKEY), CompareStrKeys);
+      }
+   }
+
+   /* Copy the sorted hits back and free the keys                       */
+   for(i=0; i<NKeys; i++)
+   {
+      if(ok)
+         hits[i] = keys[i].data;
+      if(keys[i].skey != NULL)
+         free(keys[i].skey);
+   }
+   free(keys);
+
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static int TopKKeys(SORTKEY *keys, DATA **hits, int NHits, int TopK,
+                       BOOL IsInt)
+   -------------------------------------------------------------------
+   Output:  SORTKEY *keys      The TopK best keys (in heap order)
+   Input:   DATA    **hits     Array of hits
+            int     NHits      Number of hits
+            int     TopK       Number of keys to keep
+            BOOL    IsInt      Integer sort key?
+   Returns: int                Number of keys stored (-1 if no memory)
+
+   Runs through the hits keeping the best TopK in a heap with the worst
+   of those at the root. A hit only displaces the root if it sorts
+   before it, so only TopK string keys are ever stored.
+
+   19.10.26 Original    By: ACRM
+*/
+static int TopKKeys(SORTKEY *keys, DATA **hits, int NHits, int TopK,
+                    BOOL IsInt)
+{
+   int     (*compare)(const void *, const void *);
+   SORTKEY key;
+   char    text[LARGEBUFF];
+   int     i,
+           NHeap = 0;
+
+   compare = (IsInt ? CompareIntKeys : CompareStrKeys);
+
+   for(i=0; i<NHits; i++)
+   {
+      key.data  = hits[i];
+      key.index = i;
+      key.ikey  = 0;
+      key.skey  = NULL;
+
+      if(IsInt)
+      {
+         key.ikey = GetIntegerField(hits[i], gOrderBy->type,
+                                    gOrderBy->param);
+      }
+      else
+      {
+         if(!GetFieldText(hits[i], gOrderBy->type, gOrderBy->param,
+                          text))
+            text[0] = '\0';
+         key.skey = text;
+      }
+
+      /* If the heap is full, skip this one unless it beats the root    */
+      if((NHeap == TopK) && ((*compare)(&key, &(keys[0])) >= 0))
+         continue;
+
+      /* Take a copy of the string key                                  */
+      if(!IsInt)
+      {
+         if((key.skey = (char *)malloc((strlen(text)+1)*sizeof(char)))
+            ==NULL)
+         {
+            for(i=0; i<NHeap; i++)
+               free(keys[i].skey);
+            return(-1);
+         }
+         strcpy(key.skey, text);
+      }
+
+      if(NHeap < TopK)
+      {
+         /* Add to the end of the heap and sift up                      */
+         int child, parent;
+
+         child = NHeap++;
+         while(child > 0)
+         {
+            parent = (child-1)/2;
+            if((*compare)(&(keys[parent]), &key) >= 0)
+               break;
+            keys[child] = keys[parent];
+            child       = parent;
+         }
+         keys[child] = key;
+      }
+      else
+      {
+         /* Replace the root and sift down                              */
+         if(keys[0].skey != NULL)
+            free(keys[0].skey);
+         keys[0] = key;
+         SiftDown(keys, NHeap, 0, compare);
+      }
+   }
+
+   return(NHeap);
+}
+
+
+/************************************************************************/
+/*>static void SiftDown(SORTKEY *heap, int NHeap, int i,
+                        int (*compare)(const void *, const void *))
+   ----------------------------------------------------------------
+   I/O:     SORTKEY *heap      The heap
+   Input:   int     NHeap      Number of items in the heap
+            int     i          Item to sift down
+            int     (*compare)()  Comparison function
+
+   Restores the heap property (worst item at the root) below item i.
+
+   19.10.26 Original    By: ACRM
+*/
+static void SiftDown(SORTKEY *heap, int NHeap, int i,
+                     int (*compare)(const void *, const void *))
+{
+   SORTKEY key;
+   int     child;
+
+   key = heap[i];
+   while((child = 2*i+1) < NHeap)
+   {
+      if((child+1 < NHeap) &&
+         ((*compare)(&(heap[child+1]), &(heap[child])) > 0))
+         child++;
+      if((*compare)(&(heap[child]), &key) <= 0)
+         break;
+      heap[i] = heap[child];
+      i       = child;
+   }
+   heap[i] = key;
+}
+
+
+/************************************************************************/
+/*>static BOOL RadixSortKeys(SORTKEY *keys, int NKeys)
+   ---------------------------------------------------
+   I/O:     SORTKEY *keys      Array of keys to sort
+   Input:   int     NKeys      Number of keys
+   Returns: BOOL               Success (FALSE if no memory)
+
+   LSD radix sort on the integer keys, a byte at a time. Each pass is
+   stable so ties remain in their original order. Passes where every key
+   has the same byte value are skipped, so small values (lengths, years)
+   only need one or two passes.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL RadixSortKeys(SORTKEY *keys, int NKeys)
+{
+   SORTKEY      *temp,
+                *from = keys,
+                *to,
+                *swap;
+   unsigned int ukey;
+   int          count[256],
+                pass,
+                shift,
+                i,
+                pos,
+                b;
+
+   if((temp = (SORTKEY *)malloc(NKeys * sizeof(SORTKEY)))==NULL)
+      return(FALSE);
+   to = temp;
+
+   for(pass=0; pass<4; pass++)
+   {
+      shift = pass * 8;
+
+      for(b=0; b<256; b++)
+         count[b] = 0;
+
+      /* Flipping the sign bit gives the correct unsigned order;
+         inverting all bits gives descending order
+      */
+      for(i=0; i<NKeys; i++)
+      {
+         ukey = (unsigned int)from[i].ikey ^ 0x80000000U;
+         if(sDescending) ukey = ~ukey;
+         count[(ukey >> shift) & 0xFF]++;
+      }
+
+      /* Skip this pass if all keys have the same byte                  */
+      for(b=0; b<256; b++)
+      {
+         if(count[b] == NKeys)
+            break;
+      }
+      if(b < 256)
+         continue;
+
+      /* Convert counts to start positions and distribute               */
+      for(b=0, pos=0; b<256; b++)
+      {
+         int n = count[b];
+         count[b] = pos;
+         pos += n;
+      }
+      for(i=0; i<NKeys; i++)
+      {
+         ukey = (unsigned int)from[i].ikey ^ 0x80000000U;
+         if(sDescending) ukey = ~ukey;
+         to[count[(ukey >> shift) & 0xFF]++] = from[i];
+      }
+
+      swap = from;
+      from = to;
+      to   = swap;
+   }
+
+   /* Make sure the result ends up in the caller's array                */
+   if(from != keys)
+      memcpy(keys, from, NKeys * sizeof(SORTKEY));
+
+   free(temp);
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static int CompareIntKeys(const void *k1, const void *k2)
+   ---------------------------------------------------------
+   Input:   const void *k1     First SORTKEY
+            const void *k2     Second SORTKEY
+   Returns: int                -1, 0, 1 as for strcmp()
+
+   qsort() comparison function for integer keys. Ties are broken on the
+   original order.
+
+   19.10.26 Original    By: ACRM
+*/
+static int CompareIntKeys(const void *k1, const void *k2)
+{
+   const SORTKEY *key1 = (const SORTKEY *)k1,
+                 *key2 = (const SORTKEY *)k2;
+
+   if(key1->ikey != key2->ikey)
+   {
+      if(sDescending)
+         return((key1->ikey > key2->ikey) ? -1 : 1);
+      return((key1->ikey < key2->ikey) ? -1 : 1);
+   }
+
+   return((key1->index < key2->index) ? -1 :
+          ((key1->index > key2->index) ? 1 : 0));
+}
+
+
+/************************************************************************/
+/*>static int CompareStrKeys(const void *k1, const void *k2)
+   ---------------------------------------------------------
+   Input:   const void *k1     First SORTKEY
+            const void *k2     Second SORTKEY
+   Returns: int                -1, 0, 1 as for strcmp()
+
+   qsort() comparison function for string keys. Ties are broken on the
+   original order.
+
+   19.10.26 Original    By: ACRM
+*/
+static int CompareStrKeys(const void *k1, const void *k2)
+{
+   const SORTKEY *key1 = (const SORTKEY *)k1,
+                 *key2 = (const SORTKEY *)k2;
+   int           cmp;
+
+   if((cmp = strcmp(key1->skey, key2->skey)) != 0)
+      return(sDescending ? -cmp : cmp);
+
+   return((key1->index < key2->index) ? -1 :
+          ((key1->index > key2->index) ? 1 : 0));
+}
+
@@ -0,0 +1,8 @@
+BOOL IsIntegerField(int type)
+;
+BOOL IsSortableField(int type)
+;
+int GetIntegerField(DATA *d, int type, char *param)
+;
+BOOL SortHits(DATA **hits, int NHits, int TopK)
+;
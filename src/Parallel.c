@@ -0,0 +1,216 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Parallel.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Simple support for running a loop over an array in several threads.
+   The array is split into one contiguous chunk per thread and the
+   caller's function is called once for each chunk with the thread
+   number so that it can keep per-thread results which are merged once
+   all threads have finished.
+
+   If a thread cannot be created, its chunk is simply run in the
+   calling thread so the results are always complete.
+
+   Each chunk adds to the hot-path counters for its thread number.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+
+*************************************************************************/
+/* Includes
+*/
+#include <unistd.h>
+#include <pthread.h>
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+typedef struct
+{
+   void (*func)(int, int, int, void *);
+   void *data;
+   int  start,
+        stop,
+        thread;
+}  PARTASK;
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static void *RunTask(void *arg);
+
+
+/************************************************************************/
+/*>int GetNThreads(int NItems, int MinPerThread)
+   ---------------------------------------------
+   Input:   int   NItems        Number of items to be processed
+            int   MinPerThread  Minimum number of items worth giving to
+                                a thread
+   Returns: int                 Number of threads to use
+   Globals: int   gNThreads     Requested number of threads (0 = one
+                                per processor)
+
+   Works out how many threads should be used to process a set of items.
+   Small jobs are not worth splitting so each thread is given at least
+   MinPerThread items.
+
+   19.10.26 Original    By: ACRM
+*/
+int GetNThreads(int NItems, int MinPerThread)
+{
+   int NThreads = gNThreads;
+
+   if(NThreads <= 0)
+   {
+#ifdef _SC_NPROCESSORS_ONLN
+      NThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#else
+      NThreads = 1;
+#endif
+   }
+
+   if(NThreads > MAXTHREADS)
+      NThreads = MAXTHREADS;
+
+   if(MinPerThread > 0 && NThreads > NItems / MinPerThread)
+      NThreads = NItems / MinPerThread;
+
+   if(NThreads < 1)
+      NThreads = 1;
+
+   return(NThreads);
+}
+
+
+/************************************************************************/
+/*>void ParallelFor(int NItems, int NThreads,
+                    void (*func)(int start, int stop, int thread,
+                                 void *data),
+                    void *data)
+   ---------------------------------------------------------------------
+   Input:   int   NItems       Number of items to be processed
+            int   NThreads     Number of threads to use (from
+                               GetNThreads())
+            void  (*func)()    Function to process items start to
+                               stop-1 in the specified thread
+            void  *data        Data passed to the function
+
+   Splits NItems into NThreads contiguous chunks and calls func() on
+   each in a separate thread. The first chunk is run in the calling
+   thread. Returns when all chunks have been processed.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Calling thread's hot-path counters restored at the end
+*/
+void ParallelFor(int NItems, int NThreads,
+                 void (*func)(int start, int stop, int thread,
+                              void *data),
+                 void *data)
+{
+   PARTASK   task[MAXTHREADS];
+   pthread_t tid[MAXTHREADS];
+   BOOL      started[MAXTHREADS];
+   int       i;
+
+   if(NThreads < 1)
+      NThreads = 1;
+   if(NThreads > MAXTHREADS)
+      NThreads = MAXTHREADS;
+
+   for(i=0; i<NThreads; i++)
+   {
+      task[i].func   = func;
+      task[i].data   = data;
+      task[i].thread = i;
+      task[i].start  = (int)(((long)NItems * i) / NThreads);
+      task[i].stop   = (int)(((long)NItems * (i+1)) / NThreads);
+      started[i]     = FALSE;
+   }
+
+   /* Start the extra threads; if one can't be started, it's run below */
+   for(i=1; i<NThreads; i++)
+   {
+      if(!pthread_create(&(tid[i]), NULL, RunTask, (void *)&(task[i])))
+         started[i] = TRUE;
+   }
+
+   /* Do the first chunk ourselves                                      */
+   RunTask((void *)&(task[0]));
+
+   for(i=1; i<NThreads; i++)
+   {
+      if(started[i])
+         pthread_join(tid[i], NULL);
+      else
+         RunTask((void *)&(task[i]));
+   }
+
+   STATTHREAD(0);
+}
+
+
+/************************************************************************/
+/*>static void *RunTask(void *arg)
+   -------------------------------
+   Input:   void  *arg     Pointer to a PARTASK
+
+   Thread start routine which calls the task's function for its chunk.
+   The hot-path counters used are those for the task's thread number.
+   The chunk is traced as a span on the thread.
+
+   19.10.26 Original    By: ACRM
+*/
+static void *RunTask(void *arg)
+{
+   PARTASK *task = (PARTASK *)arg;
+   char    detail[MAXBUFF];
+
+   STATTHREAD(task->thread);
+   if(task->stop > task->start)
+   {
+      sprintf(detail,"items %d-%d",task->start,task->stop-1);
+      TraceBegin(task->thread, "ParallelFor", detail);
+      (*(task->func))(task->start, task->stop, task->thread, task->data);
+      TraceEnd(task->thread);
+   }
+
+   return(NULL);
+}
@@ -0,0 +1,7 @@
+int GetNThreads(int NItems, int MinPerThread)
+;
+void ParallelFor(int NItems, int NThreads,
+                 void (*func)(int start, int stop, int thread,
+                              void *data),
+                 void *data)
+;
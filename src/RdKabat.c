@@ -3,11 +3,11 @@
    Program:    KabatMan
    File:       RdKabat.c
    
-   Version:    V2.26
-   Date:       04.10.19
+   Version:    V2.27
+   Date:       19.10.26
    Function:   Read data from a new format Kabat sequence file
    
-   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2019
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
    Author:     Dr. Andrew C. R. Martin
    Address:    Biomolecular Structure and Modelling Unit,
                Department of Biochemistry and Molecular Biology,
@@ -70,11 +70,13 @@
    V2.25 24.08.06 Modified GetKabatOffset() so it can return the label
                   from the offset as well as the offset from the label
    V2.26 04.10.19 Changed all bioplib calls to blXXX()
+   V2.27 19.10.26 Numbering arrays are allocated from an arena
 
 *************************************************************************/
 /* Includes
 */
 #include "RdKabat.h"
+#include "Arena.h"
 #include <stdlib.h>
 
 /************************************************************************/
@@ -89,6 +91,7 @@
 /* Prototypes
 */
 #include "RdKabat.p"
+#include "Arena.p"
 static int FixSequence(KABATENTRY *KabatEntry, BOOL *insert, BOOL
                        OldFormat);
 static int InsertSeq(KABATENTRY *KabatEntry, char *resnum, int *i,
@@ -599,8 +602,10 @@ int GetKabatOffset(char **table, char *label, int count)
 
 
 /************************************************************************/
-/*>char **BuildKabatNumbering(KABATENTRY Kabat, BOOL OldFormat)
+/*>char **BuildKabatNumbering(ARENA *arena, KABATENTRY Kabat,
+                               BOOL OldFormat)
    ------------------------------------------------------------
+   I/O:     ARENA         *arena     Arena for the numbering
    Input:   KABATENTRY    Kabat      Kabat entry structure
             BOOL          OldFormat  Flag for old format insertions
    Returns: char          *          Array of Kabat numbering
@@ -614,8 +619,11 @@ int GetKabatOffset(char **table, char *label, int count)
             Call to InsertSeq() stores offset in junk
             Added call to CheckKabatNumbering()
    21.07.94 Added OldFormat flag
+   19.10.26 The index and labels are allocated from an arena so they
+            are freed with the rest of the data
 */
-char **BuildKabatNumbering(KABATENTRY Kabat, BOOL OldFormat)
+char **BuildKabatNumbering(ARENA *arena, KABATENTRY Kabat,
+                           BOOL OldFormat)
 {
    KABATENTRY TempKabat;
    char       **KabatIndex = NULL,
@@ -631,7 +639,9 @@ char **BuildKabatNumbering(KABATENTRY Kabat, BOOL OldFormat)
               junk,
               NInsert;
    
-   if((KabatIndex = (char **)malloc(MAXKABATSEQ * sizeof(char *)))==NULL)
+   if((KabatIndex = (char **)ArenaAlloc(arena,
+                                        MAXKABATSEQ * sizeof(char *)))
+      ==NULL)
    {
       fprintf(stderr,"Error: No memory for Kabat numbering index\n");
       return(NULL);
@@ -668,7 +678,7 @@ char **BuildKabatNumbering(KABATENTRY Kabat, BOOL OldFormat)
       else
          ok = FALSE;
 
-      if((KabatIndex[i] = (char *)malloc(5*sizeof(char)))==NULL)
+      if((KabatIndex[i] = (char *)ArenaAlloc(arena, 5*sizeof(char)))==NULL)
       {
          fprintf(stderr,"Error: No memory for Kabat numbering index\n");
          free(resstart);
@@ -690,7 +700,8 @@ char **BuildKabatNumbering(KABATENTRY Kabat, BOOL OldFormat)
          
          for(j=1; j<NInsert; j++)
          {
-            if((KabatIndex[i++] = CreateKabatNumber(resnum,j))==NULL)
+            if((KabatIndex[i++] = CreateKabatNumber(arena,resnum,j))
+                ==NULL)
             {
                fprintf(stderr,"Error: No memory for Kabat numbering \
 index\n");
@@ -709,7 +720,7 @@ index\n");
    }
 
    /* Do the last residue                                               */
-   if((KabatIndex[i] = (char *)malloc(5*sizeof(char)))==NULL)
+   if((KabatIndex[i] = (char *)ArenaAlloc(arena, 5*sizeof(char)))==NULL)
    {
       fprintf(stderr,"Error: No memory for Kabat numbering index\n");
       free(resstart);
@@ -731,7 +742,8 @@ index\n");
       
       for(j=1; j<NInsert; j++)
       {
-         if((KabatIndex[i++] = CreateKabatNumber(resnum,j))==NULL)
+         if((KabatIndex[i++] = CreateKabatNumber(arena,resnum,j))
+                ==NULL)
          {
             fprintf(stderr,"Error: No memory for Kabat numbering \
 index\n");
@@ -817,27 +829,30 @@ void CheckKabatNumbering(char **KabatIndex)
 }
 
 /************************************************************************/
-/*>char *CreateKabatNumber(char *resnum, int offset)
-   -------------------------------------------------
+/*>char *CreateKabatNumber(ARENA *arena, char *resnum, int offset)
+   ---------------------------------------------------------------
+   I/O:     ARENA *arena      Arena for the new label
    Input:   char  *resnum     Residue number from which to derive new one
             int   offset      Offset from this base residue
-   Returns: char  *           Pointer to malloc'd char array containing
-                              new label
+   Returns: char  *           Pointer to char array allocated from the
+                              arena containing new label
 
    Allocates space and creates a new Kabat label based on a known label
    and an offset from that label. Thus given "24" and 2 as parameters
    the string "24B" will be returned. Also "27F",2 will generate "27H"
 
    N.B. Assumes sequential (ASCII) coding of characters
+
+   19.10.26 Allocates from an arena
 */
-char *CreateKabatNumber(char *resnum, int offset)
+char *CreateKabatNumber(ARENA *arena, char *resnum, int offset)
 {
    char insert = ('A'-1),     /* One before 'A'                         */
         *buffer;
    int  i;
 
    /* Allocate some space for our output                                */
-   if((buffer = (char *)malloc(5 * sizeof(char)))==NULL)
+   if((buffer = (char *)ArenaAlloc(arena, 5 * sizeof(char)))==NULL)
       return(NULL);
 
    /* Copy in the current label                                         */
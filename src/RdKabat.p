@@ -5,11 +5,12 @@ void ClearKabatEntry(KABATENTRY *KabatEntry)
 ;
 int GetKabatOffset(char **table, char *label, int count)
 ;
-char **BuildKabatNumbering(KABATENTRY Kabat, BOOL OldFormat)
+char **BuildKabatNumbering(ARENA *arena, KABATENTRY Kabat,
+                           BOOL OldFormat)
 ;
 void CheckKabatNumbering(char **KabatIndex)
 ;
-char *CreateKabatNumber(char *resnum, int offset)
+char *CreateKabatNumber(ARENA *arena, char *resnum, int offset)
 ;
 int ReadKabatEntry(FILE *fp, char *buffer, int bufflen, 
                    KABATENTRY *KabatEntry, BOOL *insert)
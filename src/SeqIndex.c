@@ -0,0 +1,842 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       SeqIndex.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   A 3-mer index of the sequences used to speed up LIKE tests on the
+   light and heavy chains and on the CDRs (under each of the loop
+   definitions).
+
+   For each indexed field there is a list, for every 3-mer, of the
+   entries (numbered by their position in gData) whose sequence
+   (without -'s) contains that 3-mer. A LIKE pattern can only match an
+   entry which contains every 3-mer of the pattern (3-mers including a
+   ? wildcard are ignored), so intersecting those lists gives the
+   candidate entries and only these need to be tested. Residues other
+   than A-Z all share a single code; this only adds candidates.
+
+   The index is written next to the stored data (in kabat.dat.idx)
+   whenever the stored data are rewritten. It is read the first time a
+   search can use it; if the file is missing or does not match the data
+   (checked with the number of entries and the chain hashes) the index
+   is built in memory instead. The index is allocated from gDataArena
+   so it goes when the data set is freed.
+
+   The index also holds the BK-trees used for WITHIN(n) tests on the
+   CDRs (see BKTree.c) and the locality sensitive hash of the chains
+   (see Similar.c). These are not saved but built when first used.
+
+**************************************************************************
+
+   Usage:
+   ======
+   SET INDEX OFF switches off use of the index; SET INDEX ON switches it
+   back on.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+                  FindCandidates() uses FindNeighbours() for WITHIN(n).
+                  IndexField() and FieldText() are no longer static
+                  Added GetLSHIndex() and FindSimilar()
+                  GetSeqIndex() and GetLSHIndex() count whether the
+                  index was ready in gCacheHits and gCacheMisses
+                  IsLSHTest() split out of FindSimilar()
+                  Added SeqIndexMemory() and LSHMemory()
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define KMER         3                 /* Length of indexed words       */
+#define NKMERCODE    27                /* A-Z and anything else         */
+#define NKMER        (NKMERCODE * NKMERCODE * NKMERCODE)
+#define NINDEXLOOP   6                 /* L1...H3                       */
+#define INDEXEXT     ".idx"
+#define INDEXMAGIC   "KabatMan sequence index V1.0\n"
+
+/************************************************************************/
+/* Globals
+*/
+static char *sLoopNames[NINDEXLOOP] = {"L1","L2","L3","H1","H2","H3"};
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static int KmerCode(char *text, BOOL IsPattern);
+static unsigned long DataFingerprint(int *NEntries);
+static BOOL BuildPostings(POSTINGS *post, int field, int *LastSeen,
+                          int *fill);
+static BOOL BuildSeqIndex(SEQINDEX *index);
+static BOOL ReadSeqIndex(char *filename, SEQINDEX *index);
+static int Intersect(int *cand, int NCand, int *list, int NList);
+static int CompareEntries(const void *e1, const void *e2);
+
+
+/************************************************************************/
+/*>SEQINDEX *GetSeqIndex(void)
+   ---------------------------
+   Returns: SEQINDEX *           The index. NULL if no memory
+   Globals: SEQINDEX *gSeqIndex  The index (set on first call)
+            char     gKabatFile  Stored data file name
+
+   Gets the sequence index for the current data set, reading it from
+   the index file if that matches the data or building it otherwise.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Counts in gCacheHits or gCacheMisses
+*/
+SEQINDEX *GetSeqIndex(void)
+{
+   SEQINDEX *index;
+   char     filename[MAXBUFF+8];
+   int      field;
+
+   if(gSeqIndex != NULL)
+   {
+      gCacheHits++;
+      return(gSeqIndex);
+   }
+   gCacheMisses++;
+
+   if((gDataArena == NULL) ||
+      ((index = (SEQINDEX *)ArenaAlloc(gDataArena, sizeof(SEQINDEX)))
+       ==NULL))
+      return(NULL);
+   for(field=0; field<NINDEXFIELD; field++)
+      index->tree[field] = NULL;
+   index->lsh = NULL;
+
+   sprintf(filename, "%s%s", gKabatFile, INDEXEXT);
+   if(!ReadSeqIndex(filename, index))
+   {
+      if(!BuildSeqIndex(index))
+      {
+         fprintf(stderr,"Warning: No memory for sequence index\n");
+         return(NULL);
+      }
+   }
+
+   gSeqIndex = index;
+   return(gSeqIndex);
+}
+
+
+/************************************************************************/
+/*>BOOL WriteSeqIndex(char *filename)
+   ----------------------------------
+   Input:   char   *filename    The stored data file name
+   Returns: BOOL                Success?
+
+   Writes the sequence index for the current data set to the stored
+   data file name with .idx appended. Called when the stored data have
+   been written. The chain hashes must have been set.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL WriteSeqIndex(char *filename)
+{
+   SEQINDEX *index;
+   FILE     *fp;
+   char     IndexFile[MAXBUFF+8];
+   int      field,
+            NPost;
+   BOOL     ok = TRUE;
+
+   if((index = GetSeqIndex())==NULL)
+      return(FALSE);
+
+   sprintf(IndexFile, "%s%s", filename, INDEXEXT);
+   if((fp=fopen(IndexFile,"wb"))==NULL)
+   {
+      fprintf(stderr,"Warning: Unable to open file %s\n",IndexFile);
+      return(FALSE);
+   }
+
+   fputs(INDEXMAGIC, fp);
+   if((fwrite(&(index->NEntries),    sizeof(int), 1, fp) != 1) ||
+      (fwrite(&(index->fingerprint), sizeof(unsigned long), 1, fp) != 1))
+      ok = FALSE;
+
+   for(field=0; ok && field<NINDEXFIELD; field++)
+   {
+      NPost = index->field[field].offsets[NKMER];
+      if((fwrite(index->field[field].offsets, sizeof(int), NKMER+1, fp)
+          != NKMER+1) ||
+         (fwrite(index->field[field].entries, sizeof(int), NPost, fp)
+          != (size_t)NPost))
+         ok = FALSE;
+   }
+
+   if(fclose(fp) || !ok)
+   {
+      fprintf(stderr,"Warning: Unable to write file %s\n",IndexFile);
+      remove(IndexFile);
+      return(FALSE);
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>BOOL FindCandidates(WHERE *wh, int **pCand, int *NCand)
+   -------------------------------------------------------
+   Input:   WHERE *wh        The WHERE item
+   Output:  int   **pCand    Malloc'd list of candidate entry numbers
+                             in ascending order
+            int   *NCand     Number of candidates
+   Returns: BOOL             Was the index used? If not, every entry
+                             must be tested
+   Globals: BOOL  gUseIndex  Use the index?
+            int   gLoopMode  Current loop definition
+
+   Finds the entries which may satisfy a LIKE test on an indexed field
+   by intersecting the lists for the 3-mers of the pattern. WITHIN(n)
+   tests are passed to FindNeighbours() and IDENTITY tests to
+   FindSimilar().
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Added WITHIN(n) and IDENTITY
+*/
+BOOL FindCandidates(WHERE *wh, int **pCand, int *NCand)
+{
+   SEQINDEX *index;
+   POSTINGS *post;
+   int      keys[MAXBUFF*2],
+            NKeys = 0,
+            field,
+            key,
+            shortest = 0,
+            len,
+            i;
+
+   *pCand = NULL;
+   *NCand = 0;
+
+   if(gUseIndex && (wh->comparison == COMP_WITHIN))
+      return(FindNeighbours(wh, pCand, NCand));
+   if(wh->type == FIELD_IDENTITY)
+      return(FindSimilar(wh, pCand, NCand));
+
+   if(!gUseIndex || (wh->comparison != COMP_SIM) ||
+      ((field = IndexField(wh->type, gLoopMode)) < 0))
+      return(FALSE);
+
+   for(i=0; i+KMER <= wh->matcher.length; i++)
+   {
+      if((key = KmerCode(wh->pattern+i, TRUE)) >= 0)
+         keys[NKeys++] = key;
+   }
+   if(NKeys == 0)
+      return(FALSE);
+
+   if((index = GetSeqIndex())==NULL)
+      return(FALSE);
+   post = &(index->field[field]);
+
+   /* Start from the shortest list                                      */
+   for(i=1; i<NKeys; i++)
+   {
+      if((post->offsets[keys[i]+1] - post->offsets[keys[i]]) <
+         (post->offsets[keys[shortest]+1] - post->offsets[keys[shortest]]))
+         shortest = i;
+   }
+   len = post->offsets[keys[shortest]+1] - post->offsets[keys[shortest]];
+
+   if((*pCand = (int *)malloc((len+1) * sizeof(int)))==NULL)
+      return(FALSE);
+   memcpy(*pCand, post->entries + post->offsets[keys[shortest]],
+          len * sizeof(int));
+   *NCand = len;
+
+   for(i=0; (i<NKeys) && (*NCand > 0); i++)
+   {
+      if(i != shortest)
+      {
+         *NCand = Intersect(*pCand, *NCand,
+                            post->entries + post->offsets[keys[i]],
+                            post->offsets[keys[i]+1] -
+                            post->offsets[keys[i]]);
+      }
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>LSHINDEX *GetLSHIndex(void)
+   ---------------------------
+   Returns: LSHINDEX *          The LSH of all the data. NULL if no memory
+   Globals: DATA     *gData     The data
+
+   Gets the locality sensitive hash for the current data set, building
+   it if this is the first time it has been needed.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Counts in gCacheHits or gCacheMisses
+*/
+LSHINDEX *GetLSHIndex(void)
+{
+   SEQINDEX *index;
+   DATA     *d,
+            **data;
+   int      NData = 0;
+
+   if((index = GetSeqIndex())==NULL)
+      return(NULL);
+   if(index->lsh != NULL)
+   {
+      gCacheHits++;
+      return(index->lsh);
+   }
+   gCacheMisses++;
+
+   for(d=gData; d!=NULL; NEXT(d))
+      NData++;
+   if((data = (DATA **)ArenaAlloc(gDataArena,
+                                  (NData+1) * sizeof(DATA *)))==NULL)
+      return(NULL);
+   for(d=gData, NData=0; d!=NULL; NEXT(d))
+      data[NData++] = d;
+
+   if((index->lsh = BuildLSH(gDataArena, data, NData))==NULL)
+      fprintf(stderr,"Warning: No memory for LSH\n");
+
+   return(index->lsh);
+}
+
+
+/************************************************************************/
+/*>BOOL FindSimilar(WHERE *wh, int **pCand, int *NCand)
+   ----------------------------------------------------
+   Input:   WHERE *wh          The WHERE item (an IDENTITY test with
+                               wh->entry set)
+   Output:  int   **pCand      Malloc'd list of candidate entry numbers
+                               in ascending order
+            int   *NCand       Number of candidates
+   Returns: BOOL               Was the LSH used? If not, every entry
+                               must be tested
+   Globals: int   gLSHMinData  Entries from which the LSH is used
+
+   For a test that the identity with an entry is at least a value of
+   LSHMINIDENTITY or more, and with at least gLSHMinData entries, gets
+   the candidates from the LSH. These may miss a few of the entries.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL FindSimilar(WHERE *wh, int **pCand, int *NCand)
+{
+   LSHINDEX *lsh;
+   int      entry;
+
+   if(!IsLSHTest(wh))
+      return(FALSE);
+
+   if(((lsh = GetLSHIndex())==NULL) || (lsh->NData < gLSHMinData))
+      return(FALSE);
+
+   for(entry=0; entry<lsh->NData; entry++)
+   {
+      if(lsh->data[entry] == wh->entry)
+         break;
+   }
+   if((entry >= lsh->NData) ||
+      ((*pCand = (int *)malloc((lsh->NData+1) * sizeof(int)))==NULL))
+      return(FALSE);
+
+   *NCand = LSHCandidates(lsh, entry, *pCand);
+   (*pCand)[(*NCand)++] = entry;
+   qsort(*pCand, *NCand, sizeof(int), CompareEntries);
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>BOOL IsLSHTest(WHERE *wh)
+   -------------------------
+   Input:   WHERE *wh          An IDENTITY WHERE item
+   Returns: BOOL               May the LSH be used?
+   Globals: int   gLSHMinData  Entries from which the LSH is used
+
+   Tests whether an identity test is for a value of at least
+   LSHMINIDENTITY so that the LSH may be used if there are enough
+   entries.
+
+   19.10.26 Original (from FindSimilar())   By: ACRM
+*/
+BOOL IsLSHTest(WHERE *wh)
+{
+   int value;
+
+   if(!gLSHMinData ||
+      (sscanf(wh->data, "%d", &value) != 1) ||
+      !(((wh->comparison == COMP_GE) && (value >= LSHMINIDENTITY)) ||
+        ((wh->comparison == COMP_GT) && (value+1 >= LSHMINIDENTITY)) ||
+        ((wh->comparison == COMP_EQ) && (value >= LSHMINIDENTITY))))
+      return(FALSE);
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>int IndexField(int type, int LoopMode)
+   --------------------------------------
+   Input:   int    type       FIELD_xxxx type
+            int    LoopMode   LOOP_xxxx definition
+   Returns: int               Index field number (-1 if not indexed)
+
+   Gives the index field used for a WHERE field type. Fields 0 and 1 are
+   the light and heavy chains; these are followed by L1...H3 for each
+   loop definition in turn.
+
+   19.10.26 Original    By: ACRM
+*/
+int IndexField(int type, int LoopMode)
+{
+   if(type == FIELD_LIGHT)
+      return(0);
+   if(type == FIELD_HEAVY)
+      return(1);
+   if((type >= FIELD_L1) && (type <= FIELD_H3) &&
+      (LoopMode >= LOOP_KABAT) && (LoopMode <= LOOP_CONTACT))
+      return(2 + (LoopMode - LOOP_KABAT) * NINDEXLOOP + (type - FIELD_L1));
+   return(-1);
+}
+
+
+/************************************************************************/
+/*>int FieldText(DATA *d, int field, char *text)
+   ---------------------------------------------
+   Input:   DATA   *d         Entry
+            int    field      Index field number
+   Output:  char   *text      Sequence for the field in upper case with
+                              -'s removed
+   Returns: int               Length of text
+
+   Gets the sequence which is indexed for an entry. This is the same
+   sequence as is tested by DoSeqTest() for a LIKE.
+
+   19.10.26 Original    By: ACRM
+*/
+int FieldText(DATA *d, int field, char *text)
+{
+   char loop[LARGEBUFF],
+        *seq;
+   int  i,
+        len = 0;
+
+   if(field == 0)
+   {
+      seq = d->light;
+   }
+   else if(field == 1)
+   {
+      seq = d->heavy;
+   }
+   else
+   {
+      FillLoopMode(sLoopNames[(field-2) % NINDEXLOOP], d, loop,
+                   LOOP_KABAT + (field-2) / NINDEXLOOP);
+      seq = loop;
+   }
+
+   for(i=0; seq[i]; i++)
+   {
+      if(seq[i] != '-')
+         text[len++] = (islower(seq[i]) ? toupper(seq[i]) : seq[i]);
+   }
+   text[len] = '\0';
+
+   return(len);
+}
+
+
+/************************************************************************/
+/*>static int KmerCode(char *text, BOOL IsPattern)
+   -----------------------------------------------
+   Input:   char   *text       Start of a 3-mer
+            BOOL   IsPattern   Is this from a LIKE pattern?
+   Returns: int                Its code (-1 if it is from a pattern and
+                               contains a ? wildcard)
+
+   Converts a 3-mer to its number in the index. A ? in the data is
+   treated like any other character which is not A-Z.
+
+   19.10.26 Original    By: ACRM
+*/
+static int KmerCode(char *text, BOOL IsPattern)
+{
+   int i,
+       code = 0;
+
+   for(i=0; i<KMER; i++)
+   {
+      if(IsPattern && (text[i] == '?'))
+         return(-1);
+      code = code * NKMERCODE +
+             (((text[i] >= 'A') && (text[i] <= 'Z')) ?
+              text[i] - 'A' : NKMERCODE - 1);
+   }
+
+   return(code);
+}
+
+
+/************************************************************************/
+/*>static unsigned long DataFingerprint(int *NEntries)
+   ---------------------------------------------------
+   Output:  int    *NEntries  Number of entries in gData
+   Returns: unsigned long     Fingerprint of the data
+   Globals: DATA   *gData     The data
+
+   Combines the chain hashes of all entries so that an index file can
+   be checked against the data.
+
+   19.10.26 Original    By: ACRM
+*/
+static unsigned long DataFingerprint(int *NEntries)
+{
+   DATA          *d;
+   unsigned long fingerprint = HASH_INIT;
+
+   *NEntries = 0;
+   for(d=gData; d!=NULL; NEXT(d))
+   {
+      fingerprint = HashBytes((char *)&(d->LightHash),
+                              sizeof(unsigned long), fingerprint);
+      fingerprint = HashBytes((char *)&(d->HeavyHash),
+                              sizeof(unsigned long), fingerprint);
+      (*NEntries)++;
+   }
+
+   return(fingerprint);
+}
+
+
+/************************************************************************/
+/*>static BOOL BuildPostings(POSTINGS *post, int field, int *LastSeen,
+                             int *fill)
+   ------------------------------------------------------------------
+   Output:  POSTINGS *post      Lists for the field
+   Input:   int      field      Index field number
+            int      *LastSeen  Work array of NKMER ints
+            int      *fill      Work array of NKMER ints
+   Returns: BOOL                Success (FALSE if no memory)
+
+   Builds the lists for one field. The entries are counted for each
+   3-mer on a first pass and stored on a second pass. LastSeen stops an
+   entry being listed twice for a 3-mer.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL BuildPostings(POSTINGS *post, int field, int *LastSeen,
+                          int *fill)
+{
+   DATA *d;
+   char text[LARGEBUFF];
+   int  entry,
+        len,
+        key,
+        pass,
+        i;
+
+   if((post->offsets = (int *)ArenaAlloc(gDataArena,
+                                         (NKMER+1) * sizeof(int)))==NULL)
+      return(FALSE);
+   for(i=0; i<=NKMER; i++)
+      post->offsets[i] = 0;
+
+   for(pass=0; pass<2; pass++)
+   {
+      for(i=0; i<NKMER; i++)
+         LastSeen[i] = (-1);
+
+      for(d=gData, entry=0; d!=NULL; NEXT(d), entry++)
+      {
+         len = FieldText(d, field, text);
+         for(i=0; i+KMER <= len; i++)
+         {
+            key = KmerCode(text+i, FALSE);
+            if(LastSeen[key] != entry)
+            {
+               LastSeen[key] = entry;
+               if(pass == 0)
+                  post->offsets[key+1]++;
+               else
+                  post->entries[fill[key]++] = entry;
+            }
+         }
+      }
+
+      if(pass == 0)
+      {
+         for(i=0; i<NKMER; i++)
+         {
+            post->offsets[i+1] += post->offsets[i];
+            fill[i] = post->offsets[i];
+         }
+         if((post->entries =
+             (int *)ArenaAlloc(gDataArena,
+                               (post->offsets[NKMER]+1) * sizeof(int)))
+            ==NULL)
+            return(FALSE);
+      }
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL BuildSeqIndex(SEQINDEX *index)
+   ------------------------------------------
+   Output:  SEQINDEX *index     The index
+   Returns: BOOL                Success (FALSE if no memory)
+
+   Builds the index for the current data set in memory.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL BuildSeqIndex(SEQINDEX *index)
+{
+   int  *LastSeen,
+        *fill,
+        field;
+   BOOL ok = TRUE;
+
+   index->fingerprint = DataFingerprint(&(index->NEntries));
+
+   if((LastSeen = (int *)malloc(2 * NKMER * sizeof(int)))==NULL)
+      return(FALSE);
+   fill = LastSeen + NKMER;
+
+   for(field=0; ok && field<NINDEXFIELD; field++)
+   {
+      ok = BuildPostings(&(index->field[field]), field, LastSeen, fill);
+   }
+
+   free(LastSeen);
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static BOOL ReadSeqIndex(char *filename, SEQINDEX *index)
+   ---------------------------------------------------------
+   Input:   char     *filename   Index file name
+   Output:  SEQINDEX *index      The index
+   Returns: BOOL                 Success (FALSE if the file is missing,
+                                 unreadable or does not match the data)
+
+   Reads an index file written by WriteSeqIndex() if it matches the
+   current data.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL ReadSeqIndex(char *filename, SEQINDEX *index)
+{
+   FILE          *fp;
+   char          magic[MAXBUFF];
+   int           field,
+                 NEntries,
+                 NPost;
+   unsigned long fingerprint;
+   POSTINGS      *post;
+
+   if((fp=fopen(filename,"rb"))==NULL)
+      return(FALSE);
+
+   index->fingerprint = DataFingerprint(&(index->NEntries));
+
+   if((fgets(magic, MAXBUFF, fp)==NULL) || strcmp(magic, INDEXMAGIC) ||
+      (fread(&NEntries, sizeof(int), 1, fp) != 1) ||
+      (NEntries != index->NEntries) ||
+      (fread(&fingerprint, sizeof(unsigned long), 1, fp) != 1) ||
+      (fingerprint != index->fingerprint))
+   {
+      fclose(fp);
+      return(FALSE);
+   }
+
+   for(field=0; field<NINDEXFIELD; field++)
+   {
+      post = &(index->field[field]);
+      if(((post->offsets =
+           (int *)ArenaAlloc(gDataArena, (NKMER+1) * sizeof(int)))
+          ==NULL) ||
+         (fread(post->offsets, sizeof(int), NKMER+1, fp) != NKMER+1) ||
+         ((NPost = post->offsets[NKMER]) < 0) ||
+         ((post->entries =
+           (int *)ArenaAlloc(gDataArena, (NPost+1) * sizeof(int)))
+          ==NULL) ||
+         (fread(post->entries, sizeof(int), NPost, fp) != (size_t)NPost))
+      {
+         fclose(fp);
+         return(FALSE);
+      }
+   }
+
+   fclose(fp);
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static int Intersect(int *cand, int NCand, int *list, int NList)
+   ----------------------------------------------------------------
+   I/O:     int    *cand      Candidate entries in ascending order
+   Input:   int    NCand      Number of candidates
+            int    *list      A 3-mer list in ascending order
+            int    NList      Length of list
+   Returns: int               Number of candidates left
+
+   Removes the candidates which are not in the list. Each candidate is
+   found with a binary search of the rest of the list, so the cost
+   depends mainly on the (normally short) candidate list.
+
+   19.10.26 Original    By: ACRM
+*/
+static int Intersect(int *cand, int NCand, int *list, int NList)
+{
+   int i,
+       n  = 0,
+       lo = 0,
+       hi,
+       mid;
+
+   for(i=0; i<NCand; i++)
+   {
+      /* Find the first list item >= this candidate                     */
+      hi = NList;
+      while(lo < hi)
+      {
+         mid = (lo + hi) / 2;
+         if(list[mid] < cand[i])
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+      if(lo >= NList)
+         break;
+      if(list[lo] == cand[i])
+         cand[n++] = cand[i];
+   }
+
+   return(n);
+}
+
+
+/************************************************************************/
+/*>static int CompareEntries(const void *e1, const void *e2)
+   ---------------------------------------------------------
+   qsort() comparison for entry numbers.
+
+   19.10.26 Original    By: ACRM
+*/
+static int CompareEntries(const void *e1, const void *e2)
+{
+   return(*(int *)e1 - *(int *)e2);
+}
+
+
+/************************************************************************/
+/*>void SeqIndexMemory(MEMUSE *use)
+   --------------------------------
+   Output:  MEMUSE    *use        Memory used by the sequence index
+   Globals: SEQINDEX  *gSeqIndex  The index (if read or built)
+
+   For SHOW MEMORY. The offsets of the lists are the same size whatever
+   the number of entries.
+
+   19.10.26 Original    By: ACRM
+*/
+void SeqIndexMemory(MEMUSE *use)
+{
+   size_t size;
+   int    field;
+
+   if(gSeqIndex == NULL)
+      return;
+
+   use->allocated = use->fixed = ArenaRound(sizeof(SEQINDEX));
+   use->used      = sizeof(SEQINDEX);
+   for(field=0; field<NINDEXFIELD; field++)
+   {
+      size            = (NKMER+1) * sizeof(int);
+      use->allocated += ArenaRound(size);
+      use->fixed     += ArenaRound(size);
+      use->used      += size;
+
+      size            = (gSeqIndex->field[field].offsets[NKMER]+1) *
+                        sizeof(int);
+      use->allocated += ArenaRound(size);
+      use->used      += size;
+   }
+}
+
+
+/************************************************************************/
+/*>void LSHMemory(MEMUSE *use)
+   ---------------------------
+   Output:  MEMUSE    *use        Memory used by the similarity hash
+   Globals: SEQINDEX  *gSeqIndex  The index (if read or built)
+
+   For SHOW MEMORY. The keys and bands have a slot for every entry
+   whether or not it has the chain.
+
+   19.10.26 Original    By: ACRM
+*/
+void LSHMemory(MEMUSE *use)
+{
+   LSHINDEX *lsh;
+   size_t   n;
+
+   if((gSeqIndex == NULL) || ((lsh = gSeqIndex->lsh) == NULL))
+      return;
+
+   n = lsh->NData + 1;
+   use->allocated = ArenaRound(sizeof(LSHINDEX)) +
+                    ArenaRound(n * sizeof(DATA *)) +
+                    4 * ArenaRound(n * sizeof(int)) +
+                    2 * NLSHBANDS * (ArenaRound(n * sizeof(unsigned long)) +
+                                     ArenaRound(n * sizeof(LSHKEY)));
+   use->used      = sizeof(LSHINDEX) + n * sizeof(DATA *) +
+                    (lsh->NNoLight + lsh->NNoHeavy + lsh->NNoChain +
+                     lsh->NData) * sizeof(int) +
+                    NLSHBANDS * (2 * lsh->NData * sizeof(unsigned long) +
+                                 (lsh->NBand[0] + lsh->NBand[1]) *
+                                 sizeof(LSHKEY));
+}
@@ -0,0 +1,20 @@
+SEQINDEX *GetSeqIndex(void)
+;
+BOOL WriteSeqIndex(char *filename)
+;
+BOOL FindCandidates(WHERE *wh, int **pCand, int *NCand)
+;
+LSHINDEX *GetLSHIndex(void)
+;
+BOOL FindSimilar(WHERE *wh, int **pCand, int *NCand)
+;
+BOOL IsLSHTest(WHERE *wh)
+;
+int IndexField(int type, int LoopMode)
+;
+int FieldText(DATA *d, int field, char *text)
+;
+void SeqIndexMemory(MEMUSE *use)
+;
+void LSHMemory(MEMUSE *use)
+;
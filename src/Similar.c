@@ -0,0 +1,596 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Similar.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Sequence identity between antibodies (used by SET VARIABILITY and
+   the IDENTITY field) and a locality sensitive hash which finds the
+   pairs of antibodies likely to be similar without comparing every
+   pair.
+
+   For the hash, each chain (without -'s) is treated as its set of
+   overlapping 3-mers and given a MinHash signature: for each of
+   NLSHBANDS x LSHROWS hash functions, the smallest hash of any of its
+   3-mers. Two chains share a signature value with a probability equal
+   to the Jaccard similarity of their 3-mer sets. The signature is cut
+   into NLSHBANDS bands of LSHROWS values and each band is hashed to a
+   key; chains sharing the key for any band are candidates. With
+   LSHROWS values to a band, chains sharing a high proportion of their
+   3-mers almost always share a band while the chance for dissimilar
+   chains falls off as the LSHROWS power of the similarity.
+
+   An antibody's identity with another is at least the cutoff only if
+   one of its chains is at least that identical, so it is enough to
+   take as candidates the antibodies sharing a band for either chain.
+   TooSimilar() does not penalise a missing chain, so antibodies having
+   no chain in common with each other are always candidates too.
+
+   The candidates are always checked with the exact SeqIdentity(), so
+   the hash can only miss pairs, never add them. lshbench reports how
+   many it misses.
+
+**************************************************************************
+
+   Usage:
+   ======
+   BuildLSH() indexes an array of entries; LSHCandidates() then gives
+   the candidates for any one of them.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original. TooSimilar() moved from ExecSearch.c
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define LSHKMER  3                     /* Length of hashed words        */
+#define LSHROWS  2                     /* Signature values in a band    */
+#define NLSHHASH (NLSHBANDS * LSHROWS)
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static void MinHash(char *seq, unsigned long *signature);
+static unsigned long Mix(unsigned long x);
+static int AddCandidates(LSHINDEX *lsh, int *list, int NList, int i,
+                         int *cand, int NCand);
+static int CompareLSHKeys(const void *k1, const void *k2);
+
+
+/************************************************************************/
+/*>REAL SeqIdentity(DATA *d, DATA *e, REAL Cutoff)
+   -----------------------------------------------
+   Input:    DATA     *d       Pointer to a data entry
+             DATA     *e       Pointer to a data entry
+             REAL     Cutoff   Percentage identity cutoff
+   Returns:  REAL              Percentage identity (Cutoff-1 if it is
+                               below Cutoff)
+
+   Calculates a percentage identity between two antibodies. A missing
+   chain in one of the sequences is not penalised. Each mismatch
+   scores a penalty of 100/MeanLength % and deletions in one sequence
+   wrt the other score a double penalty.
+
+   Returns immediately the identity falls below the specified Cutoff,
+   so give a large negative Cutoff (NOCUTOFF) to get the identity
+   whatever it is.
+
+   25.01.95 Original    By: ACRM
+   26.01.95 Modified from SimilarityScore()
+   19.10.26 Uses the chain lengths stored when the data were read
+   19.10.26 Returns the identity rather than comparing it with Cutoff
+            (which is done by TooSimilar()). Moved from ExecSearch.c
+*/
+REAL SeqIdentity(DATA *d, DATA *e, REAL Cutoff)
+{
+   int  i,
+        Length1,
+        Length2;
+   REAL MeanLength,
+        LScore = (REAL)100.0,
+        HScore = (REAL)100.0,
+        Penalty,
+        TwoPenalty,
+        TwoCutoff,
+        TwoCutMinus100;
+   BOOL LDone = FALSE,
+        HDone = FALSE;
+
+   TwoCutoff      = (REAL)2.0*Cutoff;
+   TwoCutMinus100 = TwoCutoff - (REAL)100.0;
+
+   LDone = (d->light[0] && e->light[0]);
+   HDone = (d->heavy[0] && e->heavy[0]);
+
+   /* Compare the light chains                                          */
+   if(LDone)
+   {
+      /* Calculate the mean sequence length and mismatch penalty        */
+      Length1    = d->LightLen;
+      Length2    = e->LightLen;
+      MeanLength = (REAL)(Length1+Length2)/(REAL)2.0;
+      Penalty    = (REAL)100.0/MeanLength;
+      TwoPenalty = (REAL)2.0 * Penalty;
+
+      /* For each residue in the light chain, decrement the score if there
+         is a mismatch
+      */
+      for(i=0; i<strlen(d->light); i++)
+      {
+         if(d->light[i] != e->light[i])   /* A mismatch                 */
+         {
+            /* If one was a deletion wrt to the other, double penalty   */
+            if((d->light[i] == '-') || (e->light[i] == '-'))
+               LScore -= TwoPenalty;
+            else
+               LScore -= Penalty;
+
+            /* This is an optimisation of
+               ((LScore+100.0)/2.0 < Cutoff)
+            */
+            if(LScore < TwoCutMinus100)
+               return(Cutoff - (REAL)1.0);
+         }
+      }
+   }
+
+   /* Compare the heavy chains                                          */
+   if(HDone)
+   {
+      /* Calculate the mean sequence length and mismatch penalty        */
+      Length1    = d->HeavyLen;
+      Length2    = e->HeavyLen;
+      MeanLength = (REAL)(Length1+Length2)/(REAL)2.0;
+      Penalty    = (REAL)100.0/MeanLength;
+      TwoPenalty = (REAL)2.0 * Penalty;
+
+      /* For each residue in the heavy chain, decrement the score if there
+         is a mismatch
+      */
+      for(i=0; i<strlen(d->heavy); i++)
+      {
+         if(d->heavy[i] != e->heavy[i])   /* A mismatch                 */
+         {
+            /* If one was a deletion wrt to the other, double penalty   */
+            if((d->heavy[i] == '-') || (e->heavy[i] == '-'))
+               HScore -= TwoPenalty;
+            else
+               HScore -= Penalty;
+
+            /* This is an optimisation of
+               ((HScore+LScore)/2.0 < Cutoff)
+            */
+            if((HScore+LScore) < TwoCutoff)
+               return(Cutoff - (REAL)1.0);
+         }
+      }
+   }
+
+   /* Calculate the score based on which comparisons were performed     */
+   if(LDone && HDone)
+      return((LScore + HScore) / (REAL)2.0);
+   else if(LDone)
+      return(LScore);
+   else if(HDone)
+      return(HScore);
+
+   return((REAL)100.0);
+}
+
+
+/************************************************************************/
+/*>BOOL TooSimilar(DATA *d, DATA *e, REAL Cutoff)
+   ----------------------------------------------
+   Input:    DATA     *d       Pointer to a data entry
+             DATA     *e       Pointer to a data entry
+             REAL     Cutoff   Percentage identity cutoff
+   Returns:  BOOL              True of identity > Cutoff
+
+   Tests whether two antibodies are at least Cutoff % identical.
+
+   25.01.95 Original    By: ACRM
+   26.01.95 Modified from SimilarityScore()
+   19.10.26 Uses the chain lengths stored when the data were read
+   19.10.26 Score now calculated by SeqIdentity(). Moved from
+            ExecSearch.c
+*/
+BOOL TooSimilar(DATA *d, DATA *e, REAL Cutoff)
+{
+   return(SeqIdentity(d, e, Cutoff) >= Cutoff);
+}
+
+
+/************************************************************************/
+/*>int PercentIdentity(DATA *d, DATA *e)
+   -------------------------------------
+   Input:    DATA     *d       Pointer to a data entry
+             DATA     *e       Pointer to a data entry
+   Returns:  int               Percentage identity
+
+   Gives the identity of two antibodies as a whole number for the
+   IDENTITY field. Since deletions score a double penalty the score can
+   be negative; this is given as 0. Antibodies which have no chain in
+   common also score 0 (SeqIdentity() gives them 100 so that TooSimilar()
+   treats them as redundant).
+
+   19.10.26 Original    By: ACRM
+*/
+int PercentIdentity(DATA *d, DATA *e)
+{
+   REAL identity;
+
+   if(!(d->light[0] && e->light[0]) && !(d->heavy[0] && e->heavy[0]))
+      return(0);
+
+   identity = SeqIdentity(d, e, NOCUTOFF);
+   return((identity > (REAL)0.0) ? (int)identity : 0);
+}
+
+
+/************************************************************************/
+/*>LSHINDEX *BuildLSH(ARENA *arena, DATA **data, int NData)
+   --------------------------------------------------------
+   Input:   ARENA    *arena     Arena from which to allocate the index
+            DATA     **data     Array of entries
+            int      NData      Number of entries
+   Returns: LSHINDEX *          The index. NULL if no memory
+
+   Builds the locality sensitive hash for an array of entries. Entries
+   are referred to by their position in the array.
+
+   19.10.26 Original    By: ACRM
+*/
+LSHINDEX *BuildLSH(ARENA *arena, DATA **data, int NData)
+{
+   LSHINDEX      *lsh;
+   unsigned long signature[NLSHHASH],
+                 key;
+   char          *seq;
+   int           i,
+                 chain,
+                 band,
+                 row;
+
+   if((lsh = (LSHINDEX *)ArenaAlloc(arena, sizeof(LSHINDEX)))==NULL)
+      return(NULL);
+
+   lsh->data     = data;
+   lsh->NData    = NData;
+   lsh->NBand[0] = lsh->NBand[1] = 0;
+   lsh->NNoLight = lsh->NNoHeavy = lsh->NNoChain = 0;
+   lsh->stamp    = 0;
+
+   if(((lsh->NoLight = (int *)ArenaAlloc(arena,
+                                         (NData+1) * sizeof(int)))==NULL) ||
+      ((lsh->NoHeavy = (int *)ArenaAlloc(arena,
+                                         (NData+1) * sizeof(int)))==NULL) ||
+      ((lsh->NoChain = (int *)ArenaAlloc(arena,
+                                         (NData+1) * sizeof(int)))==NULL) ||
+      ((lsh->seen    = (int *)ArenaAlloc(arena,
+                                         (NData+1) * sizeof(int)))==NULL))
+      return(NULL);
+
+   for(chain=0; chain<2; chain++)
+   {
+      for(band=0; band<NLSHBANDS; band++)
+      {
+         if(((lsh->keys[chain][band] =
+              (unsigned long *)ArenaAlloc(arena, (NData+1) *
+                                          sizeof(unsigned long)))==NULL) ||
+            ((lsh->bands[chain][band] =
+              (LSHKEY *)ArenaAlloc(arena, (NData+1) * sizeof(LSHKEY)))
+             ==NULL))
+            return(NULL);
+      }
+   }
+
+   for(i=0; i<NData; i++)
+   {
+      lsh->seen[i] = 0;
+
+      if(!data[i]->light[0])
+         lsh->NoLight[lsh->NNoLight++] = i;
+      if(!data[i]->heavy[0])
+         lsh->NoHeavy[lsh->NNoHeavy++] = i;
+      if(!data[i]->light[0] && !data[i]->heavy[0])
+         lsh->NoChain[lsh->NNoChain++] = i;
+
+      for(chain=0; chain<2; chain++)
+      {
+         seq = (chain ? data[i]->UngappedHeavy : data[i]->UngappedLight);
+         if(strlen(seq) < LSHKMER)
+         {
+            for(band=0; band<NLSHBANDS; band++)
+               lsh->keys[chain][band][i] = 0;
+            continue;
+         }
+
+         MinHash(seq, signature);
+         for(band=0; band<NLSHBANDS; band++)
+         {
+            /* Keys are never 0 so that 0 can mean `no chain'            */
+            key = 1;
+            for(row=0; row<LSHROWS; row++)
+               key = Mix(key ^ signature[band*LSHROWS + row]);
+            key |= 1;
+
+            lsh->keys[chain][band][i] = key;
+            lsh->bands[chain][band][lsh->NBand[chain]].key   = key;
+            lsh->bands[chain][band][lsh->NBand[chain]].entry = i;
+         }
+         lsh->NBand[chain]++;
+      }
+   }
+
+   for(chain=0; chain<2; chain++)
+   {
+      for(band=0; band<NLSHBANDS; band++)
+      {
+         qsort(lsh->bands[chain][band], lsh->NBand[chain], sizeof(LSHKEY),
+               CompareLSHKeys);
+      }
+   }
+
+   return(lsh);
+}
+
+
+/************************************************************************/
+/*>int LSHCandidates(LSHINDEX *lsh, int i, int *cand)
+   --------------------------------------------------
+   I/O:     LSHINDEX *lsh      The index
+   Input:   int      i         Entry number (position in lsh->data)
+   Output:  int      *cand     Candidate entry numbers (not in order)
+                               Must have space for lsh->NData entries
+   Returns: int                Number of candidates
+
+   Finds the entries which share a band with entry i for either chain,
+   or which have no chain in common with it. Entry i itself is not
+   included. Not thread-safe since lsh->seen is used to mark the
+   candidates found.
+
+   19.10.26 Original    By: ACRM
+*/
+int LSHCandidates(LSHINDEX *lsh, int i, int *cand)
+{
+   LSHKEY        *list;
+   unsigned long key;
+   int           NCand = 0,
+                 chain,
+                 band,
+                 lo,
+                 hi,
+                 mid,
+                 j;
+   BOOL          HasLight = (lsh->data[i]->light[0] != '\0'),
+                 HasHeavy = (lsh->data[i]->heavy[0] != '\0');
+
+   /* Start a new set of marks                                          */
+   if(++(lsh->stamp) <= 0)
+   {
+      for(j=0; j<lsh->NData; j++)
+         lsh->seen[j] = 0;
+      lsh->stamp = 1;
+   }
+   lsh->seen[i] = lsh->stamp;
+
+   /* Entries with no chain in common                                   */
+   if(!HasLight && !HasHeavy)
+   {
+      for(j=0; j<lsh->NData; j++)
+      {
+         if(j != i)
+            cand[NCand++] = j;
+      }
+      return(NCand);
+   }
+   else if(!HasHeavy)
+   {
+      NCand = AddCandidates(lsh, lsh->NoLight, lsh->NNoLight, i, cand,
+                            NCand);
+   }
+   else if(!HasLight)
+   {
+      NCand = AddCandidates(lsh, lsh->NoHeavy, lsh->NNoHeavy, i, cand,
+                            NCand);
+   }
+   else
+   {
+      NCand = AddCandidates(lsh, lsh->NoChain, lsh->NNoChain, i, cand,
+                            NCand);
+   }
+
+   /* Entries sharing a band                                            */
+   for(chain=0; chain<2; chain++)
+   {
+      for(band=0; band<NLSHBANDS; band++)
+      {
+         if((key = lsh->keys[chain][band][i]) == 0)
+            break;
+
+         list = lsh->bands[chain][band];
+         lo   = 0;
+         hi   = lsh->NBand[chain];
+         while(lo < hi)
+         {
+            mid = (lo + hi) / 2;
+            if(list[mid].key < key)
+               lo = mid + 1;
+            else
+               hi = mid;
+         }
+
+         for(; (lo < lsh->NBand[chain]) && (list[lo].key == key); lo++)
+         {
+            j = list[lo].entry;
+            if(lsh->seen[j] != lsh->stamp)
+            {
+               lsh->seen[j]   = lsh->stamp;
+               cand[NCand++] = j;
+            }
+         }
+      }
+   }
+
+   return(NCand);
+}
+
+
+/************************************************************************/
+/*>static int AddCandidates(LSHINDEX *lsh, int *list, int NList, int i,
+                            int *cand, int NCand)
+   --------------------------------------------------------------------
+   I/O:     LSHINDEX *lsh      The index
+   Input:   int      *list     Entry numbers
+            int      NList     Number in list
+            int      i         Entry for which candidates are wanted
+   I/O:     int      *cand     Candidates
+   Input:   int      NCand     Number of candidates so far
+   Returns: int                New number of candidates
+
+   Adds the entries in a list to the candidates for entry i.
+
+   19.10.26 Original    By: ACRM
+*/
+static int AddCandidates(LSHINDEX *lsh, int *list, int NList, int i,
+                         int *cand, int NCand)
+{
+   int k;
+
+   for(k=0; k<NList; k++)
+   {
+      if(lsh->seen[list[k]] != lsh->stamp)
+      {
+         lsh->seen[list[k]] = lsh->stamp;
+         cand[NCand++]      = list[k];
+      }
+   }
+
+   return(NCand);
+}
+
+
+/************************************************************************/
+/*>static void MinHash(char *seq, unsigned long *signature)
+   --------------------------------------------------------
+   Input:   char          *seq        Sequence without -'s (at least
+                                      LSHKMER long)
+   Output:  unsigned long *signature  NLSHHASH signature values
+
+   Calculates the MinHash signature of a sequence. Each 3-mer is coded
+   as 5 bits per residue and hashed once with Mix(); the hash functions
+   are then Mix() of this xor'd with a different constant for each.
+   Residues are already in upper case.
+
+   19.10.26 Original    By: ACRM
+*/
+static void MinHash(char *seq, unsigned long *signature)
+{
+   static unsigned long sSeeds[NLSHHASH];
+   static BOOL          sInit = FALSE;
+   unsigned long        code,
+                        base,
+                        value;
+   int                  i,
+                        k,
+                        h;
+
+   /* The seeds are always the same, so a race here is harmless         */
+   if(!sInit)
+   {
+      for(h=0; h<NLSHHASH; h++)
+         sSeeds[h] = Mix((unsigned long)(h+1));
+      sInit = TRUE;
+   }
+
+   for(h=0; h<NLSHHASH; h++)
+      signature[h] = ~(unsigned long)0;
+
+   for(i=0; seq[i+LSHKMER-1]; i++)
+   {
+      for(k=0, code=0; k<LSHKMER; k++)
+         code = (code << 5) | (unsigned long)(seq[i+k] & 0x1F);
+      base = Mix(code + 1);
+      for(h=0; h<NLSHHASH; h++)
+      {
+         if((value = Mix(base ^ sSeeds[h])) < signature[h])
+            signature[h] = value;
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>static unsigned long Mix(unsigned long x)
+   -----------------------------------------
+   Input:   unsigned long x     Value
+   Returns: unsigned long       Hashed value
+
+   Mixes the bits of a value (the finaliser of MurmurHash3, which uses
+   only the low 32 bits so is the same whatever the size of a long).
+
+   19.10.26 Original    By: ACRM
+*/
+static unsigned long Mix(unsigned long x)
+{
+   x &= 0xFFFFFFFFUL;
+   x ^= x >> 16;
+   x  = (x * 0x85EBCA6BUL) & 0xFFFFFFFFUL;
+   x ^= x >> 13;
+   x  = (x * 0xC2B2AE35UL) & 0xFFFFFFFFUL;
+   x ^= x >> 16;
+   return(x);
+}
+
+
+/************************************************************************/
+/*>static int CompareLSHKeys(const void *k1, const void *k2)
+   ---------------------------------------------------------
+   qsort() comparison for LSHKEYs; by key and then by entry.
+
+   19.10.26 Original    By: ACRM
+*/
+static int CompareLSHKeys(const void *k1, const void *k2)
+{
+   LSHKEY *key1 = (LSHKEY *)k1,
+          *key2 = (LSHKEY *)k2;
+
+   if(key1->key != key2->key)
+      return((key1->key < key2->key) ? -1 : 1);
+   return(key1->entry - key2->entry);
+}
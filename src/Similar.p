@@ -0,0 +1,10 @@
+REAL SeqIdentity(DATA *d, DATA *e, REAL Cutoff)
+;
+BOOL TooSimilar(DATA *d, DATA *e, REAL Cutoff)
+;
+int PercentIdentity(DATA *d, DATA *e)
+;
+LSHINDEX *BuildLSH(ARENA *arena, DATA **data, int NData)
+;
+int LSHCandidates(LSHINDEX *lsh, int i, int *cand)
+;
@@ -0,0 +1,217 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Stats.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Hot-path counters. The routines which dominate loading and searching
+   the data count their calls and time themselves with the STATxxxx()
+   macros from kabatman.h: loading the data set, parsing raw Kabat
+   entries, building the special numbering, pairing heavy and light
+   chains, the WHERE tests for each field type, canonical and subgroup
+   assignment, the output written and allocations from the arenas.
+
+   Times are kept in processor cycles (from the time stamp counter on
+   x86) which are converted to milliseconds when shown using the rate
+   measured since InitStats() was called. Each thread adds to its own
+   STATBLOCK in gStats[] so the counts stay exact when a search is split
+   between threads without the cost of locking. ParallelFor() points
+   gStatBlock at the block for each thread.
+
+   Compiling with -DNOSTATS removes the counters completely.
+
+**************************************************************************
+
+   Usage:
+   ======
+   SHOW STATS at the KabatMan prompt calls ShowStats(). kabatman -s
+   calls DumpStats() on exit.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define STATWIDTH 24                   /* Width of a counter name       */
+
+/************************************************************************/
+/* Globals
+*/
+#ifndef NOSTATS
+static unsigned long sStartTicks = 0L;
+static double        sStartTime  = 0.0;
+static char          *sStatNames[NSTATS] =
+{
+   "Data set loads",   "Raw entries parsed", "Numberings built",
+   "H/L pairings",     "Canonicals",         "Subgroups",
+   "Output rows",      "Arena allocations"
+};
+static char          *sAmountNames[NSTATS] =
+{
+   NULL, NULL, NULL, "paired", NULL, NULL, "bytes", "bytes"
+};
+#endif
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+
+
+/************************************************************************/
+/*>void InitStats(void)
+   --------------------
+   Notes the time stamp counter and the time at the start of the run so
+   that cycles can be converted to times.
+
+   19.10.26 Original    By: ACRM
+*/
+void InitStats(void)
+{
+#ifndef NOSTATS
+   sStartTicks = STATTICKS();
+   sStartTime  = WallTime();
+#endif
+}
+
+
+/************************************************************************/
+/*>unsigned long StatClock(void)
+   -----------------------------
+   Returns: unsigned long    Time in microseconds
+
+   Used for STATTICKS() where there is no time stamp counter.
+
+   19.10.26 Original    By: ACRM
+*/
+unsigned long StatClock(void)
+{
+   return((unsigned long)(WallTime() * 1.0e6));
+}
+
+
+/************************************************************************/
+/*>void ShowStats(FILE *fp)
+   ------------------------
+   Input:   FILE   *fp      Output file
+   Globals: STATBLOCK gStats[]   Counters for each thread
+
+   Adds up the counters of all threads and prints them with the time
+   spent in each routine and the time per call.
+
+   19.10.26 Original    By: ACRM
+*/
+void ShowStats(FILE *fp)
+{
+#ifdef NOSTATS
+   fprintf(fp,"# Hot-path counters were not compiled in\n");
+#else
+   STATBLOCK total;
+   double    elapsed,
+             rate     = 0.0,
+             ms;
+   int       i,
+             t;
+
+   memset(&total, 0, sizeof(STATBLOCK));
+   for(t=0; t<MAXTHREADS; t++)
+   {
+      for(i=0; i<NSTATS; i++)
+      {
+         total.ticks[i]  += gStats[t].ticks[i];
+         total.count[i]  += gStats[t].count[i];
+         total.amount[i] += gStats[t].amount[i];
+      }
+      for(i=0; i<NSTATFIELDS; i++)
+      {
+         total.TestTicks[i] += gStats[t].TestTicks[i];
+         total.tests[i]     += gStats[t].tests[i];
+      }
+   }
+
+   /* Ticks per second since InitStats()                                */
+   if((elapsed = WallTime() - sStartTime) > 0.0)
+      rate = (double)(STATTICKS() - sStartTicks) / elapsed;
+
+   fprintf(fp,"# Hot-path counters\n");
+   fprintf(fp,"# %-*s %10s %12s %12s\n", STATWIDTH, "Routine", "Calls",
+           "Time (ms)", "ns/call");
+   for(i=0; i<NSTATS; i++)
+   {
+      fprintf(fp,"# %-*s %10ld", STATWIDTH, sStatNames[i],
+              total.count[i]);
+      if(total.ticks[i] && (rate > 0.0))
+      {
+         ms = 1000.0 * (double)total.ticks[i] / rate;
+         fprintf(fp," %12.3f %12.1f", ms,
+                 (total.count[i] ? 1.0e6 * ms / total.count[i] : 0.0));
+      }
+      else
+      {
+         fprintf(fp," %12s %12s", "-", "-");
+      }
+      if(sAmountNames[i] != NULL)
+         fprintf(fp,"  %ld %s", total.amount[i], sAmountNames[i]);
+      fprintf(fp,"\n");
+   }
+
+   fprintf(fp,"# %-*s %10s %12s %12s\n", STATWIDTH, "WHERE test",
+           "Entries", "Time (ms)", "ns/entry");
+   for(i=0; i<NSTATFIELDS; i++)
+   {
+      if(total.tests[i])
+      {
+         ms = ((rate > 0.0) ? 1000.0 * (double)total.TestTicks[i] / rate
+                            : 0.0);
+         fprintf(fp,"# %-*s %10ld %12.3f %12.1f\n", STATWIDTH,
+                 FieldName(i, gField), total.tests[i], ms,
+                 1.0e6 * ms / total.tests[i]);
+      }
+   }
+#endif
+}
+
+
+/************************************************************************/
+/*>void DumpStats(void)
+   --------------------
+   Prints the counters to stderr. Registered with atexit() by kabatman
+   -s.
+
+   19.10.26 Original    By: ACRM
+*/
+void DumpStats(void)
+{
+   ShowStats(stderr);
+}
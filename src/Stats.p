@@ -0,0 +1,8 @@
+void InitStats(void)
+;
+unsigned long StatClock(void)
+;
+void ShowStats(FILE *fp)
+;
+void DumpStats(void)
+;
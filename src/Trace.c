@@ -0,0 +1,238 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Trace.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Writes a timeline of the work done while loading the data and running
+   searches as a file of Chrome trace events (JSON) which may be opened
+   with chrome://tracing or the Perfetto UI (ui.perfetto.dev).
+
+   Each traced routine writes a begin (B) event with its name and
+   optionally a detail (such as the WHERE test or species) and an end
+   (E) event when it finishes. The spans therefore nest to show which
+   routine called which. The thread id of each event is the thread
+   number used by ParallelFor() (0 for the main thread) so the chunks
+   of a search split between threads are shown side by side.
+
+   Each event is written with a single fprintf() which the C library
+   locks, so threads may write events at the same time. Times are in
+   microseconds from when the trace was started.
+
+   When no trace is being written TraceBegin() and TraceEnd() return
+   at once.
+
+**************************************************************************
+
+   Usage:
+   ======
+   SET TRACE file.json  starts a trace (closing any trace already open)
+   SET TRACE OFF        finishes it
+   kabatman -t file     starts a trace before the data are read
+
+   The trace is finished when the program exits.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+
+*************************************************************************/
+/* Includes
+*/
+#include <unistd.h>
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+
+/************************************************************************/
+/* Globals
+*/
+static FILE   *sTraceFile  = NULL;
+static double sTraceStart  = 0.0;
+static int    sTracePid    = 0;
+static BOOL   sAtExitSet   = FALSE;
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static void JSONString(char *out, char *in, int size);
+
+
+/************************************************************************/
+/*>BOOL OpenTrace(char *filename)
+   ------------------------------
+   Input:   char   *filename    Trace file to write
+   Returns: BOOL                Success
+
+   Starts writing a trace. Any trace already being written is finished
+   first.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL OpenTrace(char *filename)
+{
+   CloseTrace();
+
+   if((sTraceFile = fopen(filename,"w"))==NULL)
+   {
+      fprintf(stderr,"Error: Unable to open trace file %s\n",filename);
+      return(FALSE);
+   }
+
+   if(!sAtExitSet)
+   {
+      atexit(CloseTrace);
+      sAtExitSet = TRUE;
+   }
+
+   sTraceStart = WallTime();
+   sTracePid   = (int)getpid();
+
+   /* The metadata event names the process; every other event is
+      written with a leading comma
+   */
+   fprintf(sTraceFile,"[\n{\"name\":\"process_name\",\"ph\":\"M\",\
+\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"kabatman\"}}", sTracePid);
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void CloseTrace(void)
+   ---------------------
+   Finishes the trace being written (if any).
+
+   19.10.26 Original    By: ACRM
+*/
+void CloseTrace(void)
+{
+   if(sTraceFile != NULL)
+   {
+      fprintf(sTraceFile,"\n]\n");
+      fclose(sTraceFile);
+      sTraceFile = NULL;
+   }
+}
+
+
+/************************************************************************/
+/*>void TraceBegin(int thread, char *name, char *detail)
+   -----------------------------------------------------
+   Input:   int    thread     Thread number (0 for the main thread)
+            char   *name      Name of the span
+            char   *detail    Detail shown with the span (or NULL)
+
+   Writes the event for the start of a span. Each event is written by
+   a single fprintf() which locks the stream, so the threads of a
+   ParallelFor() may write events at the same time.
+
+   19.10.26 Original    By: ACRM
+*/
+void TraceBegin(int thread, char *name, char *detail)
+{
+   char text[2*MAXBUFF];
+
+   if(sTraceFile == NULL)
+      return;
+
+   if(detail != NULL)
+   {
+      JSONString(text, detail, 2*MAXBUFF);
+      fprintf(sTraceFile,",\n{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%.1f,\
+\"pid\":%d,\"tid\":%d,\"args\":{\"detail\":\"%s\"}}",
+              name, 1.0e6 * (WallTime() - sTraceStart), sTracePid,
+              thread, text);
+   }
+   else
+   {
+      fprintf(sTraceFile,",\n{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%.1f,\
+\"pid\":%d,\"tid\":%d}",
+              name, 1.0e6 * (WallTime() - sTraceStart), sTracePid,
+              thread);
+   }
+}
+
+
+/************************************************************************/
+/*>void TraceEnd(int thread)
+   -------------------------
+   Input:   int    thread     Thread number (0 for the main thread)
+
+   Writes the event for the end of the latest span started by the
+   thread.
+
+   19.10.26 Original    By: ACRM
+*/
+void TraceEnd(int thread)
+{
+   if(sTraceFile == NULL)
+      return;
+
+   fprintf(sTraceFile,",\n{\"ph\":\"E\",\"ts\":%.1f,\"pid\":%d,\"tid\":%d}",
+           1.0e6 * (WallTime() - sTraceStart), sTracePid, thread);
+}
+
+
+/************************************************************************/
+/*>static void JSONString(char *out, char *in, int size)
+   -----------------------------------------------------
+   Output:  char   *out       JSON string contents
+   Input:   char   *in        Text
+            int    size       Size of out
+
+   Escapes quotes, backslashes and control characters so that text may
+   be written in a JSON string. The text is cut short if need be.
+
+   19.10.26 Original    By: ACRM
+*/
+static void JSONString(char *out, char *in, int size)
+{
+   int i = 0;
+
+   for(; *in && (i < size-7); in++)
+   {
+      if((*in == '"') || (*in == '\\'))
+      {
+         out[i++] = '\\';
+         out[i++] = *in;
+      }
+      else if((unsigned char)*in < ' ')
+      {
+         sprintf(out+i, "\\u%04x", (unsigned char)*in);
+         i += 6;
+      }
+      else
+      {
+         out[i++] = *in;
+      }
+   }
+   out[i] = '\0';
+}
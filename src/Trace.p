@@ -0,0 +1,8 @@
+BOOL OpenTrace(char *filename)
+;
+void CloseTrace(void)
+;
+void TraceBegin(int thread, char *name, char *detail)
+;
+void TraceEnd(int thread)
+;
@@ -0,0 +1,1605 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       Update.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Incremental update of the stored data from the raw Kabat files.
+
+   When the stored data are built from the raw files, an index of the
+   raw files is kept in the !RAWINDEX section of the stored data file.
+   For each group of files (a line in the file of files) this records
+   the number of DATA entries the group produced and, for each file,
+   its size and modification time and, for each entry in the file, its
+   KADBID, a hash of its text and its offset in the file.
+
+   An incremental update (kabatman -i) compares the raw files with this
+   index. Files whose size and modification time are unchanged are not
+   read at all; other files are scanned and each entry is hashed. Since
+   light and heavy chains are only ever paired if they have the same
+   name, only entries sharing a name with an added, changed or deleted
+   entry need to be re-read and re-paired. All other entries are copied
+   from the stored data. The result is exactly what a full rebuild
+   would give.
+
+   When the data are read from a raw Kabat archive (kabatman -r) the
+   species and chain files are only held in memory. SetVirtualFiles()
+   makes these available under the names splitkabat would have given
+   them so the index is the same as for the split files. The in-memory
+   files have no modification time so are always scanned.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+                  The updated data are built in a new arena
+                  Added RawIndexGroups()
+                  Added SetVirtualFiles() and UpdateKabatGroups() so
+                  data read from a raw archive are indexed and updated
+
+*************************************************************************/
+/* Includes
+*/
+#include <sys/stat.h>
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define MAXFILENAME 160         /* As used for names in the FOF         */
+
+typedef struct _rawentry
+{
+   struct _rawentry *next;
+   DATA             *data;      /* Re-read light chain                  */
+   unsigned long    hash;       /* Hash of filename and entry text      */
+   long             offset;     /* Offset of the entry in the file      */
+   BOOL             involved,   /* Must be re-read and re-paired?       */
+                    matched;    /* Found in the new raw files?          */
+   char             kadbid[SMALLBUFF],
+                    name[SMALLBUFF];
+}  RAWENTRY;
+
+typedef struct _rawfile
+{
+   struct _rawfile *next;
+   RAWENTRY        *entries;
+   long            size,
+                   mtime;
+   char            name[MAXFILENAME];
+}  RAWFILE;
+
+typedef struct _rawgroup
+{
+   struct _rawgroup *next;
+   RAWFILE          *files;     /* Heavy chain file (if any) then the
+                                   light chain files                    */
+   DATA             *first;     /* First stored entry from this group   */
+   int              NData;      /* Number of entries from this group    */
+   BOOL             used;       /* Group still in the file of files?    */
+   char             spec[MAXBUFF];
+}  RAWGROUP;
+
+typedef struct
+{
+   char **keys;
+   void **values;
+   int  mask;
+}  KEYTABLE;
+
+/************************************************************************/
+/* Globals
+*/
+static RAWGROUP *sRawIndex = NULL;      /* Index of the raw files       */
+static BOOL     sNoIndex   = FALSE;     /* Index couldn't be built      */
+static VIRTFILE *sVirtFiles = NULL;     /* In-memory raw files          */
+static int      sNVirtFiles = 0;
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static int ParseGroupSpec(char *spec, char *HFile,
+                          char LFile[MAXLFILES][MAXFILENAME]);
+static FILE *OpenRawFile(char *filename);
+static RAWFILE *ScanRawFile(char *filename);
+static RAWFILE *CopyRawFile(RAWFILE *rf);
+static void FreeRawFile(RAWFILE *rf);
+static void FreeRawGroups(RAWGROUP *groups);
+static BOOL UpdateGroup(char *spec, RAWGROUP *og, DATA **pData,
+                        RAWGROUP **pGroup, int *NAdded, int *NChanged,
+                        int *NDeleted);
+static BOOL RereadGroup(RAWGROUP *g, RAWGROUP *og, DATA **pData,
+                        char *source, int *LCClass, int NLFile,
+                        BOOL HasHeavy);
+static BOOL CopyStoredEntry(DATA **pData, DATA *s);
+static char **CopyNumbering(ARENA *arena, char **numbers);
+static BOOL InitKeyTable(KEYTABLE *table, int NKeys);
+static void FreeKeyTable(KEYTABLE *table);
+static void *FindKey(KEYTABLE *table, char *key);
+static void *AddKey(KEYTABLE *table, char *key, void *value);
+
+
+/************************************************************************/
+/*>BOOL RecordRawGroup(char *spec, DATA *data)
+   -------------------------------------------
+   Input:   char  *spec     A line from the file of files
+            DATA  *data     The data linked list
+   Returns: BOOL            Success
+
+   Called by ReadKabatData() and ReadKabatArchive() once a group of
+   files has been read. Scans the files and adds them to the raw file
+   index. The entries in the data list which are not accounted for by
+   earlier groups are taken to come from this group. If the files can't
+   be indexed, a warning is given and no index is kept.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL RecordRawGroup(char *spec, DATA *data)
+{
+   RAWGROUP *g,
+            *last = NULL;
+   RAWFILE  *rf,
+            *lastf = NULL;
+   char     HFile[MAXFILENAME],
+            LFile[MAXLFILES][MAXFILENAME];
+   int      NLFile,
+            i,
+            NData = 0;
+
+   if(sNoIndex)
+      return(FALSE);
+
+   for(; data!=NULL; NEXT(data))
+      NData++;
+
+   for(g=sRawIndex; g!=NULL; NEXT(g))
+   {
+      NData -= g->NData;
+      last   = g;
+   }
+
+   if(last == NULL)
+   {
+      INIT(sRawIndex, RAWGROUP);
+      g = sRawIndex;
+   }
+   else
+   {
+      g = last;
+      ALLOCNEXT(g, RAWGROUP);
+   }
+   if(g == NULL)
+   {
+      fprintf(stderr,"Warning: No memory for raw file index\n");
+      FreeRawIndex();
+      sNoIndex = TRUE;
+      return(FALSE);
+   }
+
+   g->files = NULL;
+   g->first = NULL;
+   g->NData = NData;
+   g->used  = FALSE;
+   strcpy(g->spec, spec);
+
+   NLFile = ParseGroupSpec(spec, HFile, LFile);
+   for(i=(-1); i<NLFile; i++)
+   {
+      if(i<0 && HFile[0] == '-')
+         continue;
+
+      if((rf = ScanRawFile((i<0)?HFile:LFile[i]))==NULL)
+      {
+         fprintf(stderr,"Warning: Unable to index raw file %s\n",
+                 (i<0)?HFile:LFile[i]);
+         FreeRawIndex();
+         sNoIndex = TRUE;
+         return(FALSE);
+      }
+
+      if(lastf == NULL)
+         g->files    = rf;
+      else
+         lastf->next = rf;
+      lastf = rf;
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void SetVirtualFiles(VIRTFILE *files, int NFiles)
+   -------------------------------------------------
+   Input:   VIRTFILE  *files    In-memory species and chain files (NULL
+                                for none)
+            int       NFiles    Number of files
+
+   Sets the in-memory files which are opened in place of files on disk
+   with the same name when the raw files are indexed and updated. The
+   files must be kept until this is called again with NULL.
+
+   19.10.26 Original    By: ACRM
+*/
+void SetVirtualFiles(VIRTFILE *files, int NFiles)
+{
+   sVirtFiles  = files;
+   sNVirtFiles = (files == NULL) ? 0 : NFiles;
+}
+
+
+/************************************************************************/
+/*>void FreeRawIndex(void)
+   -----------------------
+   Frees the raw file index.
+
+   19.10.26 Original    By: ACRM
+*/
+void FreeRawIndex(void)
+{
+   FreeRawGroups(sRawIndex);
+   sRawIndex = NULL;
+}
+
+
+/************************************************************************/
+/*>BOOL RawIndexGroups(int *groups, int NData)
+   -------------------------------------------
+   Input:   int   NData      Number of entries in the data
+   Output:  int   *groups    Number of the raw index group from which
+                             each entry came
+   Returns: BOOL             Is there an index which accounts for all
+                             the entries?
+
+   The entries from each group of files are stored together so sorting
+   the entries only within each group (see ClusterData()) keeps the
+   index valid.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL RawIndexGroups(int *groups, int NData)
+{
+   RAWGROUP *g;
+   int      group = 0,
+            entry = 0,
+            i;
+
+   if(sRawIndex == NULL)
+      return(FALSE);
+
+   for(g=sRawIndex; g!=NULL; NEXT(g), group++)
+   {
+      if(entry + g->NData > NData)
+         return(FALSE);
+      for(i=0; i<g->NData; i++)
+         groups[entry++] = group;
+   }
+
+   return(entry == NData);
+}
+
+
+/************************************************************************/
+/*>void WriteRawIndex(FILE *fp)
+   ----------------------------
+   Input:   FILE  *fp     Stored data file
+
+   Writes the !RAWINDEX section of the stored data file. Nothing is
+   written if there is no index.
+
+   19.10.26 Original    By: ACRM
+*/
+void WriteRawIndex(FILE *fp)
+{
+   RAWGROUP *g;
+   RAWFILE  *rf;
+   RAWENTRY *e;
+
+   if(sRawIndex == NULL)
+      return;
+
+   fprintf(fp,"!RAWINDEX\n");
+   for(g=sRawIndex; g!=NULL; NEXT(g))
+   {
+      fprintf(fp,"GROUP %d %s\n", g->NData, g->spec);
+      for(rf=g->files; rf!=NULL; NEXT(rf))
+      {
+         fprintf(fp,"FILE %ld %ld %s\n", rf->size, rf->mtime, rf->name);
+         for(e=rf->entries; e!=NULL; NEXT(e))
+         {
+            fprintf(fp,"E %s %lx %ld %s\n",
+                    (e->kadbid[0] ? e->kadbid : "-"),
+                    e->hash, e->offset, e->name);
+         }
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>BOOL ReadRawIndex(FILE *fp, BOOL keep)
+   --------------------------------------
+   Input:   FILE  *fp     Stored data file positioned after the
+                          !RAWINDEX line
+            BOOL  keep    Keep the index (rather than just skipping it)
+   Returns: BOOL          Was the !COLD section which follows found?
+
+   Reads the !RAWINDEX section of the stored data file up to the !COLD
+   line. If the index is not wanted, it is simply skipped. If it can't
+   be read, a warning is given and it is discarded; an incremental
+   update will then do a full rebuild.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL ReadRawIndex(FILE *fp, BOOL keep)
+{
+   char     buffer[SEQBUFF];
+   RAWGROUP *g  = NULL;
+   RAWFILE  *rf = NULL;
+   RAWENTRY *e  = NULL;
+   int      n;
+   BOOL     ok  = TRUE;
+
+   FreeRawIndex();
+
+   while(fgets(buffer,SEQBUFF,fp))
+   {
+      TERMINATE(buffer);
+
+      if(!strncmp(buffer,"!COLD",5))
+      {
+         if(!ok)
+         {
+            fprintf(stderr,"Warning: Unable to read raw file index\n");
+            FreeRawIndex();
+         }
+         return(TRUE);
+      }
+
+      if(!keep || !ok)
+         continue;
+
+      if(!strncmp(buffer,"GROUP ",6))
+      {
+         if(g == NULL)
+         {
+            INIT(sRawIndex, RAWGROUP);
+            g = sRawIndex;
+         }
+         else
+         {
+            ALLOCNEXT(g, RAWGROUP);
+         }
+         if(g == NULL)
+         {
+            ok = FALSE;
+            continue;
+         }
+         g->files = NULL;
+         g->first = NULL;
+         g->used  = FALSE;
+         rf       = NULL;
+         if(sscanf(buffer+6,"%d %n",&(g->NData),&n) < 1)
+            ok = FALSE;
+         else
+            strcpy(g->spec, buffer+6+n);
+      }
+      else if(!strncmp(buffer,"FILE ",5) && (g != NULL))
+      {
+         if(rf == NULL)
+         {
+            INIT(g->files, RAWFILE);
+            rf = g->files;
+         }
+         else
+         {
+            ALLOCNEXT(rf, RAWFILE);
+         }
+         if(rf == NULL)
+         {
+            ok = FALSE;
+            continue;
+         }
+         rf->entries = NULL;
+         e           = NULL;
+         if(sscanf(buffer+5,"%ld %ld %n",&(rf->size),&(rf->mtime),&n)<2)
+            ok = FALSE;
+         else
+            strncpy(rf->name, buffer+5+n, MAXFILENAME-1);
+         rf->name[MAXFILENAME-1] = '\0';
+      }
+      else if(!strncmp(buffer,"E ",2) && (rf != NULL))
+      {
+         if(e == NULL)
+         {
+            INIT(rf->entries, RAWENTRY);
+            e = rf->entries;
+         }
+         else
+         {
+            ALLOCNEXT(e, RAWENTRY);
+         }
+         if(e == NULL)
+         {
+            ok = FALSE;
+            continue;
+         }
+         e->data     = NULL;
+         e->involved = FALSE;
+         e->matched  = FALSE;
+         e->name[0]  = '\0';
+         if(sscanf(buffer+2,"%6s %lx %ld%n",
+                   e->kadbid,&(e->hash),&(e->offset),&n) < 3)
+         {
+            ok = FALSE;
+         }
+         else
+         {
+            if(!strcmp(e->kadbid,"-"))
+               e->kadbid[0] = '\0';
+            if(buffer[2+n] == ' ')
+               strncpy(e->name, buffer+3+n, SMALLBUFF-1);
+            e->name[SMALLBUFF-1] = '\0';
+         }
+      }
+      else
+      {
+         ok = FALSE;
+      }
+   }
+
+   FreeRawIndex();
+   return(FALSE);
+}
+
+
+/************************************************************************/
+/*>BOOL UpdateKabatData(char *FoF, int *NChanges)
+   ----------------------------------------------
+   Input:   char  *FoF       Kabat file of files
+   Output:  int   *NChanges  Number of raw entries added, changed or
+                             deleted
+   Returns: BOOL             Success. FALSE if a full rebuild is needed
+   Globals: DATA  *gData     Data linked list read from the stored file
+                             (updated)
+
+   Brings the data read from the stored data file up to date with the
+   raw Kabat files listed in a file of files. See UpdateKabatGroups().
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Drops the columns and zone map
+            Update itself moved to UpdateKabatGroups()
+*/
+BOOL UpdateKabatData(char *FoF, int *NChanges)
+{
+   FILE *fp;
+   BOOL ok;
+
+   *NChanges = 0;
+
+   if((fp=OpenRawFile(FoF))==NULL)
+   {
+      printf("Error: Unable to open Kabat file of files: %s\n",FoF);
+      return(FALSE);
+   }
+
+   ok = UpdateKabatGroups(fp, NChanges);
+   fclose(fp);
+
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>BOOL UpdateKabatGroups(FILE *fp, int *NChanges)
+   -----------------------------------------------
+   Input:   FILE  *fp        The groups of raw files, one line per group
+                             in the format of the file of files
+   Output:  int   *NChanges  Number of raw entries added, changed or
+                             deleted
+   Returns: BOOL             Success. FALSE if a full rebuild is needed
+   Globals: DATA  *gData     Data linked list read from the stored file
+                             (updated)
+
+   Brings the data read from the stored data file up to date with the
+   raw Kabat files using the raw file index. If there is no index, or
+   the update fails, FALSE is returned and gData is unchanged.
+
+   The new linked list is built in a new arena so the old one can be
+   freed in one go once it is complete.
+
+   19.10.26 Original (from UpdateKabatData())   By: ACRM
+*/
+BOOL UpdateKabatGroups(FILE *fp, int *NChanges)
+{
+   char     buffer[MAXBUFF],
+            *p;
+   RAWGROUP *og,
+            *g,
+            *NewIndex  = NULL,
+            *LastGroup = NULL;
+   DATA     *d,
+            *NewData   = NULL;
+   ARENA    *OldArena;
+   int      NAdded     = 0,
+            NChanged   = 0,
+            NDeleted   = 0,
+            count;
+
+   *NChanges = 0;
+
+   if(gOldFormat)
+   {
+      fprintf(stderr,"Warning: Incremental update is not available for \
+old format files\n");
+      return(FALSE);
+   }
+
+   if(sRawIndex == NULL)
+   {
+      if(gInfoLevel >= 1)
+         printf("No raw file index in stored data; rebuilding\n");
+      return(FALSE);
+   }
+
+   /* Find the first stored entry from each group                       */
+   d = gData;
+   for(og=sRawIndex; og!=NULL; NEXT(og))
+   {
+      og->first = d;
+      for(count=0; count<og->NData && d!=NULL; count++)
+         NEXT(d);
+      if(count < og->NData)
+         break;
+   }
+   if(og != NULL || d != NULL)
+   {
+      fprintf(stderr,"Warning: Raw file index does not match stored \
+data; rebuilding\n");
+      return(FALSE);
+   }
+
+   /* We need all the cold fields before building the new list since
+      the stored file will be overwritten
+   */
+   if(!LoadAllColdData())
+      return(FALSE);
+
+   OldArena = gDataArena;
+   if((gDataArena = NewArena(DATAARENABLOCK))==NULL)
+   {
+      gDataArena = OldArena;
+      return(FALSE);
+   }
+
+   while(fgets(buffer,MAXBUFF-1,fp))
+   {
+      TERMINATE(buffer);
+      KILLLEADSPACES(p,buffer);
+      if(!strlen(p))
+         continue;
+
+      /* Find this group in the index                                   */
+      for(og=sRawIndex; og!=NULL; NEXT(og))
+      {
+         if(!og->used && !strcmp(og->spec, p))
+         {
+            og->used = TRUE;
+            break;
+         }
+      }
+
+      if(!UpdateGroup(p, og, &NewData, &g, &NAdded, &NChanged,
+                      &NDeleted))
+      {
+         FreeArena(gDataArena);
+         gDataArena = OldArena;
+         FreeRawGroups(g);
+         FreeRawGroups(NewIndex);
+         return(FALSE);
+      }
+
+      if(LastGroup == NULL)
+         NewIndex = g;
+      else
+         LastGroup->next = g;
+      LastGroup = g;
+   }
+
+   /* Groups no longer in the file of files                             */
+   for(og=sRawIndex; og!=NULL; NEXT(og))
+   {
+      if(!og->used)
+         NDeleted += og->NData;
+   }
+
+   *NChanges = NAdded + NChanged + NDeleted;
+   if(gInfoLevel >= 1)
+   {
+      printf("Raw entries added: %d, changed: %d, deleted: %d\n",
+             NAdded, NChanged, NDeleted);
+   }
+
+   /* Replace the data and index                                        */
+   FreeArena(OldArena);
+   gData     = NewData;
+   gSeqIndex = NULL;
+   gColumns  = NULL;
+   gZoneMap  = NULL;
+   FreeRawIndex();
+   sRawIndex = NewIndex;
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL UpdateGroup(char *spec, RAWGROUP *og, DATA **pData,
+                           RAWGROUP **pGroup, int *NAdded,
+                           int *NChanged, int *NDeleted)
+   -------------------------------------------------------------------
+   Input:   char     *spec      A line from the file of files
+            RAWGROUP *og        The index of the group from the stored
+                                file (NULL if it is a new group)
+   I/O:     DATA     **pData    The new data linked list
+            int      *NAdded    Incremented by raw entries added
+            int      *NChanged  Incremented by raw entries changed
+            int      *NDeleted  Incremented by raw entries deleted
+   Output:  RAWGROUP **pGroup   The new index of the group
+   Returns: BOOL                Success
+
+   Updates the entries from a group of files. Any entries which share a
+   name with an entry that has been added, changed or deleted are
+   flagged as involved; these are re-read and re-paired while the rest
+   are copied from the stored data.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL UpdateGroup(char *spec, RAWGROUP *og, DATA **pData,
+                        RAWGROUP **pGroup, int *NAdded, int *NChanged,
+                        int *NDeleted)
+{
+   RAWGROUP *g;
+   RAWFILE  *rf,
+            *of,
+            *lastf = NULL;
+   RAWENTRY *e,
+            *o;
+   KEYTABLE OldIDs,
+            NewIDs,
+            Names;
+   DATA     *d;
+   char     HFile[MAXFILENAME],
+            LFile[MAXLFILES][MAXFILENAME],
+            FileBuff[MAXFILENAME],
+            source[MAXBUFF];
+   int      NLFile,
+            LCClass[MAXLFILES],
+            NEntries  = 0,
+            NInvolved = 0,
+            NGone     = 0,
+            i;
+   BOOL     ok = TRUE;
+   struct stat FileStat;
+   FILE     *fp;
+
+   *pGroup = NULL;
+
+   INIT(g, RAWGROUP);
+   if(g == NULL)
+      return(FALSE);
+   g->files = NULL;
+   g->first = NULL;
+   g->NData = 0;
+   g->used  = FALSE;
+   strcpy(g->spec, spec);
+
+   NLFile = ParseGroupSpec(spec, HFile, LFile);
+
+   /* Scan each file unless it's unchanged since it was indexed         */
+   for(i=(-1); i<NLFile; i++)
+   {
+      char *filename = (i<0)?HFile:LFile[i];
+
+      if(i<0 && HFile[0] == '-')
+         continue;
+
+      if((fp=OpenRawFile(filename))==NULL)
+      {
+         fprintf(stderr,"Error: Unable to open Kabat file: `%s'\n",
+                 filename);
+         FreeRawGroups(g);
+         return(FALSE);
+      }
+      if(fstat(fileno(fp), &FileStat))
+         FileStat.st_size = FileStat.st_mtime = 0;
+      fclose(fp);
+
+      rf = NULL;
+      if(og != NULL)
+      {
+         for(of=og->files; of!=NULL; NEXT(of))
+         {
+            if(!strcmp(of->name, filename))
+            {
+               if((of->size  == (long)FileStat.st_size) &&
+                  (of->mtime == (long)FileStat.st_mtime))
+               {
+                  rf = CopyRawFile(of);
+                  ok = (rf != NULL);
+               }
+               break;
+            }
+         }
+      }
+      if(ok && rf == NULL)
+         rf = ScanRawFile(filename);
+
+      if(rf == NULL)
+      {
+         fprintf(stderr,"Error: Unable to index Kabat file: `%s'\n",
+                 filename);
+         FreeRawGroups(g);
+         return(FALSE);
+      }
+
+      if(lastf == NULL)
+         g->files    = rf;
+      else
+         lastf->next = rf;
+      lastf = rf;
+   }
+   *pGroup = g;
+
+   /* Size the hash tables                                              */
+   for(rf=g->files; rf!=NULL; NEXT(rf))
+      for(e=rf->entries; e!=NULL; NEXT(e))
+         NEntries++;
+   if(og != NULL)
+   {
+      for(of=og->files; of!=NULL; NEXT(of))
+         for(o=of->entries; o!=NULL; NEXT(o))
+            NEntries++;
+   }
+   if(!InitKeyTable(&OldIDs, NEntries))
+      return(FALSE);
+   if(!InitKeyTable(&NewIDs, NEntries))
+   {
+      FreeKeyTable(&OldIDs);
+      return(FALSE);
+   }
+   if(!InitKeyTable(&Names, NEntries))
+   {
+      FreeKeyTable(&OldIDs);
+      FreeKeyTable(&NewIDs);
+      return(FALSE);
+   }
+
+   /* Index the old entries. Those without a usable KADBID (or with a
+      duplicate) can't be matched so their names are always involved
+   */
+   if(og != NULL)
+   {
+      for(of=og->files; of!=NULL; NEXT(of))
+      {
+         for(o=of->entries; o!=NULL; NEXT(o))
+         {
+            o->matched = FALSE;
+            if(!o->kadbid[0] ||
+               ((e = (RAWENTRY *)AddKey(&OldIDs, o->kadbid, o))!=NULL))
+            {
+               AddKey(&Names, o->name, o);
+               if(o->kadbid[0])
+                  AddKey(&Names, e->name, e);
+            }
+         }
+      }
+   }
+
+   /* Compare the new entries with the old ones                         */
+   for(rf=g->files; rf!=NULL; NEXT(rf))
+   {
+      for(e=rf->entries; e!=NULL; NEXT(e))
+      {
+         if(!e->kadbid[0] ||
+            ((o = (RAWENTRY *)AddKey(&NewIDs, e->kadbid, e))!=NULL))
+         {
+            AddKey(&Names, e->name, e);
+            if(e->kadbid[0])
+               AddKey(&Names, o->name, o);
+         }
+
+         if(!e->kadbid[0] ||
+            (o = (RAWENTRY *)FindKey(&OldIDs, e->kadbid))==NULL)
+         {
+            (*NAdded)++;
+            AddKey(&Names, e->name, e);
+         }
+         else
+         {
+            o->matched = TRUE;
+            if(o->hash != e->hash)
+            {
+               (*NChanged)++;
+               AddKey(&Names, e->name, e);
+               AddKey(&Names, o->name, o);
+            }
+         }
+      }
+   }
+
+   /* Old entries which have gone                                       */
+   if(og != NULL)
+   {
+      for(of=og->files; of!=NULL; NEXT(of))
+      {
+         for(o=of->entries; o!=NULL; NEXT(o))
+         {
+            if(!o->matched)
+            {
+               NGone++;
+               AddKey(&Names, o->name, o);
+            }
+         }
+      }
+   }
+
+   /* Flag the entries to be re-read                                    */
+   for(rf=g->files; rf!=NULL; NEXT(rf))
+   {
+      for(e=rf->entries; e!=NULL; NEXT(e))
+      {
+         if((e->involved = (FindKey(&Names, e->name) != NULL)))
+            NInvolved++;
+      }
+   }
+
+   FreeKeyTable(&OldIDs);
+   FreeKeyTable(&NewIDs);
+   FreeKeyTable(&Names);
+   *NDeleted += NGone;
+
+   if(og != NULL && NInvolved == 0 && NGone == 0)
+   {
+      /* Nothing to do; just copy the stored entries                    */
+      for(i=0, d=og->first; i<og->NData; i++, NEXT(d))
+      {
+         if(!CopyStoredEntry(pData, d))
+            return(FALSE);
+      }
+      g->NData = og->NData;
+      return(TRUE);
+   }
+
+   if(gInfoLevel >= 1) printf("Processing files: %s\n",spec);
+
+   /* Get the source and light chain classes from the filenames         */
+   if(HFile[0] != '-')
+      GetSource(HFile, source);
+   else
+      GetSource(LFile[0], source);
+
+   for(i=0; i<NLFile; i++)
+   {
+      LCClass[i] = 0;
+      strcpy(FileBuff, LFile[i]);
+      UPPER(FileBuff);
+      if(strstr(FileBuff,"KAPPA")!=NULL)
+         LCClass[i] = CLASS_KAPPA;
+      else if(strstr(FileBuff,"LAMBDA")!=NULL)
+         LCClass[i] = CLASS_LAMBDA;
+   }
+
+   return(RereadGroup(g, og, pData, source, LCClass, NLFile,
+                      (HFile[0] != '-')));
+}
+
+
+/************************************************************************/
+/*>static BOOL RereadGroup(RAWGROUP *g, RAWGROUP *og, DATA **pData,
+                           char *source, int *LCClass, int NLFile,
+                           BOOL HasHeavy)
+   ----------------------------------------------------------------
+   Input:   RAWGROUP *g         The new index of the group with involved
+                                entries flagged
+            RAWGROUP *og        The index of the group from the stored
+                                file (or NULL)
+            char     *source    Source derived from the filename
+            int      *LCClass   Light chain classes from the filenames
+            int      NLFile     Number of light chain files
+            BOOL     HasHeavy   Is there a heavy chain file?
+   I/O:     DATA     **pData    The new data linked list
+   Returns: BOOL                Success
+
+   Rebuilds the entries for a group of files in the same order as
+   ReadKabatData() would. Involved entries are re-read from the raw
+   files and paired with StoreHAndMatchL(); the others are copied from
+   the stored data. The re-read light chains are kept in a temporary
+   arena.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Uses ParseNextKabatEntry()
+*/
+static BOOL RereadGroup(RAWGROUP *g, RAWGROUP *og, DATA **pData,
+                        char *source, int *LCClass, int NLFile,
+                        BOOL HasHeavy)
+{
+   KEYTABLE   HChains,
+              LChains;
+   RAWFILE    *rf,
+              *HRaw = NULL,
+              *LRaw[MAXLFILES];
+   RAWENTRY   *e;
+   DATA       *d,
+              *p = NULL,
+              *KabatLData[MAXLFILES];
+   KABATENTRY KabatEntry;
+   FILE       *fp;
+   ARENA      *LArena = NULL;
+   int        i,
+              nseq;
+   BOOL       GotInsert,
+              ok = TRUE;
+
+   /* Index the stored entries by heavy chain and unpaired light chain
+      KADBID
+   */
+   if(!InitKeyTable(&HChains, (og==NULL)?0:og->NData))
+      return(FALSE);
+   if(!InitKeyTable(&LChains, (og==NULL)?0:og->NData))
+   {
+      FreeKeyTable(&HChains);
+      return(FALSE);
+   }
+   if(og != NULL)
+   {
+      for(i=0, d=og->first; i<og->NData; i++, NEXT(d))
+      {
+         if(d->heavy[0])
+            AddKey(&HChains, d->idheavy, d);
+         else
+            AddKey(&LChains, d->idlight, d);
+      }
+   }
+
+   /* The heavy chain file (if any) is first in the list                */
+   rf = g->files;
+   if(HasHeavy)
+   {
+      HRaw = rf;
+      NEXT(rf);
+   }
+   for(i=0; i<NLFile; i++, NEXT(rf))
+   {
+      LRaw[i]       = rf;
+      KabatLData[i] = NULL;
+   }
+
+   /* Re-read the involved light chains                                 */
+   if((LArena = NewArena(DATAARENABLOCK))==NULL)
+      ok = FALSE;
+   for(i=0; ok && i<NLFile; i++)
+   {
+      if((fp = OpenRawFile(LRaw[i]->name))==NULL)
+      {
+         ok = FALSE;
+         break;
+      }
+
+      for(e=LRaw[i]->entries; e!=NULL; NEXT(e))
+      {
+         e->data = NULL;
+         if(!e->involved)
+            continue;
+
+         fseek(fp, e->offset, SEEK_SET);
+         nseq = ParseNextKabatEntry(fp, &KabatEntry, &GotInsert, FALSE);
+         if(nseq == (-1))
+         {
+            if(gInfoLevel >= 1)
+               printf("Skipped L chain for %s (%s)\n",
+                      KabatEntry.aaname, KabatEntry.kadbid);
+         }
+         else if(nseq > MINSEQ)
+         {
+            if(KabatLData[i] == NULL)
+            {
+               ARENAINIT(LArena, (KabatLData[i]), DATA);
+               p = KabatLData[i];
+            }
+            else
+            {
+               ARENANEXT(LArena, p, DATA);
+            }
+            if(p==NULL)
+            {
+               ok = FALSE;
+               break;
+            }
+
+            CopyLKabatToData(p, KabatEntry, GotInsert, source,
+                             LCClass[i]);
+            e->data = p;
+         }
+      }
+      fclose(fp);
+   }
+
+   /* Heavy chains in order, pairing the involved ones                  */
+   if(ok && HRaw != NULL)
+   {
+      if((fp = OpenRawFile(HRaw->name))==NULL)
+         ok = FALSE;
+
+      for(e=HRaw->entries; ok && e!=NULL; NEXT(e))
+      {
+         if(!e->involved)
+         {
+            if((d = (DATA *)FindKey(&HChains, e->kadbid))!=NULL)
+            {
+               ok = CopyStoredEntry(pData, d);
+               g->NData++;
+            }
+            continue;
+         }
+
+         fseek(fp, e->offset, SEEK_SET);
+         nseq = ParseNextKabatEntry(fp, &KabatEntry, &GotInsert, FALSE);
+         if(nseq == (-1))
+         {
+            if(gInfoLevel >= 1)
+               printf("Skipped H chain for %s (%s)\n",
+                      KabatEntry.aaname, KabatEntry.kadbid);
+         }
+         else if(nseq > MINSEQ)
+         {
+            if((*pData = StoreHAndMatchL(*pData, KabatEntry, KabatLData,
+                                         NLFile, source, GotInsert))
+               ==(DATA *)(-1))
+            {
+               *pData = NULL;
+               ok     = FALSE;
+            }
+            g->NData++;
+         }
+      }
+      if(fp != NULL)
+         fclose(fp);
+   }
+
+   /* Unpaired light chains in order                                    */
+   for(i=0; ok && i<NLFile; i++)
+   {
+      for(e=LRaw[i]->entries; ok && e!=NULL; NEXT(e))
+      {
+         if(e->involved)
+         {
+            if((e->data != NULL) && !(e->data->active[0]))
+            {
+               ok = StoreDataInData(pData, e->data, 'L', source);
+               g->NData++;
+            }
+         }
+         else if((d = (DATA *)FindKey(&LChains, e->kadbid))!=NULL)
+         {
+            ok = CopyStoredEntry(pData, d);
+            g->NData++;
+         }
+      }
+   }
+
+   FreeArena(LArena);
+   FreeKeyTable(&HChains);
+   FreeKeyTable(&LChains);
+
+   if(!ok)
+      fprintf(stderr,"Error: Failed to update data for files: %s\n",
+              g->spec);
+
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static BOOL CopyStoredEntry(DATA **pData, DATA *s)
+   --------------------------------------------------
+   I/O:     DATA  **pData   Data linked list
+   Input:   DATA  *s        Stored entry
+   Returns: BOOL            Success
+
+   Appends a copy of a stored entry to the data linked list. The
+   numbering and cold fields are copied into gDataArena since the
+   stored entry's arena is freed when the update is complete.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL CopyStoredEntry(DATA **pData, DATA *s)
+{
+   DATA     copy;
+   COLDDATA *cold = GetColdData(s);
+
+   copy = *s;
+   if((copy.cold = NewColdData(gDataArena, cold->antigen, cold->fsource,
+                               cold->reference))==NULL)
+      return(FALSE);
+   if((s->LNumbers != NULL) &&
+      (copy.LNumbers = CopyNumbering(gDataArena, s->LNumbers))==NULL)
+      return(FALSE);
+   if((s->HNumbers != NULL) &&
+      (copy.HNumbers = CopyNumbering(gDataArena, s->HNumbers))==NULL)
+      return(FALSE);
+
+   if(copy.heavy[0])
+   {
+      if(!StoreDataInData(pData, &copy, 'H', NULL))
+         return(FALSE);
+      if(copy.light[0])
+         AddDataToData(*pData, &copy, 'L');
+      return(TRUE);
+   }
+
+   return(StoreDataInData(pData, &copy, 'L', NULL));
+}
+
+
+/************************************************************************/
+/*>static char **CopyNumbering(ARENA *arena, char **numbers)
+   ---------------------------------------------------------
+   I/O:     ARENA  *arena     Arena from which to allocate
+   Input:   char   **numbers  NULL-terminated array of residue numbers
+   Returns: char   **         Copy of the array. NULL if no memory
+
+   Copies a special numbering array into an arena.
+
+   19.10.26 Original    By: ACRM
+*/
+static char **CopyNumbering(ARENA *arena, char **numbers)
+{
+   char **copy;
+   int  i;
+
+   if((copy = (char **)ArenaAlloc(arena, MAXKABATSEQ * sizeof(char *)))
+      ==NULL)
+      return(NULL);
+
+   for(i=0; numbers[i] != NULL; i++)
+   {
+      if((copy[i] = (char *)ArenaAlloc(arena, 5 * sizeof(char)))==NULL)
+         return(NULL);
+      strcpy(copy[i], numbers[i]);
+   }
+   copy[i] = NULL;
+
+   return(copy);
+}
+
+
+/************************************************************************/
+/*>static int ParseGroupSpec(char *spec, char *HFile,
+                             char LFile[MAXLFILES][MAXFILENAME])
+   -------------------------------------------------------------
+   Input:   char  *spec     A line from the file of files
+   Output:  char  *HFile    Heavy chain file (- if none)
+            char  LFile[][] Light chain files
+   Returns: int             Number of light chain files
+
+   Splits a line from the file of files in the same way as
+   ReadKabatData().
+
+   19.10.26 Original    By: ACRM
+*/
+static int ParseGroupSpec(char *spec, char *HFile,
+                          char LFile[MAXLFILES][MAXFILENAME])
+{
+   int NLFile;
+
+   spec = blGetWord(spec, HFile, MAXFILENAME);
+   for(NLFile=0; NLFile<MAXLFILES; NLFile++)
+      spec = blGetWord(spec, LFile[NLFile], MAXFILENAME);
+
+   for(NLFile=0; NLFile<MAXLFILES; NLFile++)
+   {
+      if(!LFile[NLFile][0])
+         break;
+   }
+
+   return(NLFile);
+}
+
+
+/************************************************************************/
+/*>static FILE *OpenRawFile(char *filename)
+   ----------------------------------------
+   Input:   char  *filename   File to open
+   Returns: FILE  *           File pointer (NULL if not opened)
+
+   Opens a file in the current directory or, failing that, in the
+   directory named by the KABATDIR environment variable. An in-memory
+   file set with SetVirtualFiles() is used in place of one on disk.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Opens in-memory files with fmemopen()
+*/
+static FILE *OpenRawFile(char *filename)
+{
+   FILE *fp;
+   char *KabatDir,
+        FileBuff[MAXBUFF+MAXFILENAME];
+   int  i;
+
+   for(i=0; i<sNVirtFiles; i++)
+   {
+      if(!strcmp(sVirtFiles[i].name, filename))
+         return(fmemopen(sVirtFiles[i].buffer, sVirtFiles[i].length,
+                         "r"));
+   }
+
+   if((fp=fopen(filename,"r"))==NULL)
+   {
+      if((KabatDir = getenv(ENV_KABATDIR))!=NULL)
+      {
+         sprintf(FileBuff,"%s/%s",KabatDir,filename);
+         fp = fopen(FileBuff,"r");
+      }
+   }
+   return(fp);
+}
+
+
+/************************************************************************/
+/*>static RAWFILE *ScanRawFile(char *filename)
+   -------------------------------------------
+   Input:   char     *filename   Raw Kabat file
+   Returns: RAWFILE  *           Index of the file (NULL if it couldn't
+                                 be read)
+
+   Indexes the entries in a raw Kabat file without parsing them. An
+   entry runs from its KADBID line to its RECEND| line in the same way
+   as ReadKabatEntry(). The hash of each entry includes the filename so
+   that an entry which moves to a different file is seen as changed.
+   The modification time of a file modified very recently, or of an
+   in-memory file, is not recorded as it can't be trusted.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 No modification time for files which can't be stat'd
+*/
+static RAWFILE *ScanRawFile(char *filename)
+{
+   FILE          *fp;
+   RAWFILE       *rf;
+   RAWENTRY      *e = NULL;
+   char          buffer[SEQBUFF];
+   long          offset;
+   unsigned long FileHash;
+   struct stat   FileStat;
+   BOOL          InEntry = FALSE;
+
+   if((fp=OpenRawFile(filename))==NULL)
+      return(NULL);
+
+   INIT(rf, RAWFILE);
+   if(rf == NULL)
+   {
+      fclose(fp);
+      return(NULL);
+   }
+   rf->entries = NULL;
+   rf->size    = 0L;
+   rf->mtime   = (-1L);
+   strncpy(rf->name, filename, MAXFILENAME-1);
+   rf->name[MAXFILENAME-1] = '\0';
+
+   if(!fstat(fileno(fp), &FileStat))
+   {
+      rf->size  = (long)FileStat.st_size;
+      rf->mtime = (long)FileStat.st_mtime;
+
+      /* If the file was modified in the last couple of seconds it could
+         be changed again without the time changing, so make sure it is
+         scanned next time
+      */
+      if(rf->mtime >= (long)time(NULL) - 2)
+         rf->mtime = (-1L);
+   }
+
+   FileHash = HashBytes(filename, strlen(filename), HASH_INIT);
+   offset   = ftell(fp);
+
+   while(fgets(buffer,SEQBUFF,fp))
+   {
+      if(!InEntry && !strncmp(buffer,"KADBID",6))
+      {
+         if(rf->entries == NULL)
+         {
+            INIT(rf->entries, RAWENTRY);
+            e = rf->entries;
+         }
+         else
+         {
+            ALLOCNEXT(e, RAWENTRY);
+         }
+         if(e == NULL)
+         {
+            FreeRawFile(rf);
+            fclose(fp);
+            return(NULL);
+         }
+         e->data      = NULL;
+         e->hash      = FileHash;
+         e->offset    = offset;
+         e->involved  = FALSE;
+         e->matched   = FALSE;
+         e->kadbid[0] = e->name[0] = '\0';
+         InEntry      = TRUE;
+      }
+
+      if(InEntry)
+      {
+         e->hash = HashBytes(buffer, strlen(buffer), e->hash);
+         TERMINATE(buffer);
+
+         if(!strncmp(buffer,"RECEND|",7))
+         {
+            InEntry = FALSE;
+         }
+         else if(!strncmp(buffer,"KADBID",6))
+         {
+            /* As ReadKabatEntry(). A KADBID containing a space can't
+               be written to the index so is left blank
+            */
+            e->kadbid[0] = '\0';
+            if(strlen(buffer) > 12)
+            {
+               strncpy(e->kadbid, buffer+12, 6);
+               e->kadbid[6] = '\0';
+               if(strchr(e->kadbid,' ') || !strcmp(e->kadbid,"-"))
+                  e->kadbid[0] = '\0';
+            }
+         }
+         else if(!strncmp(buffer,"AANAME",6))
+         {
+            e->name[0] = '\0';
+            if(strlen(buffer) > 12)
+               strncpy(e->name, buffer+12, SMALLBUFF);
+            e->name[SMALLBUFF-1] = '\0';
+         }
+      }
+
+      offset = ftell(fp);
+   }
+
+   fclose(fp);
+   return(rf);
+}
+
+
+/************************************************************************/
+/*>static RAWFILE *CopyRawFile(RAWFILE *rf)
+   ----------------------------------------
+   Input:   RAWFILE  *rf     Index of a raw file
+   Returns: RAWFILE  *       Copy of the index (NULL if no memory)
+
+   19.10.26 Original    By: ACRM
+*/
+static RAWFILE *CopyRawFile(RAWFILE *rf)
+{
+   RAWFILE  *copy;
+   RAWENTRY *e,
+            *ce = NULL;
+
+   INIT(copy, RAWFILE);
+   if(copy == NULL)
+      return(NULL);
+
+   copy->entries = NULL;
+   copy->size    = rf->size;
+   copy->mtime   = rf->mtime;
+   strcpy(copy->name, rf->name);
+
+   for(e=rf->entries; e!=NULL; NEXT(e))
+   {
+      if(ce == NULL)
+      {
+         INIT(copy->entries, RAWENTRY);
+         ce = copy->entries;
+      }
+      else
+      {
+         ALLOCNEXT(ce, RAWENTRY);
+      }
+      if(ce == NULL)
+      {
+         FreeRawFile(copy);
+         return(NULL);
+      }
+
+      ce->data     = NULL;
+      ce->hash     = e->hash;
+      ce->offset   = e->offset;
+      ce->involved = FALSE;
+      ce->matched  = FALSE;
+      strcpy(ce->kadbid, e->kadbid);
+      strcpy(ce->name,   e->name);
+   }
+
+   return(copy);
+}
+
+
+/************************************************************************/
+/*>static void FreeRawFile(RAWFILE *rf)
+   ------------------------------------
+   Input:   RAWFILE  *rf     Index of a raw file
+
+   Frees the index of a raw file (but not any following it in a list).
+
+   19.10.26 Original    By: ACRM
+*/
+static void FreeRawFile(RAWFILE *rf)
+{
+   if(rf != NULL)
+   {
+      if(rf->entries != NULL)
+         FREELIST(rf->entries, RAWENTRY);
+      free(rf);
+   }
+}
+
+
+/************************************************************************/
+/*>static void FreeRawGroups(RAWGROUP *groups)
+   -------------------------------------------
+   Input:   RAWGROUP  *groups   Linked list of raw file group indexes
+
+   19.10.26 Original    By: ACRM
+*/
+static void FreeRawGroups(RAWGROUP *groups)
+{
+   RAWGROUP *g;
+   RAWFILE  *rf;
+
+   while(groups != NULL)
+   {
+      g = groups;
+      NEXT(groups);
+
+      while(g->files != NULL)
+      {
+         rf = g->files;
+         NEXT(g->files);
+         FreeRawFile(rf);
+      }
+      free(g);
+   }
+}
+
+
+/************************************************************************/
+/*>static BOOL InitKeyTable(KEYTABLE *table, int NKeys)
+   ----------------------------------------------------
+   Output:  KEYTABLE  *table   Hash table
+   Input:   int       NKeys    Maximum number of keys to be stored
+   Returns: BOOL               Success
+
+   Allocates an empty open addressing hash table from strings to
+   pointers. The keys are not copied so must not be freed while the
+   table is in use.
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL InitKeyTable(KEYTABLE *table, int NKeys)
+{
+   int size = 16,
+       i;
+
+   /* Table is a power of 2 and at least twice the number of keys       */
+   while(size < 2 * NKeys)
+      size *= 2;
+   table->mask = size - 1;
+
+   if((table->keys = (char **)malloc(size * sizeof(char *)))==NULL)
+      return(FALSE);
+   if((table->values = (void **)malloc(size * sizeof(void *)))==NULL)
+   {
+      free(table->keys);
+      return(FALSE);
+   }
+   for(i=0; i<size; i++)
+      table->keys[i] = NULL;
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static void FreeKeyTable(KEYTABLE *table)
+   -----------------------------------------
+   I/O:     KEYTABLE  *table   Hash table
+
+   19.10.26 Original    By: ACRM
+*/
+static void FreeKeyTable(KEYTABLE *table)
+{
+   free(table->keys);
+   free(table->values);
+}
+
+
+/************************************************************************/
+/*>static void *FindKey(KEYTABLE *table, char *key)
+   ------------------------------------------------
+   Input:   KEYTABLE  *table   Hash table
+            char      *key     Key to find
+   Returns: void      *        Value stored with the key (NULL if not
+                               found)
+
+   19.10.26 Original    By: ACRM
+*/
+static void *FindKey(KEYTABLE *table, char *key)
+{
+   int j;
+
+   j = (int)(HashBytes(key, strlen(key), HASH_INIT) & table->mask);
+   for(; table->keys[j]!=NULL; j=(j+1) & table->mask)
+   {
+      if(!strcmp(table->keys[j], key))
+         return(table->values[j]);
+   }
+   return(NULL);
+}
+
+
+/************************************************************************/
+/*>static void *AddKey(KEYTABLE *table, char *key, void *value)
+   ------------------------------------------------------------
+   I/O:     KEYTABLE  *table   Hash table
+   Input:   char      *key     Key to add
+            void      *value   Value (not NULL) to store with the key
+   Returns: void      *        NULL if the key was added; the value
+                               already stored if the key was present
+
+   19.10.26 Original    By: ACRM
+*/
+static void *AddKey(KEYTABLE *table, char *key, void *value)
+{
+   int j;
+
+   j = (int)(HashBytes(key, strlen(key), HASH_INIT) & table->mask);
+   for(; table->keys[j]!=NULL; j=(j+1) & table->mask)
+   {
+      if(!strcmp(table->keys[j], key))
+         return(table->values[j]);
+   }
+   table->keys[j]   = key;
+   table->values[j] = value;
+   return(NULL);
+}
@@ -0,0 +1,16 @@
+BOOL RecordRawGroup(char *spec, DATA *data)
+;
+void SetVirtualFiles(VIRTFILE *files, int NFiles)
+;
+void FreeRawIndex(void)
+;
+BOOL RawIndexGroups(int *groups, int NData)
+;
+void WriteRawIndex(FILE *fp)
+;
+BOOL ReadRawIndex(FILE *fp, BOOL keep)
+;
+BOOL UpdateKabatData(char *FoF, int *NChanges)
+;
+BOOL UpdateKabatGroups(FILE *fp, int *NChanges)
+;
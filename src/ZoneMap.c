@@ -0,0 +1,473 @@
+/*************************************************************************
+
+   Program:    KabatMan
+   File:       ZoneMap.c
+
+   Version:    V2.27
+   Date:       19.10.26
+   Function:   Database program for reading Kabat sequence files
+
+   Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure and Modelling Unit,
+               Department of Biochemistry and Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Zone maps allow a scan to skip blocks of entries which can't pass a
+   test on the source, class, reference date or the length of a CDR.
+
+   The entries are taken in blocks (zones) of ZONESIZE in the order in
+   which they are stored. For each zone the map keeps the lowest and
+   highest reference date, the lowest and highest length of each CDR
+   with each loop definition and bitsets of the codes of the sources and
+   classes present (see Batch.c).
+
+   For a test on the source or class, the test is applied once to each
+   distinct value to give the bits of the values which pass, and a zone
+   is skipped if it has none of them. For a test on a number, a zone is
+   skipped if no value between its lowest and highest could pass. The
+   tests themselves are then only applied to entries in the remaining
+   zones, so the results are the same as a full scan.
+
+   The map is built from the columns the first time it is needed. The
+   CDR lengths for a loop and loop definition are only found the first
+   time a LENGTH test on that loop is run with that definition. Like the
+   sequence index, the map is allocated from gDataArena so it goes when
+   the data do.
+
+   The zones are only selective if entries with similar values are
+   stored together. kabatman -c sorts the entries by source and then
+   class each time the stored data are written. If there is a raw file
+   index, the entries are only sorted within each group of files so the
+   index can still be used by kabatman -i. Since the groups are mostly
+   by species, little is lost.
+
+**************************************************************************
+
+   Usage:
+   ======
+   FindZones() is called by HandleMatch(). SET ZONEMAP OFF stops the
+   maps being used.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V2.27 19.10.26 Original
+                  ClusterData() keeps the raw file index
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+typedef struct
+{
+   DATA *data;
+   int  group,                  /* Raw file index group                 */
+        order;
+}  CLUSTERKEY;
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+static BOOL RangeMayPass(int min, int max, int comparison, int value);
+static BOOL FindZoneLengths(ZONEMAP *zm, COLUMNS *cols, int loop,
+                            int mode);
+static int CompareClusterKeys(const void *k1, const void *k2);
+
+
+/************************************************************************/
+/*>ZONEMAP *GetZoneMap(void)
+   -------------------------
+   Returns: ZONEMAP *           The zone map. NULL if no memory
+   Globals: ZONEMAP *gZoneMap   Set when first built
+
+   Gets the zone map, building it from the columns the first time.
+   Whether it was ready is counted in gCacheHits and gCacheMisses.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Built from the COLUMNS
+*/
+ZONEMAP *GetZoneMap(void)
+{
+   ZONEMAP *zm;
+   COLUMNS *cols;
+   ZONE    *zone = NULL;
+   int     entry,
+           loop,
+           mode;
+
+   if(gZoneMap != NULL)
+   {
+      gCacheHits++;
+      return(gZoneMap);
+   }
+   gCacheMisses++;
+
+   if(((cols = GetColumns())==NULL) || (cols->NRows == 0) ||
+      ((zm = (ZONEMAP *)ArenaAlloc(gDataArena, sizeof(ZONEMAP)))==NULL))
+      return(NULL);
+
+   zm->NZones = (cols->NRows + ZONESIZE - 1) / ZONESIZE;
+   for(loop=0; loop<NLENGTHLOOPS; loop++)
+   {
+      for(mode=0; mode<NLOOPMODES; mode++)
+         zm->HaveLength[loop][mode] = FALSE;
+   }
+
+   if((zm->zones = (ZONE *)ArenaAlloc(gDataArena,
+                                      zm->NZones * sizeof(ZONE)))==NULL)
+      return(NULL);
+
+   for(entry=0; entry<cols->NRows; entry++)
+   {
+      if((entry % ZONESIZE) == 0)
+      {
+         zone          = zm->zones + (entry / ZONESIZE);
+         zone->sources = zone->classes = 0;
+         zone->MinDate = zone->MaxDate = cols->dates[entry];
+      }
+
+      zone->sources |= (uint64_t)1 << cols->sources[entry];
+      zone->classes |= (uint64_t)1 << cols->classes[entry];
+      if(cols->dates[entry] < zone->MinDate)
+         zone->MinDate = cols->dates[entry];
+      if(cols->dates[entry] > zone->MaxDate)
+         zone->MaxDate = cols->dates[entry];
+   }
+
+   gZoneMap = zm;
+   return(zm);
+}
+
+
+/************************************************************************/
+/*>BOOL IsZoneTest(WHERE *wh)
+   --------------------------
+   Input:   WHERE  *wh        A WHERE test
+   Returns: BOOL              Can the zone map be used for the test?
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL IsZoneTest(WHERE *wh)
+{
+   if(!gUseZoneMap || wh->SetOper)
+      return(FALSE);
+
+   switch(wh->type)
+   {
+   case FIELD_SOURCE:
+   case FIELD_CLASS:
+      return(TRUE);
+   case FIELD_LENGTH:
+      if(LengthLoop(wh->param) < 0)
+         return(FALSE);
+      /* Fall through                                                   */
+   case FIELD_REFDATE:
+      return((wh->comparison >= COMP_EQ) && (wh->comparison <= COMP_GE));
+   default:
+      break;
+   }
+   return(FALSE);
+}
+
+
+/************************************************************************/
+/*>BOOL FindZones(WHERE *wh, char **pZones, int *NZones)
+   -----------------------------------------------------
+   Input:   WHERE  *wh        A WHERE test
+   Output:  char   **pZones   Flag for each zone: may an entry in it
+                              pass the test? Allocated; the caller
+                              frees it
+            int    *NZones    Number of zones
+   Returns: BOOL              Was the zone map used? (FALSE if it can't
+                              be used for the test or there is no
+                              memory, in which case every entry must be
+                              tested)
+
+   Finds the zones which need to be scanned for a test.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL FindZones(WHERE *wh, char **pZones, int *NZones)
+{
+   ZONEMAP  *zm;
+   COLUMNS  *cols;
+   ZONE     *zone;
+   uint64_t pass  = 0;
+   int      value = 0,
+            loop  = 0,
+            mode  = gLoopMode - 1,
+            i;
+
+   *pZones = NULL;
+   *NZones = 0;
+
+   if(!IsZoneTest(wh) || ((zm = GetZoneMap())==NULL))
+      return(FALSE);
+   cols = GetColumns();
+
+   switch(wh->type)
+   {
+   case FIELD_SOURCE:
+      pass = CodePass(cols->SourceValues, cols->NSources,
+                      cols->OtherSources, wh);
+      break;
+   case FIELD_CLASS:
+      pass = CodePass(cols->ClassValues, cols->NClasses,
+                      cols->OtherClasses, wh);
+      break;
+   case FIELD_LENGTH:
+      loop = LengthLoop(wh->param);
+      if(!zm->HaveLength[loop][mode] &&
+         !FindZoneLengths(zm, cols, loop, mode))
+         return(FALSE);
+      /* Fall through                                                   */
+   case FIELD_REFDATE:
+      if(!sscanf(wh->data,"%d",&value)) value=0;  /* As TestEntry()     */
+      break;
+   }
+
+   if((*pZones = (char *)malloc(zm->NZones * sizeof(char)))==NULL)
+      return(FALSE);
+
+   for(i=0; i<zm->NZones; i++)
+   {
+      zone = zm->zones + i;
+      switch(wh->type)
+      {
+      case FIELD_SOURCE:
+         (*pZones)[i] = ((zone->sources & pass) != 0);
+         break;
+      case FIELD_CLASS:
+         (*pZones)[i] = ((zone->classes & pass) != 0);
+         break;
+      case FIELD_LENGTH:
+         (*pZones)[i] = RangeMayPass(zone->MinLen[loop][mode],
+                                     zone->MaxLen[loop][mode],
+                                     wh->comparison, value);
+         break;
+      case FIELD_REFDATE:
+         (*pZones)[i] = RangeMayPass(zone->MinDate, zone->MaxDate,
+                                     wh->comparison, value);
+         break;
+      }
+   }
+   *NZones = zm->NZones;
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>BOOL ClusterData(void)
+   ----------------------
+   Returns: BOOL            Success (FALSE if no memory, in which case
+                            the data are unchanged)
+   Globals: DATA   *gData   The data; re-ordered
+
+   Sorts the entries by source and then class, keeping their order
+   otherwise, so that the zone maps are selective. If there is a raw
+   file index, the entries are sorted within each of its groups since
+   the index needs the entries from each group to stay together.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Sorts within the raw file index groups rather than dropping
+            the index
+*/
+BOOL ClusterData(void)
+{
+   CLUSTERKEY *keys;
+   DATA       *d;
+   int        *groups,
+              NData = 0,
+              i;
+   BOOL       grouped;
+
+   for(d=gData; d!=NULL; NEXT(d))
+      NData++;
+   if(NData < 2)
+      return(TRUE);
+
+   if(((keys = (CLUSTERKEY *)malloc(NData * sizeof(CLUSTERKEY)))==NULL) ||
+      ((groups = (int *)malloc(NData * sizeof(int)))==NULL))
+   {
+      if(keys != NULL)
+         free(keys);
+      fprintf(stderr,"Warning: No memory to sort the entries\n");
+      return(FALSE);
+   }
+
+   grouped = RawIndexGroups(groups, NData);
+   for(d=gData, i=0; d!=NULL; NEXT(d), i++)
+   {
+      keys[i].data  = d;
+      keys[i].group = (grouped ? groups[i] : 0);
+      keys[i].order = i;
+   }
+   free(groups);
+   qsort(keys, NData, sizeof(CLUSTERKEY), CompareClusterKeys);
+
+   gData = keys[0].data;
+   for(i=0; i<NData-1; i++)
+      keys[i].data->next = keys[i+1].data;
+   keys[NData-1].data->next = NULL;
+
+   free(keys);
+
+   /* An index which doesn't match the data is no use anyway            */
+   if(!grouped)
+      FreeRawIndex();
+   gSeqIndex = NULL;
+   gColumns  = NULL;
+   gZoneMap  = NULL;
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void ZoneMapMemory(MEMUSE *use)
+   -------------------------------
+   Output:  MEMUSE   *use        Memory used by the zone map
+   Globals: ZONEMAP  *gZoneMap   The zone map (if built)
+
+   For SHOW MEMORY.
+
+   19.10.26 Original    By: ACRM
+*/
+void ZoneMapMemory(MEMUSE *use)
+{
+   if(gZoneMap == NULL)
+      return;
+
+   use->allocated = ArenaRound(sizeof(ZONEMAP)) +
+                    ArenaRound(gZoneMap->NZones * sizeof(ZONE));
+   use->used      = sizeof(ZONEMAP) + gZoneMap->NZones * sizeof(ZONE);
+}
+
+
+/************************************************************************/
+/*>static BOOL RangeMayPass(int min, int max, int comparison, int value)
+   ---------------------------------------------------------------------
+   Input:   int    min          Lowest number in the zone
+            int    max          Highest number in the zone
+            int    comparison   COMP_EQ...COMP_GE
+            int    value        Number in the test
+   Returns: BOOL                Could DoIntTest() pass for any number
+                                from min to max?
+
+   19.10.26 Original    By: ACRM
+*/
+static BOOL RangeMayPass(int min, int max, int comparison, int value)
+{
+   switch(comparison)
+   {
+   case COMP_EQ:
+      return((value >= min) && (value <= max));
+   case COMP_NE:
+      return((min != value) || (max != value));
+   case COMP_LT:
+      return(min < value);
+   case COMP_LE:
+      return(min <= value);
+   case COMP_GT:
+      return(max > value);
+   case COMP_GE:
+      return(max >= value);
+   default:
+      break;
+   }
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL FindZoneLengths(ZONEMAP *zm, COLUMNS *cols, int loop,
+                               int mode)
+   --------------------------------------------------------------------
+   I/O:     ZONEMAP *zm       The zone map
+   Input:   COLUMNS *cols     The columns
+            int     loop      Index of the loop in gLoopDefs[]
+            int     mode      Loop definition (LOOP_xxxx - 1)
+   Returns: BOOL              Success (FALSE if no memory)
+
+   Fills in the lowest and highest lengths of a loop in each zone.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Uses the lengths in the COLUMNS
+*/
+static BOOL FindZoneLengths(ZONEMAP *zm, COLUMNS *cols, int loop,
+                            int mode)
+{
+   ZONE *zone = NULL;
+   int  *lengths,
+        entry;
+
+   if((lengths = ColumnLengths(cols, loop, mode))==NULL)
+      return(FALSE);
+
+   for(entry=0; entry<cols->NRows; entry++)
+   {
+      if((entry % ZONESIZE) == 0)
+      {
+         zone = zm->zones + (entry / ZONESIZE);
+         zone->MinLen[loop][mode] = zone->MaxLen[loop][mode] =
+            (short)lengths[entry];
+      }
+      if(lengths[entry] < zone->MinLen[loop][mode])
+         zone->MinLen[loop][mode] = (short)lengths[entry];
+      if(lengths[entry] > zone->MaxLen[loop][mode])
+         zone->MaxLen[loop][mode] = (short)lengths[entry];
+   }
+
+   zm->HaveLength[loop][mode] = TRUE;
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static int CompareClusterKeys(const void *k1, const void *k2)
+   -------------------------------------------------------------
+   qsort() comparison for ClusterData(): by raw file index group,
+   source, class and then the original order.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Raw file index group first
+*/
+static int CompareClusterKeys(const void *k1, const void *k2)
+{
+   CLUSTERKEY *c1 = (CLUSTERKEY *)k1,
+              *c2 = (CLUSTERKEY *)k2;
+   int        cmp;
+
+   if(c1->group != c2->group)
+      return(c1->group - c2->group);
+   if((cmp = blUpstrcmp(c1->data->source, c2->data->source)) != 0)
+      return(cmp);
+   if((cmp = blUpstrcmp(c1->data->class, c2->data->class)) != 0)
+      return(cmp);
+   return(c1->order - c2->order);
+}
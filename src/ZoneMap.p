@@ -0,0 +1,10 @@
+ZONEMAP *GetZoneMap(void)
+;
+BOOL IsZoneTest(WHERE *wh)
+;
+BOOL FindZones(WHERE *wh, char **pZones, int *NZones)
+;
+BOOL ClusterData(void)
+;
+void ZoneMapMemory(MEMUSE *use)
+;
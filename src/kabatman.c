@@ -3,11 +3,11 @@
    Program:    KabatMan
    File:       kabatman.c
    
-   Version:    V2.26
-   Date:       04.10.19
+   Version:    V2.27
+   Date:       19.10.26
    Function:   Database program for reading Kabat sequence files
    
-   Copyright:  (c) UCL / Andrew C. R. Martin 1994-2019
+   Copyright:  (c) UCL / Andrew C. R. Martin 1994-2026
    Author:     Dr. Andrew C. R. Martin
    Address:    Biomolecular Structure and Modelling Unit,
                Department of Biochemistry and Molecular Biology,
@@ -41,6 +41,21 @@
             -q        Read data quietly
             -o        Read old format files
             -v        Increase verbosity level
+            -u        Rewrite the stored data file in the current format
+            -i        Update the stored data from changed Kabat files
+            -r file   Read a raw Kabat archive or directory of entries
+                      (with -i, update the stored data from it)
+            -b file   Run the benchmark queries in file and report the
+                      timings as JSON instead of reading commands
+            -n n      Number of timed runs of each benchmark query
+            -g n file Write a synthetic data set of n entries based on
+                      the data to file and exit
+            -s        Print the hot-path counters on exit
+            -t file   Write a Chrome trace of loading and searching
+            -l file   Append a log of the searches run to file
+            -memstats Print the memory report at the end of the run
+            -c        Sort the entries by source and class when the
+                      stored data are written (use with -u)
             -version  Just print version info
 
 **************************************************************************
@@ -95,6 +110,37 @@
    V2.25 24.08.06 Added SEQUENCE option which works like PIR, but writes
                   a numbered sequence file
    V2.26 04.10.19 Changed all bioplib calls to blXXX()
+   V2.27 19.10.26 Added LIMIT, OFFSET and ORDER BY to the WHERE statement
+                  Added GROUP BY, aggregate functions and SET THREADS
+                  Added SELECT DISTINCT. Chain hashes set after reading
+                  data
+                  Antigen, full source and reference moved to COLDDATA
+                  which is read on demand. Stored data file version 5.0
+                  Added -u
+                  Added -i for incremental update using a raw file index
+                  in the stored data file (version 5.1)
+                  Added -r to read a raw Kabat archive directly
+                  Data set and Chothia data allocated from arenas and
+                  freed in one go
+                  Added NormaliseData() to make the upper case and
+                  ungapped copies used for searching
+                  Writes the sequence index when the stored data are
+                  written. Added SET INDEX
+                  Added SET LSH
+                  Added -b to run a benchmark. Commands handled by
+                  HandleCommand()
+                  Added -g to generate a synthetic data set
+                  main() may be left out (-DNOMAIN) so the rest may be
+                  linked with other programs
+                  Added EXPLAIN [ANALYZE]
+                  Added SHOW STATS and -s. Loading, parsing, numbering
+                  and pairing are timed by the hot-path counters
+                  Added SET TRACE and -t. Reading the data and running
+                  searches are traced
+                  Added SET LOG and -l to log the searches run
+                  Added SHOW MEMORY and -memstats
+                  Added SET ZONEMAP and -c to cluster the stored data
+                  Added SET BATCH
 
 *************************************************************************/
 /* Includes
@@ -112,12 +158,16 @@
 
 /************************************************************************/
 /* Prototypes
+   19.10.26 Source copied with a bound
 */
 #include "protos.h"
 static BOOL doStoreData(DATA **pData, KABATENTRY *Kabat, DATA *extra,
                         char chain, BOOL allocate, char *source,
                         BOOL GotInsert);
+static BOOL DoReadStoredData(char *filename);
+static BOOL DoReadKabatData(char *FoF);
 
+#ifndef NOMAIN
 /************************************************************************/
 /*>int main(int argc, char **argv)
    -------------------------------
@@ -134,10 +184,52 @@ static BOOL doStoreData(DATA **pData, KABATENTRY *Kabat, DATA *extra,
    11.04.96 Initialise gFileDate
    14.10.98 DisplayCopyright() now takes a flag to introduce with #s
    28.02.05 blGetWord() now takes maximum word length
+   19.10.26 Calls SetChainHashes() once the data have been read
+            Added Upgrade flag (-u)
+            Added Incremental flag (-i). Discards any partly read stored
+            data before reading the Kabat files
+            Added Archive (-r) to read a raw Kabat archive directly
+            Starts a new data set (arena) before reading the Kabat files
+            and frees it at the end
+            Calls NormaliseData() once the data have been read
+            Writes the sequence index if the stored data were written
+            Added the benchmark (-b) which is run instead of the command
+            loop
+            Added generation of synthetic data (-g)
+            Initialises and times the loading of the data with the
+            hot-path counters. Added DumpStats (-s)
+            Added TraceFile (-t)
+            Added LogFile (-l)
+            Added MemStats (-memstats). The memory report is printed
+            before the data are freed
+            -u writes the sequence index before exiting since -c may
+            have changed the order of the entries
+            -r with -i updates the stored data from the archive
+            The sequence index is always written after -i
 */
 int main(int argc, char **argv)
 {
-   BOOL ForceRead = FALSE;
+   BOOL   ForceRead    = FALSE,
+          Upgrade      = FALSE,
+          Incremental  = FALSE,
+          Stored       = FALSE,
+          Upgraded     = FALSE,
+          DumpAtExit   = FALSE,
+          MemStats     = FALSE;
+   int    NChanges     = 0,
+          BenchRepeats = DEF_BENCHREPEATS;
+   long   NGenerate    = 0L;
+   char   Archive[MAXBUFF],
+          BenchFile[MAXBUFF],
+          GenFile[MAXBUFF],
+          TraceFile[MAXBUFF],
+          LogFile[MAXBUFF];
+   double StartTime;
+   STATTIMER(LoadStart)
+
+   StartTime = WallTime();
+   InitStats();
+   InitMemory();
 
    strcpy(gFOF,         DEF_FOF);
    strcpy(gKabatFile,   DEF_KABAT);
@@ -146,24 +238,102 @@ int main(int argc, char **argv)
    gInfoLevel         = DEF_INFO;
    gOldFormat         = FALSE;
    gFileDate[0]       = '\0';
+   Archive[0]         = '\0';
+   BenchFile[0]       = '\0';
+   GenFile[0]         = '\0';
+   TraceFile[0]       = '\0';
+   LogFile[0]         = '\0';
+   gCanonical[0]      = '\0';
 
    /* This causes blGetWord() to return inverted commas as part of the
       words read out of the buffer. (Default mode is to strip them.)
    */
    /*   blGetWord(NULL, NULL, 0); */
 
-   if(ParseCmdLine(argc, argv, &ForceRead))
+   STATSTART(LoadStart);
+   if(ParseCmdLine(argc, argv, &ForceRead, &Upgrade, &Incremental,
+                   Archive, BenchFile, &BenchRepeats, &NGenerate,
+                   GenFile, &DumpAtExit, TraceFile, LogFile,
+                   &MemStats))
    {
-      if(ForceRead || !ReadStoredData(gKabatFile))
+      gKeepRawIndex = (Upgrade || Incremental);
+      if(DumpAtExit)
+         atexit(DumpStats);
+      if(TraceFile[0])
+         OpenTrace(TraceFile);
+      if(LogFile[0])
+         OpenCapture(LogFile);
+      
+      if(Archive[0])
+      {
+         /* Read a raw Kabat archive without splitting it into files    */
+         if(gOldFormat)
+         {
+            fprintf(stderr,"Error: -r is not available with -o\n");
+            return(1);
+         }
+         if(!ForceRead && Incremental && ReadStoredData(gKabatFile) &&
+            UpdateKabatArchive(Archive, &NChanges))
+         {
+            if(NChanges)
+            {
+               /* Update changed the data; store with new date          */
+               gFileDate[0] = '\0';
+               if(!(Stored = StoreKabatData(gKabatFile)))
+               {
+                  fprintf(stderr,"Warning: Unable to store Kabat \
+data\n");
+               }
+            }
+         }
+         else
+         {
+            /* Discard anything read from the stored data               */
+            if(!NewDataSet() || !ReadKabatArchive(Archive))
+            {
+               fprintf(stderr,"Error: Unable to read Kabat archive\n");
+               return(1);
+            }
+            if(!(Stored = StoreKabatData(gKabatFile)))
+            {
+               fprintf(stderr,"Warning: Unable to store Kabat data\n");
+            }
+         }
+      }
+      else if(!ForceRead && ReadStoredData(gKabatFile) &&
+         (!Incremental || UpdateKabatData(gFOF, &NChanges)))
+      {
+         if(NChanges)
+         {
+            /* Incremental update changed the data; store with new date */
+            gFileDate[0] = '\0';
+            if(!(Stored = StoreKabatData(gKabatFile)))
+            {
+               fprintf(stderr,"Warning: Unable to store Kabat data\n");
+            }
+         }
+         else if(Upgrade)
+         {
+            if(!(Stored = StoreKabatData(gKabatFile)))
+            {
+               fprintf(stderr,"Error: Unable to rewrite stored data\n");
+               return(1);
+            }
+         }
+
+         Upgraded = Upgrade;
+      }
+      else
       {
-         if(!ReadKabatData(gFOF))
+         /* Discard anything read from the stored data                  */
+         if(!NewDataSet() || !ReadKabatData(gFOF))
          {
             fprintf(stderr,"Error: Unable to read Kabat data\n");
             return(1);
          }
          else
          {
-            if(!StoreKabatData(gKabatFile))
+            if(!(Stored = StoreKabatData(gKabatFile)))
             {
                fprintf(stderr,"Warning: Unable to store Kabat data\n");
             }
@@ -171,7 +341,38 @@ int main(int argc, char **argv)
       }
    }
 
-   DisplayCopyright(FALSE);
+   if(!NormaliseData(gData))
+   {
+      fprintf(stderr,"Error: No memory to prepare Kabat data\n");
+      return(1);
+   }
+   SetChainHashes(gData);
+   STATSTOP(STAT_LOAD, LoadStart);
+
+   /* The sequence index is written alongside the stored data. After an
+      incremental update it is written even if nothing changed, so that
+      the index always goes with the updated stored data file
+   */
+   if((Stored || Incremental) && (gData != NULL))
+      WriteSeqIndex(gKabatFile);
+
+   if(Upgraded)
+   {
+      FreeDataSet();
+      return(0);
+   }
+
+   if(GenFile[0])
+   {
+      /* Write a synthetic data set based on these data and exit        */
+      if(!GenerateData(GenFile, NGenerate))
+         return(1);
+      FreeDataSet();
+      return(0);
+   }
+
+   if(!BenchFile[0])
+      DisplayCopyright(FALSE);
    
    if(!ReadChothiaData(gChothiaFile))
    {
@@ -179,10 +380,25 @@ int main(int argc, char **argv)
 not available.\n\n");
    }
    
-   CommandLoop();
+   if(BenchFile[0])
+   {
+      if(!RunBenchmark(BenchFile, BenchRepeats, WallTime() - StartTime))
+         return(1);
+   }
+   else
+   {
+      CommandLoop();
+   }
+
+   if(MemStats)
+      ShowMemory(stderr);
+
+   FreeDataSet();
+   FreeArena(gChothiaArena);
    
    return(0);
 }
+#endif
 
 
 /************************************************************************/
@@ -221,16 +437,17 @@ not available.\n\n");
    28.02.05 V2.24
    24.08.06 V2.25
    04.10.19 V2.26
+   19.10.26 V2.27
 */
 void DisplayCopyright(BOOL DoHash)
 {
    printf("\n");
    if(DoHash) printf("# ");
-   printf("KabatMan V2.26\n");
+   printf("KabatMan V2.27\n");
    if(DoHash) printf("# ");
    printf("==============\n");
    if(DoHash) printf("# ");
-   printf("Copyright (c) 1994-2019, Dr. Andrew C.R. Martin / University \
+   printf("Copyright (c) 1994-2026, Dr. Andrew C.R. Martin / University \
 College London / University of Reading.\n");
    if(DoHash) printf("# ");
    printf("This program is copyright. Any copying without the permission \
@@ -241,13 +458,32 @@ of the\n");
 
 
 /************************************************************************/
-/*>BOOL ParseCmdLine(int argc, char **argv, BOOL *ForceRead)
-   ---------------------------------------------------------
+/*>BOOL ParseCmdLine(int argc, char **argv, BOOL *ForceRead,
+                     BOOL *Upgrade, BOOL *Incremental, char *Archive,
+                     char *BenchFile, int *BenchRepeats,
+                     long *NGenerate, char *GenFile, BOOL *DumpAtExit,
+                     char *TraceFile, char *LogFile, BOOL *MemStats)
+   ------------------------------------------------------------------
    Input:   int   argc         Number of arguments
             char  **argv       Argument list
    Output:  BOOL  *ForceRead   Force reading of Kabat files? (-f)
+            BOOL  *Upgrade     Rewrite the stored data file? (-u)
+            BOOL  *Incremental Update the stored data from changed
+                               Kabat files? (-i)
+            char  *Archive     Raw Kabat archive or directory of entry
+                               files to read (-r)
+            char  *BenchFile   File of benchmark queries to run (-b)
+            int   *BenchRepeats Timed runs of each query (-n)
+            long  *NGenerate   Number of synthetic entries (-g)
+            char  *GenFile     File for the synthetic data (-g)
+            BOOL  *DumpAtExit  Print the hot-path counters on exit? (-s)
+            char  *TraceFile   File for a Chrome trace (-t)
+            char  *LogFile     File to log the searches to (-l)
+            BOOL  *MemStats    Print the memory report at the end?
+                               (-memstats)
    Globals: int   gInfoLevel   Information level (-q, -v)
             BOOL  gOldFormat   Old Kabat dump format
+            BOOL  gClusterData Sort the stored data (-c)
    Returns: BOOL               Success?
 
    Parses the command line.
@@ -258,8 +494,18 @@ of the\n");
    21.07.94 Changed OldFormat to a global variable.
    16.03.95 Added -version handling
    11.04.96 Also allow --version (Posix standard for long flags)
+   19.10.26 Added -u, -i and -r
+            Added -b, -n and -g
+            Added -s and -t
+            Added -l
+            Added -memstats
+            Added -c
 */
-BOOL ParseCmdLine(int argc, char **argv, BOOL *ForceRead)
+BOOL ParseCmdLine(int argc, char **argv, BOOL *ForceRead,
+                  BOOL *Upgrade, BOOL *Incremental, char *Archive,
+                  char *BenchFile, int *BenchRepeats,
+                  long *NGenerate, char *GenFile, BOOL *DumpAtExit,
+                  char *TraceFile, char *LogFile, BOOL *MemStats)
 {
    int i;
    
@@ -287,6 +533,82 @@ BOOL ParseCmdLine(int argc, char **argv, BOOL *ForceRead)
          case 'F':
             *ForceRead = TRUE;
             break;
+         case 'u':              /* Upgrade the stored data file         */
+         case 'U':
+            *Upgrade = TRUE;
+            break;
+         case 'i':              /* Incremental update from Kabat files  */
+         case 'I':
+            *Incremental = TRUE;
+            break;
+         case 'r':              /* Read a raw Kabat archive             */
+         case 'R':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            strncpy(Archive, argv[0], MAXBUFF-1);
+            Archive[MAXBUFF-1] = '\0';
+            break;
+         case 'b':              /* Run a benchmark                      */
+         case 'B':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            strncpy(BenchFile, argv[0], MAXBUFF-1);
+            BenchFile[MAXBUFF-1] = '\0';
+            break;
+         case 'n':              /* Timed runs of each benchmark query   */
+         case 'N':
+            argc--;
+            argv++;
+            if(!argc || (sscanf(argv[0],"%d",BenchRepeats) != 1) ||
+               (*BenchRepeats < 1))
+               return(FALSE);
+            break;
+         case 'g':              /* Generate synthetic data              */
+         case 'G':
+            argc--;
+            argv++;
+            if((argc < 2) || (sscanf(argv[0],"%ld",NGenerate) != 1) ||
+               (*NGenerate < 1))
+               return(FALSE);
+            argc--;
+            argv++;
+            strncpy(GenFile, argv[0], MAXBUFF-1);
+            GenFile[MAXBUFF-1] = '\0';
+            break;
+         case 's':              /* Print the hot-path counters on exit  */
+         case 'S':
+            *DumpAtExit = TRUE;
+            break;
+         case 't':              /* Write a Chrome trace                 */
+         case 'T':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            strncpy(TraceFile, argv[0], MAXBUFF-1);
+            TraceFile[MAXBUFF-1] = '\0';
+            break;
+         case 'l':              /* Log the searches                     */
+         case 'L':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            strncpy(LogFile, argv[0], MAXBUFF-1);
+            LogFile[MAXBUFF-1] = '\0';
+            break;
+         case 'm':              /* Print the memory report (-memstats)  */
+         case 'M':
+            *MemStats = TRUE;
+            break;
+         case 'c':              /* Cluster the stored data              */
+         case 'C':
+            gClusterData = TRUE;
+            break;
          case 'o':              /* Read old format files                */
          case 'O':
             gOldFormat = TRUE;
@@ -317,11 +639,149 @@ BOOL ParseCmdLine(int argc, char **argv, BOOL *ForceRead)
 }
 
 
+/************************************************************************/
+/*>BOOL NewDataSet(void)
+   ---------------------
+   Returns: BOOL                Success
+   Globals: DATA  *gData        Data linked list (set to NULL)
+            ARENA *gDataArena   Arena for the data (replaced)
+
+   Discards the current data set and starts a new, empty one.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL NewDataSet(void)
+{
+   FreeDataSet();
+   if((gDataArena = NewArena(DATAARENABLOCK))==NULL)
+   {
+      fprintf(stderr,"Error: No memory for Kabat data\n");
+      return(FALSE);
+   }
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void FreeDataSet(void)
+   ----------------------
+   Globals: DATA  *gData        Data linked list (set to NULL)
+            ARENA *gDataArena   Arena for the data (freed)
+            SEQINDEX *gSeqIndex Sequence index (set to NULL)
+            COLUMNS  *gColumns  Columns (set to NULL)
+            ZONEMAP  *gZoneMap  Zone map (set to NULL)
+
+   Frees the current data set. The DATA linked list, numbering, cold
+   fields, sequence index, columns and zone map all live in gDataArena
+   so this is a single FreeArena().
+
+   19.10.26 Original    By: ACRM
+*/
+void FreeDataSet(void)
+{
+   CloseColdData();
+   FreeArena(gDataArena);
+   gDataArena = NULL;
+   gData      = NULL;
+   gSeqIndex  = NULL;
+   gColumns   = NULL;
+   gZoneMap   = NULL;
+}
+
+
+/************************************************************************/
+/*>BOOL NormaliseData(DATA *data)
+   ------------------------------
+   I/O:     DATA  *data        Data linked list
+   Returns: BOOL               Success (FALSE if no memory)
+   Globals: ARENA *gDataArena  Arena for the data
+
+   Prepares the data for searching once they have been read. The source,
+   accession codes and sequences are converted to upper case in place
+   (they are normally upper case already). Upper case copies of the
+   name and class (which are displayed as given) and copies of the
+   chains with the -'s removed are made, and the number of residues in
+   each chain is stored. String comparisons can then be done without
+   changing or copying the data.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL NormaliseData(DATA *data)
+{
+   DATA *d;
+   int  i,
+        j;
+
+   for(d=data; d!=NULL; NEXT(d))
+   {
+      UPPER(d->source);
+      UPPER(d->idlight);
+      UPPER(d->idheavy);
+      UPPER(d->light);
+      UPPER(d->heavy);
+
+      if(((d->UpperName = (char *)ArenaAlloc(gDataArena,
+                                             strlen(d->name)+1))==NULL) ||
+         ((d->UpperClass = (char *)ArenaAlloc(gDataArena,
+                                              strlen(d->class)+1))==NULL) ||
+         ((d->UngappedLight = (char *)ArenaAlloc(gDataArena,
+                                                 strlen(d->light)+1))
+          ==NULL) ||
+         ((d->UngappedHeavy = (char *)ArenaAlloc(gDataArena,
+                                                 strlen(d->heavy)+1))
+          ==NULL))
+         return(FALSE);
+
+      strcpy(d->UpperName,  d->name);
+      strcpy(d->UpperClass, d->class);
+      UPPER(d->UpperName);
+      UPPER(d->UpperClass);
+
+      for(i=0, j=0; d->light[i]; i++)
+         if(d->light[i] != '-') d->UngappedLight[j++] = d->light[i];
+      d->UngappedLight[j] = '\0';
+
+      for(i=0, j=0; d->heavy[i]; i++)
+         if(d->heavy[i] != '-') d->UngappedHeavy[j++] = d->heavy[i];
+      d->UngappedHeavy[j] = '\0';
+
+      d->LightLen = blTrueSeqLen(d->light);
+      d->HeavyLen = blTrueSeqLen(d->heavy);
+   }
+
+   return(TRUE);
+}
+
+
 /************************************************************************/
 /*>BOOL ReadStoredData(char *filename)
    -----------------------------------
    Input:   char  *filename     Name of datafile
    Returns: BOOL                Success
+
+   Reads the stored data with DoReadStoredData() tracing it as one
+   span.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Source copied with a bound
+*/
+BOOL ReadStoredData(char *filename)
+{
+   BOOL ok;
+
+   TraceBegin(0, "ReadStoredData", filename);
+   ok = DoReadStoredData(filename);
+   TraceEnd(0);
+
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static BOOL DoReadStoredData(char *filename)
+   --------------------------------------------
+   Input:   char  *filename     Name of datafile
+   Returns: BOOL                Success
    Globals: DATA  *gData        Linked list containing read data (output)
 
    Read data stored in our own internal format.
@@ -339,17 +799,32 @@ BOOL ParseCmdLine(int argc, char **argv, BOOL *ForceRead)
    11.04.96 Skip comment lines from start of file, but reads date from
             them if found
    03.04.02 Added reference date reading
+   19.10.26 Reads file version 5.0 in which the antigen, fsource and
+            reference are in a separate !COLD section at the end of the
+            file. This section is not read here; the file is left open
+            so the fields can be read when needed. Version 4.0 files are
+            still read as before
+            Reads the raw file index of version 5.1 files if 
+            gKeepRawIndex is set
+            Starts a new data set and allocates from its arena
+            Renamed from ReadStoredData() which now traces it
 */
-BOOL ReadStoredData(char *filename)
+static BOOL DoReadStoredData(char *filename)
 {
    DATA *p = NULL;
    FILE *fp;
    char buffer[SEQBUFF],
         FileBuff[MAXBUFF],
+        fsource[SEQBUFF],
+        antigen[SEQBUFF],
         *kabatdir,
         *ptr;
-   int  line = 0;
-   BOOL StartOfFile = TRUE;
+   int  line = 0,
+        field,
+        V5Fields[] = {0, 1, 3, 4, 7, 14, 8, 9, 10, 11, 12, 13};
+   REAL version = 0.0;
+   BOOL StartOfFile = TRUE,
+        GotCold     = FALSE;
    
    /* Open the data file                                                */
    if((fp=fopen(filename,"r"))==NULL)
@@ -365,9 +840,11 @@ BOOL ReadStoredData(char *filename)
    }
 
    /* Free any currently stored data                                    */
-   if(gData != NULL)
-      FREELIST(gData,DATA);
-   gData = NULL;
+   if(!NewDataSet())
+   {
+      fclose(fp);
+      return(FALSE);
+   }
    
    /* Now read the file into a new data linked list                     */
    while(fgets(buffer,SEQBUFF,fp))
@@ -384,11 +861,29 @@ BOOL ReadStoredData(char *filename)
                ptr += 6;
                strncpy(gFileDate,ptr,MAXBUFF);
             }
+            else if((ptr=strstr(buffer,"VERSION: "))!=NULL)
+            {
+               sscanf(ptr+9,"%lf",&version);
+            }
             
             continue;
          }
       }
 
+      /* The cold section is read on demand                             */
+      if(!strncmp(buffer,"!COLD",5))
+      {
+         GotCold = TRUE;
+         break;
+      }
+
+      /* The raw file index (version 5.1) precedes the cold section     */
+      if(!strncmp(buffer,"!RAWINDEX",9))
+      {
+         GotCold = ReadRawIndex(fp, gKeepRawIndex);
+         break;
+      }
+
       /* Check for start of new record and allocate space if found      */
       if(buffer[0] == '>')
       {
@@ -398,48 +893,68 @@ BOOL ReadStoredData(char *filename)
 
          if(gData == NULL)
          {
-            INIT(gData, DATA);
+            ARENAINIT(gDataArena, gData, DATA);
             p = gData;
          }
          else
          {
-            ALLOCNEXT(p,DATA);
+            ARENANEXT(gDataArena, p, DATA);
          }
          
          if(p==NULL)
          {
             fprintf(stderr,"Error: Unable to allocate memory for stored \
 data.\n");
+            fclose(fp);
             return(FALSE);
          }
 
          p->LNumbers = p->HNumbers = NULL;
          p->light[0] = p->heavy[0] = '\0';
+         p->cold       = NULL;
+         p->ColdOffset = (-1L);
       }
       else
       {
          line++;
       }
+
+      /* Version 5.0 files don't have the cold fields (lines 2, 5 and 6
+         of version 4.0) but have the offset of the entry's record in
+         the !COLD section after the date. V5Fields[] converts to the
+         equivalent line of a version 4.0 file with 14 for the offset
+      */
+      field = line;
+      if(version >= 5.0)
+         field = (line < 12) ? V5Fields[line] : 0;
       
-      switch(line)
+      switch(field)
       {
       case 1:
          strcpy(p->name,       buffer);
          break;
       case 2:
-         strcpy(p->fsource,    buffer);
+         strcpy(fsource,       buffer);
          break;
       case 3:
-         strcpy(p->source,     buffer);
+         strncpy(p->source,    buffer, MAXBUFF-1);
+         p->source[MAXBUFF-1] = '\0';
          break;
       case 4:
          strcpy(p->class,      buffer);
          break;
       case 5:
-         strcpy(p->antigen,    buffer);
+         strcpy(antigen,       buffer);
          break;
       case 6:
-         strcpy(p->reference,  buffer);
+         if((p->cold = NewColdData(gDataArena, antigen, fsource,
+                                   buffer))==NULL)
+         {
+            fprintf(stderr,"Error: Unable to allocate memory for stored \
+data.\n");
+            fclose(fp);
+            return(FALSE);
+         }
          break;
       case 7:
          if(!sscanf(buffer, "%d", &(p->refdate)) || (p->refdate == 0))
@@ -449,10 +964,12 @@ data.\n");
          if(buffer[0] != '*')
          {
             /* We've got a special numbering scheme                     */
-            if((p->LNumbers = ReadSpecialNumbering(buffer))==NULL)
+            if((p->LNumbers = ReadSpecialNumbering(gDataArena,
+                                                     buffer))==NULL)
             {
                fprintf(stderr,"Error: Unable to allocate memory for \
 Kabat numbering of stored data\n");
+               fclose(fp);
                return(FALSE);
             }
          }
@@ -461,10 +978,12 @@ Kabat numbering of stored data\n");
          if(buffer[0] != '*')
          {
             /* We've got a special numbering scheme                     */
-            if((p->HNumbers = ReadSpecialNumbering(buffer))==NULL)
+            if((p->HNumbers = ReadSpecialNumbering(gDataArena,
+                                                     buffer))==NULL)
             {
                fprintf(stderr,"Error: Unable to allocate memory for \
 Kabat numbering of stored data\n");
+               fclose(fp);
                return(FALSE);
             }
          }
@@ -481,19 +1000,27 @@ Kabat numbering of stored data\n");
       case 13:
          strcpy(p->idheavy,    buffer);
          break;
+      case 14:
+         sscanf(buffer,"%ld",&(p->ColdOffset));
+         break;
       default:
          break;
       }
    }
 
-   fclose(fp);
+   if(GotCold)
+      OpenColdData(fp, ftell(fp));
+   else
+      fclose(fp);
+   
    return(TRUE);
 }
 
 
 /************************************************************************/
-/*>char **ReadSpecialNumbering(char *buffer)
-   -----------------------------------------
+/*>char **ReadSpecialNumbering(ARENA *arena, char *buffer)
+   -------------------------------------------------------
+   I/O:     ARENA *arena       Arena from which to allocate
    Input:   char  *buffer      Buffer read from data file
    Returns: char  **           Array of pointers to char containing
                                the residue numbers. NULL if error.
@@ -504,15 +1031,17 @@ Kabat numbering of stored data\n");
    have occurred over the standard Kabat scheme.
 
    25.04.94 Original    By: ACRM
+   19.10.26 Allocates from an arena
 */
-char **ReadSpecialNumbering(char *buffer)
+char **ReadSpecialNumbering(ARENA *arena, char *buffer)
 {
    char **NumBuff = NULL,
         *np       = NULL,
         *numbers  = buffer;
    int  i         = 0;
    
-   if((NumBuff = (char **)malloc(MAXKABATSEQ * sizeof(char *)))==NULL)
+   if((NumBuff = (char **)ArenaAlloc(arena, MAXKABATSEQ * sizeof(char *)))
+      ==NULL)
       return(NULL);
    
    while((np = strchr(numbers,' ')) != NULL)
@@ -525,16 +1054,8 @@ char **ReadSpecialNumbering(char *buffer)
          break;
 
       /* Allocate space to store number                                 */
-      if((NumBuff[i] = (char *)malloc(5 * sizeof(char)))==NULL)
-      {
-         /* Error in allocation. Free up memory and return              */
-         int j;
-         
-         for(j=0; j<i; j++)
-            free(NumBuff[j]);
-         free(NumBuff);
+      if((NumBuff[i] = (char *)ArenaAlloc(arena, 5 * sizeof(char)))==NULL)
          return(NULL);
-      }
       
       /* Copy in the number                                             */
       strcpy(NumBuff[i],numbers);
@@ -558,6 +1079,7 @@ char **ReadSpecialNumbering(char *buffer)
    Input:   char   *filename    Filename to write
    Returns: BOOL                Success in opening file?
    Globals: DATA   gData        The Kabat data linked list (input)
+            BOOL   gClusterData Sort the entries first? (-c)
 
    Writes the data contained in the global data linked list to a file
 
@@ -568,64 +1090,51 @@ char **ReadSpecialNumbering(char *buffer)
    11.04.96 Writes comment lines at the top which include the date of
             writing and the file format version
    03.04.02 Added refdate field. Bumped file version number
+   19.10.26 Writes file version 5.0 with the antigen, fsource and 
+            reference in a separate !COLD section at the end of the file.
+            Only sets the date if it is not already set
+            Writes the raw file index. Bumped file version to 5.1
+            Header and entries written by WriteStoredHeader() and
+            WriteStoredEntry()
+            Sorts the entries with ClusterData() for -c
 */
 BOOL StoreKabatData(char *filename)
 {
    DATA   *p;
    FILE   *fp;
-   int    i;
-   time_t TheTime;
+   long   ColdOffset = 0L;
 
    if(gData != NULL)
    {
+      /* Make sure we have all the cold fields before the file is
+         overwritten since we may be reading them from it
+      */
+      if(!LoadAllColdData())
+         return(FALSE);
+
+      /* Put entries with the same source and class together so the
+         zone maps can skip them
+      */
+      if(gClusterData)
+         ClusterData();
+      
       if((fp=fopen(filename,"w"))==NULL)
       {
          fprintf(stderr,"Warning: Unable to open file %s\n",filename);
          return(FALSE);
       }
 
-      /* Determine the current date                                     */
-      time(&TheTime);
-      strcpy(gFileDate, ctime(&TheTime));
-      TERMINATE(gFileDate);
+      WriteStoredHeader(fp);
+      for(p=gData; p!=NULL; NEXT(p))
+         ColdOffset += WriteStoredEntry(fp, p, ColdOffset);
 
-      /* Put a header into the file including a date stamp              */
-      fprintf(fp,"! KabatMan data file.\n");
-      fprintf(fp,"! KabatMan is Copyright 1994-2002, \
-Dr. Andrew C.R. Martin / UCL / University of Reading\n");
-      fprintf(fp,"! FILE VERSION: 4.0\n");
-      fprintf(fp,"! CREATION DATE: %s\n",gFileDate);
-      fprintf(fp,"!\n");
-      
+      /* The raw file index for incremental updates                     */
+      WriteRawIndex(fp);
+
+      /* Now the cold fields                                            */
+      fprintf(fp,"!COLD\n");
       for(p=gData; p!=NULL; NEXT(p))
-      {
-         fprintf(fp,">\n");
-         fprintf(fp,"%s\n",p->name);
-         fprintf(fp,"%s\n",p->fsource);
-         fprintf(fp,"%s\n",p->source);
-         fprintf(fp,"%s\n",p->class);
-         fprintf(fp,"%s\n",p->antigen);
-         fprintf(fp,"%s\n",p->reference);
-         fprintf(fp,"%d\n",p->refdate);
-
-         if(p->LNumbers)
-         {
-            for(i=0; p->LNumbers[i]!=NULL; i++)
-               fprintf(fp,"%s ",p->LNumbers[i]);
-         }
-         fprintf(fp,"*\n");
-         if(p->HNumbers)
-         {
-            for(i=0; p->HNumbers[i]!=NULL; i++)
-               fprintf(fp,"%s ",p->HNumbers[i]);
-         }
-         fprintf(fp,"*\n");
-         
-         fprintf(fp,"%s\n",p->light);
-         fprintf(fp,"%s\n",p->heavy);
-         fprintf(fp,"%s\n",p->idlight);
-         fprintf(fp,"%s\n",p->idheavy);
-      }
+         WriteColdData(fp, p);
       
       fclose(fp);
    }
@@ -634,10 +1143,113 @@ Dr. Andrew C.R. Martin / UCL / University of Reading\n");
 }
 
 
+/************************************************************************/
+/*>void WriteStoredHeader(FILE *fp)
+   --------------------------------
+   Input:   FILE   *fp          Stored data file
+   Globals: char   gFileDate[]  Date of the data (set to now if blank)
+
+   Writes the comment lines at the top of the stored data file which
+   give the file format version and the date.
+
+   19.10.26 Original (from StoreKabatData())   By: ACRM
+*/
+void WriteStoredHeader(FILE *fp)
+{
+   time_t TheTime;
+
+   /* Determine the current date                                        */
+   if(!gFileDate[0])
+   {
+      time(&TheTime);
+      strcpy(gFileDate, ctime(&TheTime));
+      TERMINATE(gFileDate);
+   }
+
+   /* Put a header into the file including a date stamp                 */
+   fprintf(fp,"! KabatMan data file.\n");
+   fprintf(fp,"! KabatMan is Copyright 1994-2026, \
+Dr. Andrew C.R. Martin / UCL / University of Reading\n");
+   fprintf(fp,"! FILE VERSION: 5.1\n");
+   fprintf(fp,"! CREATION DATE: %s\n",gFileDate);
+   fprintf(fp,"!\n");
+}
+
+
+/************************************************************************/
+/*>long WriteStoredEntry(FILE *fp, DATA *p, long ColdOffset)
+   ---------------------------------------------------------
+   Input:   FILE   *fp          Stored data file
+            DATA   *p           Entry to write
+            long   ColdOffset   Offset of the entry's record in the
+                                !COLD section
+   Returns: long                Size of the entry's !COLD record
+
+   Writes an entry to the stored data file. The cold fields are
+   written separately with WriteColdData().
+
+   19.10.26 Original (from StoreKabatData())   By: ACRM
+*/
+long WriteStoredEntry(FILE *fp, DATA *p, long ColdOffset)
+{
+   int i;
+
+   fprintf(fp,">\n");
+   fprintf(fp,"%s\n",p->name);
+   fprintf(fp,"%s\n",p->source);
+   fprintf(fp,"%s\n",p->class);
+   fprintf(fp,"%d\n",p->refdate);
+   fprintf(fp,"%ld\n",ColdOffset);
+
+   if(p->LNumbers)
+   {
+      for(i=0; p->LNumbers[i]!=NULL; i++)
+         fprintf(fp,"%s ",p->LNumbers[i]);
+   }
+   fprintf(fp,"*\n");
+   if(p->HNumbers)
+   {
+      for(i=0; p->HNumbers[i]!=NULL; i++)
+         fprintf(fp,"%s ",p->HNumbers[i]);
+   }
+   fprintf(fp,"*\n");
+   
+   fprintf(fp,"%s\n",p->light);
+   fprintf(fp,"%s\n",p->heavy);
+   fprintf(fp,"%s\n",p->idlight);
+   fprintf(fp,"%s\n",p->idheavy);
+
+   return(WriteColdData(NULL, p));
+}
+
+
 /************************************************************************/
 /*>BOOL ReadKabatData(char *FoF)
    -----------------------------
    Input:   char *FoF        Kabat file of files
+   Returns: BOOL             Success?
+
+   Reads the Kabat data files with DoReadKabatData() tracing it as one
+   span.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL ReadKabatData(char *FoF)
+{
+   BOOL ok;
+
+   TraceBegin(0, "ReadKabatData", FoF);
+   ok = DoReadKabatData(FoF);
+   TraceEnd(0);
+
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static BOOL DoReadKabatData(char *FoF)
+   --------------------------------------
+   Input:   char *FoF        Kabat file of files
    Globals: BOOL gOldFormat  Read old format Kabat files
    Returns: BOOL             Success?
    Globals: DATA *gData      Data linked list
@@ -662,8 +1274,13 @@ Dr. Andrew C.R. Martin / UCL / University of Reading\n");
    21.07.94 Made OldFormat global
    11.04.96 On skipped chains, also print accession code
    28.02.05 blGetWord() now takes max word length
+   19.10.26 Records each group of files in the raw file index
+            Reading and pairing of a group moved to ReadKabatGroup().
+            No longer closes a NULL heavy chain file when the group has
+            no heavy chain file
+            Renamed from ReadKabatData() which now traces it
 */
-BOOL ReadKabatData(char *FoF)
+static BOOL DoReadKabatData(char *FoF)
 {
    char       buffer[MAXBUFF],
               FileBuff[MAXBUFF],
@@ -671,21 +1288,21 @@ BOOL ReadKabatData(char *FoF)
               HFile[160],
               LFile[MAXLFILES][160],
               *p = buffer,
-              source[MAXBUFF];
+              source[MAXBUFF],
+              spec[MAXBUFF];
    FILE       *fp = NULL,
               *fpH = NULL,
               *fpL[MAXLFILES];
    int        NLFile = 0,
               i,
-              LCClass[MAXLFILES],
-              nseq;
-   KABATENTRY KabatH;
-   DATA       *KabatLData[MAXLFILES];
-   BOOL       GotInsert;
+              LCClass[MAXLFILES];
    
    /* Get the Kabat directory environment for future use                */
    KabatDir = getenv(ENV_KABATDIR);
 
+   /* Start a new raw file index                                        */
+   FreeRawIndex();
+
    /* Open Kabat file of files for reading                              */
    if((fp=fopen(FoF,"r"))==NULL)
    {
@@ -712,6 +1329,7 @@ BOOL ReadKabatData(char *FoF)
       if(strlen(p))
       {
          if(gInfoLevel >= 1) printf("Processing files: %s\n",p);
+         strcpy(spec, p);
          
          /* Got a line specifying a group of files                      */
          p = buffer;
@@ -787,54 +1405,19 @@ file: `%s'\n", LFile[NLFile]);
          else
             GetSource(LFile[0], source);
 
-         /* Read data in from the light chain files                     */
-         if(!ReadLFiles(fpL, NLFile, KabatLData, source, LCClass))
-         {
-            fprintf(stderr,"Error: Failed to make temporary store for \
-L-chain data\n");
-            fclose(fp);
-            return(FALSE);
-         }
-      
-         if(fpH)            /* If we have a heavy chain file            */
-         {
-            /* Read entries from the heavy chain file                   */
-            while((nseq=ReadNextKabatEntry(fpH,&KabatH,&GotInsert,
-                                           gOldFormat)) != 0)
-            {
-               if(nseq == (-1))
-               {
-                  if(gInfoLevel >= 1)
-                     printf("Skipped H chain for %s (%s)\n", 
-                            KabatH.aaname, KabatH.kadbid);
-               }
-               else if(nseq > MINSEQ)
-               {
-                  /* Store entry and search for matching light chain    */
-                  if((gData = StoreHAndMatchL(gData, KabatH, KabatLData,
-                                              NLFile, source, GotInsert))
-                     ==(DATA *)(-1))
-                  {
-                     fprintf(stderr,"Error: Failed to store H-chain \
-data\n");
-                     fclose(fp);
-                     return(FALSE);
-                  }
-               }
-            }
-         }
-      
-         /* Store any unmatched light chain entries                     */
-         if((gData = StoreUnmatchedL(gData, KabatLData,
-                                     NLFile, source))==(DATA *)(-1))
+         /* Read and pair the entries from these files                  */
+         if(!ReadKabatGroup(fpH, fpL, NLFile, source, LCClass))
          {
-            fprintf(stderr,"Error: Failed to store L-chain data\n");
             fclose(fp);
             return(FALSE);
          }
          
          /* Close files                                                 */
-         fclose(fpH);
+         if(fpH != NULL)
+         {
+            fclose(fpH);
+            fpH = NULL;
+         }
          
          for(i=0; i<NLFile; i++)
          {
@@ -842,9 +1425,8 @@ data\n");
             fpL[i] = NULL;
          }
 
-         /* Free memory for the L files                                 */
-         for(i=0; i<NLFile; i++)
-            FREELIST(KabatLData[i], DATA);
+         /* Add these files to the raw file index                       */
+         RecordRawGroup(spec, gData);
          
       }  /* Not a blank line in the file                                */
    }  /* while() line in File of files                                  */
@@ -854,6 +1436,98 @@ data\n");
 }
 
 
+/************************************************************************/
+/*>BOOL ReadKabatGroup(FILE *fpH, FILE **fpL, int NLFile, char *source,
+                       int *LCClass)
+   --------------------------------------------------------------------
+   Input:   FILE  *fpH        Heavy chain file (or NULL)
+            FILE  **fpL       Array of light chain files
+            int   NLFile      Number of light chain files
+            char  *source     Source from the file names
+            int   *LCClass    Array of light chain classes
+   Returns: BOOL              Success?
+   Globals: BOOL gOldFormat   Read old format Kabat files
+            DATA *gData       Data linked list
+
+   Reads a group of heavy and light chain files for one species, pairs
+   the heavy and light chains and adds them to gData. The files are
+   left open.
+
+   19.10.26 Original - split out of ReadKabatData() so raw Kabat
+            archives can be read without writing the files    By: ACRM
+   19.10.26 The temporary light chain lists are allocated from an arena
+            which is freed once the group has been paired
+            Uses ParseNextKabatEntry()
+            The group, reading the light chains and pairing are traced
+*/
+BOOL ReadKabatGroup(FILE *fpH, FILE **fpL, int NLFile, char *source,
+                    int *LCClass)
+{
+   int        nseq;
+   KABATENTRY KabatH;
+   DATA       *KabatLData[MAXLFILES];
+   BOOL       GotInsert,
+              ok = TRUE;
+   ARENA      *LArena;
+
+   TraceBegin(0, "ReadKabatGroup", source);
+
+   /* Read data in from the light chain files                           */
+   TraceBegin(0, "ReadLFiles", source);
+   if(((LArena = NewArena(DATAARENABLOCK))==NULL) ||
+      !ReadLFiles(LArena, fpL, NLFile, KabatLData, source, LCClass))
+   {
+      fprintf(stderr,"Error: Failed to make temporary store for \
+L-chain data\n");
+      ok = FALSE;
+   }
+   TraceEnd(0);
+      
+   TraceBegin(0, "StoreHAndMatchL", source);
+   if(ok && fpH)            /* If we have a heavy chain file            */
+   {
+      /* Read entries from the heavy chain file                         */
+      while((nseq=ParseNextKabatEntry(fpH,&KabatH,&GotInsert,
+                                      gOldFormat)) != 0)
+      {
+         if(nseq == (-1))
+         {
+            if(gInfoLevel >= 1)
+               printf("Skipped H chain for %s (%s)\n", 
+                      KabatH.aaname, KabatH.kadbid);
+         }
+         else if(nseq > MINSEQ)
+         {
+            /* Store entry and search for matching light chain          */
+            if((gData = StoreHAndMatchL(gData, KabatH, KabatLData,
+                                        NLFile, source, GotInsert))
+               ==(DATA *)(-1))
+            {
+               fprintf(stderr,"Error: Failed to store H-chain data\n");
+               ok = FALSE;
+               break;
+            }
+         }
+      }
+   }
+      
+   /* Store any unmatched light chain entries                           */
+   if(ok && (gData = StoreUnmatchedL(gData, KabatLData,
+                                     NLFile, source))==(DATA *)(-1))
+   {
+      fprintf(stderr,"Error: Failed to store L-chain data\n");
+      ok = FALSE;
+   }
+   TraceEnd(0);
+         
+   /* Free memory for the L files                                       */
+   FreeArena(LArena);
+
+   TraceEnd(0);
+   return(ok);
+}
+
+
 /************************************************************************/
 /*>BOOL StoreKabatInData(DATA **pData, KABATENTRY Kabat, char chain,
                          char *source, BOOL GotInsert)
@@ -980,6 +1654,7 @@ void AddDataToData(DATA *Data, DATA *Extra, char chain)
             Ensures light and heavy chains set to NULL
    18.07.94 Only copies source name in if not VARIOUS
    02.04.96 Initialises new id strings to NULL
+   19.10.26 Allocates from gDataArena
 */
 static BOOL doStoreData(DATA **pData, KABATENTRY *Kabat, DATA *extra,
                         char chain, BOOL allocate, char *source,
@@ -993,12 +1668,12 @@ static BOOL doStoreData(DATA **pData, KABATENTRY *Kabat, DATA *extra,
       {
          if(*pData == NULL)
          {
-            INIT((*pData), DATA);
+            ARENAINIT(gDataArena, (*pData), DATA);
             p = *pData;
          }
          else
          {
-            ALLOCNEXT(p,DATA);
+            ARENANEXT(gDataArena, p, DATA);
          }
 
          if(p!=NULL)
@@ -1018,7 +1693,10 @@ static BOOL doStoreData(DATA **pData, KABATENTRY *Kabat, DATA *extra,
    if(Kabat != NULL || extra != NULL)
    {
       if(source != NULL && blUpstrncmp(source,"VARIOUS",7))
-         strcpy(p->source, source);
+      {
+         strncpy(p->source, source, MAXBUFF-1);
+         p->source[MAXBUFF-1] = '\0';
+      }
       
       UPPER(p->source);
    }
@@ -1056,16 +1734,21 @@ static BOOL doStoreData(DATA **pData, KABATENTRY *Kabat, DATA *extra,
    21.07.94 Now uses RefCheck() rather than NameCheck(). This allows
             multiple references
    23.06.95 Removed redundant variables
+   19.10.26 Reference obtained with GetColdData()
+            Search for the light chain timed by STAT_PAIR
 */
 DATA *StoreHAndMatchL(DATA *Data, KABATENTRY KabatH, DATA *KabL[], 
                       int NLFile, char *source, BOOL GotInsert)
 {
    int        i;
    DATA       *p;
+   STATTIMER(start)
    
    if(!StoreKabatInData(&Data, KabatH, 'H', source, GotInsert))
       return((DATA *)(-1));
 
+   STATSTART(start);
+
    if(gInfoLevel >= 2)
       printf("Stored H chain for %s\n", KabatH.aaname);
    
@@ -1076,7 +1759,7 @@ DATA *StoreHAndMatchL(DATA *Data, KABATENTRY KabatH, DATA *KabL[],
       for(p=KabL[i]; p!=NULL; NEXT(p))
       {
          if(!strcmp(KabatH.aaname, p->name) && 
-            RefCheck(KabatH.reference, p->reference))
+            RefCheck(KabatH.reference, GetColdData(p)->reference))
          {
             /* This light chain entry matches the heavy chain entry     */
             AddDataToData(Data, p, 'L');
@@ -1086,11 +1769,14 @@ DATA *StoreHAndMatchL(DATA *Data, KABATENTRY KabatH, DATA *KabL[],
 
             /* Flag this one as used                                    */
             p->active[0] = TRUE;
+            STATAMOUNT(STAT_PAIR, 1);
+            STATSTOP(STAT_PAIR, start);
             return(Data);
          }
       }
    }
    
+   STATSTOP(STAT_PAIR, start);
    return(Data);
 }
 
@@ -1162,16 +1848,25 @@ DATA *StoreUnmatchedL(DATA *Data, DATA *KabL[], int NLFile, char *source)
    21.07.94 Added gOldFormat flag to calls to BuildKabatNumbering()
    02.04.96 Added kadbid
    03.04.02 Added refdate
+   19.10.26 antigen, fsource and reference now go into a COLDDATA
+            block. This and the numbering are allocated from gDataArena
+            since they are shared with the entry in gData
+            Building the numbering timed by STAT_NUMBER
+   19.10.26 Source copied with a bound
 */
 void CopyKabatToData(DATA *p, KABATENTRY Kabat, char chain, 
                      BOOL GotInsert)
 {
-   strcpy(p->antigen,    Kabat.antigen);
+   STATTIMER(start)
+
    strcpy(p->class,      Kabat.class);
    strcpy(p->name,       Kabat.aaname);
-   strcpy(p->fsource,    Kabat.source);
-   strcpy(p->source,     Kabat.source);
-   strcpy(p->reference,  Kabat.reference);
+   strncpy(p->source,    Kabat.source, MAXBUFF-1);
+   p->source[MAXBUFF-1] = '\0';
+
+   p->cold       = NewColdData(gDataArena, Kabat.antigen, Kabat.source,
+                               Kabat.reference);
+   p->ColdOffset = (-1L);
 
    p->refdate   = Kabat.refdate;
    p->active[0] = FALSE;
@@ -1179,13 +1874,23 @@ void CopyKabatToData(DATA *p, KABATENTRY Kabat, char chain,
    if(chain=='l' || chain=='L')
    {
       strcpy(p->light, Kabat.sequence);
-      if(GotInsert) p->LNumbers = BuildKabatNumbering(Kabat,gOldFormat);
+      if(GotInsert)
+      {
+         STATSTART(start);
+         p->LNumbers = BuildKabatNumbering(gDataArena,Kabat,gOldFormat);
+         STATSTOP(STAT_NUMBER, start);
+      }
       strcpy(p->idlight, Kabat.kadbid);
    }
    else
    {
       strcpy(p->heavy, Kabat.sequence);
-      if(GotInsert) p->HNumbers = BuildKabatNumbering(Kabat,gOldFormat);
+      if(GotInsert)
+      {
+         STATSTART(start);
+         p->HNumbers = BuildKabatNumbering(gDataArena,Kabat,gOldFormat);
+         STATSTOP(STAT_NUMBER, start);
+      }
       strcpy(p->idheavy, Kabat.kadbid);
    }
 }
@@ -1207,15 +1912,19 @@ void CopyKabatToData(DATA *p, KABATENTRY Kabat, char chain,
    21.07.94 Fixed LNumbers and HNumbers only to be copied if needed (!)
    02.04.96 Added kadbid
    03.04.02 Added refdate
+   19.10.26 The COLDDATA block (antigen, fsource and reference) is 
+            shared rather than copied
+   19.10.26 Source copied with a bound
 */
 void CopyDataToData(DATA *p, DATA *extra, char chain)
 {
-   strcpy(p->antigen,    extra->antigen);
    strcpy(p->class,      extra->class);
    strcpy(p->name,       extra->name);
-   strcpy(p->source,     extra->source);
-   strcpy(p->fsource,    extra->fsource);
-   strcpy(p->reference,  extra->reference);
+   strncpy(p->source,    extra->source, MAXBUFF-1);
+   p->source[MAXBUFF-1] = '\0';
+
+   p->cold       = extra->cold;
+   p->ColdOffset = extra->ColdOffset;
 
    p->refdate   = extra->refdate;
    p->active[0] = FALSE;
@@ -1236,9 +1945,10 @@ void CopyDataToData(DATA *p, DATA *extra, char chain)
 
 
 /************************************************************************/
-/*>BOOL ReadLFiles(FILE *fpL[], int NLFile, DATA *KabatLData[], 
-                   char *source, int *LCClass)
-   ------------------------------------------------------------
+/*>BOOL ReadLFiles(ARENA *arena, FILE *fpL[], int NLFile,
+                   DATA *KabatLData[], char *source, int *LCClass)
+   ----------------------------------------------------------------
+   I/O:     ARENA  *arena         Arena for the linked lists
    Input:   FILE   *fpL[]         Array of light chain file pointers
             int    NLFile         Number of light chains
             char   *source        Source name from filename
@@ -1261,9 +1971,12 @@ void CopyDataToData(DATA *p, DATA *extra, char chain)
    21.07.94 Made OldFormat flag global
    23.06.95 Initialised p
    11.04.96 Also prints accession code for skipped entries
+   19.10.26 Moved setting up of each entry into CopyLKabatToData()
+            Uses ParseNextKabatEntry()
+            The lists are allocated from an arena
 */
-BOOL ReadLFiles(FILE *fpL[], int NLFile, DATA *KabatLData[], char *source,
-                int *LCClass)
+BOOL ReadLFiles(ARENA *arena, FILE *fpL[], int NLFile,
+                DATA *KabatLData[], char *source, int *LCClass)
 {
    int        i,
               nseq;
@@ -1276,8 +1989,8 @@ BOOL ReadLFiles(FILE *fpL[], int NLFile, DATA *KabatLData[], char *source,
    
    for(i=0; i<NLFile; i++)
    {
-      while((nseq=ReadNextKabatEntry(fpL[i],&KabatEntry,&GotInsert,
-                                     gOldFormat)) != 0)
+      while((nseq=ParseNextKabatEntry(fpL[i],&KabatEntry,&GotInsert,
+                                      gOldFormat)) != 0)
       {
          if(nseq == (-1))
          {
@@ -1289,35 +2002,18 @@ BOOL ReadLFiles(FILE *fpL[], int NLFile, DATA *KabatLData[], char *source,
          {
             if(KabatLData[i] == NULL)
             {
-               INIT((KabatLData[i]), DATA);
+               ARENAINIT(arena, (KabatLData[i]), DATA);
                p = KabatLData[i];
             }
             else
             {
-               ALLOCNEXT(p, DATA);
+               ARENANEXT(arena, p, DATA);
             }
 
             if(p==NULL) return(FALSE);
 
-            p->LNumbers = p->HNumbers = NULL;
-            p->light[0] = p->heavy[0] = '\0';
-            
-            CopyKabatToData(p, KabatEntry, 'L', GotInsert);
-
-            /* Only copy source from filename if not VARIOUS            */
-            if(blUpstrncmp(source,"VARIOUS",7))
-               strcpy(p->source, source);
-            
-            UPPER(p->source);
-
-            /* Set class from filename if not specified in file         */
-            if(!(p->class[0]))
-            {
-               if(LCClass[i] == CLASS_LAMBDA)
-                  strcpy(p->class,"LAMBDA");
-               else if(LCClass[i] == CLASS_KAPPA)
-                  strcpy(p->class,"KAPPA");
-            }
+            CopyLKabatToData(p, KabatEntry, GotInsert, source, 
+                             LCClass[i]);
          }
       }
    }
@@ -1326,6 +2022,80 @@ BOOL ReadLFiles(FILE *fpL[], int NLFile, DATA *KabatLData[], char *source,
 }
 
 
+/************************************************************************/
+/*>int ParseNextKabatEntry(FILE *fp, KABATENTRY *Kabat, BOOL *insert,
+                           BOOL OldFormat)
+   ------------------------------------------------------------------
+   Input:   FILE        *fp          Kabat file pointer
+            BOOL        OldFormat    Read old format files
+   Output:  KABATENTRY  *Kabat       Completed KABATENTRY data structure
+            BOOL        *insert      Has an insertion occurred?
+   Returns: int                      As ReadNextKabatEntry()
+
+   Calls ReadNextKabatEntry() timing each entry read with STAT_PARSE.
+
+   19.10.26 Original    By: ACRM
+*/
+int ParseNextKabatEntry(FILE *fp, KABATENTRY *Kabat, BOOL *insert,
+                        BOOL OldFormat)
+{
+   int nseq;
+   STATTIMER(start)
+
+   STATSTART(start);
+   nseq = ReadNextKabatEntry(fp, Kabat, insert, OldFormat);
+   if(nseq != 0)
+      STATSTOP(STAT_PARSE, start);
+
+   return(nseq);
+}
+
+
+/************************************************************************/
+/*>void CopyLKabatToData(DATA *p, KABATENTRY Kabat, BOOL GotInsert,
+                         char *source, int LCClass)
+   ----------------------------------------------------------------
+   Input:   KABATENTRY  Kabat      Light chain Kabat entry
+            BOOL        GotInsert  Kabat entry has an insert
+            char        *source    Source name from filename
+            int         LCClass    Class from filename
+   Output:  DATA        *p         Completed light chain data structure
+
+   Sets up a DATA structure for a light chain read from a light chain
+   file. Split out of ReadLFiles() so the same is done when light
+   chains are re-read by an incremental update.
+
+   19.10.26 Original    By: ACRM
+   19.10.26 Source copied with a bound
+*/
+void CopyLKabatToData(DATA *p, KABATENTRY Kabat, BOOL GotInsert,
+                      char *source, int LCClass)
+{
+   p->LNumbers = p->HNumbers = NULL;
+   p->light[0] = p->heavy[0] = '\0';
+            
+   CopyKabatToData(p, Kabat, 'L', GotInsert);
+
+   /* Only copy source from filename if not VARIOUS                     */
+   if(blUpstrncmp(source,"VARIOUS",7))
+   {
+      strncpy(p->source, source, MAXBUFF-1);
+      p->source[MAXBUFF-1] = '\0';
+   }
+            
+   UPPER(p->source);
+
+   /* Set class from filename if not specified in file                  */
+   if(!(p->class[0]))
+   {
+      if(LCClass == CLASS_LAMBDA)
+         strcpy(p->class,"LAMBDA");
+      else if(LCClass == CLASS_KAPPA)
+         strcpy(p->class,"KAPPA");
+   }
+}
+
+
 /************************************************************************/
 /*>void GetSource(char *filename, char *source)
    --------------------------------------------
@@ -1363,89 +2133,21 @@ void GetSource(char *filename, char *source)
    25.04.94 No longer reports blank lines as syntax error
    22.06.95 Doubled buffer size to stop problems with people entering
             whole chains
+   19.10.26 Each line is handled by HandleCommand()
+            Returns at the end of the input rather than exiting so that
+            main() tidies up
 */
 void CommandLoop(void)
 {
-   char buffer[2*MAXBUFF],
-        *p;
+   char buffer[2*MAXBUFF];
    int Mode = 0;
    
    printf("KABATMAN> ");
    
    while(fgets(buffer,MAXBUFF,stdin))
    {
-      /* Tidy up the buffer                                             */
-      TERMINATE(buffer);
-      KILLLEADSPACES(p,buffer);
-
-
-      if(p[0] == ';' || p[0] == '.')  /* Cause the search to be run     */
-      {
-         Mode = 0;
-         ExecuteSearch(NULL);
-      }
-      else if(p[0] == '>')            /* Run search and redirect        */
-      {
-         Mode = 0;
-         KILLLEADSPACES(p,p+1);
-         ExecuteSearch(p);
-      }
-      else if(p[0] == '\0')           /* Blank line                     */
-      {
-         while(FALSE) ;
-      }
-      else
-      {
-         /* See if we're entering a new mode                            */
-         if(!blUpstrncmp(p,"SET",3))
-         {
-            if(Mode != 0)
-               fprintf(stderr,"SET only allowed at main prompt\n");
-            else
-               HandleSetCommand(p);
-         }
-         else if(!blUpstrncmp(p,"SELECT",6))
-         {
-            Mode = 1;
-            ClearSelect();
-            BuildSelect(p);
-         }
-         else if(!blUpstrncmp(p,"WHERE",5))
-         {
-            Mode = 2;
-            ClearWhere();
-            BuildWhere(p);
-         }
-         else if(!blUpstrncmp(p,"FROM",4))
-         {
-            Mode = 3;
-            BuildFrom(p);
-         }
-         else if(!blUpstrncmp(p,"QUIT",4) || !blUpstrncmp(p,"EXIT",4))
-         {
-            ClearSelect();
-            ClearWhere();
-            return;
-         }
-         else     /* Add info to the current mode                       */
-         {
-            switch(Mode)
-            {
-            case 1:
-               BuildSelect(p);
-               break;
-            case 2:
-               BuildWhere(p);
-               break;
-            case 3:
-               BuildFrom(p);
-               break;
-            default:
-               fprintf(stderr,"Error: (Syntax) %s\n",p);
-               break;
-            }
-         }
-      }
+      if(!HandleCommand(buffer, &Mode, NULL))
+         return;
 
       switch(Mode)
       {
@@ -1463,8 +2165,153 @@ void CommandLoop(void)
          break;
       }
    }
+}
+
+
+/************************************************************************/
+/*>BOOL HandleCommand(char *buffer, int *Mode, char *OutFile)
+   ----------------------------------------------------------
+   I/O:     char  *buffer     Command line (modified)
+            int   *Mode       Current mode: 0 at the main prompt, 1-3 
+                              while entering SELECT, WHERE or FROM
+   Input:   char  *OutFile    File for the output of a search run with
+                              ; or . (NULL for stdout)
+   Returns: BOOL              FALSE if the line was QUIT or EXIT
+
+   Handles one line of input. Split out of CommandLoop() so that the
+   benchmark can run commands in the same way.
+
+   A line may start with EXPLAIN or EXPLAIN ANALYZE which applies to
+   the next search to be run.
+
+   The lines of the SELECT and WHERE clauses are kept so that searches
+   may be logged. gNRows is set to -1 before a search is run so that
+   one which fails is not logged.
+
+   19.10.26 Original (from CommandLoop())   By: ACRM
+   19.10.26 Added EXPLAIN [ANALYZE]
+            Added SHOW STATS
+            Searches are traced
+            Searches are logged
+            Added SHOW MEMORY
+*/
+BOOL HandleCommand(char *buffer, int *Mode, char *OutFile)
+{
+   char   *p;
+   double start;
+
+   /* Tidy up the buffer                                                */
+   TERMINATE(buffer);
+   KILLLEADSPACES(p,buffer);
+
+   /* EXPLAIN [ANALYZE] may be followed by the rest of a command        */
+   if(!blUpstrncmp(p,"EXPLAIN",7))
+   {
+      gExplain = EXPLAIN_PLAN;
+      KILLLEADSPACES(p,p+7);
+      if(!blUpstrncmp(p,"ANALYZE",7) || !blUpstrncmp(p,"ANALYSE",7))
+      {
+         gExplain = EXPLAIN_ANALYZE;
+         KILLLEADSPACES(p,p+7);
+      }
+   }
+
+   if(p[0] == ';' || p[0] == '.')  /* Cause the search to be run        */
+   {
+      *Mode = 0;
+      gNRows = (-1);
+      start  = WallTime();
+      TraceBegin(0, "ExecuteSearch", NULL);
+      ExecuteSearch(OutFile);
+      TraceEnd(0);
+      CaptureSearch(WallTime() - start);
+      gExplain = EXPLAIN_NONE;
+   }
+   else if(p[0] == '>')            /* Run search and redirect           */
+   {
+      *Mode = 0;
+      KILLLEADSPACES(p,p+1);
+      gNRows = (-1);
+      start  = WallTime();
+      TraceBegin(0, "ExecuteSearch", p);
+      ExecuteSearch(p);
+      TraceEnd(0);
+      CaptureSearch(WallTime() - start);
+      gExplain = EXPLAIN_NONE;
+   }
+   else if(p[0] == '\0')           /* Blank line                        */
+   {
+      while(FALSE) ;
+   }
+   else
+   {
+      /* See if we're entering a new mode                               */
+      if(!blUpstrncmp(p,"SET",3))
+      {
+         if(*Mode != 0)
+            fprintf(stderr,"SET only allowed at main prompt\n");
+         else
+            HandleSetCommand(p);
+      }
+      else if(!blUpstrncmp(p,"SHOW",4))
+      {
+         KILLLEADSPACES(p,p+4);
+         if(*Mode != 0)
+            fprintf(stderr,"SHOW only allowed at main prompt\n");
+         else if(!blUpstrncmp(p,"STATS",5))
+            ShowStats(stdout);
+         else if(!blUpstrncmp(p,"MEM",3))
+            ShowMemory(stdout);
+         else
+            fprintf(stderr,"Error: (Syntax) SHOW %s\n",p);
+      }
+      else if(!blUpstrncmp(p,"SELECT",6))
+      {
+         *Mode = 1;
+         CaptureLine(p, *Mode, TRUE);
+         ClearSelect();
+         BuildSelect(p);
+      }
+      else if(!blUpstrncmp(p,"WHERE",5))
+      {
+         *Mode = 2;
+         CaptureLine(p, *Mode, TRUE);
+         ClearWhere();
+         BuildWhere(p);
+      }
+      else if(!blUpstrncmp(p,"FROM",4))
+      {
+         *Mode = 3;
+         BuildFrom(p);
+      }
+      else if(!blUpstrncmp(p,"QUIT",4) || !blUpstrncmp(p,"EXIT",4))
+      {
+         ClearSelect();
+         ClearWhere();
+         return(FALSE);
+      }
+      else     /* Add info to the current mode                          */
+      {
+         CaptureLine(p, *Mode, FALSE);
+         switch(*Mode)
+         {
+         case 1:
+            BuildSelect(p);
+            break;
+         case 2:
+            BuildWhere(p);
+            break;
+         case 3:
+            BuildFrom(p);
+            break;
+         default:
+            fprintf(stderr,"Error: (Syntax) %s\n",p);
+            break;
+         }
+      }
+   }
 
-   exit(0);
+   return(TRUE);
 }
 
 
@@ -1680,8 +2527,16 @@ void BuildFrom(char *buffer)
             CHOTHIA *gChothia   The Chothia data; refreshed by 
                                    SET CANONICAL {type}
             char  gDelim        Set by DELIMiter {delim}
+            int   gNThreads     Set by THREADS {value}
+            BOOL  gUseIndex     Set by INDEX {ON|OFF}
+            int   gLSHMinData   Set by LSH {value|OFF}
+            BOOL  gUseZoneMap   Set by ZONEMAP {ON|OFF}
+            BOOL  gUseBatch     Set by BATCH {ON|OFF}
+            char  gCanonical[]  Set by CANONICAL {type}
 
-   Handles commands which set variables
+   Handles commands which set variables. SET TRACE {file|OFF} starts
+   or finishes a trace. SET LOG {file|OFF} starts or stops logging the
+   searches.
 
    21.04.94 Original    By: ACRM
    25.04.94 Added INSERTS {ON|OFF}
@@ -1694,6 +2549,13 @@ void BuildFrom(char *buffer)
             Added check for value!
    31.07.00 Added LOOP definitions for Contact CDR definitions
    28.02.05 blGetWord() now takes max word length
+   19.10.26 Added SET THREADS {value}
+            Added SET INDEX {ON|OFF}
+            Added SET LSH {value|OFF}
+            Added SET TRACE {file|OFF}
+            Added SET LOG {file|OFF}. CANONICAL is kept in gCanonical
+            Added SET ZONEMAP {ON|OFF}
+            Added SET BATCH {ON|OFF}
 */
 void HandleSetCommand(char *buffer)
 {
@@ -1780,6 +2642,7 @@ void HandleSetCommand(char *buffer)
             if(!blUpstrncmp(value,"DEF",3))
             {
                ReadChothiaData(gChothiaFile);
+               gCanonical[0] = '\0';
             }
             else
             {
@@ -1798,6 +2661,7 @@ reading key residue file\n");
                sprintf(filename,"%s.%s",gChothiaFile, value);
                
                ReadChothiaData(filename);
+               strcpy(gCanonical, value);
 
                free(filename);
             }
@@ -1806,6 +2670,54 @@ reading key residue file\n");
          {
             gDelim = value[0];
          }
+         else if(!blUpstrncmp(word,"THREAD",6))
+         {
+            if((sscanf(value,"%d",&gNThreads)!=1) || (gNThreads < 0))
+               gNThreads = 0;
+         }
+         else if(!blUpstrncmp(word,"INDEX",5))
+         {
+            if(!blUpstrncmp(value,"ON",2))
+               gUseIndex = TRUE;
+            else
+               gUseIndex = FALSE;
+         }
+         else if(!blUpstrncmp(word,"LSH",3))
+         {
+            if(!blUpstrncmp(value,"OFF",3))
+               gLSHMinData = 0;
+            else if((sscanf(value,"%d",&gLSHMinData)!=1) ||
+                    (gLSHMinData < 0))
+               gLSHMinData = DEF_LSHMINDATA;
+         }
+         else if(!blUpstrncmp(word,"ZONEMAP",4))
+         {
+            if(!blUpstrncmp(value,"ON",2))
+               gUseZoneMap = TRUE;
+            else
+               gUseZoneMap = FALSE;
+         }
+         else if(!blUpstrncmp(word,"BATCH",5))
+         {
+            if(!blUpstrncmp(value,"ON",2))
+               gUseBatch = TRUE;
+            else
+               gUseBatch = FALSE;
+         }
+         else if(!blUpstrncmp(word,"TRACE",5))
+         {
+            if(!blUpstrncmp(value,"OFF",3))
+               CloseTrace();
+            else if(value[0])
+               OpenTrace(value);
+         }
+         else if(!blUpstrncmp(word,"LOG",3))
+         {
+            if(!blUpstrncmp(value,"OFF",3))
+               CloseCapture();
+            else if(value[0])
+               OpenCapture(value);
+         }
          else
          {
             fprintf(stderr,"Error: Unknown variable (%s)\n",word);
@@ -1848,6 +2760,8 @@ reading key residue file\n");
    29.05.96 Now frees any pre-existing data so this can be called
             multiple times.
    28.02.05 blGetWord() now takes max word length
+   19.10.26 Allocates from gChothiaArena so the old data are freed in
+            one go
 */
 BOOL ReadChothiaData(char *filename)
 {
@@ -1874,10 +2788,12 @@ BOOL ReadChothiaData(char *filename)
    }
 
    /* Free the current Chothia data if there is any                     */
-   if(gChothia != NULL)
+   FreeArena(gChothiaArena);
+   gChothia = NULL;
+   if((gChothiaArena = NewArena(DATAARENABLOCK))==NULL)
    {
-      FREELIST(gChothia, CHOTHIA);
-      gChothia = NULL;
+      fclose(fp);
+      return(FALSE);
    }
 
    /* This flag indicatess whether the file contains Chothia or Kabat
@@ -1909,12 +2825,12 @@ BOOL ReadChothiaData(char *filename)
             /* Allocate space in linked list                            */
             if(gChothia == NULL)
             {
-               INIT(gChothia,CHOTHIA);
+               ARENAINIT(gChothiaArena, gChothia, CHOTHIA);
                p = gChothia;
             }
             else
             {
-               ALLOCNEXT(p,CHOTHIA);
+               ARENANEXT(gChothiaArena, p, CHOTHIA);
             }
             if(p==NULL) return(FALSE);
             
@@ -3,11 +3,11 @@
    Program:    KabatMan
    File:       kabatman.h
    
-   Version:    V2.25
-   Date:       24.08.06
+   Version:    V2.27
+   Date:       19.10.26
    Function:   Database program for reading Kabat sequence files
    
-   Copyright:  (c) UCL / Andrew C. R. Martin 1994-2006
+   Copyright:  (c) UCL / Andrew C. R. Martin 1994-2026
    Author:     Dr. Andrew C. R. Martin
    Address:    Biomolecular Structure and Modelling Unit,
                Department of Biochemistry and Molecular Biology,
@@ -71,6 +71,36 @@
    V2.24 28.02.05 Added types for LFR1...HFR4
    V2.25 24.08.06 Added FIELD_SEQUENCE - option which works like PIR, but 
                   writes a numbered sequence file
+   V2.26 04.10.19 Skipped
+   V2.27 19.10.26 Added gLimit, gOffset, gOrderBy and gOrderDesc
+                  Added aggregate to SELECTION, AGG_xxxx types, gGroupBy
+                  and gNThreads
+                  Added LightHash and HeavyHash to DATA and gDistinct
+                  Moved antigen, fsource and reference out of DATA into
+                  COLDDATA
+                  Added gKeepRawIndex
+                  Added DATAARENABLOCK, gDataArena and gChothiaArena
+                  Added upper case and ungapped copies of the searched
+                  fields to DATA, COLDDATA and WHERE
+                  Added MATCHER and the matcher in WHERE
+                  Added SEQINDEX, gSeqIndex and gUseIndex
+                  Added COMP_MISMATCH, COMP_SIMILAR and the bit masks
+                  and error count in MATCHER
+                  Added COMP_WITHIN and the BK-trees in SEQINDEX
+                  Added FIELD_IDENTITY, LSHINDEX and gLSHMinData
+                  Added DEF_BENCHREPEATS and gNRows
+                  Added STEPSTATS in WHERE, EXPLAIN_xxxx, STAGE_xxxx,
+                  ACCESS_xxxx, gExplain, gCacheHits and gCacheMisses
+                  Added STATBLOCK, STAT_xxxx, the STATxxxx() macros,
+                  gStats and gStatBlock
+                  Added gCanonical
+                  Added MEMUSE
+                  Added ZONE, ZONEMAP, ACCESS_ZONEMAP, gZoneMap,
+                  gUseZoneMap and gClusterData
+                  Added COLUMNS, BATCHSIZE, gColumns, gUseBatch and
+                  STATTESTS(). The zone map values are in the COLUMNS
+                  Added gLimitError
+                  Added VIRTFILE
 
 *************************************************************************/
 #ifndef _KABATMAN_H
@@ -84,12 +114,14 @@
 #include <ctype.h>
 #include <sys/types.h>
 #include <time.h>
+#include <stdint.h>
 
 #include "bioplib/macros.h"
 #include "bioplib/SysDefs.h"
 #include "bioplib/general.h"
 
 #include "RdKabat.h"
+#include "Arena.h"
 
 /************************************************************************/
 /* Defines and macros
@@ -144,6 +176,7 @@
 #define FIELD_HFR3      32
 #define FIELD_HFR4      33
 #define FIELD_SEQUENCE  34
+#define FIELD_IDENTITY  35
 
 #define OPER_AND        1        /* Types for logical set operators     */
 #define OPER_OR         2
@@ -156,6 +189,11 @@
 #define COMP_LE         5
 #define COMP_GE         6
 #define COMP_SIM        7
+#define COMP_MISMATCH   8        /* Up to n substitutions               */
+#define COMP_SIMILAR    9        /* Up to n substitutions and indels    */
+#define COMP_WITHIN     10       /* Whole sequence within n edits       */
+
+#define MAXMATCHLEN     64       /* Max pattern for MISMATCH / SIMILAR  */
 
 #define LOOP_KABAT      1        /* Loop definitions                    */
 #define LOOP_ABM        2
@@ -165,9 +203,79 @@
 #define CLASS_LAMBDA    1        /* Light chain classes                 */
 #define CLASS_KAPPA     2
 
+#define AGG_NONE        0        /* Aggregate functions in SELECT       */
+#define AGG_COUNT       1
+#define AGG_MIN         2
+#define AGG_MAX         3
+#define AGG_AVG         4
+
+#define MAXTHREADS      16       /* Max threads used for a search       */
+#define HASH_INIT       2166136261UL /* Starting value for HashBytes()  */
+#define DATAARENABLOCK  1048576  /* Block size for data set arenas      */
+#define NINDEXFIELD     26       /* Light, heavy and 6 CDRs x 4 defs    */
+#define NLSHBANDS       16       /* MinHash bands for each chain        */
+#define DEF_LSHMINDATA  20000    /* Entries from which the LSH is used  */
+#define LSHMINIDENTITY  80.0     /* Lowest % identity it is used for    */
+#define DEF_BENCHREPEATS 20      /* Timed runs of each benchmark query  */
+#define NOCUTOFF        (REAL)(-1.0e6) /* SeqIdentity() with no cutoff  */
+#define ZONESIZE        256      /* Entries summarised by each zone     */
+#define BATCHSIZE       1024     /* Entries tested at a time (a multiple
+                                    of ZONESIZE)                        */
+#define MAXCODES        64       /* Coded sources or classes (one bit
+                                    each in a uint64_t)                 */
+#define NLENGTHLOOPS    6        /* CDRs whose lengths are kept         */
+#define NLOOPMODES      4        /* LOOP_KABAT...LOOP_CONTACT           */
+
+#define EXPLAIN_NONE    0        /* EXPLAIN [ANALYZE] before a query    */
+#define EXPLAIN_PLAN    1
+#define EXPLAIN_ANALYZE 2
+
+#define STAGE_VARIABILITY 0      /* Steps of a search after the WHERE   */
+#define STAGE_DISTINCT  1        /* clause which are timed by EXPLAIN   */
+#define STAGE_ORDER     2        /* ANALYZE                             */
+#define STAGE_GROUP     3
+#define STAGE_DISPLAY   4
+#define NSTAGES         5
+
+#define ACCESS_SCAN     0        /* How the entries for a test are found*/
+#define ACCESS_INDEX    1
+#define ACCESS_PARALLEL 2
+#define ACCESS_ZONEMAP  3
+
+#define STAT_LOAD       0        /* Hot-path counters for SHOW STATS    */
+#define STAT_PARSE      1
+#define STAT_NUMBER     2
+#define STAT_PAIR       3
+#define STAT_CANONICAL  4
+#define STAT_SUBGROUP   5
+#define STAT_OUTPUT     6
+#define STAT_ALLOC      7
+#define NSTATS          8
+#define NSTATFIELDS     (FIELD_IDENTITY+1) /* WHERE tests counted by   */
+                                           /* field type                */
+
+/* The long text fields which are rarely used are stored separately
+   from the DATA structure and may be read on demand. Access these via
+   GetColdData()
+   19.10.26 Added upper case copies of antigen and reference
+*/
+typedef struct
+{
+   char *antigen,
+        *fsource,
+        *reference,
+        *UpperAntigen,          /* Upper case copies for searching      */
+        *UpperReference;
+}  COLDDATA;
+
 /* A linked list of DATA structures is used to store the actual Kabat
    data
    03.04.02 Added refdate
+   19.10.26 antigen, fsource and reference moved to COLDDATA. Added
+            hashes of the chains
+            Added upper case name and class, ungapped chains and chain
+            lengths set by NormaliseData()
+            source is MAXBUFF since some are longer than SMALLBUFF
 */
 typedef struct _data
 {
@@ -175,17 +283,24 @@ typedef struct _data
    BOOL         active[STACKDEPTH];
    char         **LNumbers,
                 **HNumbers;
+   COLDDATA     *cold;          /* Antigen, fsource and reference       */
+   long         ColdOffset;     /* Offset of these in the stored file   */
    int          refdate;
-   char         antigen[LARGEBUFF],
-                class[SMALLBUFF],
+   char         class[SMALLBUFF],
                 name[SMALLBUFF],
-                source[SMALLBUFF],
-                fsource[LARGEBUFF],
-                reference[LARGEBUFF],
+                source[MAXBUFF],
                 light[LARGEBUFF],
                 heavy[LARGEBUFF],
                 idlight[SMALLBUFF],
                 idheavy[SMALLBUFF];
+   unsigned long LightHash,     /* Hashes of the chain sequences        */
+                 HeavyHash;
+   char         *UpperName,     /* Upper case copies for searching      */
+                *UpperClass,
+                *UngappedLight, /* Chains with the -'s removed          */
+                *UngappedHeavy;
+   int          LightLen,       /* Residues in each chain               */
+                HeavyLen;
 }  DATA;
    
 /* An array of FIELD structures links each of the field strings to a 
@@ -204,12 +319,122 @@ typedef struct
 typedef struct _selection
 {
    struct _selection *next;
-   int               type;
+   int               type,
+                     aggregate;     /* AGG_xxxx type                    */
    char              param[MAXBUFF];
 }  SELECTION;
 
+/* A substring pattern prepared for SeqMatch(). The first and last
+   characters of the pattern which are not a ? wildcard are used to
+   find candidate matches. For MISMATCH() and SIMILAR(), masks[c] has
+   bit i set if pattern position i matches character c
+*/
+typedef struct
+{
+   int      length,             /* Length of the pattern                */
+            first,              /* Offsets of the first and last non-?  */
+            last,               /* characters (-1 if all are ?)         */
+            errors;             /* Errors allowed by MISMATCH/SIMILAR/  */
+                                /* WITHIN                               */
+   uint64_t masks[256];
+}  MATCHER;
+
+/* What was done in one step of a search, for EXPLAIN ANALYZE. The
+   hits and misses count the data built on demand (sequence index,
+   BK-trees, LSH and cold fields) which were found ready or had to be
+   read or built
+*/
+typedef struct
+{
+   double time;                 /* Elapsed time (s)                     */
+   long   hits,
+          misses;
+   int    RowsIn,               /* Entries given to the step            */
+          RowsOut,              /* Entries passed on by it              */
+          tested,               /* Entries tested (WHERE tests only)    */
+          access;               /* ACCESS_xxxx (WHERE tests only)       */
+   BOOL   done,                 /* Was the step run?                    */
+          stopped;              /* Did the scan stop at the LIMIT?      */
+}  STEPSTATS;
+
+/* Hot-path counters shown by SHOW STATS. Each thread has its own block
+   so no locking is needed; they are added together when shown. The
+   padding stops the blocks of different threads sharing a cache line.
+*/
+typedef struct
+{
+   unsigned long ticks[NSTATS],            /* Time in STATTICKS() units */
+                 TestTicks[NSTATFIELDS];
+   long          count[NSTATS],            /* Calls                     */
+                 amount[NSTATS],           /* Chains paired, bytes      */
+                 tests[NSTATFIELDS];       /* Entries tested            */
+   char          pad[64];
+}  STATBLOCK;
+
+/* Memory used by one part of the program, for SHOW MEMORY. allocated
+   is the memory set aside for it and used the part which holds data.
+   fixed is the part of allocated which does not grow with the number
+   of entries
+*/
+typedef struct
+{
+   size_t allocated,
+          used,
+          fixed;
+}  MEMUSE;
+
+/* An in-memory species and chain file as splitkabat would write it
+   (see Ingest.c)
+*/
+typedef struct
+{
+   char *name,
+        *buffer;
+   long length,
+        size;
+}  VIRTFILE;
+
+/* Macros to update the counters. gStatBlock points to the calling
+   thread's block so needs __thread; without it (or with -DNOSTATS) the
+   macros do nothing. STATTIMER() declares a timer so is used without
+   a semi-colon.
+*/
+#if !defined(NOSTATS) && !defined(__GNUC__)
+#define NOSTATS
+#endif
+#ifdef NOSTATS
+#define STATTIMER(t)
+#define STATSTART(t)        ((void)0)
+#define STATSTOP(c, t)      ((void)0)
+#define STATCOUNT(c)        ((void)0)
+#define STATAMOUNT(c, n)    ((void)0)
+#define STATTEST(f)         ((void)0)
+#define STATTESTS(f, n)     ((void)0)
+#define STATTESTTIME(f, t)  ((void)0)
+#define STATTHREAD(n)       ((void)0)
+#else
+#if defined(__x86_64__) || defined(__i386__)
+#define STATTICKS()         ((unsigned long)__builtin_ia32_rdtsc())
+#else
+#define STATTICKS()         StatClock()
+#endif
+#define STATTIMER(t)        unsigned long t;
+#define STATSTART(t)        ((t) = STATTICKS())
+#define STATSTOP(c, t)      (gStatBlock->ticks[(c)] += STATTICKS() - (t), \
+                             gStatBlock->count[(c)]++)
+#define STATCOUNT(c)        (gStatBlock->count[(c)]++)
+#define STATAMOUNT(c, n)    (gStatBlock->amount[(c)] += (long)(n))
+#define STATTEST(f)         (gStatBlock->tests[(f)]++)
+#define STATTESTS(f, n)     (gStatBlock->tests[(f)] += (long)(n))
+#define STATTESTTIME(f, t)  (gStatBlock->TestTicks[(f)] += \
+                             STATTICKS() - (t))
+#define STATTHREAD(n)       (gStatBlock = gStats + (n))
+#endif
+
 /* A linked list of WHERE structures is used to store the elements of
    the WHERE statement
+   19.10.26 data is stored in upper case. Added pattern and matcher
+            Added stats
 */
 typedef struct _where
 {
@@ -219,9 +444,132 @@ typedef struct _where
                  comparison;
    BOOL          SetOper;
    char          param[MAXBUFF],
-                 data[MAXBUFF*2];
+                 data[MAXBUFF*2],       /* Upper case                   */
+                 pattern[MAXBUFF*2];    /* data with the -'s removed    */
+   MATCHER       matcher;               /* pattern prepared for search  */
+   DATA          *entry;                /* Entry named for IDENTITY     */
+   STEPSTATS     stats;                 /* Set by EXPLAIN ANALYZE       */
 }  WHERE;
 
+/* The sequence index (SeqIndex.c). For each field, offsets[k] is the
+   start in entries[] of the list of entries containing 3-mer k and
+   offsets[NKMER] is the total length of the lists
+*/
+typedef struct
+{
+   int *offsets,
+       *entries;                /* Entry numbers in ascending order     */
+}  POSTINGS;
+
+/* A BK-tree (BKTree.c) of the distinct sequences of a CDR. Each node
+   lists the entries having its sequence. The children of a node are
+   linked through sibling and each is at edit distance dist from it
+*/
+typedef struct
+{
+   char *seq;                   /* Upper case without -'s               */
+   int  *entries,               /* Entry numbers in ascending order     */
+        NEntries,
+        length,                 /* Length of seq                        */
+        dist,                   /* Edit distance from the parent        */
+        child,                  /* First child (-1 if none)             */
+        sibling;                /* Next child of the parent (-1 if none)*/
+}  BKNODE;
+
+typedef struct
+{
+   BKNODE *nodes;               /* nodes[0] is the root                 */
+   int    NNodes;
+}  BKTREE;
+
+/* The MinHash locality sensitive hash (Similar.c). For each chain
+   (0 = light, 1 = heavy) and band, keys[chain][band][i] is the key of
+   entry i (0 if it has no such chain) and bands[chain][band] lists the
+   entries with the chain in order of key. Entries which have no light
+   chain, no heavy chain or neither are also listed since TooSimilar()
+   does not penalise a missing chain
+*/
+typedef struct
+{
+   unsigned long key;
+   int           entry;
+}  LSHKEY;
+
+typedef struct
+{
+   DATA          **data;        /* The entries in the order indexed     */
+   unsigned long *keys[2][NLSHBANDS];
+   LSHKEY        *bands[2][NLSHBANDS];
+   int           NData,
+                 NBand[2],      /* Entries in bands[0] and bands[1]     */
+                 *NoLight,
+                 *NoHeavy,
+                 *NoChain,
+                 NNoLight,
+                 NNoHeavy,
+                 NNoChain,
+                 *seen,         /* Marks candidates already found       */
+                 stamp;
+}  LSHINDEX;
+
+typedef struct
+{
+   int           NEntries;
+   unsigned long fingerprint;   /* From the chain hashes                */
+   POSTINGS      field[NINDEXFIELD];
+   BKTREE        *tree[NINDEXFIELD]; /* Built when first needed         */
+   LSHINDEX      *lsh;               /* Built when first needed         */
+}  SEQINDEX;
+
+/* Columns (Batch.c) of the values tested most often, one element per
+   entry in the order of gData, so tests can be run on batches of
+   entries in tight loops. Sources and classes are stored as codes: code
+   i is the i'th value listed and the last code stands for all the
+   values after the first MAXCODES-1. The CDR lengths for each loop
+   definition and the sets on the search stack (used in place of the
+   active flags in DATA) are filled in when first needed
+*/
+typedef struct
+{
+   DATA          **rows;
+   int           *dates,
+                 *lengths[NLENGTHLOOPS][NLOOPMODES];
+   unsigned char *sources,
+                 *classes,
+                 *complete,
+                 *sets[STACKDEPTH];
+   char          *SourceValues[MAXCODES-1],
+                 *ClassValues[MAXCODES-1];
+   int           NRows,
+                 NSources,
+                 NClasses;
+   BOOL          OtherSources,  /* Values beyond those listed?          */
+                 OtherClasses;
+}  COLUMNS;
+
+/* Zone maps (ZoneMap.c). The entries are taken in blocks of ZONESIZE
+   and each ZONE summarises one block so that a scan can skip blocks in
+   which no entry can pass a test. Bit i of sources or classes is set
+   if an entry in the block has code i in the COLUMNS. The CDR lengths
+   for each loop definition are filled in when first needed
+*/
+typedef struct
+{
+   uint64_t sources,
+            classes;
+   int      MinDate,
+            MaxDate;
+   short    MinLen[NLENGTHLOOPS][NLOOPMODES],
+            MaxLen[NLENGTHLOOPS][NLOOPMODES];
+}  ZONE;
+
+typedef struct
+{
+   ZONE *zones;
+   int  NZones;
+   BOOL HaveLength[NLENGTHLOOPS][NLOOPMODES];
+}  ZONEMAP;
+
 /* An array of LOOP structures is used to store the alternative loop
    defintions
 */
@@ -252,10 +600,12 @@ char  **gFlagList = NULL,
       gFOF[MAXBUFF],
       gKabatFile[MAXBUFF],
       gChothiaFile[MAXBUFF],
+      gCanonical[MAXBUFF],
       gFileDate[MAXBUFF],
       gURLFormat[MAXBUFF],
       gDelim      = ',';
 DATA  *gData      = NULL;                   /* Kabat data linked list   */
+ARENA *gDataArena = NULL;                   /* Memory for gData         */
 int   gInfoLevel  = DEF_INFO,               /* Information level        */
       gLoopMode   = LOOP_KABAT;             /* Loop definition mode     */
 BOOL  gShowInserts= FALSE,                  /* Show inserts in loops?   */
@@ -296,6 +646,7 @@ FIELD gField[]    =                         /* Link field names/numbers */
    {  FIELD_HFR3,      4, "HFR3"},
    {  FIELD_HFR4,      4, "HFR4"},
    {  FIELD_SEQUENCE,  3, "SEQUENCE"},
+   {  FIELD_IDENTITY,  3, "IDENTITY"},
    {  0,               0, NULL}
 }  ;
 FIELD gSetOper[]  =                         /* Link set oper names/nums */
@@ -318,20 +669,49 @@ SELECTION *gSelectClause  = NULL,           /* SELECT statement list    */
           *gCurrentSelect = NULL;
 WHERE     *gWhereClause   = NULL,           /* WHERE statement list     */
           *gCurrentWhere  = NULL;
+BOOL      gLimitError     = FALSE;          /* Error in LIMIT or OFFSET */
 CHOTHIA   *gChothia       = NULL;           /* CHOTHIA class types      */
+ARENA     *gChothiaArena  = NULL;           /* Memory for gChothia      */
 BOOL      gOldFormat      = FALSE;          /* Old Kabat format         */
 REAL      gVariability    = 0.0;            /* Variability              */
 BOOL      gHTML           = FALSE;          /* HTML Output format       */
+int       gLimit          = 0,              /* Max hits to show (0=all) */
+          gOffset         = 0;              /* Hits to skip before shown*/
+SELECTION *gOrderBy       = NULL;           /* ORDER BY field           */
+BOOL      gOrderDesc      = FALSE;          /* ORDER BY ... DESC        */
+SELECTION *gGroupBy       = NULL;           /* GROUP BY field list      */
+int       gNThreads       = 0;              /* Threads to use (0=auto)  */
+BOOL      gDistinct       = FALSE;          /* SELECT DISTINCT          */
+BOOL      gKeepRawIndex   = FALSE;          /* Keep raw file index when
+                                               reading stored data?     */
+SEQINDEX  *gSeqIndex      = NULL;           /* Sequence index (lazy)    */
+BOOL      gUseIndex       = TRUE;           /* Use the sequence index?  */
+ZONEMAP   *gZoneMap       = NULL;           /* Zone maps (lazy)         */
+BOOL      gUseZoneMap     = TRUE;           /* Use the zone maps?       */
+BOOL      gClusterData    = FALSE;          /* Sort entries when stored?*/
+COLUMNS   *gColumns       = NULL;           /* Columns for tests (lazy) */
+BOOL      gUseBatch       = TRUE;           /* Test batches of entries? */
+int       gLSHMinData     = DEF_LSHMINDATA; /* Entries to use LSH (0=no)*/
+int       gNRows          = 0;              /* Rows shown by last search*/
+int       gExplain        = EXPLAIN_NONE;   /* EXPLAIN the next search  */
+long      gCacheHits      = 0L,             /* Data built on demand     */
+          gCacheMisses    = 0L;             /* found ready / not ready  */
+#ifndef NOSTATS
+STATBLOCK gStats[MAXTHREADS];               /* Hot-path counters        */
+__thread STATBLOCK *gStatBlock = gStats;    /* This thread's counters   */
+#endif
 
 #else              /*------------- External  references ----------------*/
 extern char      **gFlagList,
                  gFOF[MAXBUFF],
                  gKabatFile[MAXBUFF],
                  gChothiaFile[MAXBUFF],
+                 gCanonical[MAXBUFF],
                  gFileDate[MAXBUFF],
                  gURLFormat[MAXBUFF],
                  gDelim;
 extern DATA      *gData;
+extern ARENA     *gDataArena;
 extern int       gInfoLevel,
                  gLoopMode;
 extern BOOL      gShowInserts,
@@ -343,10 +723,36 @@ extern SELECTION *gSelectClause,
                  *gCurrentSelect;
 extern WHERE     *gWhereClause,
                  *gCurrentWhere;
+extern BOOL      gLimitError;
 extern CHOTHIA   *gChothia;
+extern ARENA     *gChothiaArena;
 extern BOOL      gOldFormat;
 extern REAL      gVariability;
 extern BOOL      gHTML;
+extern int       gLimit,
+                 gOffset;
+extern SELECTION *gOrderBy;
+extern BOOL      gOrderDesc;
+extern SELECTION *gGroupBy;
+extern int       gNThreads;
+extern BOOL      gDistinct;
+extern BOOL      gKeepRawIndex;
+extern SEQINDEX  *gSeqIndex;
+extern BOOL      gUseIndex;
+extern ZONEMAP   *gZoneMap;
+extern BOOL      gUseZoneMap;
+extern BOOL      gClusterData;
+extern COLUMNS   *gColumns;
+extern BOOL      gUseBatch;
+extern int       gLSHMinData;
+extern int       gNRows;
+extern int       gExplain;
+extern long      gCacheHits,
+                 gCacheMisses;
+#ifndef NOSTATS
+extern STATBLOCK gStats[MAXTHREADS];
+extern __thread STATBLOCK *gStatBlock;
+#endif
 
 #endif             /*-------------- End of global data -----------------*/
 
@@ -2,16 +2,33 @@ int main(int argc, char **argv)
 ;
 void DisplayCopyright(BOOL DoHash)
 ;
-BOOL ParseCmdLine(int argc, char **argv, BOOL *ForceRead)
+BOOL ParseCmdLine(int argc, char **argv, BOOL *ForceRead,
+                  BOOL *Upgrade, BOOL *Incremental, char *Archive,
+                  char *BenchFile, int *BenchRepeats,
+                  long *NGenerate, char *GenFile, BOOL *DumpAtExit,
+                  char *TraceFile, char *LogFile, BOOL *MemStats)
+;
+BOOL NewDataSet(void)
+;
+void FreeDataSet(void)
+;
+BOOL NormaliseData(DATA *data)
 ;
 BOOL ReadStoredData(char *filename)
 ;
-char **ReadSpecialNumbering(char *buffer)
+char **ReadSpecialNumbering(ARENA *arena, char *buffer)
 ;
 BOOL StoreKabatData(char *filename)
 ;
+void WriteStoredHeader(FILE *fp)
+;
+long WriteStoredEntry(FILE *fp, DATA *p, long ColdOffset)
+;
 BOOL ReadKabatData(char *FoF)
 ;
+BOOL ReadKabatGroup(FILE *fpH, FILE **fpL, int NLFile, char *source,
+                    int *LCClass)
+;
 BOOL StoreKabatInData(DATA **pData, KABATENTRY Kabat, char chain,
                       char *source, BOOL GotInsert)
 ;
@@ -32,13 +49,21 @@ void CopyKabatToData(DATA *p, KABATENTRY Kabat, char chain,
 ;
 void CopyDataToData(DATA *p, DATA *extra, char chain)
 ;
-BOOL ReadLFiles(FILE *fpL[], int NLFile, DATA *KabatLData[], char *source,
-                int *LCClass)
+void CopyLKabatToData(DATA *p, KABATENTRY Kabat, BOOL GotInsert,
+                      char *source, int LCClass)
+;
+BOOL ReadLFiles(ARENA *arena, FILE *fpL[], int NLFile,
+                DATA *KabatLData[], char *source, int *LCClass)
+;
+int ParseNextKabatEntry(FILE *fp, KABATENTRY *Kabat, BOOL *insert,
+                        BOOL OldFormat)
 ;
 void GetSource(char *filename, char *source)
 ;
 void CommandLoop(void)
 ;
+BOOL HandleCommand(char *buffer, int *Mode, char *OutFile)
+;
 BOOL ReadChothiaData(char *filename)
 ;
 BOOL RefCheck(char *inref1, char *inref2)
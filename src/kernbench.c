@@ -0,0 +1,741 @@
+/*************************************************************************
+
+   Program:    kernbench
+   File:       kernbench.c
+
+   Version:    V1.0
+   Date:       19.10.26
+   Function:   Microbenchmarks for the inner routines of KabatMan
+
+   Copyright:  (c) UCL / Dr. Andrew C. R. Martin 2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Times the routines called for every entry in a search or when the
+   raw data are read, one at a time, over the entries of the stored
+   data file (kabat.dat, found as by KabatMan itself) so that the one
+   responsible for a change in speed can be found.
+
+   Each kernel makes a pass over the entries doing a fixed set of
+   operations on each (e.g. extracting each of the six CDRs). It is
+   run once to warm up and then the given number of times. The report
+   gives the operations in a pass, the fastest and median time per
+   operation and the number of calls to malloc(), calloc() and
+   realloc() per operation. These are counted by linking with
+   -Wl,--wrap (see the Makefile) so this needs the GNU linker.
+
+   The raw Kabat readers (ReadKabatEntry() via ReadNextKabatEntry()
+   and BuildKabatNumbering()) are run over new format Kabat records
+   made from the first RAWENTRIES chains in the data. The stored data
+   have already had insertions resolved, so these records give the
+   numbering of each position directly rather than by INSERTSAA.
+
+**************************************************************************
+
+   Usage:
+   ======
+   kernbench [repeats]
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  19.10.26 Original
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define DEF_REPEATS   10               /* Default timed passes          */
+#define RAWENTRIES    2000             /* Chains used for raw kernels   */
+#define SIMCUTOFF     ((REAL)90.0)     /* Cutoff for TooSimilar()       */
+
+typedef struct
+{
+   char *name;
+   long (*run)(void);
+}  KERNEL;
+
+/************************************************************************/
+/* Globals
+*/
+static DATA       **sData     = NULL;  /* Entries as an array           */
+static int        sNData      = 0;
+static char       **sSubSeqs  = NULL;  /* Human chains for det_sgpe()   */
+static int        sNSubSeqs   = 0;
+static int        *sL1Len     = NULL,  /* AbM lengths of L1 and H1      */
+                  *sH1Len     = NULL;
+static FILE       *sRawFp     = NULL;  /* New format Kabat records      */
+static KABATENTRY *sRawKabat  = NULL;  /* The records once read         */
+static int        sNRaw       = 0;
+static long       sNAllocs    = 0L;    /* Calls to malloc() etc.        */
+
+static char *sLoops[]    = {"L1", "L2", "L3", "H1", "H2", "H3", NULL};
+static char *sFWs[]      = {"LFR1", "LFR2", "LFR3", "LFR4",
+                            "HFR1", "HFR2", "HFR3", "HFR4", NULL};
+static char *sResidues[] = {"L24", "L27A", "L50", "L91", "L95B",
+                            "H35B", "H52A", "H94", "H100", "H100K",
+                            NULL};
+static char *sPattern    = "WGQG?TLVTV";
+static char *sThree[26]  =
+{
+   "ALA", "ASX", "CYS", "ASP", "GLU", "PHE", "GLY", "HIS", "ILE", "UNK",
+   "LYS", "LEU", "MET", "ASN", "UNK", "PRO", "GLN", "ARG", "SER", "THR",
+   "UNK", "VAL", "TRP", "UNK", "TYR", "GLX"
+};
+
+/************************************************************************/
+/* Prototypes
+*/
+#include "protos.h"
+int main(int argc, char **argv);
+BOOL Setup(void);
+BOOL MakeRawRecords(void);
+void WriteRawRecord(FILE *fp, DATA *d, int chain, int id);
+double RunKernel(KERNEL *kernel, long *NOps, long *NAllocs);
+int CompareDoubles(const void *d1, const void *d2);
+long KernGetKabatOffset(void);
+long KernFillLoop(void);
+long KernFillFW(void);
+long KernGetResidue(void);
+long KernDoStrTest(void);
+long KernFuzzystrstr(void);
+long KernTooSimilar(void);
+long KernFindCanonical(void);
+long KernDetSgpe(void);
+long KernKabCho(void);
+long KernChoKab(void);
+long KernReadKabatEntry(void);
+long KernBuildKabatNumbering(void);
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__wrap_malloc(size_t size);
+void *__wrap_calloc(size_t n, size_t size);
+void *__wrap_realloc(void *ptr, size_t size);
+
+static KERNEL sKernels[] =
+{
+   {"GetKabatOffset",      KernGetKabatOffset},
+   {"FillLoop",            KernFillLoop},
+   {"FillFW",              KernFillFW},
+   {"GetResidue",          KernGetResidue},
+   {"DoStrTest",           KernDoStrTest},
+   {"fuzzystrstr",         KernFuzzystrstr},
+   {"TooSimilar",          KernTooSimilar},
+   {"FindCanonical",       KernFindCanonical},
+   {"det_sgpe",            KernDetSgpe},
+   {"KabCho",              KernKabCho},
+   {"ChoKab",              KernChoKab},
+   {"ReadKabatEntry",      KernReadKabatEntry},
+   {"BuildKabatNumbering", KernBuildKabatNumbering},
+   {NULL,                  NULL}
+};
+
+
+/************************************************************************/
+/*>int main(int argc, char **argv)
+   -------------------------------
+   Main program for the kernel microbenchmarks
+
+   19.10.26 Original    By: ACRM
+*/
+int main(int argc, char **argv)
+{
+   KERNEL *k;
+   double *times;
+   long   NOps,
+          NAllocs;
+   int    repeats = DEF_REPEATS,
+          i;
+
+   if(argc > 1)
+      repeats = atoi(argv[1]);
+   if((argc > 2) || (repeats < 1))
+   {
+      fprintf(stderr,"Usage: kernbench [repeats]\n");
+      return(1);
+   }
+
+   if(!Setup())
+      return(1);
+   if((times = (double *)malloc(repeats * sizeof(double)))==NULL)
+   {
+      fprintf(stderr,"Error: No memory for times\n");
+      return(1);
+   }
+
+   printf("%d entries, %d raw records, %d repeats\n\n", sNData, sNRaw,
+          repeats);
+   printf("%-20s %10s %12s %12s %10s\n", "Kernel", "Ops/pass",
+          "Min ns/op", "Median ns/op", "Allocs/op");
+
+   for(k=sKernels; k->name!=NULL; k++)
+   {
+      RunKernel(k, &NOps, &NAllocs);            /* Warm up              */
+      for(i=0; i<repeats; i++)
+         times[i] = RunKernel(k, &NOps, &NAllocs);
+      qsort(times, repeats, sizeof(double), CompareDoubles);
+
+      printf("%-20s %10ld %12.1f %12.1f %10.3f\n", k->name, NOps,
+             (NOps ? 1.0e9 * times[0] / NOps : 0.0),
+             (NOps ? 1.0e9 * times[repeats/2] / NOps : 0.0),
+             (NOps ? (double)NAllocs / NOps : 0.0));
+   }
+
+   return(0);
+}
+
+
+/************************************************************************/
+/*>BOOL Setup(void)
+   ----------------
+   Returns: BOOL       Success
+
+   Reads the stored data and the Chothia data as KabatMan does and
+   prepares the inputs for the kernels.
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL Setup(void)
+{
+   DATA *d;
+   char loop[LARGEBUFF];
+   int  i, j;
+
+   strcpy(gKabatFile,   DEF_KABAT);
+   strcpy(gChothiaFile, DEF_CHOTHIA);
+   gInfoLevel = 0;
+
+   if(!ReadStoredData(gKabatFile) || !NormaliseData(gData))
+   {
+      fprintf(stderr,"Error: Unable to read %s\n", gKabatFile);
+      return(FALSE);
+   }
+   SetChainHashes(gData);
+   if(!ReadChothiaData(gChothiaFile))
+      fprintf(stderr,"Warning: Unable to read Chothia data\n");
+
+   for(d=gData; d!=NULL; NEXT(d))
+      sNData++;
+   if((sNData < 2) ||
+      ((sData    = (DATA **)malloc(sNData * sizeof(DATA *)))==NULL) ||
+      ((sSubSeqs = (char **)malloc(2 * sNData * sizeof(char *)))==NULL) ||
+      ((sL1Len   = (int *)malloc(2 * sNData * sizeof(int)))==NULL))
+   {
+      fprintf(stderr,"Error: No data or no memory\n");
+      return(FALSE);
+   }
+   sH1Len = sL1Len + sNData;
+
+   for(d=gData, i=0; d!=NULL; NEXT(d), i++)
+   {
+      sData[i] = d;
+
+      /* KabCho() and ChoKab() take the AbM loop lengths                */
+      FillLoopMode("L1", d, loop, LOOP_ABM);
+      sL1Len[i] = blTrueSeqLen(loop);
+      FillLoopMode("H1", d, loop, LOOP_ABM);
+      sH1Len[i] = blTrueSeqLen(loop);
+
+      /* det_sgpe() takes ungapped human chains with X for unknown      */
+      if(!strcmp(d->source, "HUMAN"))
+      {
+         if(d->UngappedLight[0])
+            sSubSeqs[sNSubSeqs++] = d->UngappedLight;
+         if(d->UngappedHeavy[0])
+            sSubSeqs[sNSubSeqs++] = d->UngappedHeavy;
+      }
+   }
+   for(i=0; i<sNSubSeqs; i++)
+   {
+      if(strchr(sSubSeqs[i], '?') != NULL)
+      {
+         char *seq;
+
+         if((seq = (char *)malloc(strlen(sSubSeqs[i])+1))==NULL)
+            return(FALSE);
+         for(j=0; sSubSeqs[i][j]; j++)
+            seq[j] = ((sSubSeqs[i][j] == '?') ? 'X' : sSubSeqs[i][j]);
+         seq[j] = '\0';
+         sSubSeqs[i] = seq;
+      }
+   }
+
+   return(MakeRawRecords());
+}
+
+
+/************************************************************************/
+/*>BOOL MakeRawRecords(void)
+   -------------------------
+   Returns: BOOL       Success
+
+   Writes the first RAWENTRIES chains as new format Kabat records to a
+   temporary file for ReadKabatEntry() and reads them back for
+   BuildKabatNumbering().
+
+   19.10.26 Original    By: ACRM
+*/
+BOOL MakeRawRecords(void)
+{
+   BOOL insert;
+   int  i,
+        id = 0;
+
+   if(((sRawFp = tmpfile())==NULL) ||
+      ((sRawKabat = (KABATENTRY *)malloc(RAWENTRIES * sizeof(KABATENTRY)))
+       ==NULL))
+   {
+      fprintf(stderr,"Error: Unable to create raw Kabat records\n");
+      return(FALSE);
+   }
+
+   for(i=0; (i<sNData) && (id<RAWENTRIES); i++)
+   {
+      if(sData[i]->light[0])
+         WriteRawRecord(sRawFp, sData[i], 0, ++id);
+      if(sData[i]->heavy[0] && (id<RAWENTRIES))
+         WriteRawRecord(sRawFp, sData[i], 1, ++id);
+   }
+
+   rewind(sRawFp);
+   while((sNRaw < RAWENTRIES) &&
+         (ReadNextKabatEntry(sRawFp, &(sRawKabat[sNRaw]), &insert, FALSE)
+          > 0))
+      sNRaw++;
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void WriteRawRecord(FILE *fp, DATA *d, int chain, int id)
+   ---------------------------------------------------------
+   Input:   FILE   *fp       File to write
+            DATA   *d        Entry
+            int    chain     0 for light, 1 for heavy
+            int    id        Kabat ID for the record
+
+   Writes one chain of an entry as a new format Kabat record with one
+   SEQTPA line for each position of the aligned sequence. Unknown
+   residues are left blank as in the Kabat files.
+
+   19.10.26 Original    By: ACRM
+*/
+void WriteRawRecord(FILE *fp, DATA *d, int chain, int id)
+{
+   char **table,
+        *seq,
+        *code,
+        label[SMALLBUFF];
+   int  i;
+
+   seq   = (chain ? d->heavy    : d->light);
+   table = (chain ? d->HNumbers : d->LNumbers);
+
+   fprintf(fp,"KADBID      %06d\n", id);
+   fprintf(fp,"AANAME      %s\n",   d->name);
+   fprintf(fp,"SPECIE      %s\n",   d->source);
+   fprintf(fp,"ANNOTA CLAS %s\n",   d->class);
+
+   for(i=0; seq[i]; i++)
+   {
+      label[0] = (chain ? 'H' : 'L');
+      label[1] = '\0';
+      if(GetKabatOffset(table, label, i) < 0)
+         break;
+
+      if(seq[i] == '-')
+         code = "-";
+      else if(isupper(seq[i]))
+         code = sThree[seq[i] - 'A'];
+      else
+         code = "";
+
+      fprintf(fp,"SEQTPA            %5s     %-3s\n", label, code);
+   }
+
+   fprintf(fp,"RECEND|\n");
+}
+
+
+/************************************************************************/
+/*>double RunKernel(KERNEL *kernel, long *NOps, long *NAllocs)
+   -----------------------------------------------------------
+   Input:   KERNEL *kernel     The kernel
+   Output:  long   *NOps       Operations done
+            long   *NAllocs    Calls to malloc(), calloc() and realloc()
+   Returns: double             Time taken (s)
+
+   Runs one pass of a kernel.
+
+   19.10.26 Original    By: ACRM
+*/
+double RunKernel(KERNEL *kernel, long *NOps, long *NAllocs)
+{
+   double start;
+
+   sNAllocs = 0L;
+   start    = WallTime();
+   *NOps    = (*kernel->run)();
+   start    = WallTime() - start;
+   *NAllocs = sNAllocs;
+
+   return(start);
+}
+
+
+/************************************************************************/
+/*>int CompareDoubles(const void *d1, const void *d2)
+   --------------------------------------------------
+   qsort() comparison for doubles
+
+   19.10.26 Original    By: ACRM
+*/
+int CompareDoubles(const void *d1, const void *d2)
+{
+   double a = *(const double *)d1,
+          b = *(const double *)d2;
+
+   return((a < b) ? (-1) : ((a > b) ? 1 : 0));
+}
+
+
+/************************************************************************/
+/* The kernels. Each does one pass and returns the operations done. The
+   results go to sSink so that the calls are not optimized away.
+*/
+static volatile long sSink = 0L;
+
+/************************************************************************/
+/*>long KernGetKabatOffset(void)
+   -----------------------------
+   Looks up each of sResidues[] in the numbering of each entry
+
+   19.10.26 Original    By: ACRM
+*/
+long KernGetKabatOffset(void)
+{
+   long NOps = 0L;
+   int  i, j;
+
+   for(i=0; i<sNData; i++)
+   {
+      for(j=0; sResidues[j]!=NULL; j++, NOps++)
+      {
+         sSink += GetKabatOffset((sResidues[j][0] == 'L') ?
+                                 sData[i]->LNumbers : sData[i]->HNumbers,
+                                 sResidues[j], -1);
+      }
+   }
+   return(NOps);
+}
+
+
+/************************************************************************/
+/*>long KernFillLoop(void)
+   -----------------------
+   Extracts each CDR from each entry
+
+   19.10.26 Original    By: ACRM
+*/
+long KernFillLoop(void)
+{
+   char loop[LARGEBUFF];
+   long NOps = 0L;
+   int  i, j;
+
+   for(i=0; i<sNData; i++)
+   {
+      for(j=0; sLoops[j]!=NULL; j++, NOps++)
+      {
+         FillLoop(sLoops[j], sData[i], loop);
+         sSink += loop[0];
+      }
+   }
+   return(NOps);
+}
+
+
+/************************************************************************/
+/*>long KernFillFW(void)
+   ---------------------
+   Extracts each framework region from each entry
+
+   19.10.26 Original    By: ACRM
+*/
+long KernFillFW(void)
+{
+   char fw[LARGEBUFF];
+   long NOps = 0L;
+   int  i, j;
+
+   for(i=0; i<sNData; i++)
+   {
+      for(j=0; sFWs[j]!=NULL; j++, NOps++)
+      {
+         FillFW(sFWs[j], sData[i], fw);
+         sSink += fw[0];
+      }
+   }
+   return(NOps);
+}
+
+
+/************************************************************************/
+/*>long KernGetResidue(void)
+   -------------------------
+   Gets each of sResidues[] from each entry
+
+   19.10.26 Original    By: ACRM
+*/
+long KernGetResidue(void)
+{
+   long NOps = 0L;
+   int  i, j;
+
+   for(i=0; i<sNData; i++)
+   {
+      for(j=0; sResidues[j]!=NULL; j++, NOps++)
+         sSink += GetResidue(sData[i], sResidues[j]);
+   }
+   return(NOps);
+}
+
+
+/************************************************************************/
+/*>long KernDoStrTest(void)
+   ------------------------
+   Searches the ungapped heavy chain of each entry for sPattern as for
+   a LIKE test
+
+   19.10.26 Original    By: ACRM
+*/
+long KernDoStrTest(void)
+{
+   long NOps = 0L;
+   int  i;
+
+   for(i=0; i<sNData; i++, NOps++)
+      sSink += DoStrTest(sData[i]->UngappedHeavy, COMP_SIM, sPattern);
+   return(NOps);
+}
+
+
+/************************************************************************/
+/*>long KernFuzzystrstr(void)
+   --------------------------
+   Searches the heavy chain of each entry, with its -'s, for sPattern
+
+   19.10.26 Original    By: ACRM
+*/
+long KernFuzzystrstr(void)
+{
+   long NOps = 0L;
+   int  i;
+
+   for(i=0; i<sNData; i++, NOps++)
+      sSink += fuzzystrstr(sData[i]->heavy, sPattern);
+   return(NOps);
+}
+
+
+/************************************************************************/
+/*>long KernTooSimilar(void)
+   -------------------------
+   Compares each entry with the next as the redundancy filter does
+
+   19.10.26 Original    By: ACRM
+*/
+long KernTooSimilar(void)
+{
+   long NOps = 0L;
+   int  i;
+
+   for(i=0; i<sNData-1; i++, NOps++)
+      sSink += TooSimilar(sData[i], sData[i+1], SIMCUTOFF);
+   return(NOps);
+}
+
+
+/************************************************************************/
+/*>long KernFindCanonical(void)
+   ----------------------------
+   Finds the canonical class of each CDR of each entry
+
+   19.10.26 Original    By: ACRM
+*/
+long KernFindCanonical(void)
+{
+   char class[LARGEBUFF];
+   long NOps = 0L;
+   int  i, j;
+
+   for(i=0; i<sNData; i++)
+   {
+      for(j=0; sLoops[j]!=NULL; j++, NOps++)
+         sSink += FindCanonical(sData[i], sLoops[j], class);
+   }
+   return(NOps);
+}
+
+
+/************************************************************************/
+/*>long KernDetSgpe(void)
+   ----------------------
+   Assigns the class and subgroup of each human chain
+
+   19.10.26 Original    By: ACRM
+*/
+long KernDetSgpe(void)
+{
+   long NOps = 0L,
+        class,
+        sgpe;
+   int  i;
+
+   for(i=0; i<sNSubSeqs; i++, NOps++)
+   {
+      det_sgpe(sSubSeqs[i], &class, &sgpe);
+      sSink += sgpe;
+   }
+   return(NOps);
+}
+
+
+/************************************************************************/
+/*>long KernKabCho(void)
+   ---------------------
+   Converts residues in CDR-L1 and CDR-H1 of each entry from Kabat to
+   Chothia numbering
+
+   19.10.26 Original    By: ACRM
+*/
+long KernKabCho(void)
+{
+   static char *L1Specs[] = {"L27", "L27A", "L27D", "L29", "L31", NULL},
+               *H1Specs[] = {"H31", "H33", "H35", "H35A", "H35B", NULL};
+   long NOps = 0L;
+   int  i, j;
+
+   for(i=0; i<sNData; i++)
+   {
+      for(j=0; L1Specs[j]!=NULL; j++, NOps++)
+         sSink += KabCho("L1", sL1Len[i], L1Specs[j])[0];
+      for(j=0; H1Specs[j]!=NULL; j++, NOps++)
+         sSink += KabCho("H1", sH1Len[i], H1Specs[j])[0];
+   }
+   return(NOps);
+}
+
+
+/************************************************************************/
+/*>long KernChoKab(void)
+   ---------------------
+   Converts residues in CDR-L1 and CDR-H1 of each entry from Chothia to
+   Kabat numbering
+
+   19.10.26 Original    By: ACRM
+*/
+long KernChoKab(void)
+{
+   static char *L1Specs[] = {"L27", "L29", "L30", "L30A", "L31", NULL},
+               *H1Specs[] = {"H26", "H31", "H31A", "H31B", "H32", NULL};
+   long NOps = 0L;
+   int  i, j;
+
+   for(i=0; i<sNData; i++)
+   {
+      for(j=0; L1Specs[j]!=NULL; j++, NOps++)
+         sSink += ChoKab("L1", sL1Len[i], L1Specs[j])[0];
+      for(j=0; H1Specs[j]!=NULL; j++, NOps++)
+         sSink += ChoKab("H1", sH1Len[i], H1Specs[j])[0];
+   }
+   return(NOps);
+}
+
+
+/************************************************************************/
+/*>long KernReadKabatEntry(void)
+   -----------------------------
+   Reads each of the raw Kabat records
+
+   19.10.26 Original    By: ACRM
+*/
+long KernReadKabatEntry(void)
+{
+   static KABATENTRY Kabat;
+   BOOL              insert;
+   long              NOps = 0L;
+
+   rewind(sRawFp);
+   while(ReadNextKabatEntry(sRawFp, &Kabat, &insert, FALSE) > 0)
+      NOps++;
+   return(NOps);
+}
+
+
+/************************************************************************/
+/*>long KernBuildKabatNumbering(void)
+   ----------------------------------
+   Builds the numbering of each of the raw Kabat records. The arena is
+   made and freed in each pass as when a data set is read.
+
+   19.10.26 Original    By: ACRM
+*/
+long KernBuildKabatNumbering(void)
+{
+   ARENA *arena;
+   long  NOps = 0L;
+   int   i;
+
+   if((arena = NewArena(DATAARENABLOCK))==NULL)
+      return(0L);
+   for(i=0; i<sNRaw; i++, NOps++)
+      sSink += (BuildKabatNumbering(arena, sRawKabat[i], FALSE) != NULL);
+   FreeArena(arena);
+   return(NOps);
+}
+
+
+/************************************************************************/
+/* Counting wrappers for the memory allocators. With -Wl,--wrap=malloc
+   calls to malloc() come here and __real_malloc() is the C library's.
+*/
+void *__wrap_malloc(size_t size)
+{
+   sNAllocs++;
+   return(__real_malloc(size));
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+   sNAllocs++;
+   return(__real_calloc(n, size));
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+   sNAllocs++;
+   return(__real_realloc(ptr, size));
+}
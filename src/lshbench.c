@@ -0,0 +1,397 @@
+/*************************************************************************
+
+   Program:    lshbench
+   File:       lshbench.c
+
+   Version:    V1.0
+   Date:       19.10.26
+   Function:   Benchmark of the LSH used for the redundancy filter
+
+   Copyright:  (c) UCL / Dr. Andrew C. R. Martin 2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Compares the candidate pairs from the MinHash LSH (BuildLSH() and
+   LSHCandidates()) with an exact comparison of every pair by
+   TooSimilar() at a range of identity cutoffs.
+
+   A synthetic repertoire is generated with a fixed seed: germline
+   chains, lineages derived from them with their own CDR-H3 and
+   mutations, and members of each lineage with further mutations. Some
+   entries are missing a chain and some have gaps, as in the Kabat data.
+
+   For each cutoff the program reports the number of pairs at least
+   that identical, the recall (the proportion of those pairs which the
+   LSH gives as candidates), the number of pairs compared and the time
+   taken by each method. It also runs the greedy filter used by
+   SET VARIABILITY both ways and reports the number of entries kept.
+
+**************************************************************************
+
+   Usage:
+   ======
+   lshbench [nentries]
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  19.10.26 Original
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+#include "Arena.p"
+#include "Similar.p"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define DEF_NDATA     10000            /* Default number of entries     */
+#define NGERMLINE     40               /* Germline chains of each type  */
+#define LIGHTLEN      108              /* Aligned chain lengths         */
+#define HEAVYLEN      120
+#define H3START       97               /* Positions of the CDR-H3       */
+#define H3LEN         16
+#define LINEAGESIZE   12               /* Mean members per lineage      */
+#define NOCHAINEVERY  50               /* 1 in 50 has only one chain    */
+#define NCUTOFFS      4
+
+/************************************************************************/
+/* Globals
+*/
+static REAL sCutoffs[NCUTOFFS] = {80.0, 90.0, 95.0, 99.0};
+static char *sAminoAcids       = "ACDEFGHIKLMNPQRSTVWY";
+static unsigned long sSeed     = 12345;
+
+/************************************************************************/
+/* Prototypes
+*/
+int main(int argc, char **argv);
+DATA **MakeRepertoire(int NData);
+void Mutate(char *seq, int length, int percent);
+void SetUngapped(DATA *d);
+int Random(int n);
+double Seconds(clock_t start);
+
+
+/************************************************************************/
+/*>int main(int argc, char **argv)
+   -------------------------------
+   Main program for the LSH benchmark
+
+   19.10.26 Original    By: ACRM
+*/
+int main(int argc, char **argv)
+{
+   DATA     **data;
+   ARENA    *arena;
+   LSHINDEX *lsh;
+   BOOL     *ExactKept,
+            *LSHKept;
+   int      *cand,
+            NData = DEF_NDATA,
+            NCand,
+            i, j, k, c,
+            NKeptExact,
+            NKeptLSH;
+   long     NPairs,
+            NSimilar,
+            NFound,
+            NCompared;
+   double   ExactTime,
+            LSHTime,
+            BuildTime;
+   clock_t  start;
+
+   if(argc > 1)
+      NData = atoi(argv[1]);
+   if((argc > 2) || (NData < 2))
+   {
+      fprintf(stderr,"Usage: lshbench [nentries]\n");
+      return(1);
+   }
+
+   if(((data = MakeRepertoire(NData))==NULL) ||
+      ((arena = NewArena(DATAARENABLOCK))==NULL) ||
+      ((cand = (int *)malloc(NData * sizeof(int)))==NULL) ||
+      ((ExactKept = (BOOL *)malloc(2 * NData * sizeof(BOOL)))==NULL))
+   {
+      fprintf(stderr,"Error: No memory for data\n");
+      return(1);
+   }
+   LSHKept = ExactKept + NData;
+
+   start = clock();
+   if((lsh = BuildLSH(arena, data, NData))==NULL)
+   {
+      fprintf(stderr,"Error: No memory for LSH\n");
+      return(1);
+   }
+   BuildTime = Seconds(start);
+
+   NPairs = (long)NData * (NData - 1) / 2;
+   printf("%d entries (%ld pairs). LSH built in %.3fs\n\n", NData, NPairs,
+          BuildTime);
+   printf("%6s %10s %7s %10s %9s %9s %9s %9s\n", "Cutoff", "Pairs",
+          "Recall", "Compared", "Exact", "LSH", "Kept", "LSHKept");
+
+   for(c=0; c<NCUTOFFS; c++)
+   {
+      /* Exact: every pair                                              */
+      NSimilar = 0;
+      start    = clock();
+      for(i=0; i<NData; i++)
+      {
+         for(j=i+1; j<NData; j++)
+         {
+            if(TooSimilar(data[i], data[j], sCutoffs[c]))
+               NSimilar++;
+         }
+      }
+      ExactTime = Seconds(start);
+
+      /* LSH: only the candidates                                       */
+      NFound    = 0;
+      NCompared = 0;
+      start     = clock();
+      for(i=0; i<NData; i++)
+      {
+         NCand = LSHCandidates(lsh, i, cand);
+         for(k=0; k<NCand; k++)
+         {
+            if(cand[k] > i)
+            {
+               NCompared++;
+               if(TooSimilar(data[i], data[cand[k]], sCutoffs[c]))
+                  NFound++;
+            }
+         }
+      }
+      LSHTime = Seconds(start);
+
+      /* The greedy filter of RemoveDupes() done both ways               */
+      for(i=0; i<NData; i++)
+         ExactKept[i] = LSHKept[i] = TRUE;
+      NKeptExact = NKeptLSH = 0;
+      for(i=0; i<NData; i++)
+      {
+         if(ExactKept[i])
+         {
+            NKeptExact++;
+            for(j=i+1; j<NData; j++)
+            {
+               if(ExactKept[j] &&
+                  TooSimilar(data[i], data[j], sCutoffs[c]))
+                  ExactKept[j] = FALSE;
+            }
+         }
+         if(LSHKept[i])
+         {
+            NKeptLSH++;
+            NCand = LSHCandidates(lsh, i, cand);
+            for(k=0; k<NCand; k++)
+            {
+               if((cand[k] > i) && LSHKept[cand[k]] &&
+                  TooSimilar(data[i], data[cand[k]], sCutoffs[c]))
+                  LSHKept[cand[k]] = FALSE;
+            }
+         }
+      }
+
+      printf("%5.0f%% %10ld %6.2f%% %10ld %8.3fs %8.3fs %9d %9d\n",
+             sCutoffs[c], NSimilar,
+             (NSimilar ? (100.0 * NFound / NSimilar) : 100.0),
+             NCompared, ExactTime, LSHTime, NKeptExact, NKeptLSH);
+   }
+
+   return(0);
+}
+
+
+/************************************************************************/
+/*>DATA **MakeRepertoire(int NData)
+   --------------------------------
+   Input:   int    NData    Number of entries
+   Returns: DATA   **       Array of entries. NULL if no memory
+
+   Generates the synthetic repertoire. Each lineage takes a random light
+   and heavy germline, a random CDR-H3 (with 0-5 deletions shown as
+   -'s) and about 5% mutations; each member then has up to a further 8%
+   mutations. Every NOCHAINEVERY'th entry has one chain missing.
+
+   19.10.26 Original    By: ACRM
+*/
+DATA **MakeRepertoire(int NData)
+{
+   static char germlines[2][NGERMLINE][LARGEBUFF];
+   DATA        **data;
+   char        light[LARGEBUFF],
+               heavy[LARGEBUFF];
+   int         i, j,
+               left = 0,
+               gaps;
+
+   for(i=0; i<NGERMLINE; i++)
+   {
+      for(j=0; j<LIGHTLEN; j++)
+         germlines[0][i][j] = sAminoAcids[Random(20)];
+      germlines[0][i][LIGHTLEN] = '\0';
+      for(j=0; j<HEAVYLEN; j++)
+         germlines[1][i][j] = sAminoAcids[Random(20)];
+      germlines[1][i][HEAVYLEN] = '\0';
+   }
+
+   if((data = (DATA **)malloc(NData * sizeof(DATA *)))==NULL)
+      return(NULL);
+
+   for(i=0; i<NData; i++)
+   {
+      if(left-- <= 0)
+      {
+         /* Start a new lineage                                         */
+         left = Random(2 * LINEAGESIZE);
+         strcpy(light, germlines[0][Random(NGERMLINE)]);
+         strcpy(heavy, germlines[1][Random(NGERMLINE)]);
+         for(j=0; j<H3LEN; j++)
+            heavy[H3START+j] = sAminoAcids[Random(20)];
+         for(gaps=Random(6), j=0; j<gaps; j++)
+            heavy[H3START+H3LEN-1-j] = '-';
+         Mutate(light, LIGHTLEN, 5);
+         Mutate(heavy, HEAVYLEN, 5);
+      }
+
+      if((data[i] = (DATA *)calloc(1, sizeof(DATA)))==NULL)
+         return(NULL);
+      strcpy(data[i]->light, light);
+      strcpy(data[i]->heavy, heavy);
+      Mutate(data[i]->light, LIGHTLEN, Random(9));
+      Mutate(data[i]->heavy, HEAVYLEN, Random(9));
+
+      if(!(i % NOCHAINEVERY))
+      {
+         if(Random(2))
+            data[i]->light[0] = '\0';
+         else
+            data[i]->heavy[0] = '\0';
+      }
+      SetUngapped(data[i]);
+   }
+
+   return(data);
+}
+
+
+/************************************************************************/
+/*>void Mutate(char *seq, int length, int percent)
+   -----------------------------------------------
+   I/O:     char   *seq       Sequence
+   Input:   int    length     Its length
+            int    percent    Percentage of positions to mutate
+
+   Replaces the residue at about percent% of the positions (other than
+   -'s) with a random residue.
+
+   19.10.26 Original    By: ACRM
+*/
+void Mutate(char *seq, int length, int percent)
+{
+   int i;
+
+   for(i=0; i<length; i++)
+   {
+      if((seq[i] != '-') && (Random(100) < percent))
+         seq[i] = sAminoAcids[Random(20)];
+   }
+}
+
+
+/************************************************************************/
+/*>void SetUngapped(DATA *d)
+   -------------------------
+   I/O:     DATA   *d        Entry
+
+   Sets the ungapped copies of the chains and their lengths as is done
+   when the data are read.
+
+   19.10.26 Original    By: ACRM
+*/
+void SetUngapped(DATA *d)
+{
+   int chain,
+       i,
+       len;
+   char *seq,
+        *ungapped;
+
+   for(chain=0; chain<2; chain++)
+   {
+      seq      = (chain ? d->heavy : d->light);
+      ungapped = (char *)malloc(strlen(seq) + 1);
+      for(i=0, len=0; seq[i]; i++)
+      {
+         if(seq[i] != '-')
+            ungapped[len++] = seq[i];
+      }
+      ungapped[len] = '\0';
+
+      if(chain)
+      {
+         d->UngappedHeavy = ungapped;
+         d->HeavyLen      = len;
+      }
+      else
+      {
+         d->UngappedLight = ungapped;
+         d->LightLen      = len;
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>int Random(int n)
+   -----------------
+   Input:   int    n        Range
+   Returns: int             Random number 0...n-1
+
+   Simple linear congruential generator so that the repertoire is the
+   same on every machine.
+
+   19.10.26 Original    By: ACRM
+*/
+int Random(int n)
+{
+   sSeed = (sSeed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+   return((int)((sSeed >> 16) % (unsigned long)n));
+}
+
+
+/************************************************************************/
+/*>double Seconds(clock_t start)
+   -----------------------------
+   Input:   clock_t start    Start time
+   Returns: double           CPU seconds since start
+
+   19.10.26 Original    By: ACRM
+*/
+double Seconds(clock_t start)
+{
+   return((double)(clock() - start) / CLOCKS_PER_SEC);
+}
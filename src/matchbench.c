@@ -0,0 +1,310 @@
+/*************************************************************************
+
+   Program:    matchbench
+   File:       matchbench.c
+
+   Version:    V1.1
+   Date:       19.10.26
+   Function:   Microbenchmark for the LIKE sequence matcher
+
+   Copyright:  (c) UCL / Dr. Andrew C. R. Martin 2026
+   Author:     Dr. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is copyright.
+
+   Any copying without the express permission of the author is illegal.
+
+**************************************************************************
+
+   Description:
+   ============
+   Times the three ways of finding a pattern (with ? wildcards) in an
+   ungapped sequence: SeqMatch() as now used for the light and heavy
+   chains, fuzzystrstr() which was used before and blQueryStrStr().
+   Also times the approximate matches HammingMatch() and EditMatch()
+   (used by MISMATCH(n) and SIMILAR(n)) allowing APPROXERRORS errors.
+
+   A set of random variable domain length sequences is generated with a
+   fixed seed. A framework 4 motif is planted in some of them so that
+   the motif patterns have hits. Each pattern is searched for in every
+   sequence, repeatedly, by each method. The number of hits from each
+   exact method is checked to be the same.
+
+**************************************************************************
+
+   Usage:
+   ======
+   matchbench [nseq [repeats]]
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  19.10.26 Original
+   V1.1  19.10.26 Added HammingMatch() and EditMatch()
+
+*************************************************************************/
+/* Includes
+*/
+#include "kabatman.h"
+#include "Match.p"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define DEF_NSEQ     20000             /* Default number of sequences   */
+#define DEF_REPEATS  20                /* Default passes over the data  */
+#define MINLEN       105               /* Range of sequence lengths     */
+#define MAXLEN       130
+#define MOTIF        "WGQGTTLVTV"      /* Planted in 1 in PLANTEVERY    */
+#define PLANTEVERY   8
+
+#define METHOD_SEQMATCH    0
+#define METHOD_FUZZY       1
+#define METHOD_QUERYSTRSTR 2
+#define NEXACT             3           /* Methods giving the same hits  */
+#define METHOD_HAMMING     3
+#define METHOD_EDIT        4
+#define NMETHODS           5
+#define APPROXERRORS       2
+
+/************************************************************************/
+/* Globals
+*/
+static char *sMethodName[NMETHODS] =
+{
+   "SeqMatch", "fuzzystrstr", "blQueryStrStr", "HammingMatch",
+   "EditMatch"
+};
+
+static char *sPatterns[] =
+{
+   "WGQG?TLVTV",
+   "WGQGTTLVTV",
+   "W??G",
+   "C?R",
+   "YYC",
+   "QVQLVQSGAE",
+   "?????????W",
+   NULL
+};
+
+static unsigned long sSeed = 12345;
+
+/************************************************************************/
+/* Prototypes
+*/
+int main(int argc, char **argv);
+char **MakeSequences(int NSeq);
+int Random(int n);
+long RunMethod(int method, char **seqs, int *lengths, int NSeq,
+               int repeats, char *pattern, MATCHER *matcher,
+               double *seconds);
+
+
+/************************************************************************/
+/*>int main(int argc, char **argv)
+   -------------------------------
+   Main program for the matcher benchmark
+
+   19.10.26 Original    By: ACRM
+*/
+int main(int argc, char **argv)
+{
+   char    **seqs;
+   int     *lengths,
+           NSeq    = DEF_NSEQ,
+           repeats = DEF_REPEATS,
+           i,
+           method;
+   long    hits[NMETHODS];
+   double  seconds[NMETHODS];
+   MATCHER matcher;
+   BOOL    ok = TRUE;
+
+   if(argc > 1)
+      NSeq = atoi(argv[1]);
+   if(argc > 2)
+      repeats = atoi(argv[2]);
+   if((argc > 3) || (NSeq <= 0) || (repeats <= 0))
+   {
+      fprintf(stderr,"Usage: matchbench [nseq [repeats]]\n");
+      return(1);
+   }
+
+   if(((seqs = MakeSequences(NSeq))==NULL) ||
+      ((lengths = (int *)malloc(NSeq * sizeof(int)))==NULL))
+   {
+      fprintf(stderr,"Error: No memory for sequences\n");
+      return(1);
+   }
+   for(i=0; i<NSeq; i++)
+      lengths[i] = strlen(seqs[i]);
+
+   printf("%d sequences, %d repeats\n\n", NSeq, repeats);
+   printf("%-12s %8s", "Pattern", "Hits");
+   for(method=0; method<NMETHODS; method++)
+      printf(" %13s", sMethodName[method]);
+   printf(" %8s\n", "Speedup");
+
+   for(i=0; sPatterns[i]!=NULL; i++)
+   {
+      InitMatcher(sPatterns[i], &matcher);
+      matcher.errors = APPROXERRORS;
+      for(method=0; method<NMETHODS; method++)
+      {
+         hits[method] = RunMethod(method, seqs, lengths, NSeq, repeats,
+                                  sPatterns[i], &matcher,
+                                  &seconds[method]);
+      }
+
+      printf("%-12s %8ld", sPatterns[i], hits[METHOD_SEQMATCH]);
+      for(method=0; method<NMETHODS; method++)
+         printf(" %12.3fs", seconds[method]);
+      printf(" %7.1fx\n",
+             (seconds[METHOD_SEQMATCH] > 0.0) ?
+             seconds[METHOD_FUZZY] / seconds[METHOD_SEQMATCH] : 0.0);
+
+      for(method=1; method<NEXACT; method++)
+      {
+         if(hits[method] != hits[METHOD_SEQMATCH])
+         {
+            fprintf(stderr,"Error: %s found %ld hits for %s, SeqMatch \
+found %ld\n", sMethodName[method], hits[method], sPatterns[i],
+                    hits[METHOD_SEQMATCH]);
+            ok = FALSE;
+         }
+      }
+   }
+
+   return(ok ? 0 : 1);
+}
+
+
+/************************************************************************/
+/*>char **MakeSequences(int NSeq)
+   ------------------------------
+   Input:   int    NSeq     Number of sequences
+   Returns: char   **       Array of sequences. NULL if no memory
+
+   Generates random sequences of variable domain length. The motif
+   MOTIF is placed near the C-terminus of every PLANTEVERY'th sequence.
+
+   19.10.26 Original    By: ACRM
+*/
+char **MakeSequences(int NSeq)
+{
+   static char *sAminoAcids = "ACDEFGHIKLMNPQRSTVWY";
+   char        **seqs;
+   int         i, j,
+               len;
+
+   if((seqs = (char **)malloc(NSeq * sizeof(char *)))==NULL)
+      return(NULL);
+
+   for(i=0; i<NSeq; i++)
+   {
+      len = MINLEN + Random(MAXLEN - MINLEN + 1);
+      if((seqs[i] = (char *)malloc(len+1))==NULL)
+         return(NULL);
+      for(j=0; j<len; j++)
+         seqs[i][j] = sAminoAcids[Random(20)];
+      seqs[i][len] = '\0';
+
+      if(!(i % PLANTEVERY))
+         memcpy(seqs[i] + len - strlen(MOTIF) - 2, MOTIF, strlen(MOTIF));
+   }
+
+   return(seqs);
+}
+
+
+/************************************************************************/
+/*>int Random(int n)
+   -----------------
+   Input:   int    n        Range
+   Returns: int             Random number 0...n-1
+
+   Simple linear congruential generator so that the sequences are the
+   same on every machine.
+
+   19.10.26 Original    By: ACRM
+*/
+int Random(int n)
+{
+   sSeed = (sSeed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+   return((int)((sSeed >> 16) % (unsigned long)n));
+}
+
+
+/************************************************************************/
+/*>long RunMethod(int method, char **seqs, int *lengths, int NSeq,
+                  int repeats, char *pattern, MATCHER *matcher,
+                  double *seconds)
+   ----------------------------------------------------------------
+   Input:   int     method     METHOD_xxxx
+            char    **seqs     The sequences
+            int     *lengths   Their lengths
+            int     NSeq       Number of sequences
+            int     repeats    Number of passes over the sequences
+            char    *pattern   The pattern
+            MATCHER *matcher   Matcher for the pattern
+   Output:  double  *seconds   CPU time taken
+   Returns: long               Number of hits in one pass
+
+   Searches all the sequences for the pattern using the specified
+   method.
+
+   19.10.26 Original    By: ACRM
+*/
+long RunMethod(int method, char **seqs, int *lengths, int NSeq,
+               int repeats, char *pattern, MATCHER *matcher,
+               double *seconds)
+{
+   clock_t start;
+   long    hits = 0;
+   int     i, r;
+
+   start = clock();
+   for(r=0; r<repeats; r++)
+   {
+      hits = 0;
+      for(i=0; i<NSeq; i++)
+      {
+         switch(method)
+         {
+         case METHOD_SEQMATCH:
+            if(SeqMatch(seqs[i], lengths[i], pattern, matcher))
+               hits++;
+            break;
+         case METHOD_FUZZY:
+            if(fuzzystrstr(seqs[i], pattern))
+               hits++;
+            break;
+         case METHOD_QUERYSTRSTR:
+            if(blQueryStrStr(seqs[i], pattern) != NULL)
+               hits++;
+            break;
+         case METHOD_HAMMING:
+            if(HammingMatch(seqs[i], lengths[i], matcher))
+               hits++;
+            break;
+         case METHOD_EDIT:
+            if(EditMatch(seqs[i], lengths[i], matcher))
+               hits++;
+            break;
+         }
+      }
+   }
+   *seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   return(hits);
+}
@@ -3,8 +3,8 @@
    Program:    KabatMan
    File:       protos.h
    
-   Version:    V2.25
-   Date:       24.08.06
+   Version:    V2.27
+   Date:       19.10.26
    Function:   Include all prototype files
    
    Copyright:  (c) UCL / Andrew C. R. Martin, UCL 1994-2005
@@ -66,6 +66,13 @@
    V2.23 03.04.02 Skipped
    V2.24 28.02.05 Skipped
    V2.25 24.08.06 Skipped
+   V2.26 04.10.19 Skipped
+   V2.27 19.10.26 Added OrderBy.p, GroupBy.p, Parallel.p, Distinct.p,
+                  ColdData.p, Update.p, KabClass.p, Ingest.p,
+                  Arena.p, Match.p, SeqIndex.p, BKTree.p,
+                  Similar.p, Bench.p, Generate.p, Explain.p,
+                  Stats.p, Trace.p, Capture.p, Memory.p,
+                  ZoneMap.p and Batch.p
 
 *************************************************************************/
 /* Includes
@@ -77,6 +84,28 @@
 #include "ExecSearch.p"
 #include "KabCho.p"
 #include "subgroup.p"
+#include "OrderBy.p"
+#include "GroupBy.p"
+#include "Parallel.p"
+#include "Distinct.p"
+#include "ColdData.p"
+#include "Update.p"
+#include "KabClass.p"
+#include "Ingest.p"
+#include "Arena.p"
+#include "Match.p"
+#include "SeqIndex.p"
+#include "BKTree.p"
+#include "Similar.p"
+#include "Bench.p"
+#include "Generate.p"
+#include "Explain.p"
+#include "Stats.p"
+#include "Trace.p"
+#include "Capture.p"
+#include "Memory.p"
+#include "ZoneMap.p"
+#include "Batch.p"
 
 #ifdef NOBIOPLIB
 #include "libroutines.p"
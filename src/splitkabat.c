@@ -3,8 +3,8 @@
    Program:    splitkabat
    File:       splitkabat.c
    
-   Version:    V1.2
-   Date:       08.02.95
+   Version:    V1.4
+   Date:       19.10.26
    Function:   Split Kabat new format database files into types
    
    Copyright:  (c) UCL / Dr. Andrew C. R. Martin 1994-5
@@ -45,6 +45,13 @@
    with keywords from the gSkipKeys[] array in their DEFINI records)
    and writes out files of the appropriate species and chain type.
 
+   The input file is mapped into memory and each entry is copied to its
+   output file as a single block. All the output files are kept open
+   (with large buffers) until the end. With -t, the input is divided at
+   RECEND lines into one section per thread; the threads classify the
+   entries in their sections and the entries are then written in their
+   original order, so the output files are the same as with one thread.
+
 **************************************************************************
 
    Usage:
@@ -58,107 +65,82 @@
    V1.1  18.07.94 Now checks SPECIES records as well as DEFINI for the
                   type
    V1.2  08.02.95 Changes for new 1995 release format.
+   V1.3  19.10.26 gFileInfo[], gSkipKeys[] and the classification moved
+                  to KabClass.c so KabatMan can use them
+   V1.4  19.10.26 Input mapped into memory and entries copied as blocks.
+                  Output files kept open. Added -t for threads
 
 *************************************************************************/
 /* Includes
 */
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include "bioplib/SysDefs.h"
 #include "bioplib/macros.h"
 
 /************************************************************************/
 /* Defines and macros
 */
-#define NHEADER    16
-#define MAXBUFF    160
-#define MAXDEFLINE 8
+#define MAXOUTFILE   64                /* Max number of output files    */
+#define MAXTHREADS   64                /* Max number of threads         */
+#define OUTBUFFSIZE  (256*1024)        /* Buffer for each output file   */
+#define MINSECTION   (1024*1024)       /* Min bytes worth a thread      */
 
-typedef struct
+typedef struct                         /* An entry found in the input   */
+{
+   char *file;                         /* Output file (NULL to skip)    */
+   long start,                         /* Start of entry                */
+        HeaderEnd,                     /* End of header lines read      */
+        end;                           /* End of entry                  */
+   int  status;                        /* From ScanKabatEntry()         */
+}  ENTRY;
+
+typedef struct                         /* A section of the input        */
+{
+   char  *buffer;                      /* The whole input               */
+   long  start,                        /* First byte of the section     */
+         limit,                        /* Start of the next section     */
+         end,                          /* End of the last entry         */
+         length;                       /* Length of the whole input     */
+   ENTRY *entries;
+   int   NEntries,
+         MaxEntries;
+   BOOL  ok;
+}  SECTION;
+
+typedef struct                         /* An open output file           */
 {
-   char *source,
-        *chain,
-        *file;
-}  FILEINFO;
+   char *name;
+   FILE *fp;
+}  OUTFILE;
 
 /************************************************************************/
 /* Globals
 */
-FILEINFO gFileInfo[] =              /* Map keywords to filename         */
-{  { "CAT ", "HEAVY", "cat.ig.hc"},
-   { "CAT ", "LAMBDA", "cat.ig.lambda"},
-   { "CAT ", "KAPPA", "cat.ig.kappa"},
-   { "CAT\n", "HEAVY", "cat.ig.hc"},
-   { "CAT\n", "LAMBDA", "cat.ig.lambda"},
-   { "CAT\n", "KAPPA", "cat.ig.kappa"},
-   { "CHICKEN", "HEAVY", "chicken.ig.hc"},
-   { "CHICKEN", "LAMBDA", "chicken.ig.lambda"},
-   { "CHICKEN", "KAPPA", "chicken.ig.kappa"},
-   { "DOG ", "HEAVY", "dog.ig.hc"},
-   { "DOG ", "LAMBDA", "dog.ig.lambda"},
-   { "DOG ", "KAPPA", "dog.ig.kappa"},
-   { "DOG\n", "HEAVY", "dog.ig.hc"},
-   { "DOG\n", "LAMBDA", "dog.ig.lambda"},
-   { "DOG\n", "KAPPA", "dog.ig.kappa"},
-   { "FROG", "HEAVY", "frog.ig.hc"},
-   { "FROG", "LAMBDA", "frog.ig.lambda"},
-   { "FROG", "KAPPA", "frog.ig.kappa"},
-   { "GOPHER", "HEAVY", "gopher.ig.hc"},
-   { "GOPHER", "LAMBDA", "gopher.ig.lambda"},
-   { "GOPHER", "KAPPA", "gopher.ig.kappa"},
-   { "HORSE", "HEAVY", "horse.ig.hc"},
-   { "HORSE", "LAMBDA", "horse.ig.lambda"},
-   { "HORSE", "KAPPA", "horse.ig.kappa"},
-   { "HUMAN", "HEAVY", "human.ig.hc"},
-   { "HUMAN", "LAMBDA", "human.ig.lambda"},
-   { "HUMAN", "KAPPA", "human.ig.kappa"},
-   { "MOUSE", "HEAVY", "mouse.ig.hc"},
-   { "MOUSE", "LAMBDA", "mouse.ig.lambda"},
-   { "MOUSE", "KAPPA", "mouse.ig.kappa"},
-   { "RABBIT", "HEAVY", "rabbit.ig.hc"},
-   { "RABBIT", "LAMBDA", "rabbit.ig.lambda"},
-   { "RABBIT", "KAPPA", "rabbit.ig.kappa"},
-   { "RAT", "HEAVY", "rat.ig.hc"},
-   { "RAT", "LAMBDA", "rat.ig.lambda"},
-   { "RAT", "KAPPA", "rat.ig.kappa"},
-   { "SHARK", "HEAVY", "shark.ig.hc"},
-   { "SHARK", "LAMBDA", "shark.ig.lambda"},
-   { "SHARK", "KAPPA", "shark.ig.kappa"},
-   { "SHEEP", "HEAVY", "sheep.ig.hc"},
-   { "SHEEP", "LAMBDA", "sheep.ig.lambda"},
-   { "SHEEP", "KAPPA", "sheep.ig.kappa"},
-   { "VARIOUS", "HEAVY", "various.ig.hc"},
-   { "VARIOUS", "LAMBDA", "various.ig.lambda"},
-   { "VARIOUS", "KAPPA", "various.ig.kappa"},
-   { NULL, NULL, NULL}  
-}  ;
-
-char *gSkipKeys[] =               /* Any DEFINI having these is skipped */
-{  "MINIGENE",
-   "RECEPTOR",
-   "PSEUDOGENE",
-   "HISTOCOMPATIBILITY",
-   "CONSTANT",
-   "ADHESION",
-   "MICROGLOBULIN",
-   "COMPLEMENT",
-   "T-CELL",
-   "SIGNAL",
-   NULL
-}  ;
-     
+OUTFILE gOutFile[MAXOUTFILE];
+int     gNOutFile = 0;
+
 /************************************************************************/
 /* Prototypes
 */
+#include "KabClass.p"
 int main(int argc, char **argv);
+char *MapInput(char *FileName, long *length, BOOL *mapped);
+void FindSections(char *buffer, long length, SECTION *section,
+                  int NSection);
+void *ScanSection(void *arg);
+BOOL WriteSection(SECTION *section);
 FILE *SetOutputFile(char *FileName);
-char *FindFileType(FILE *in, char header[NHEADER][MAXBUFF], 
-                   int *HeaderLine);
-void WriteEntry(FILE *in, FILE *out, char header[NHEADER][MAXBUFF], 
-                int HeaderLine);
+BOOL CloseOutputFiles(void);
 void Usage(void);
-void SkipEntry(FILE *in);
 
 /************************************************************************/
 /*>int main(int argc, char **argv)
@@ -167,239 +149,405 @@ void SkipEntry(FILE *in);
 
    29.06.94 Original    By:ACRM
    30.06.94 Added call to SkipEntry()
+   19.10.26 Rewritten to work on the input mapped into memory, split
+            into sections for the threads
 */
 int main(int argc, char **argv)
 {
-   FILE *in  = NULL,
-        *out = NULL;
-   char header[NHEADER][MAXBUFF],
-        *FileName        = NULL;
-   int  HeaderLine       = 0;
+   SECTION   section[MAXTHREADS];
+   pthread_t tid[MAXTHREADS];
+   char      *buffer;
+   long      length;
+   int       NThreads = 1,
+             i;
+   BOOL      mapped,
+             started[MAXTHREADS],
+             ok       = TRUE;
    
-   if(argc < 2)
+   if((argc == 4) && !strcmp(argv[1],"-t"))
+   {
+      NThreads = atoi(argv[2]);
+      if(NThreads <= 0)
+         NThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+      if(NThreads < 1)
+         NThreads = 1;
+      if(NThreads > MAXTHREADS)
+         NThreads = MAXTHREADS;
+      argc -= 2;
+      argv += 2;
+   }
+   if(argc != 2)
    {
       Usage();
       return(1);
    }
    
-   if((in=fopen(argv[1],"r"))==NULL)
+   if((buffer = MapInput(argv[1], &length, &mapped))==NULL)
    {
       fprintf(stderr,"Unable to open input file: %s\n",argv[1]);
       return(1);
    }
-   
-   while(!feof(in))
+
+   if(!InitKabatClassifier())
    {
-      if((FileName = FindFileType(in, header, &HeaderLine))==((char *)-1))
-         break;
+      fprintf(stderr,"Unable to compile species and chain keywords\n");
+      return(1);
+   }
 
-      if(FileName)
-      {
-         if((out = SetOutputFile(FileName))==NULL)
-         {
-            fprintf(stderr,"Warning: Unable to open output file %s\n",
-                    FileName);
-            SkipEntry(in);
-         }
-         else
-         {
-            WriteEntry(in, out, header, HeaderLine);
-         }
-      }
-      else
+   /* Small files aren't worth splitting                                */
+   if(NThreads > length / MINSECTION)
+      NThreads = (int)(length / MINSECTION);
+   if(NThreads < 1)
+      NThreads = 1;
+
+   /* Find the entries in each section                                  */
+   FindSections(buffer, length, section, NThreads);
+   for(i=1; i<NThreads; i++)
+   {
+      started[i] = !pthread_create(&(tid[i]), NULL, ScanSection,
+                                   (void *)&(section[i]));
+      if(!started[i])
+         ScanSection((void *)&(section[i]));
+   }
+   ScanSection((void *)&(section[0]));
+   for(i=1; i<NThreads; i++)
+   {
+      if(started[i])
+         pthread_join(tid[i], NULL);
+   }
+
+   /* Write the entries in order                                        */
+   for(i=0; i<NThreads; i++)
+   {
+      /* If the last entry of the previous section ran past the end of
+         the section (a RECEND line within an entry header) rescan from
+         where it actually ended
+      */
+      if((i > 0) && (section[i].start != section[i-1].end))
       {
-         D("No appropriate output file\n");
-         SkipEntry(in);
+         section[i].start = section[i-1].end;
+         if(section[i].limit < section[i].start)
+            section[i].limit = section[i].start;
+         ScanSection((void *)&(section[i]));
       }
+
+      if(!section[i].ok || !WriteSection(&(section[i])))
+         ok = FALSE;
    }
    
-   return(0);
+   if(!CloseOutputFiles())
+      ok = FALSE;
+
+   if(mapped)
+      munmap(buffer, length);
+   else
+      free(buffer);
+
+   return(ok ? 0 : 1);
 }
 
 /************************************************************************/
-/*>FILE *SetOutputFile(char *FileName)
-   -----------------------------------
-   Opens the specified file for append access if it's not already open
-
-   29.06.94 Original    By:ACRM
+/*>char *MapInput(char *FileName, long *length, BOOL *mapped)
+   ----------------------------------------------------------
+   Input:   char  *FileName    Input file
+   Output:  long  *length      Length of the file
+            BOOL  *mapped      Was the file mapped? (Otherwise it was
+                               read into allocated memory)
+   Returns: char  *            The contents of the file (NULL on error)
+
+   Maps the input file into memory. If this can't be done, the file is
+   read into memory instead.
+
+   19.10.26 Original    By: ACRM
 */
-FILE *SetOutputFile(char *FileName)
+char *MapInput(char *FileName, long *length, BOOL *mapped)
 {
-   static char *CurrentFileName = NULL;
-   static FILE *out             = NULL;
+   struct stat StatBuf;
+   char        *buffer;
+   int         fd;
+   long        nread = 0,
+               n;
+
+   *mapped = FALSE;
+   *length = 0;
 
-   if(FileName == NULL)
+   if((fd = open(FileName, O_RDONLY))<0)
+      return(NULL);
+   if(fstat(fd, &StatBuf))
    {
-      D("NULL filename given\n");
-      
-      if(out != NULL)
+      close(fd);
+      return(NULL);
+   }
+   *length = (long)StatBuf.st_size;
+
+   if(*length > 0)
+   {
+      buffer = (char *)mmap(NULL, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(buffer != (char *)MAP_FAILED)
       {
-         D("Closing old output file\n");
-         fclose(out);
+#ifdef MADV_SEQUENTIAL
+         madvise(buffer, *length, MADV_SEQUENTIAL);
+#endif
+         *mapped = TRUE;
+         close(fd);
+         return(buffer);
       }
-      
-      out = NULL;
    }
-   else
+
+   /* Couldn't map it, so read it                                       */
+   if((buffer = (char *)malloc((*length > 0) ? *length : 1))==NULL)
+   {
+      close(fd);
+      return(NULL);
+   }
+   while(nread < *length &&
+         (n = (long)read(fd, buffer+nread, *length-nread)) > 0)
+      nread += n;
+   close(fd);
+   *length = nread;
+
+   return(buffer);
+}
+
+/************************************************************************/
+/*>void FindSections(char *buffer, long length, SECTION *section,
+                     int NSection)
+   ----------------------------------------------------------------
+   Input:   char     *buffer     The input
+            long     length      Length of the input
+   Output:  SECTION  *section    The sections
+   Input:   int      NSection    Number of sections
+
+   Divides the input into roughly equal sections, each starting after a
+   RECEND line.
+
+   19.10.26 Original    By: ACRM
+*/
+void FindSections(char *buffer, long length, SECTION *section,
+                  int NSection)
+{
+   long pos;
+   int  i;
+
+   for(i=0; i<NSection; i++)
    {
-      if(FileName != CurrentFileName)
+      section[i].buffer     = buffer;
+      section[i].length     = length;
+      section[i].entries    = NULL;
+      section[i].NEntries   = 0;
+      section[i].MaxEntries = 0;
+      section[i].ok         = TRUE;
+
+      if(i == 0)
       {
-         if(out != NULL)
-            fclose(out);
-         
-         out=fopen(FileName,"a");
-         CurrentFileName = FileName;
+         section[i].start = 0;
+      }
+      else
+      {
+         /* Find the line after the next RECEND line                    */
+         pos = (length / NSection) * i;
+         if(pos < section[i-1].start)
+            pos = section[i-1].start;
+         while(pos < length)
+         {
+            if(((pos == 0) || (buffer[pos-1] == '\n')) &&
+               !strncmp(buffer+pos, "RECEND", (length-pos < 6) ?
+                        (size_t)(length-pos) : 6))
+            {
+               while((pos < length) && (buffer[pos++] != '\n'));
+               break;
+            }
+            pos++;
+         }
+         section[i].start   = pos;
+         section[i-1].limit = pos;
       }
    }
-   
-   return(out);
+   section[NSection-1].limit = length;
 }
-      
+
 /************************************************************************/
-/*>char *FindFileType(FILE *in, char header[NHEADER][MAXBUFF], 
-                      int *HeaderLine)
-   -----------------------------------------------------------
-   Reads in the first lines from a Kabat entry and selects the
-   appropriate output file from the DEFINI line
+/*>void *ScanSection(void *arg)
+   ----------------------------
+   I/O:     void  *arg      The SECTION to scan
+   Returns: void  *         NULL
 
-   29.06.94 Original    By:ACRM
-   30.06.94 Handles multiple DEFINI lines
-            Handles gSkipKeys[]
-   18.07.94 Checks specifes lines as well as DEFINI lines
-   08.02.95 Just looks for SEQ to end a header rather than SEQRES
-            for latest release of the d/b. Upcases the header buffer
-            before testing for keywords.
+   Finds and classifies the entries in a section of the input. An entry
+   which starts in the section is read to its end even if that is
+   beyond the section. Run by each thread.
+
+   19.10.26 Original    By: ACRM
 */
-char *FindFileType(FILE *in, char header[NHEADER][MAXBUFF], 
-                   int *HeaderLine)
+void *ScanSection(void *arg)
 {
-   int  i,
-        DefLine[MAXDEFLINE],
-        NDefLine = 0;
-   char buffer[MAXDEFLINE * MAXBUFF];
-
-   *HeaderLine = 0;
-   buffer[0] = '\0';
+   SECTION *section = (SECTION *)arg;
+   ENTRY   *entry;
+   long    pos      = section->start;
 
-   while(fgets(header[*HeaderLine],MAXBUFF,in))
+   section->NEntries = 0;
+   while(pos < section->limit)
    {
-      /* N.B. TERMINATE() must *not* be called                          */
-#ifdef DEBUG
-      printf("%d: %s",*HeaderLine, header[*HeaderLine]);
-#endif
-      
-      if(!strncmp(header[*HeaderLine],"DEFINI",6) ||
-         !strncmp(header[*HeaderLine],"SPECIE",6))
-         DefLine[NDefLine++] = *HeaderLine;
-      if(!strncmp(header[*HeaderLine],"AANAME",6))
-      {
-         (*HeaderLine)++;
-         break;
-      }
-      if(!strncmp(header[*HeaderLine],"SEQ",3))
+      if(section->NEntries >= section->MaxEntries)
       {
-         NDefLine = 0;
-         break;
+         section->MaxEntries = (section->MaxEntries ?
+                                2 * section->MaxEntries : 1024);
+         if((entry = (ENTRY *)realloc(section->entries,
+                                      section->MaxEntries *
+                                      sizeof(ENTRY)))==NULL)
+         {
+            fprintf(stderr,"No memory for entry list\n");
+            section->ok = FALSE;
+            break;
+         }
+         section->entries = entry;
       }
-      
-      if(++(*HeaderLine) >= NHEADER)
+
+      entry        = &(section->entries[section->NEntries]);
+      entry->start = pos;
+      if((entry->status = ScanKabatEntry(section->buffer,
+                                         section->length, &pos,
+                                         &(entry->HeaderEnd),
+                                         &(entry->file)))==0)
       {
-         NDefLine = 0;
+         /* End of data                                                 */
+         pos = section->length;
          break;
       }
+      entry->end = pos;
+      section->NEntries++;
    }
+   section->end = pos;
 
-   if(!(*HeaderLine))
-      return((char *)(-1));
+   return(NULL);
+}
 
-   if(NDefLine == 0)
-   {
-      fprintf(stderr,"File missing DEFINI or AANAME line in entry:\n");
-      for(i=0; i<(*HeaderLine); i++)
-         fputs(header[i],stderr);
-      return(NULL);
-   }
+/************************************************************************/
+/*>BOOL WriteSection(SECTION *section)
+   -----------------------------------
+   Input:   SECTION  *section   A scanned section
+   Returns: BOOL                Success?
 
-   /* Build all DEFINI lines into a single buffer                       */
-   for(i=0; i<NDefLine; i++)
-      strcat(buffer,header[DefLine[i]]);
+   Writes the entries of a section to their output files and frees the
+   list of entries.
 
-   /* Upcase the buffer                                                 */
-   for(i=0; i<strlen(buffer); i++)
-   {
-      if(islower(buffer[i]))
-         buffer[i] = toupper(buffer[i]);
-   }
-   
-   /* See if any of the skip keys are present, if so return NULL        */
-   for(i=0; gSkipKeys[i] != NULL; i++)
-   {
-      if(strstr(buffer,gSkipKeys[i]))
-         return(NULL);
-   }
+   29.06.94 Original (as WriteEntry())    By:ACRM
+   19.10.26 Writes each entry as a block from the input in memory
+*/
+BOOL WriteSection(SECTION *section)
+{
+   ENTRY *entry;
+   FILE  *out;
+   int   i;
+   BOOL  ok = TRUE;
 
-   /* Search for specific types                                         */
-   for(i=0; gFileInfo[i].file != NULL; i++)
+   for(i=0; i<section->NEntries; i++)
    {
-      if(strstr(buffer,gFileInfo[i].source) &&
-         strstr(buffer,gFileInfo[i].chain))
-         return(gFileInfo[i].file);
-   }
-   
-   /* Now do `various' types                                            */
-   for(i=0; gFileInfo[i].file != NULL; i++)
-   {
-      if(!strncmp(gFileInfo[i].source,"VARIOUS",7) &&
-         strstr(buffer,gFileInfo[i].chain))
-         return(gFileInfo[i].file);
+      entry = &(section->entries[i]);
+
+      if(entry->status < 0)
+      {
+         fprintf(stderr,"File missing DEFINI or AANAME line in entry:\n");
+         fwrite(section->buffer+entry->start, 1,
+                entry->HeaderEnd-entry->start, stderr);
+      }
+
+      if(entry->file == NULL)
+      {
+         D("No appropriate output file\n");
+      }
+      else if((out = SetOutputFile(entry->file))==NULL)
+      {
+         fprintf(stderr,"Warning: Unable to open output file %s\n",
+                 entry->file);
+      }
+      else if(fwrite(section->buffer+entry->start, 1,
+                     entry->end-entry->start, out) !=
+              (size_t)(entry->end-entry->start))
+      {
+         fprintf(stderr,"Warning: Unable to write to output file %s\n",
+                 entry->file);
+         ok = FALSE;
+      }
    }
 
-   return(NULL);
+   if(section->entries != NULL)
+      free(section->entries);
+   section->entries  = NULL;
+   section->NEntries = 0;
+
+   return(ok);
 }
-      
+
 /************************************************************************/
-/*>void WriteEntry(FILE *in, FILE *out, char header[NHEADER][MAXBUFF], 
-                   int HeaderLine)
-   -------------------------------------------------------------------
-   First writes the header information, then copies the rest of the
-   entry.
+/*>FILE *SetOutputFile(char *FileName)
+   -----------------------------------
+   Input:   char  *FileName   Output file name
+   Returns: FILE  *           The file, opened for append (NULL if it
+                              can't be opened)
+
+   Opens the specified file for append access if it's not already open
 
    29.06.94 Original    By:ACRM
+   19.10.26 Keeps all the output files open, each with a large buffer,
+            rather than closing the last one
 */
-void WriteEntry(FILE *in, FILE *out, char header[NHEADER][MAXBUFF], 
-                int HeaderLine)
+FILE *SetOutputFile(char *FileName)
 {
-   int i;
-   char buffer[MAXBUFF];
-   
-   for(i=0; i<HeaderLine; i++)
-      fputs(header[i], out);
+   static OUTFILE *last = NULL;
+   int            i;
+
+   if((last != NULL) && !strcmp(last->name, FileName))
+      return(last->fp);
 
-   while(fgets(buffer,MAXBUFF,in))
+   for(i=0; i<gNOutFile; i++)
    {
-      fputs(buffer,out);
-      if(!strncmp(buffer,"RECEND",6))
-         break;
+      if(!strcmp(gOutFile[i].name, FileName))
+      {
+         last = &(gOutFile[i]);
+         return(last->fp);
+      }
    }
+
+   if(gNOutFile >= MAXOUTFILE)
+      return(NULL);
+
+   last       = &(gOutFile[gNOutFile++]);
+   last->name = FileName;
+   if((last->fp = fopen(FileName,"a"))!=NULL)
+      setvbuf(last->fp, NULL, _IOFBF, OUTBUFFSIZE);
+
+   return(last->fp);
 }
-   
+
 /************************************************************************/
-/*>void SkipEntry(FILE *in)
-   ------------------------
-   Skips the rest of an entry for which we haven't got an output file
-   30.06.94 Original    By: ACRM
+/*>BOOL CloseOutputFiles(void)
+   ---------------------------
+   Returns: BOOL       Were all the files written successfully?
+
+   Closes all the output files.
+
+   19.10.26 Original    By: ACRM
 */
-void SkipEntry(FILE *in)
+BOOL CloseOutputFiles(void)
 {
-   char buffer[MAXBUFF];
-   
-   while(fgets(buffer,MAXBUFF,in))
+   int  i;
+   BOOL ok = TRUE;
+
+   for(i=0; i<gNOutFile; i++)
    {
-      if(!strncmp(buffer,"RECEND",6))
-         break;
+      if((gOutFile[i].fp != NULL) && fclose(gOutFile[i].fp))
+      {
+         fprintf(stderr,"Warning: Unable to write to output file %s\n",
+                 gOutFile[i].name);
+         ok = FALSE;
+      }
+      gOutFile[i].fp = NULL;
    }
+   gNOutFile = 0;
+
+   return(ok);
 }
-  
+      
 /************************************************************************/
 /*>void Usage(void)
    ----------------
@@ -407,12 +555,16 @@ void SkipEntry(FILE *in)
 
    29.06.94 Original    By:ACRM
    08.02.95 V1.2
+   19.10.26 V1.3
+   19.10.26 V1.4
 */
 void Usage(void)
 {
-   fprintf(stderr,"\nSplitKabat V1.2 (c) 1994-5 Dr. Andrew C.R. Martin, \
+   fprintf(stderr,"\nSplitKabat V1.4 (c) 1994-2026 Dr. Andrew C.R. Martin, \
 UCL\n");
-   fprintf(stderr,"Usage: splitkabat <kabatfile>\n");
+   fprintf(stderr,"Usage: splitkabat [-t nthreads] <kabatfile>\n");
+   fprintf(stderr,"       -t Use this many threads (0 = one per \
+processor)\n");
    fprintf(stderr,"Splits new format Kabat files into separate files\n");
    fprintf(stderr,"based on source and chain type.\n\n");
 }